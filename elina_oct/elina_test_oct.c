@@ -22,6 +22,20 @@
 #include "opt_oct.h"
 #include "opt_oct_internal.h"
 #include "opt_oct_hmat.h"
+#include "opt_oct_parallel.h"
+#if defined(VECTOR)
+#include "opt_oct_closure_dense.h"
+#endif
+
+/* checks that compare results rather than print them */
+int num_failed = 0;
+
+void report(const char *name, bool ok){
+	printf("%s: %s\n",name,ok ? "ok" : "FAILED");
+	if(!ok){
+		num_failed++;
+	}
+}
 
 
 elina_interval_t ** generate_random_box(unsigned short int dim){
@@ -400,6 +414,410 @@ void test_oct_of_box(unsigned short int dim){
 	elina_manager_free(man);
 }
 
+/******
+	Random constraints v1 +/- v2 + c >= 0 with c >= 0, always satisfiable,
+	between variables of the same group of group_size variables, the
+	octagon decomposes into at least dim/group_size components.
+******/
+elina_lincons0_array_t generate_grouped_lincons0_array(unsigned short int dim, size_t nbcons, unsigned short int group_size){
+	size_t i;
+	elina_lincons0_array_t  lincons0 = elina_lincons0_array_make(nbcons);
+	for(i=0; i < nbcons; i++){
+		lincons0.p[i].constyp = ELINA_CONS_SUPEQ;
+		int v1 = rand()%dim;
+		int first = (v1/group_size)*group_size;
+		int size = first + group_size <= dim ? group_size : dim - first;
+		int v2 = v1;
+		while(size > 1 && v2==v1){
+			v2 = first + rand()%size;
+		}
+		if(v2==v1){
+			v2 = (v1 + 1)%dim;
+		}
+		int coeff1 = rand()%2==0? -1 :1;
+		int coeff2 = rand()%2==0? -1 :1;
+		lincons0.p[i].linexpr0 = generate_random_linexpr0(dim,v1,v2,coeff1,coeff2);
+	}
+	return lincons0;
+}
+
+
+/******
+	Dense half matrix of dimension dim with non-negative integer bounds,
+	a quarter of them top
+******/
+opt_oct_mat_t * generate_random_dense_mat(int dim){
+	opt_oct_mat_t *oo = opt_hmat_alloc_top(dim);
+	free_array_comp_list(oo->acl);
+	oo->acl = NULL;
+	oo->is_dense = true;
+	oo->ti = true;
+	oo->is_top = false;
+	oo->nni = 2*dim*(dim+1);
+	for(int i = 0; i < 2*dim; i++){
+		for(int j = 0; j <= (i|1); j++){
+			oo->mat[opt_matpos(i,j)] = i==j ? 0 : (rand()%4 ? rand()%20 + 1 : INFINITY);
+		}
+	}
+	return oo;
+}
+
+
+/******
+	Copy of oo with every entry of the half matrix set, the relations
+	between independent components are top
+******/
+opt_oct_mat_t * dense_copy(opt_oct_mat_t *oo, int dim){
+	opt_oct_mat_t *res = opt_hmat_copy(oo,dim);
+	opt_hmat_unpack(res,dim);
+	if(!res->is_dense){
+		convert_to_dense_mat(res,dim,false);
+	}
+	return res;
+}
+
+
+bool same_half(double *m1, double *m2, int dim){
+	int size = 2*dim*(dim+1);
+	for(int i = 0; i < size; i++){
+		if(m1[i]!=m2[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/******
+	Reference strong closure: Floyd-Warshall over all 2*dim nodes of the
+	full coherent matrix, then one strengthening as in the closures of the
+	library. Returns true if the octagon is empty.
+******/
+bool reference_strong_closure(double *m, int dim){
+	int n = 2*dim;
+	double *f = (double *)malloc(n*n*sizeof(double));
+	double *temp = (double *)malloc(n*sizeof(double));
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j < n; j++){
+			f[i*n + j] = m[opt_matpos2(i,j)];
+		}
+	}
+	for(int k = 0; k < n; k++){
+		for(int i = 0; i < n; i++){
+			for(int j = 0; j < n; j++){
+				f[i*n + j] = fmin(f[i*n + j], f[i*n + k] + f[k*n + j]);
+			}
+		}
+	}
+	for(int i = 0; i < n; i++){
+		temp[i] = is_int_flag ? ceil(f[(i^1)*n + i]/2) : f[(i^1)*n + i]/2;
+	}
+	bool empty = false;
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j <= (i|1); j++){
+			m[opt_matpos(i,j)] = fmin(f[i*n + j], temp[i^1] + temp[j]);
+		}
+		int ind = opt_matpos(i,i);
+		if(m[ind] < 0){
+			empty = true;
+		}
+		m[ind] = 0;
+	}
+	free(f);
+	free(temp);
+	return empty;
+}
+
+
+/******
+	Closes src sequentially and with several threads, both results must
+	equal the reference closure entry by entry
+******/
+void check_closure(const char *name, opt_oct_mat_t *src, int dim){
+	opt_oct_mat_t *expected = dense_copy(src,dim);
+	bool expected_empty = reference_strong_closure(expected->mat,dim);
+	int num_threads[2] = {1, 4};
+	for(int t = 0; t < 2; t++){
+		opt_oct_mat_t *oo = opt_hmat_copy(src,dim);
+		bool empty = opt_hmat_strong_closure(oo,dim,num_threads[t]);
+		bool ok = empty==expected_empty;
+		if(ok && !empty){
+			opt_oct_mat_t *closed = dense_copy(oo,dim);
+			ok = same_half(closed->mat,expected->mat,dim);
+			opt_hmat_free(closed);
+		}
+		char buf[128];
+		snprintf(buf,sizeof(buf),"%s closure dim %d, %d thread%s",name,dim,num_threads[t],num_threads[t]>1 ? "s" : "");
+		report(buf,ok);
+		opt_hmat_free(oo);
+	}
+	opt_hmat_free(expected);
+}
+
+
+void test_closure(unsigned short int dim, size_t nbcons){
+	opt_oct_mat_t *oo = generate_random_dense_mat(dim);
+	check_closure("dense",oo,dim);
+	opt_hmat_free(oo);
+
+	// meet the constraints without closing, to close a decomposed matrix
+	elina_manager_t * man = opt_oct_manager_alloc();
+	man->option.funopt[ELINA_FUNID_MEET_LINCONS_ARRAY].algorithm = -1;
+	unsigned short int group_size = dim > 8 ? dim/4 : 2;
+	elina_lincons0_array_t lincons = generate_grouped_lincons0_array(dim,nbcons,group_size);
+	opt_oct_t * oa1 = opt_oct_top(man,dim,0);
+	opt_oct_t * oa2 = opt_oct_meet_lincons_array(man,false,oa1,&lincons);
+	check_closure("decomposed",oa2->m ? oa2->m : oa2->closed,dim);
+	opt_oct_free(man,oa1);
+	opt_oct_free(man,oa2);
+	elina_lincons0_array_clear(&lincons);
+	elina_manager_free(man);
+}
+
+
+/******
+	Operators run on packed copies of their arguments must give the
+	results of the originals
+******/
+typedef enum pack_op_t{
+	PACK_JOIN,
+	PACK_MEET,
+	PACK_WIDENING,
+	PACK_MEET_LINCONS,
+	PACK_FORGET,
+	PACK_PERMUTE,
+	PACK_NUM_OPS,
+}pack_op_t;
+
+const char *pack_op_names[PACK_NUM_OPS] = {"join", "meet", "widening", "meet lincons", "forget", "permute"};
+
+
+opt_oct_t * apply_pack_op(elina_manager_t *man, pack_op_t op, opt_oct_t *oa1, opt_oct_t *oa2, elina_lincons0_array_t *lincons, elina_dimperm_t *perm){
+	elina_dim_t tdim[2] = {0, oa1->dim - 1};
+	switch(op){
+		case PACK_JOIN:
+			return opt_oct_join(man,false,oa1,oa2);
+		case PACK_MEET:
+			return opt_oct_meet(man,false,oa1,oa2);
+		case PACK_WIDENING:
+			return opt_oct_widening(man,oa1,oa2);
+		case PACK_MEET_LINCONS:
+			return opt_oct_meet_lincons_array(man,false,oa1,lincons);
+		case PACK_FORGET:
+			return opt_oct_forget_array(man,false,oa1,tdim,2,false);
+		default:
+			return opt_oct_permute_dimensions(man,false,oa1,perm);
+	}
+}
+
+
+void test_pack(unsigned short int dim, size_t nbcons){
+	elina_manager_t * man = opt_oct_manager_alloc();
+	unsigned short int group_size = dim > 8 ? dim/4 : 2;
+	elina_lincons0_array_t lincons1 = generate_grouped_lincons0_array(dim,nbcons,group_size);
+	elina_lincons0_array_t lincons2 = generate_grouped_lincons0_array(dim,nbcons,group_size);
+	elina_lincons0_array_t lincons3 = generate_grouped_lincons0_array(dim,nbcons/4 + 1,group_size);
+	elina_dimperm_t *perm = elina_dimperm_alloc(dim);
+	for(unsigned short int i = 0; i < dim; i++){
+		perm->dim[i] = dim - 1 - i;
+	}
+	opt_oct_t * top = opt_oct_top(man,dim,0);
+	opt_oct_t * oa1 = opt_oct_meet_lincons_array(man,false,top,&lincons1);
+	opt_oct_t * oa2 = opt_oct_meet_lincons_array(man,false,top,&lincons2);
+
+	opt_oct_t * copy = opt_oct_copy(man,oa1);
+	opt_oct_mat_t * oo = copy->closed ? copy->closed : copy->m;
+	report("copy is packed",oo->mat==NULL && oo->num_blocks > 0 && opt_oct_size(man,copy) < 2*dim*(dim+1));
+	report("packed copy equals original",opt_oct_is_eq(man,copy,oa1) && opt_oct_is_leq(man,oa1,copy));
+	opt_oct_free(man,copy);
+
+	// minimize packs in place
+	copy = opt_oct_copy(man,oa2);
+	opt_oct_unpack(copy);
+	opt_oct_minimize(man,copy);
+	oo = copy->closed ? copy->closed : copy->m;
+	report("minimize packs",oo->mat==NULL && opt_oct_is_eq(man,copy,oa2));
+	opt_oct_free(man,copy);
+
+	// operators unpack their arguments and results, minimize packs them again
+	copy = opt_oct_copy(man,oa1);
+	opt_oct_t * joined = opt_oct_join(man,false,copy,oa2);
+	opt_oct_t * expected_join = opt_oct_join(man,false,oa1,oa2);
+	oo = copy->closed ? copy->closed : copy->m;
+	opt_oct_mat_t * ooj = joined->closed ? joined->closed : joined->m;
+	bool unpacked = oo->mat!=NULL && (ooj==NULL || ooj->is_dense || ooj->mat!=NULL);
+	opt_oct_minimize(man,copy);
+	opt_oct_minimize(man,joined);
+	ooj = joined->closed ? joined->closed : joined->m;
+	report("operator results are unpacked",unpacked);
+	report("minimize packs operator results",(ooj==NULL || ooj->is_dense || ooj->mat==NULL) && opt_oct_is_eq(man,joined,expected_join) && opt_oct_is_eq(man,copy,oa1));
+	opt_oct_free(man,copy);
+	opt_oct_free(man,joined);
+	opt_oct_free(man,expected_join);
+
+	for(pack_op_t op = PACK_JOIN; op < PACK_NUM_OPS; op++){
+		opt_oct_t * copy1 = opt_oct_copy(man,oa1);
+		opt_oct_t * copy2 = opt_oct_copy(man,oa2);
+		opt_oct_t * expected = apply_pack_op(man,op,oa1,oa2,&lincons3,perm);
+		opt_oct_t * result = apply_pack_op(man,op,copy1,copy2,&lincons3,perm);
+		char buf[128];
+		snprintf(buf,sizeof(buf),"%s on packed copies",pack_op_names[op]);
+		report(buf,opt_oct_is_eq(man,result,expected) && opt_oct_is_leq(man,result,oa1)==opt_oct_is_leq(man,expected,oa1));
+		opt_oct_free(man,copy1);
+		opt_oct_free(man,copy2);
+		opt_oct_free(man,expected);
+		opt_oct_free(man,result);
+	}
+
+	opt_oct_free(man,top);
+	opt_oct_free(man,oa1);
+	opt_oct_free(man,oa2);
+	elina_dimperm_free(perm);
+	elina_lincons0_array_clear(&lincons1);
+	elina_lincons0_array_clear(&lincons2);
+	elina_lincons0_array_clear(&lincons3);
+	elina_manager_free(man);
+}
+
+
+/******
+	Number of blocks of oo1 that are also blocks of oo2
+******/
+int num_shared_blocks(opt_oct_mat_t *oo1, opt_oct_mat_t *oo2){
+	int count = 0;
+	for(int i = 0; i < oo1->num_blocks; i++){
+		for(int j = 0; j < oo2->num_blocks; j++){
+			if(oo1->blocks[i]==oo2->blocks[j]){
+				count++;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+
+/******
+	Copies of packed octagons share their blocks, and packing the result
+	of an operator only makes new blocks for the components it changed
+******/
+void test_share(unsigned short int dim, size_t nbcons){
+	elina_manager_t * man = opt_oct_manager_alloc();
+	unsigned short int group_size = dim > 8 ? dim/4 : 2;
+	elina_lincons0_array_t lincons = generate_grouped_lincons0_array(dim,nbcons,group_size);
+	opt_oct_t * top = opt_oct_top(man,dim,0);
+	opt_oct_t * oa = opt_oct_meet_lincons_array(man,false,top,&lincons);
+
+	opt_oct_t * copy1 = opt_oct_copy(man,oa);
+	opt_oct_t * copy2 = opt_oct_copy(man,copy1);
+	opt_oct_mat_t * oo1 = copy1->closed;
+	opt_oct_mat_t * oo2 = copy2->closed;
+	int num_blocks = oo1->num_blocks;
+	size_t count = num_blocks ? oo1->blocks[0]->count : 0;
+	report("copies share blocks",num_blocks > 0 && oo2->num_blocks==num_blocks && num_shared_blocks(oo1,oo2)==num_blocks && count==2);
+
+	// forgetting the first variable only changes its component
+	elina_dim_t tdim = 0;
+	opt_oct_t * result = opt_oct_forget_array(man,false,copy1,&tdim,1,false);
+	bool changed = !opt_oct_is_eq(man,result,oa);
+	opt_oct_minimize(man,result);
+	int shared = result->closed ? num_shared_blocks(result->closed,oo2) : 0;
+	report("packing reuses unchanged blocks",result->closed && result->closed->mat==NULL && shared==num_blocks - (changed ? 1 : 0));
+	report("shared blocks are unchanged",opt_oct_is_eq(man,copy1,oa) && opt_oct_is_eq(man,copy2,oa));
+	opt_oct_free(man,result);
+	opt_oct_free(man,copy1);
+	report("blocks are released",oo2->blocks[0]->count==1);
+	opt_oct_free(man,copy2);
+
+	opt_oct_free(man,top);
+	opt_oct_free(man,oa);
+	elina_lincons0_array_clear(&lincons);
+	elina_manager_free(man);
+}
+
+
+/******
+	Both matrices absent, or present with the same entries
+******/
+bool same_mat(opt_oct_mat_t *oo1, opt_oct_mat_t *oo2, int dim){
+	if(!oo1 || !oo2){
+		return oo1==oo2;
+	}
+	opt_oct_mat_t *d1 = dense_copy(oo1,dim);
+	opt_oct_mat_t *d2 = dense_copy(oo2,dim);
+	bool res = same_half(d1->mat,d2->mat,dim);
+	opt_hmat_free(d1);
+	opt_hmat_free(d2);
+	return res;
+}
+
+
+void check_serialize(const char *name, elina_manager_t *man, opt_oct_t *oa){
+	elina_membuf_t buf = opt_oct_serialize_raw(man,oa);
+	size_t size1 = 0, size2 = 0;
+	opt_oct_t *res = opt_oct_deserialize_raw(man,buf.ptr,&size1);
+	bool ok = size1==buf.size && res->dim==oa->dim && res->intdim==oa->intdim;
+	ok = ok && (!res->m || res->m!=res->closed);
+	ok = ok && same_mat(res->m,oa->m,oa->dim) && same_mat(res->closed,oa->closed,oa->dim);
+	char str[128];
+	snprintf(str,sizeof(str),"%s serialize round trip",name);
+	report(str,ok);
+	opt_oct_free(man,res);
+
+	// a copy of a mapped element reads the buffer until it is freed
+	res = opt_oct_map_raw(man,buf.ptr,&size2);
+	opt_oct_t *copy = opt_oct_copy(man,res);
+	opt_oct_free(man,res);
+	ok = size2==buf.size && same_mat(copy->m,oa->m,oa->dim) && same_mat(copy->closed,oa->closed,oa->dim);
+	snprintf(str,sizeof(str),"%s map round trip",name);
+	report(str,ok);
+	opt_oct_free(man,copy);
+	free(buf.ptr);
+}
+
+
+void test_serialize(unsigned short int dim, size_t nbcons){
+	elina_manager_t * man = opt_oct_manager_alloc();
+	unsigned short int group_size = dim > 8 ? dim/4 : 2;
+	elina_lincons0_array_t lincons = generate_grouped_lincons0_array(dim,nbcons,group_size);
+	opt_oct_t * top = opt_oct_top(man,dim,0);
+	opt_oct_t * bottom = opt_oct_bottom(man,dim,0);
+	check_serialize("top",man,top);
+	check_serialize("bottom",man,bottom);
+
+	opt_oct_t * oa = opt_oct_meet_lincons_array(man,false,top,&lincons);
+	check_serialize("closed",man,oa);
+	opt_oct_t * copy = opt_oct_copy(man,oa);
+	check_serialize("packed",man,copy);
+	opt_oct_free(man,copy);
+
+	// meet without closing, then keep both the matrix and its closure
+	man->option.funopt[ELINA_FUNID_MEET_LINCONS_ARRAY].algorithm = -1;
+	opt_oct_t * ob = opt_oct_meet_lincons_array(man,false,top,&lincons);
+	check_serialize("unclosed",man,ob);
+	ob->closed = opt_hmat_copy(ob->m,dim);
+	if(opt_hmat_strong_closure(ob->closed,dim,1)){
+		opt_hmat_free(ob->closed);
+		ob->closed = NULL;
+	}
+	check_serialize("unclosed and closed",man,ob);
+
+	opt_oct_t * od = opt_oct_top(man,dim,0);
+	opt_hmat_free(od->closed);
+	od->closed = NULL;
+	od->m = generate_random_dense_mat(dim);
+	check_serialize("dense",man,od);
+
+	opt_oct_free(man,top);
+	opt_oct_free(man,bottom);
+	opt_oct_free(man,oa);
+	opt_oct_free(man,ob);
+	opt_oct_free(man,od);
+	elina_lincons0_array_clear(&lincons);
+	elina_manager_free(man);
+}
+
+
 int main(int argc, char **argv){
 	if(argc < 3){
 		printf("The test requires two positive integers: (a) Number of variables and (b) Number of constraints");
@@ -425,4 +843,20 @@ int main(int argc, char **argv){
 	test_expand(dim,nbcons);
 	printf("Testing Oct of Box\n");
 	test_oct_of_box(dim);
+	printf("Testing Closure\n");
+	test_closure(dim,nbcons);
+	// large enough for the closure to use its threads
+	test_closure(OPT_OCT_PAR_MIN_DIM + 72,4*(OPT_OCT_PAR_MIN_DIM + 72));
+	#if defined(VECTOR)
+	// dense matrices of this size are closed tile by tile
+	test_closure(OPT_OCT_TILE_MIN_DIM + 45,4*(OPT_OCT_TILE_MIN_DIM + 45));
+	#endif
+	printf("Testing Packed Copies\n");
+	test_pack(dim,nbcons);
+	printf("Testing Shared Blocks\n");
+	// few enough constraints for the groups to stay separate components
+	test_share(dim,dim/2 + 1);
+	printf("Testing Serialization\n");
+	test_serialize(dim,nbcons);
+	return num_failed;
 }
@@ -39,6 +39,27 @@ extern "C" {
 
 elina_manager_t* opt_oct_manager_alloc(void);
 
+/* Number of threads used by the strong closure, independent components
+   are closed concurrently and large dense matrices split their rows.
+   num_threads = 0 uses one thread per online CPU, the default is 1. */
+void opt_oct_manager_set_num_threads(elina_manager_t* man, int num_threads);
+
+/* Decomposed octagons can be packed: one half-DBM per independent component
+   is kept instead of the full 2*dim*(dim+1) half matrix. Copies are packed,
+   and elina_abstract0_minimize packs an octagon in place. The operators do
+   not work on the blocks: they unpack their arguments in place, which
+   allocates the full half matrix and writes only the component blocks, and
+   their results are unpacked. Arguments and results stay unpacked until they
+   are minimized, so a program that keeps many octagons alive should minimize
+   the ones it stores. */
+
+/* Read an octagon written by elina_abstract0_serialize_raw without copying
+   the bounds of its independent components: they stay in the buffer p (for
+   instance a file mapped with mmap), which must be aligned to 8 bytes and
+   remain valid and unchanged until the result and all its copies are freed.
+   Dense octagons, and any buffer that is not aligned, are copied. */
+elina_abstract0_t* elina_abstract0_opt_oct_map_raw(elina_manager_t* man, void* p, size_t* size);
+
 /* Enlarge each bound by epsilon times the maximum finite bound in 
      the octagon */
 
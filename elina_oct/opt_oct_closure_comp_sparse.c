@@ -20,6 +20,7 @@
 
 
 #include "opt_oct_closure_comp_sparse.h"
+#include "opt_oct_parallel.h"
 
 
 /******
@@ -520,13 +521,18 @@ double calculate_comp_sparsity(opt_oct_mat_t *oo, comp_list_t *cl, int dim){
 	return 1- ((double)(count/(double)size));
 }
 
-bool floyd_warshall_comp_dense(opt_oct_mat_t * oo, comp_list_t * cl, int dim){
+bool floyd_warshall_comp_dense(opt_oct_mat_t * oo, comp_list_t * cl, int dim, int num_threads){
 	unsigned short int comp_size = cl->size;
 	double *m = oo->mat;
 	int size = 2*comp_size*(comp_size+1);
-	opt_oct_mat_t * ot = opt_hmat_alloc(size);
-	double * temp = ot->mat;
-	ot->is_dense = true;
+	/******
+		Only the buffer of the temporary matrix is used, it is not
+		allocated through opt_hmat_alloc as this may run on a worker.
+	******/
+	opt_oct_mat_t ot;
+	double * temp = (double *)malloc(size*sizeof(double));
+	ot.mat = temp;
+	ot.is_dense = true;
 	/******
 		Copy the component set to temporary dense matrix.
 	******/
@@ -551,9 +557,9 @@ bool floyd_warshall_comp_dense(opt_oct_mat_t * oo, comp_list_t * cl, int dim){
 		Apply Floyd-Warshall on temporary matrix.
 	*******/
 	#if defined(VECTOR)
-			floyd_warshall_dense(ot,temp1,temp2,comp_size, flag);
+			floyd_warshall_dense(&ot,temp1,temp2,comp_size, flag, num_threads);
 	#else
-			floyd_warshall_dense_scalar(ot,temp1,temp2,comp_size, flag);
+			floyd_warshall_dense_scalar(&ot,temp1,temp2,comp_size, flag);
 	#endif
 	free(temp1);
 	free(temp2);
@@ -575,382 +581,483 @@ bool floyd_warshall_comp_dense(opt_oct_mat_t * oo, comp_list_t * cl, int dim){
 		}
 	}
 	free(ca);
-	free_array_comp_list(ot->acl);
-	opt_hmat_free(ot);
+	free(temp);
         return false;
 }
 
-bool strong_closure_comp_sparse(opt_oct_mat_t *oo, double *temp1, double *temp2, unsigned short int *index1, unsigned short int *index2, int dim, bool is_int){
-    double *m = oo->mat;
-    array_comp_list_t *acl = oo->acl;
-    int count = oo->nni;
-    int n = 2*dim; 
-    for(int i = 0; i < n; i++){
-        temp1[i] = 0;
-        temp2[i] = 0;
-    }
-    unsigned short int num_comp = acl->size;
-    comp_list_t * cl = acl->head;
-    
-    for(int l = 0; l < num_comp; l++){
-	    /******
-			Calculate precise sparsity of each component set.
-			If it is less than threshold use dense Floyd Warshall,
-			otherwise use decomposition based Floyd Warshall.
-	    *******/
-	    double sparsity = calculate_comp_sparsity(oo,cl,dim);
-	    if(sparsity < sparse_threshold){
-			floyd_warshall_comp_dense(oo,cl,dim);
-			cl = cl->next;
-			continue;
-	    }
-	    unsigned short int comp_size = cl->size;
-	    unsigned short int * ca = to_sorted_array(cl,dim);
-	    //comp_t * ck = cl->head;
-	    /******
-			Floyd-Warshall step for each set independently
-	    ******/
-	    for(int k = 0; k < comp_size; k++){
-		//Compute index at start of iteration
-		unsigned short int k1 = ca[k];
-		//ck = ck->next;
-		/******
-			Compute index for k-th iteration
-		*******/
-		compute_index_comp_sparse(m,ca, comp_size, index1, index2, k1, dim);
-		
-		int s1 = index1[0],s2 = index1[n + 1];
-		int s3 = index2[0], s4 = index2[n + 1];
-		int pos1 = ((2*k1)^1) + ((((2*k1) + 1)*((2*k1) + 1))/2);
-		//int pos2 = matpos2((2*k)^1, 2*k);
-		int pos2 = (2*k1) + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-		//Compute (2k) and (2k+1)-th row and column, update the index
-		if(m[pos1]!= INFINITY){
-			  for(int i = 0; i < s3;i++){
-				int i2 = index2[i + 1];
-				int i1 = i2;
-				//int ind2 = n*i2 + ((2*k)^1);
-				//int ind1 = n*i1 + (2*k);
-				int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
-				int ind2 = ((2*k1)^1) + (((i2 + 1)*(i2 + 1))/2);
+/******
+	Decomposition based Floyd-Warshall on a single component set.
+	Returns the number of entries that became finite.
+******/
+static int floyd_warshall_comp_sparse(double *m, comp_list_t *cl, double *temp1, double *temp2, unsigned short int *index1, unsigned short int *index2, int dim){
+    int n = 2*dim;
+    int count = 0;
+    unsigned short int comp_size = cl->size;
+    unsigned short int * ca = to_sorted_array(cl,dim);
+    //comp_t * ck = cl->head;
+    /******
+		Floyd-Warshall step for each set independently
+    ******/
+    for(int k = 0; k < comp_size; k++){
+	//Compute index at start of iteration
+	unsigned short int k1 = ca[k];
+	//ck = ck->next;
+	/******
+		Compute index for k-th iteration
+	*******/
+	compute_index_comp_sparse(m,ca, comp_size, index1, index2, k1, dim);
+	
+	int s1 = index1[0],s2 = index1[n + 1];
+	int s3 = index2[0], s4 = index2[n + 1];
+	int pos1 = ((2*k1)^1) + ((((2*k1) + 1)*((2*k1) + 1))/2);
+	//int pos2 = matpos2((2*k)^1, 2*k);
+	int pos2 = (2*k1) + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+	//Compute (2k) and (2k+1)-th row and column, update the index
+	if(m[pos1]!= INFINITY){
+		  for(int i = 0; i < s3;i++){
+			int i2 = index2[i + 1];
+			int i1 = i2;
+			//int ind2 = n*i2 + ((2*k)^1);
+			//int ind1 = n*i1 + (2*k);
+			int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
+			int ind2 = ((2*k1)^1) + (((i2 + 1)*(i2 + 1))/2);
 
-				if(m[ind2]!= INFINITY){
-					m[ind2] = min(m[ind2],  m[pos1] + m[ind1]);
-				}
-				else{
-					m[ind2] =  m[pos1] + m[ind1];
-					//index1[m*i2 + index1[m*i2] + 1] = ((2*k)^1);
-					index2[n + s4 + 2] = i2;
-					//index1[m*i2]++;
-					s4++;
-					count++;
-				}
-				//temp2[i2] = m[ind2];
+			if(m[ind2]!= INFINITY){
+				m[ind2] = min(m[ind2],  m[pos1] + m[ind1]);
 			}
-			index2[n + 1] = s4;
-		}
-		
-		for(int i = 2*k1+2; i < n; i++){
-			int ind = ((2*k1)^1) + (((i+1)*(i+1))/2);
-			//temp2[i] = m[n*i + ((2*k)^1)];
-			temp2[i] = m[ind];
+			else{
+				m[ind2] =  m[pos1] + m[ind1];
+				//index1[m*i2 + index1[m*i2] + 1] = ((2*k)^1);
+				index2[n + s4 + 2] = i2;
+				//index1[m*i2]++;
+				s4++;
+				count++;
+			}
+			//temp2[i2] = m[ind2];
 		}
+		index2[n + 1] = s4;
+	}
 	
+	for(int i = 2*k1+2; i < n; i++){
+		int ind = ((2*k1)^1) + (((i+1)*(i+1))/2);
+		//temp2[i] = m[n*i + ((2*k)^1)];
+		temp2[i] = m[ind];
+	}
 
-		if(m[pos2] != INFINITY){
-		
-			for(int i = 0; i < s4; i++){
-				int i2 = index2[n + i + 2];
-				int i1 = i2;
-				//int ind2 = n*i2 + ((2*k)^1);
-				//int ind1 = n*i1 + (2*k);
-				int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
-				int ind2 = ((2*k1)^1) + (((i2 + 1)*(i2 + 1))/2);
-				if(m[ind1] != INFINITY){
-					m[ind1] = min(m[ind1], m[pos2] + m[ind2]);
-				}
-				else{
-					m[ind1] = m[pos2] + m[ind2];
-					//index1[m*i1 + index1[m*i1] + 1] = 2*k;
-					index2[s3 + 1] = i1;
-					//index1[m*i1]++;
-					s3++;
-					count++;
-				}
-				//temp1[i1] = m[ind1];
-			}
 
-			index2[0] = s3;
-		}
-		
-		for(int i = 2*k1+2; i < n; i++){
-			int ind = (2*k1) + (((i+1)*(i+1))/2);
-			//temp1[i] = m[n*i + (2*k)];
-			temp1[i] = m[ind];
+	if(m[pos2] != INFINITY){
+	
+		for(int i = 0; i < s4; i++){
+			int i2 = index2[n + i + 2];
+			int i1 = i2;
+			//int ind2 = n*i2 + ((2*k)^1);
+			//int ind1 = n*i1 + (2*k);
+			int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
+			int ind2 = ((2*k1)^1) + (((i2 + 1)*(i2 + 1))/2);
+			if(m[ind1] != INFINITY){
+				m[ind1] = min(m[ind1], m[pos2] + m[ind2]);
+			}
+			else{
+				m[ind1] = m[pos2] + m[ind2];
+				//index1[m*i1 + index1[m*i1] + 1] = 2*k;
+				index2[s3 + 1] = i1;
+				//index1[m*i1]++;
+				s3++;
+				count++;
+			}
+			//temp1[i1] = m[ind1];
 		}
 
-		if(m[pos2] != INFINITY){
+		index2[0] = s3;
+	}
+	
+	for(int i = 2*k1+2; i < n; i++){
+		int ind = (2*k1) + (((i+1)*(i+1))/2);
+		//temp1[i] = m[n*i + (2*k)];
+		temp1[i] = m[ind];
+	}
 
-			for(int j = 0; j < s1; j++){
-				//int ind4 = get_index(n, 2*k,j);
-				//int j1 = index1[m*(2*k) + j + 1];
-				int j1 = index1[j + 1];
-				int ind1 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
-				int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-				if(m[ind2] != INFINITY ){
-					m[ind2] = min(m[ind2], m[pos2] + m[ind1]);
-				}
-				else{
-					m[ind2] =  m[pos2] + m[ind1];
-					index1[n + s2 + 2] = j1;
-					//index2[m*j1 + index2[m*j1] + 1] = ((2*k)^1);
-					s2++;
-					count++;
-					//index2[m*j1]++;
-				} 
+	if(m[pos2] != INFINITY){
+
+		for(int j = 0; j < s1; j++){
+			//int ind4 = get_index(n, 2*k,j);
+			//int j1 = index1[m*(2*k) + j + 1];
+			int j1 = index1[j + 1];
+			int ind1 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
+			int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+			if(m[ind2] != INFINITY ){
+				m[ind2] = min(m[ind2], m[pos2] + m[ind1]);
 			}
-			index1[n + 1] = s2;
+			else{
+				m[ind2] =  m[pos2] + m[ind1];
+				index1[n + s2 + 2] = j1;
+				//index2[m*j1 + index2[m*j1] + 1] = ((2*k)^1);
+				s2++;
+				count++;
+				//index2[m*j1]++;
+			} 
 		}
+		index1[n + 1] = s2;
+	}
 
-		if(m[pos1] != INFINITY){
+	if(m[pos1] != INFINITY){
 
-			for(int j = 0; j < s2; j++){
-				//int ind4 = get_index(n, 2*k,j);
-				//int j1 = index1[m*((2*k)^1) + j + 1];
-				int j1 = index1[n + j + 2];
-				int ind1 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
-				int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-				//if(m[ind2] != std::numeric_limits<double>::infinity(
-				if(m[ind1] != INFINITY ){
-					m[ind1] = min(m[ind1], m[pos1] + m[ind2]);
-				}
-				else{
-					m[ind1] =  m[pos1] + m[ind2];
-					index1[s1 + 1] = j1;
-					//index2[m*j1 + index2[m*j1] + 1] = (2*k);
-					s1++;
-					count++;
-					//index2[m*j1]++;
-				}
+		for(int j = 0; j < s2; j++){
+			//int ind4 = get_index(n, 2*k,j);
+			//int j1 = index1[m*((2*k)^1) + j + 1];
+			int j1 = index1[n + j + 2];
+			int ind1 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
+			int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+			//if(m[ind2] != std::numeric_limits<double>::infinity(
+			if(m[ind1] != INFINITY ){
+				m[ind1] = min(m[ind1], m[pos1] + m[ind2]);
 			}
-			index1[0] = s1;
-		}
-	        
-		//This is the Main Loop Divided into four parts
-		//First Part through 2k+1
-		int ind1_k = index1[0];
-		int ind2_k = index1[n + 1];
-		int ind3_k = index2[0];
-		int ind4_k = index2[n + 1];
-		for(int i = 0; i < ind1_k; i++){
-			int i1 = index1[i + 1];
-			int i2 = (i1%2==0) ? (i1 + 1): i1;
-			int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
-			int ind1 = i1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
-			//double t1 = m[n*(2*k) + i1];
-			double t1 = m[ind1];
-			//double t2 = m[n*((2*k)^1) + (i^1)];
-			//int j2 = (j/2)*2;
-			for(int j = 0;j < ind2_k ; j++){
-				//int ind2 = get_index(k,j);
-		        	//int j1 = index1[m*((2*k)^1) + j + 1];
-				int j1 = index1[n + j + 2];
-				if(j1 > br){
-					break;
-					//continue;
-				}
-				int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-				//double op1 = t1 + m[n*((2*k)^1) + j1];RDTSC(end);
-        
-				double op1 = t1 + m[ind2];
-				//double op2 = t2 + m[n*(2*k) + j];
-				//double op3 = min(op1, op2);
-				int ind3 = j1 + ((((i1^1) + 1)*((i1^1) + 1))/2);
-				//m[n*(i1^1) + j1] = min(m[n*(i1^1) + j1],op1 );
-				if(m[ind3]!=INFINITY){
-					m[ind3] = min(m[ind3],op1 );
-				}
-				else{
-					m[ind3] = op1;
-					count++;
-				}
-			}
-			//for(int j = 0; j < index2[m*2*k]; j++){
-			for(int j = 0;j < ind3_k; j++){
-				int j1 = index2[j + 1];
-				if(j1>i2){
-					 break;
-					//continue;
-			    	}
-				double op1 = t1 + temp1[j1];
-				int ind3 = (j1^1) + ((((i1^1) + 1)*((i1^1) + 1))/2);
-				//m[n*(i1^1) + (j1^1)] = min(m[n*(i1^1) + (j1^1)],op1 );
-				if(m[ind3]!=INFINITY){
-					m[ind3] = min(m[ind3],op1 );
-				}
-				else{
-					m[ind3] = op1;
-					count++;
-				}
+			else{
+				m[ind1] =  m[pos1] + m[ind2];
+				index1[s1 + 1] = j1;
+				//index2[m*j1 + index2[m*j1] + 1] = (2*k);
+				s1++;
+				count++;
+				//index2[m*j1]++;
 			}
-			//}
 		}
-		
-		//Second Part through 2k
-		for(int i = 0; i < ind2_k; i++){
-		    int i1 = index1[n + i + 2];
-		    int i2 = (i1%2==0) ? (i1 + 1): i1;
-		    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
-		    //double t1 = m[n*(2*k) + i1];
-		    int ind1 = i1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-		    //double t2 = m[n*((2*k)^1) + i1];
-		    double t2 = m[ind1];
-		    //int j2 = (j/2)*2;
-		    for(int j = 0; j < ind1_k; j++){
-			    int j1 = index1[j + 1];
-			    if(j1 > br){
-				break;
-				//continue;
-			    }
-			    int ind2 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
-		            //double op2 = t2 + m[n*(2*k) + j1];
-			    double op2 = t2 + m[ind2];
-			    int ind3 = j1 + ((((i1^1) + 1)*((i1^1) + 1))/2);
-		            //m[n*(i1^1) + j1] = min(m[n*(i1^1) + j1],op2 );
-			    if(m[ind3] !=INFINITY){
-			    	m[ind3] = min(m[ind3],op2 );
-			    }
-			    else{
-				m[ind3] = op2;
-				count++;
-			    }
-		        }
-		        //for(int j = 0; j < index2[m*((2*k)^1)]; j++){
-			  for(int j = 0; j < ind4_k; j++){
-			     int j1 = index2[n + j + 2];
-			     if(j1>i2){
-				break;
-				//continue;
-			    }
-		            double op2 = t2 + temp2[j1];
-			    int ind3 = (j1^1) + ((((i1^1) + 1)*((i1^1) + 1))/2);
-		            //m[n*(i1^1) + (j1^1)] = min(m[n*(i1^1) + (j1^1)],op2 );
-			    if(m[ind3]!=INFINITY){
-			    	m[ind3] = min(m[ind3],op2 );
-			    }
-			    else{
-				m[ind3] = op2;
-				count++;
-			    }
-		        }
-		    //}
-		}
-	    
-		//Third Part i >= (2*k+1)
-		for(int i = 0; i < ind4_k; i++){
-		    int i1 = index2[n + i + 2];
-		    int i2 = (i1%2==0) ? (i1 + 1): i1;
-		    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
-		    int ind1 = ((2*k1)^1) + (((i1 + 1)*(i1 + 1))/2);
-		    //double t1 = m[n*i1 + ((2*k)^1)];
-		    double t1 = m[ind1];
-		   
-		    for(int j = 0; j < ind2_k; j++){
-		   	    //int j1 = index1[m*((2*k)^1) + j + 1];
-			    int j1 = index1[n + j + 2];
-			    if(j1 > br){
+		index1[0] = s1;
+	}
+        
+	//This is the Main Loop Divided into four parts
+	//First Part through 2k+1
+	int ind1_k = index1[0];
+	int ind2_k = index1[n + 1];
+	int ind3_k = index2[0];
+	int ind4_k = index2[n + 1];
+	for(int i = 0; i < ind1_k; i++){
+		int i1 = index1[i + 1];
+		int i2 = (i1%2==0) ? (i1 + 1): i1;
+		int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
+		int ind1 = i1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
+		//double t1 = m[n*(2*k) + i1];
+		double t1 = m[ind1];
+		//double t2 = m[n*((2*k)^1) + (i^1)];
+		//int j2 = (j/2)*2;
+		for(int j = 0;j < ind2_k ; j++){
+			//int ind2 = get_index(k,j);
+	        	//int j1 = index1[m*((2*k)^1) + j + 1];
+			int j1 = index1[n + j + 2];
+			if(j1 > br){
 				break;
 				//continue;
-			    }
-			    int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
-		            //double op1 = t1 + m[n*((2*k)^1) + j1];
-			    double op1 = t1 + m[ind2];
-			    int ind3 = j1 + (((i1 + 1)*(i1 + 1))/2);
-		            //m[n*i1 + j1] = min(m[n*i1 + j1],op1 );
-			    if(m[ind3]!=INFINITY){
-			    	m[ind3] = min(m[ind3],op1 );
-			    }
-			    else{
+			}
+			int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+			//double op1 = t1 + m[n*((2*k)^1) + j1];RDTSC(end);
+        
+			double op1 = t1 + m[ind2];
+			//double op2 = t2 + m[n*(2*k) + j];
+			//double op3 = min(op1, op2);
+			int ind3 = j1 + ((((i1^1) + 1)*((i1^1) + 1))/2);
+			//m[n*(i1^1) + j1] = min(m[n*(i1^1) + j1],op1 );
+			if(m[ind3]!=INFINITY){
+				m[ind3] = min(m[ind3],op1 );
+			}
+			else{
 				m[ind3] = op1;
 				count++;
-			    }
-		        }
-		        
-		 	for(int j = 0; j < ind3_k ; j++){
-		            
-			    int j1 = index2[j + 1];
-			    if(j1>i2){
-				break;
+			}
+		}
+		//for(int j = 0; j < index2[m*2*k]; j++){
+		for(int j = 0;j < ind3_k; j++){
+			int j1 = index2[j + 1];
+			if(j1>i2){
+				 break;
 				//continue;
-			     }
-		            double op1 = t1 + temp1[j1];
-		            //double op1 = t1 + m[n*(j1) + 2*k];
-		     	    int ind3 = (j1^1) + (((i1 + 1)*(i1 + 1))/2);
-			    if(m[ind3]!=INFINITY){
-			    	m[ind3] = min(m[ind3],op1 );
-			    }
-			    else{
+		    	}
+			double op1 = t1 + temp1[j1];
+			int ind3 = (j1^1) + ((((i1^1) + 1)*((i1^1) + 1))/2);
+			//m[n*(i1^1) + (j1^1)] = min(m[n*(i1^1) + (j1^1)],op1 );
+			if(m[ind3]!=INFINITY){
+				m[ind3] = min(m[ind3],op1 );
+			}
+			else{
 				m[ind3] = op1;
 				count++;
-			    }
-		        }
+			}
 		}
-		
-		//Fourth Part i >= 2*k
-		for(int i = 0; i < ind3_k; i++){
-		    //int i1 = index2[m*(2*k) + i + 1];
-		    int i1 = index2[i + 1];
-		    int i2 = (i1%2==0) ? (i1 + 1): i1;
-		    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
-		    //double t2 = m[n*i1 + (2*k)];
-		    int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
-		    double t2 = m[ind1];
-		    for(int j = 0; j < ind1_k; j++){
-			    int j1 = index1[j + 1];
-			    if(j1 > br){
-				break;
-				//continue;
-			    }
-			    
-		            //double op2 = t2 + m[n*(2*k) + j1];
-			    int ind2 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
-			    double op2 = t2 + m[ind2];
-			    int ind3 = j1 + (((i1 + 1)*(i1 + 1))/2);
-		            //m[n*i1 + j1] = min(m[n*i1 + j1],op2 );
-			    if(m[ind3]!=INFINITY){
-			    	m[ind3] = min(m[ind3],op2 );
-			    }
-			    else{
-				m[ind3] = op2;
-				count++;
-			    }
-		        }
-		       
-		       // j >= 2*k
-		       for(int j = 0; j < ind4_k ; j++){
-			    int j1 = index2[n + j + 2];
-			    if(j1>i2){
-				break;
-				//continue;
-			    }
-			    
-		            double op2 = t2 + temp2[j1];
-			    int ind3 = (j1^1) + (((i1 + 1)*(i1 + 1))/2);
-		            //m[n*i1 + (j1^1)] = min(m[n*i1 + (j1^1)],op2 );
-			    if(m[ind3]!=INFINITY){
-			    	m[ind3] = min(m[ind3],op2 );
-			    }
-			    else{
-				m[ind3] = op2;
-				count++;
-			    }
-		        }
+		//}
+	}
+	
+	//Second Part through 2k
+	for(int i = 0; i < ind2_k; i++){
+	    int i1 = index1[n + i + 2];
+	    int i2 = (i1%2==0) ? (i1 + 1): i1;
+	    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
+	    //double t1 = m[n*(2*k) + i1];
+	    int ind1 = i1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+	    //double t2 = m[n*((2*k)^1) + i1];
+	    double t2 = m[ind1];
+	    //int j2 = (j/2)*2;
+	    for(int j = 0; j < ind1_k; j++){
+		    int j1 = index1[j + 1];
+		    if(j1 > br){
+			break;
+			//continue;
+		    }
+		    int ind2 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
+	            //double op2 = t2 + m[n*(2*k) + j1];
+		    double op2 = t2 + m[ind2];
+		    int ind3 = j1 + ((((i1^1) + 1)*((i1^1) + 1))/2);
+	            //m[n*(i1^1) + j1] = min(m[n*(i1^1) + j1],op2 );
+		    if(m[ind3] !=INFINITY){
+		    	m[ind3] = min(m[ind3],op2 );
+		    }
+		    else{
+			m[ind3] = op2;
+			count++;
+		    }
+	        }
+	        //for(int j = 0; j < index2[m*((2*k)^1)]; j++){
+		  for(int j = 0; j < ind4_k; j++){
+		     int j1 = index2[n + j + 2];
+		     if(j1>i2){
+			break;
+			//continue;
+		    }
+	            double op2 = t2 + temp2[j1];
+		    int ind3 = (j1^1) + ((((i1^1) + 1)*((i1^1) + 1))/2);
+	            //m[n*(i1^1) + (j1^1)] = min(m[n*(i1^1) + (j1^1)],op2 );
+		    if(m[ind3]!=INFINITY){
+		    	m[ind3] = min(m[ind3],op2 );
+		    }
+		    else{
+			m[ind3] = op2;
+			count++;
+		    }
+	        }
+	    //}
+	}
+    
+	//Third Part i >= (2*k+1)
+	for(int i = 0; i < ind4_k; i++){
+	    int i1 = index2[n + i + 2];
+	    int i2 = (i1%2==0) ? (i1 + 1): i1;
+	    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
+	    int ind1 = ((2*k1)^1) + (((i1 + 1)*(i1 + 1))/2);
+	    //double t1 = m[n*i1 + ((2*k)^1)];
+	    double t1 = m[ind1];
+	   
+	    for(int j = 0; j < ind2_k; j++){
+	   	    //int j1 = index1[m*((2*k)^1) + j + 1];
+		    int j1 = index1[n + j + 2];
+		    if(j1 > br){
+			break;
+			//continue;
+		    }
+		    int ind2 = j1 + (((((2*k1)^1) + 1)*(((2*k1)^1) + 1))/2);
+	            //double op1 = t1 + m[n*((2*k)^1) + j1];
+		    double op1 = t1 + m[ind2];
+		    int ind3 = j1 + (((i1 + 1)*(i1 + 1))/2);
+	            //m[n*i1 + j1] = min(m[n*i1 + j1],op1 );
+		    if(m[ind3]!=INFINITY){
+		    	m[ind3] = min(m[ind3],op1 );
+		    }
+		    else{
+			m[ind3] = op1;
+			count++;
+		    }
+	        }
+	        
+	 	for(int j = 0; j < ind3_k ; j++){
+	            
+		    int j1 = index2[j + 1];
+		    if(j1>i2){
+			break;
+			//continue;
+		     }
+	            double op1 = t1 + temp1[j1];
+	            //double op1 = t1 + m[n*(j1) + 2*k];
+	     	    int ind3 = (j1^1) + (((i1 + 1)*(i1 + 1))/2);
+		    if(m[ind3]!=INFINITY){
+		    	m[ind3] = min(m[ind3],op1 );
+		    }
+		    else{
+			m[ind3] = op1;
+			count++;
+		    }
+	        }
+	}
+	
+	//Fourth Part i >= 2*k
+	for(int i = 0; i < ind3_k; i++){
+	    //int i1 = index2[m*(2*k) + i + 1];
+	    int i1 = index2[i + 1];
+	    int i2 = (i1%2==0) ? (i1 + 1): i1;
+	    int br = i2 < 2*k1 ? i2 : 2*k1 - 1;
+	    //double t2 = m[n*i1 + (2*k)];
+	    int ind1 = (2*k1) + (((i1 + 1)*(i1 + 1))/2);
+	    double t2 = m[ind1];
+	    for(int j = 0; j < ind1_k; j++){
+		    int j1 = index1[j + 1];
+		    if(j1 > br){
+			break;
+			//continue;
+		    }
+		    
+	            //double op2 = t2 + m[n*(2*k) + j1];
+		    int ind2 = j1 + ((((2*k1) + 1)*((2*k1) + 1))/2);
+		    double op2 = t2 + m[ind2];
+		    int ind3 = j1 + (((i1 + 1)*(i1 + 1))/2);
+	            //m[n*i1 + j1] = min(m[n*i1 + j1],op2 );
+		    if(m[ind3]!=INFINITY){
+		    	m[ind3] = min(m[ind3],op2 );
+		    }
+		    else{
+			m[ind3] = op2;
+			count++;
+		    }
+	        }
+	       
+	       // j >= 2*k
+	       for(int j = 0; j < ind4_k ; j++){
+		    int j1 = index2[n + j + 2];
+		    if(j1>i2){
+			break;
+			//continue;
+		    }
+		    
+	            double op2 = t2 + temp2[j1];
+		    int ind3 = (j1^1) + (((i1 + 1)*(i1 + 1))/2);
+	            //m[n*i1 + (j1^1)] = min(m[n*i1 + (j1^1)],op2 );
+		    if(m[ind3]!=INFINITY){
+		    	m[ind3] = min(m[ind3],op2 );
+		    }
+		    else{
+			m[ind3] = op2;
+			count++;
+		    }
+	        }
+	}
+	
+    }
+free(ca);
+    return count;
+}
+
+typedef struct comp_closure_t{
+	comp_list_t *cl;
+	bool is_dense;
+}comp_closure_t;
+
+typedef struct comp_sparse_thread_t{
+	opt_oct_mat_t *oo;
+	comp_closure_t *comps;
+	int num_comp;
+	int *next;
+	int dim;
+	int count;
+}comp_sparse_thread_t;
+
+static int comp_closure_cmp(const void *a, const void *b){
+	unsigned short int sa = ((const comp_closure_t *)a)->cl->size;
+	unsigned short int sb = ((const comp_closure_t *)b)->cl->size;
+	return (sa < sb) - (sa > sb);
+}
+
+/******
+	Worker for the independent component sets, each thread
+	takes the next set and closes it with its own buffers.
+******/
+static void *strong_closure_comp_sparse_thread(void *args){
+	comp_sparse_thread_t *data = (comp_sparse_thread_t *)args;
+	int n = 2*data->dim;
+	double *temp1 = (double *)calloc(n,sizeof(double));
+	double *temp2 = (double *)calloc(n,sizeof(double));
+	unsigned short int *index1 = (unsigned short int *)calloc(2*(n + 1),sizeof(unsigned short int));
+	unsigned short int *index2 = (unsigned short int *)calloc(2*(n + 1),sizeof(unsigned short int));
+	data->count = 0;
+	while(true){
+		int l = __sync_fetch_and_add(data->next,1);
+		if(l >= data->num_comp){
+			break;
 		}
-		
+		comp_closure_t *comp = data->comps + l;
+		if(comp->is_dense){
+			floyd_warshall_comp_dense(data->oo,comp->cl,data->dim,1);
+		}
+		else{
+			data->count += floyd_warshall_comp_sparse(data->oo->mat,comp->cl,temp1,temp2,index1,index2,data->dim);
+		}
+	}
+	free(temp1);
+	free(temp2);
+	free(index1);
+	free(index2);
+	return NULL;
+}
+
+bool strong_closure_comp_sparse(opt_oct_mat_t *oo, double *temp1, double *temp2, unsigned short int *index1, unsigned short int *index2, int dim, bool is_int, int num_threads){
+    double *m = oo->mat;
+    array_comp_list_t *acl = oo->acl;
+    int count = oo->nni;
+    int n = 2*dim; 
+    for(int i = 0; i < n; i++){
+        temp1[i] = 0;
+        temp2[i] = 0;
+    }
+    unsigned short int num_comp = acl->size;
+    comp_list_t * cl = acl->head;
+    comp_closure_t *comps = (comp_closure_t *)malloc(num_comp*sizeof(comp_closure_t));
+    int num_rest = 0;
+    double work = 0;
+    for(int l = 0; l < num_comp; l++){
+	    /******
+			Calculate precise sparsity of each component set.
+			If it is less than threshold use dense Floyd Warshall,
+			otherwise use decomposition based Floyd Warshall.
+			The sets are disjoint, large dense sets distribute their
+			rows over the threads, the rest is closed concurrently.
+	    *******/
+	    double sparsity = calculate_comp_sparsity(oo,cl,dim);
+	    bool is_dense = sparsity < sparse_threshold;
+	    if(is_dense && num_threads > 1 && cl->size >= OPT_OCT_PAR_MIN_DIM){
+		floyd_warshall_comp_dense(oo,cl,dim,num_threads);
 	    }
-	free(ca);
-	cl = cl->next;
+	    else{
+		comps[num_rest].cl = cl;
+		comps[num_rest].is_dense = is_dense;
+		num_rest++;
+		work += 8.0*cl->size*cl->size*cl->size;
+	    }
+	    cl = cl->next;
+    }
+    
+    if(num_threads > 1 && num_rest > 1 && work >= OPT_OCT_PAR_MIN_WORK){
+	/* largest sets first for a better balance */
+	qsort(comps,num_rest,sizeof(comp_closure_t),comp_closure_cmp);
+	int num_workers = num_threads < num_rest ? num_threads : num_rest;
+	int next = 0;
+	comp_sparse_thread_t *args = (comp_sparse_thread_t *)malloc(num_workers*sizeof(comp_sparse_thread_t));
+	for(int t = 0; t < num_workers; t++){
+		args[t].oo = oo;
+		args[t].comps = comps;
+		args[t].num_comp = num_rest;
+		args[t].next = &next;
+		args[t].dim = dim;
+	}
+	opt_oct_parallel_run(strong_closure_comp_sparse_thread,args,sizeof(comp_sparse_thread_t),num_workers);
+	for(int t = 0; t < num_workers; t++){
+		count += args[t].count;
+	}
+	free(args);
+    }
+    else{
+	for(int l = 0; l < num_rest; l++){
+		if(comps[l].is_dense){
+			floyd_warshall_comp_dense(oo,comps[l].cl,dim,1);
+		}
+		else{
+			count += floyd_warshall_comp_sparse(m,comps[l].cl,temp1,temp2,index1,index2,dim);
+		}
+	}
     }
+    free(comps);
     oo->nni = count;
     
     if(is_int){
@@ -20,6 +20,7 @@
 
 
 #include "opt_oct_closure_dense.h"
+#include "opt_oct_parallel.h"
 #include <assert.h>
 
 #define U_i 32
@@ -132,15 +133,11 @@ bool strengthning_dense(opt_oct_mat_t * oo, double *temp, int n){
 	return false;
 }
 
-bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int dim, bool is_int){
-    double *m = oo->mat;
-    int size = 4 * dim * dim;
-    int n = 2*dim; 
-    double count = 0;
-    /******
-		Floyd Warshall step
-    *******/
-    for(int k = 0; k < dim; k++){
+/******
+	Pivot step of k-th iteration, the updated 2k and
+	(2k+1)-th columns are stored in temp1 and temp2.
+******/
+static void floyd_warshall_dense_pivot(double *m, double *temp1, double *temp2, int k, int n){
 	//int pos1 = matpos2(2*k, (2*k)^1);
 	int ki = ((((2*k) + 1)*((2*k) + 1))/2);
 	int kki = (((((2*k)^1) + 1)*(((2*k)^1) + 1))/2);
@@ -160,7 +157,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		//int ind1 = n*i + (2*k);
 		//m[ind2] = min(m[ind2], m[ind1] + m[n*(2*k) + ((2*k)^1)] );
 		m[ind1] = min(m[ind1], m[ind2] + m[pos1] );
-                count = count + 2;
 		temp2[i^1] = m[ind1];
 	}
 
@@ -175,7 +171,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		//m[ind1] = min(m[ind1], m[ind2] + m[n*((2*k)^1) + (2*k)] );
 		m[ind2] = min(m[ind2], m[ind1] + m[pos2] );
 		temp1[i^1] = m[ind2];
-		count = count + 2;
 	}
 
 	for(int j = 0; j < (2*k); j++){
@@ -185,7 +180,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		int ind4 = j + ki;
 		//m[n*((2*k)^1) + j] = min(m[n*((2*k)^1) + j], m[n*((2*k)^1) + 2*k] + m[n*(2*k) + j]);
 		m[ind3] = min(m[ind3], m[pos2] + m[ind4]);
-		count = count + 2;
 	}
 	for(int j = 0; j < (2*k); j++){
 		//int ind3 = matpos2((2*k)^1,j);
@@ -194,8 +188,17 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		int ind4 = j + ki;
 		//m[n*2*k + j] = min(m[n*2*k + j], m[n*2*k + ((2*k)^1)] + m[n*((2*k)^1) + j]);
 		m[ind4] = min(m[ind4], m[pos1] + m[ind3]);
-		count = count + 2;
 	}
+}
+
+/******
+	Apply k-th iteration on the rows in [start, end), rows 2k and
+	(2k+1) are skipped. A row only reads itself, the pivot rows and
+	temp1, temp2, so disjoint ranges can be updated concurrently.
+******/
+static void floyd_warshall_dense_rows(double *m, double *temp1, double *temp2, int k, int n, int start, int end){
+	int ki = ((((2*k) + 1)*((2*k) + 1))/2);
+	int kki = (((((2*k)^1) + 1)*(((2*k)^1) + 1))/2);
 	double *p1 = m + kki;
 	double *p2 = m + ki;
 	int l = (2*k + 2);
@@ -208,7 +211,9 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		rest of elements, which is equivalent to 2k and (2k+1)-th
 		iteration in APRON strong closure algorithm.
 	********/
-	for(int i = 0; i < 2*k; i++){
+	int end1 = end < 2*k ? end : 2*k;
+	int start2 = start > 2*k + 2 ? start : 2*k + 2;
+	for(int i = start; i < end1; i++){
 		int i2 = (i%2==0) ? (i + 1): i;
 		int br = i2 < 2*k ? i2 : 2*k - 1;
 		//int ind1 = matpos2(i,2*k);
@@ -237,7 +242,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 			v_double_type res = v_min_double(op3, op4);
 			v_store_double(p + j*v_length, res);
 			//m[ind5] = min(m[ind5],op3 );
-			count = count + 4;
 		}
 			
 		for(int j = (br/v_length)*v_length; j<=br;j++){
@@ -271,7 +275,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 				//m[ind5] = min(m[ind5],op3 );
 				v_double_type res = v_min_double(op3, op4);
 				v_store_double(p + j*v_length, res);
-				count = count + 4;
 			}
 			for(int j = (i2/v_length)*v_length; j<=i2; j++){
 				int ind5 = j + (((i+1)*(i+1))/2);
@@ -284,7 +287,7 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 		//}
 	}
 
-	for(int i = 2*k + 2; i < n; i++){
+	for(int i = start2; i < end; i++){
 		int i2 = (i%2==0) ? (i + 1): i;
 		int br = i2 < 2*k ? i2 : 2*k - 1;
 		//int ind1 = matpos2(i,(2*k)^1);
@@ -323,7 +326,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 			//m[ind5] = min(m[ind5],op3 );
 			v_double_type res = v_min_double(op3,op4);
 			v_store_double(p + j*v_length,res);
-			count = count + 4;
 		}
 		for(int j = (br/v_length)*v_length; j<=br; j++){
 			int ind3 = j + kki;
@@ -333,7 +335,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 			double op2 = ft2 + m[ind4];
 			double op3 = min(op1, op2);
 			m[ind5] = min(m[ind5],op3 );
-			count = count + 4;
 		}
 		for(int j = 2*k + 2; j <= b; j++){
 			int ind5 = j + (((i+1)*(i+1))/2);
@@ -364,7 +365,6 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 				//m[ind5] = min(m[ind5],op3 );
 				v_double_type res = v_min_double(op3,op4);
 				v_store_double(p + j*v_length, res);
-				count = count + 4;
 			}
 			for(int j = (i2/v_length)*v_length; j <=i2; j++){
 				int ind5 = j + (((i+1)*(i+1))/2);
@@ -375,12 +375,271 @@ bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int d
 			}
 		}
 	}
-	
+}
+
+typedef struct floyd_warshall_dense_thread_t{
+	double *m;
+	double *temp1;
+	double *temp2;
+	int dim;
+	int start;
+	int end;
+	bool is_pivot;
+	opt_oct_barrier_t *barrier;
+}floyd_warshall_dense_thread_t;
+
+static void *floyd_warshall_dense_thread(void *args){
+	floyd_warshall_dense_thread_t *data = (floyd_warshall_dense_thread_t *)args;
+	double *m = data->m;
+	int n = 2*data->dim;
+	for(int k = 0; k < data->dim; k++){
+		if(data->is_pivot){
+			floyd_warshall_dense_pivot(m,data->temp1,data->temp2,k,n);
+		}
+		opt_oct_barrier_wait(data->barrier);
+		floyd_warshall_dense_rows(m,data->temp1,data->temp2,k,n,data->start,data->end);
+		opt_oct_barrier_wait(data->barrier);
+	}
+	return NULL;
+}
+
+/******
+	Every thread owns a fixed band of rows, the work of a row
+	grows linearly with its index so the band limits are chosen
+	to split the triangle into equal areas.
+******/
+static void floyd_warshall_dense_parallel(double *m, double *temp1, double *temp2, int dim, int num_threads){
+	int n = 2*dim;
+	floyd_warshall_dense_thread_t *args = (floyd_warshall_dense_thread_t *)malloc(num_threads*sizeof(floyd_warshall_dense_thread_t));
+	opt_oct_barrier_t barrier;
+	opt_oct_barrier_init(&barrier,num_threads);
+	int start = 0;
+	for(int t = 0; t < num_threads; t++){
+		int end = (t==num_threads-1) ? n : (int)(n*sqrt((double)(t+1)/num_threads));
+		end = end < start ? start : end;
+		args[t].m = m;
+		args[t].temp1 = temp1;
+		args[t].temp2 = temp2;
+		args[t].dim = dim;
+		args[t].start = start;
+		args[t].end = end;
+		args[t].is_pivot = (t==0);
+		args[t].barrier = &barrier;
+		start = end;
+	}
+	opt_oct_parallel_run(floyd_warshall_dense_thread,args,sizeof(floyd_warshall_dense_thread_t),num_threads);
+	opt_oct_barrier_destroy(&barrier);
+	free(args);
+}
+
+/******
+	Cache-blocked Floyd-Warshall for large matrices. The half
+	matrix is unpacked into a full coherent DBM of OPT_OCT_TILE x
+	OPT_OCT_TILE tiles. For every diagonal tile K the tile is closed,
+	then the column of tiles (I,K), and all other tiles only read
+	the final row and column. By coherence m[i][j] = m[j^1][i^1]
+	and a tile holds both 2k and 2k+1, so the row of tiles is a
+	mirror of the column and only tiles (I,J) with J <= I are
+	updated, tiles above the diagonal are rebuilt when needed.
+******/
+static inline void floyd_warshall_tile_row(double *q, double *p, double a, int j0, int j1){
+	v_double_type op1 = v_set1_double(a);
+	int j = j0;
+	for(; j + v_length <= j1; j += v_length){
+		v_double_type op2 = v_load_double(p + j);
+		v_double_type op3 = v_add_double(op1,op2);
+		v_double_type op4 = v_load_double(q + j);
+		v_store_double(q + j, v_min_double(op3,op4));
+	}
+	for(; j < j1; j++){
+		q[j] = min(q[j], a + p[j]);
+	}
+}
+
+/* tile [i0,i1)x[j0,j1) through pivots [k0,k1), in place for tiles sharing rows or columns with the pivots */
+static void floyd_warshall_tile_closure(double *f, int N, int i0, int i1, int j0, int j1, int k0, int k1){
+	for(int k = k0; k < k1; k++){
+		double *p = f + (size_t)k*N;
+		for(int i = i0; i < i1; i++){
+			double *q = f + (size_t)i*N;
+			floyd_warshall_tile_row(q,p,q[k],j0,j1);
+		}
+	}
+}
+
+/******
+	Tile [i0,i1)x[j0,j1) through pivots [k0,k1) whose row and column
+	tiles are final. Blocks of OPT_OCT_TILE_REG vectors of row i stay
+	in registers while the pivots are applied.
+******/
+static void floyd_warshall_tile_mult(double *f, int N, int i0, int i1, int j0, int j1, int k0, int k1){
+	const int w = OPT_OCT_TILE_REG*v_length;
+	for(int i = i0; i < i1; i++){
+		double *q = f + (size_t)i*N;
+		int j = j0;
+		for(; j + w <= j1; j += w){
+			v_double_type res[OPT_OCT_TILE_REG];
+			for(int r = 0; r < OPT_OCT_TILE_REG; r++){
+				res[r] = v_load_double(q + j + r*v_length);
+			}
+			for(int k = k0; k < k1; k++){
+				double a = q[k];
+				if(a==INFINITY){
+					continue;
+				}
+				v_double_type op1 = v_set1_double(a);
+				double *p = f + (size_t)k*N + j;
+				for(int r = 0; r < OPT_OCT_TILE_REG; r++){
+					v_double_type op3 = v_add_double(op1,v_load_double(p + r*v_length));
+					res[r] = v_min_double(op3,res[r]);
+				}
+			}
+			for(int r = 0; r < OPT_OCT_TILE_REG; r++){
+				v_store_double(q + j + r*v_length, res[r]);
+			}
+		}
+		if(j < j1){
+			for(int k = k0; k < k1; k++){
+				double a = q[k];
+				if(a==INFINITY){
+					continue;
+				}
+				floyd_warshall_tile_row(q,f + (size_t)k*N,a,j,j1);
+			}
+		}
+	}
+}
+
+/* rebuild tile [i0,i1)x[j0,j1) from the coherent tile */
+static void floyd_warshall_tile_coherent(double *f, int N, int i0, int i1, int j0, int j1){
+	for(int i = i0; i < i1; i++){
+		double *q = f + (size_t)i*N;
+		for(int j = j0; j < j1; j++){
+			q[j] = f[(size_t)(j^1)*N + (i^1)];
+		}
+	}
+}
+
+typedef struct floyd_warshall_tiled_thread_t{
+	double *f;
+	int N;
+	int tid;
+	int num_threads;
+	opt_oct_barrier_t *barrier;
+}floyd_warshall_tiled_thread_t;
+
+static void *floyd_warshall_tiled_thread(void *args){
+	floyd_warshall_tiled_thread_t *data = (floyd_warshall_tiled_thread_t *)args;
+	double *f = data->f;
+	int N = data->N;
+	int tid = data->tid, num_threads = data->num_threads;
+	int nt = (N + OPT_OCT_TILE - 1)/OPT_OCT_TILE;
+	#define TILE_END(T) ((T)*OPT_OCT_TILE + OPT_OCT_TILE < N ? (T)*OPT_OCT_TILE + OPT_OCT_TILE : N)
+	for(int K = 0; K < nt; K++){
+		int k0 = K*OPT_OCT_TILE, k1 = TILE_END(K);
+		for(int I = tid; I < K; I += num_threads){
+			floyd_warshall_tile_coherent(f,N,I*OPT_OCT_TILE,TILE_END(I),k0,k1);
+		}
+		if(tid==0){
+			floyd_warshall_tile_closure(f,N,k0,k1,k0,k1,k0,k1);
+		}
+		opt_oct_barrier_wait(data->barrier);
+		for(int I = tid; I < nt; I += num_threads){
+			if(I!=K){
+				floyd_warshall_tile_closure(f,N,I*OPT_OCT_TILE,TILE_END(I),k0,k1,k0,k1);
+			}
+		}
+		opt_oct_barrier_wait(data->barrier);
+		for(int J = tid; J < nt; J += num_threads){
+			if(J!=K){
+				floyd_warshall_tile_coherent(f,N,k0,k1,J*OPT_OCT_TILE,TILE_END(J));
+			}
+		}
+		opt_oct_barrier_wait(data->barrier);
+		int t = 0;
+		for(int I = 0; I < nt; I++){
+			for(int J = 0; J <= I; J++){
+				if(I==K || J==K){
+					continue;
+				}
+				if(t++ % num_threads==tid){
+					floyd_warshall_tile_mult(f,N,I*OPT_OCT_TILE,TILE_END(I),J*OPT_OCT_TILE,TILE_END(J),k0,k1);
+				}
+			}
+		}
+		opt_oct_barrier_wait(data->barrier);
+	}
+	#undef TILE_END
+	return NULL;
+}
+
+static bool floyd_warshall_dense_tiled(double *m, int dim, int num_threads){
+	int N = 2*dim;
+	double *f = (double *)malloc((size_t)N*N*sizeof(double));
+	if(f==NULL){
+		return false;
+	}
+	for(int i = 0; i < N; i++){
+		double *q = f + (size_t)i*N;
+		int br = i|1;
+		for(int j = 0; j <= br; j++){
+			q[j] = m[j + (((i+1)*(i+1))/2)];
+		}
+		for(int j = br + 1; j < N; j++){
+			q[j] = m[(i^1) + ((((j^1)+1)*((j^1)+1))/2)];
+		}
+	}
+	int nt = (N + OPT_OCT_TILE - 1)/OPT_OCT_TILE;
+	num_threads = num_threads < nt ? num_threads : nt;
+	num_threads = num_threads < 1 ? 1 : num_threads;
+	floyd_warshall_tiled_thread_t *args = (floyd_warshall_tiled_thread_t *)malloc(num_threads*sizeof(floyd_warshall_tiled_thread_t));
+	opt_oct_barrier_t barrier;
+	opt_oct_barrier_init(&barrier,num_threads);
+	for(int t = 0; t < num_threads; t++){
+		args[t].f = f;
+		args[t].N = N;
+		args[t].tid = t;
+		args[t].num_threads = num_threads;
+		args[t].barrier = &barrier;
+	}
+	opt_oct_parallel_run(floyd_warshall_tiled_thread,args,sizeof(floyd_warshall_tiled_thread_t),num_threads);
+	opt_oct_barrier_destroy(&barrier);
+	free(args);
+	/* the half matrix lies in the tiles on and below the diagonal */
+	for(int i = 0; i < N; i++){
+		double *q = f + (size_t)i*N;
+		int br = i|1;
+		for(int j = 0; j <= br; j++){
+			m[j + (((i+1)*(i+1))/2)] = q[j];
+		}
+	}
+	free(f);
+	return true;
+}
+
+bool floyd_warshall_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int dim, bool is_int, int num_threads){
+    double *m = oo->mat;
+    int n = 2*dim;
+    if(dim >= OPT_OCT_TILE_MIN_DIM && floyd_warshall_dense_tiled(m,dim,num_threads)){
+	return false;
+    }
+    if(num_threads > 1 && dim >= OPT_OCT_PAR_MIN_DIM){
+	floyd_warshall_dense_parallel(m,temp1,temp2,dim,num_threads);
+	return false;
     }
+    /******
+		Floyd Warshall step
+    *******/
+    for(int k = 0; k < dim; k++){
+	floyd_warshall_dense_pivot(m,temp1,temp2,k,n);
+	floyd_warshall_dense_rows(m,temp1,temp2,k,n,0,n);
+    }
+    return false;
 }
 
-bool strong_closure_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int dim, bool is_int){
-    floyd_warshall_dense(oo,temp1,temp2,dim,is_int);
+
+bool strong_closure_dense(opt_oct_mat_t *oo, double *temp1, double *temp2, int dim, bool is_int, int num_threads){
+    floyd_warshall_dense(oo,temp1,temp2,dim,is_int,num_threads);
     int n = 2*dim;
     oo->nni = 2*dim*(dim+1);
     if(is_int){
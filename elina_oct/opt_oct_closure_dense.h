@@ -30,12 +30,21 @@ extern "C" {
 #include <immintrin.h>
 #include "vector_intrin.h"
 
+/* tile size of the blocked closure, even and a multiple of v_length */
+#define OPT_OCT_TILE 64
+
+/* vectors of a tile row kept in registers by the tile update */
+#define OPT_OCT_TILE_REG 8
+
+/* matrices of at least this dimension are closed tile by tile */
+#define OPT_OCT_TILE_MIN_DIM 256
+
 void print_dense(double *m, int dim);
 
 double strong_closure_calc_perf_dense(double cycles, int dim);
-bool strong_closure_dense(opt_oct_mat_t *m, double * temp1, double *temp2, int dim, bool is_int);
+bool strong_closure_dense(opt_oct_mat_t *m, double * temp1, double *temp2, int dim, bool is_int, int num_threads);
 bool strengthning_int_dense(opt_oct_mat_t * result, double *temp, int n);
-bool floyd_warshall_dense(opt_oct_mat_t *m, double * temp1, double *temp2, int dim, bool is_int);
+bool floyd_warshall_dense(opt_oct_mat_t *m, double * temp1, double *temp2, int dim, bool is_int, int num_threads);
 bool strengthning_dense(opt_oct_mat_t * result, double *temp, int n);
 
 #ifdef __cplusplus
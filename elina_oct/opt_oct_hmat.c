@@ -55,6 +55,8 @@ opt_oct_mat_t* opt_hmat_alloc(int size){
 	double *m = (double *)malloc(size*sizeof(double));
 	opt_oct_mat_t *oo= (opt_oct_mat_t *)malloc(sizeof(opt_oct_mat_t));
 	oo->mat = m;
+	oo->blocks = NULL;
+	oo->num_blocks = 0;
 	oo->nni = 0;
 	oo->acl = create_array_comp_list();
 	oo->is_dense = false;
@@ -70,6 +72,7 @@ void opt_hmat_free(opt_oct_mat_t *oo){
 		start_timing();
 	#endif
         free(oo->mat);
+	opt_hmat_release_blocks(oo);
 	if(!oo->is_dense){
 		free_array_comp_list(oo->acl);
 	}
@@ -148,6 +151,8 @@ opt_oct_mat_t * opt_hmat_alloc_top(int dim){
 	assert(m);
 	opt_oct_mat_t * oo = (opt_oct_mat_t *)malloc(sizeof(opt_oct_mat_t));
 	oo->mat = m;
+	oo->blocks = NULL;
+	oo->num_blocks = 0;
 	oo->nni = 2*dim;
 	oo->acl = create_array_comp_list();
 	oo->is_dense = false;
@@ -168,6 +173,9 @@ opt_oct_mat_t *opt_hmat_copy(opt_oct_mat_t * src_mat, int dim){
 	if(!src_mat){
 		return NULL;
 	}
+	if(!src_mat->mat){
+		return opt_hmat_copy_packed(src_mat,dim);
+	}
 	#if defined(TIMING)
 		start_timing();
 	#endif
@@ -231,6 +239,11 @@ opt_oct_mat_t *opt_hmat_copy(opt_oct_mat_t * src_mat, int dim){
 	}	
 	
 	dst_mat->mat = dest;
+	dst_mat->blocks = NULL;
+	dst_mat->num_blocks = 0;
+	if(!src_mat->is_dense){
+		opt_hmat_share_blocks(dst_mat,src_mat);
+	}
 	dst_mat->nni = src_mat->nni;
   	dst_mat->is_dense = src_mat->is_dense;
 	dst_mat->is_top = src_mat->is_top;
@@ -246,6 +259,311 @@ opt_oct_mat_t *opt_hmat_copy(opt_oct_mat_t * src_mat, int dim){
 	return dst_mat;
 }
 
+/******
+	Packed storage of decomposed octagons. Every independent
+	component keeps its own half-DBM over its sorted variables in a
+	reference counted block, the blocks are sorted by the smallest
+	variable of the component. The relations between components are
+	top, only O(sum of comp_size^2) doubles are kept. Operators work
+	on the half matrix, which opt_hmat_unpack rebuilds.
+
+	Blocks are never written once built. Copies of a packed matrix
+	share all of them, and an unpacked matrix and its copies keep
+	the blocks it was rebuilt from, so that packing shares every
+	block whose component and values did not change.
+******/
+size_t opt_hmat_packed_size(opt_oct_mat_t *oo){
+	size_t size = 0;
+	comp_list_t * cl = oo->acl->head;
+	while(cl!=NULL){
+		size = size + 2*(size_t)cl->size*(cl->size + 1);
+		cl = cl->next;
+	}
+	return size;
+}
+
+static void opt_block_free(opt_oct_block_t *b){
+	b->count--;
+	if(b->count==0){
+		free(b->ca);
+		if(!b->mapped){
+			free(b->data);
+		}
+		free(b);
+	}
+}
+
+void opt_hmat_release_blocks(opt_oct_mat_t *oo){
+	for(int l = 0; l < oo->num_blocks; l++){
+		opt_block_free(oo->blocks[l]);
+	}
+	free(oo->blocks);
+	oo->blocks = NULL;
+	oo->num_blocks = 0;
+}
+
+void opt_hmat_share_blocks(opt_oct_mat_t *dst, opt_oct_mat_t *src){
+	dst->num_blocks = src->num_blocks;
+	dst->blocks = NULL;
+	if(!src->num_blocks){
+		return;
+	}
+	dst->blocks = (opt_oct_block_t **)malloc(src->num_blocks*sizeof(opt_oct_block_t *));
+	for(int l = 0; l < src->num_blocks; l++){
+		dst->blocks[l] = src->blocks[l];
+		dst->blocks[l]->count++;
+	}
+}
+
+/* copy a block from the half matrix m to p or back, or compare them */
+static bool opt_block_move(double *m, double *p, unsigned short int *ca, unsigned short int comp_size, int op){
+	for(int i = 0; i < 2*comp_size; i++){
+		int i1 = 2*ca[i/2] + (i&1);
+		double *row = m + (((i1 + 1)*(i1 + 1))/2);
+		for(int j = 0; j <= (i|1); j++){
+			int j1 = 2*ca[j/2] + (j&1);
+			if(op==0){
+				*p = row[j1];
+			}
+			else if(op==1){
+				row[j1] = *p;
+			}
+			else if(row[j1]!=*p){
+				return false;
+			}
+			p++;
+		}
+	}
+	return true;
+}
+
+static int cmp_block_first(const void *a, const void *b){
+	unsigned short int ia = (*(opt_oct_block_t * const *)a)->ca[0];
+	unsigned short int ib = (*(opt_oct_block_t * const *)b)->ca[0];
+	return (ia > ib) - (ia < ib);
+}
+
+/* blocks of the components of m, taken from ref when unchanged */
+static opt_oct_block_t ** opt_hmat_make_blocks(double *m, array_comp_list_t *acl, opt_oct_block_t **ref, int num_ref, int dim, int *num_blocks){
+	int num_comp = 0;
+	comp_list_t * cl = acl->head;
+	while(cl!=NULL){
+		num_comp = num_comp + (cl->size > 0);
+		cl = cl->next;
+	}
+	opt_oct_block_t ** blocks = (opt_oct_block_t **)malloc(num_comp*sizeof(opt_oct_block_t *));
+	num_comp = 0;
+	cl = acl->head;
+	while(cl!=NULL){
+		if(cl->size){
+			opt_oct_block_t *b = (opt_oct_block_t *)malloc(sizeof(opt_oct_block_t));
+			b->count = 1;
+			b->size = cl->size;
+			b->ca = to_sorted_array(cl,dim);
+			b->data = NULL;
+			b->mapped = false;
+			blocks[num_comp++] = b;
+		}
+		cl = cl->next;
+	}
+	qsort(blocks,num_comp,sizeof(opt_oct_block_t *),cmp_block_first);
+	int r = 0;
+	for(int l = 0; l < num_comp; l++){
+		opt_oct_block_t *b = blocks[l];
+		while(r < num_ref && ref[r]->ca[0] < b->ca[0]){
+			r++;
+		}
+		if(r < num_ref && ref[r]->size==b->size && !memcmp(ref[r]->ca,b->ca,b->size*sizeof(unsigned short int)) &&
+		   opt_block_move(m,ref[r]->data,b->ca,b->size,2)){
+			opt_block_free(b);
+			blocks[l] = ref[r];
+			ref[r]->count++;
+			continue;
+		}
+		b->data = (double *)malloc(2*(size_t)b->size*(b->size + 1)*sizeof(double));
+		opt_block_move(m,b->data,b->ca,b->size,0);
+	}
+	*num_blocks = num_comp;
+	return blocks;
+}
+
+opt_oct_mat_t *opt_hmat_copy_packed(opt_oct_mat_t * src_mat, int dim){
+	if(!src_mat){
+		return NULL;
+	}
+	if(src_mat->is_dense){
+		return opt_hmat_copy(src_mat,dim);
+	}
+	#if defined(TIMING)
+		start_timing();
+	#endif
+	opt_oct_mat_t * dst_mat = (opt_oct_mat_t *)malloc(sizeof(opt_oct_mat_t));
+	dst_mat->mat = NULL;
+	if(src_mat->mat){
+		dst_mat->blocks = opt_hmat_make_blocks(src_mat->mat,src_mat->acl,src_mat->blocks,src_mat->num_blocks,dim,&dst_mat->num_blocks);
+	}
+	else{
+		opt_hmat_share_blocks(dst_mat,src_mat);
+	}
+	dst_mat->nni = src_mat->nni;
+	dst_mat->is_dense = false;
+	dst_mat->ti = false;
+	dst_mat->is_top = src_mat->is_top;
+	dst_mat->acl = copy_array_comp_list(src_mat->acl);
+	#if defined(TIMING)
+		record_timing(copy_time);
+	#endif
+	return dst_mat;
+}
+
+void opt_hmat_pack(opt_oct_mat_t *oo, int dim){
+	if(!oo->mat || oo->is_dense){
+		return;
+	}
+	int num_blocks;
+	opt_oct_block_t ** blocks = opt_hmat_make_blocks(oo->mat,oo->acl,oo->blocks,oo->num_blocks,dim,&num_blocks);
+	opt_hmat_release_blocks(oo);
+	oo->blocks = blocks;
+	oo->num_blocks = num_blocks;
+	free(oo->mat);
+	oo->mat = NULL;
+	oo->ti = false;
+}
+
+void opt_hmat_unpack(opt_oct_mat_t *oo, int dim){
+	if(oo->mat){
+		return;
+	}
+	oo->mat = (double *)malloc(2*dim*(dim + 1)*sizeof(double));
+	for(int l = 0; l < oo->num_blocks; l++){
+		opt_oct_block_t *b = oo->blocks[l];
+		opt_block_move(oo->mat,b->data,b->ca,b->size,1);
+	}
+}
+
+/******
+	Raw serialization. A dense matrix is written as a whole, a decomposed
+	one as its component list followed by the block of every component,
+	in list order. Offsets of the doubles are multiples of 8 from the
+	start of the record, so that mapped blocks can point into the buffer.
+******/
+static size_t opt_raw_align(size_t idx){
+	return (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+}
+
+size_t opt_hmat_serialize_common(void *dst, opt_oct_mat_t *oo, int dim, bool dry_run){
+	size_t idx = 0;
+	if(!dry_run){
+		*(bool*)(dst + idx) = oo->is_dense;
+	}
+	idx += sizeof(bool);
+
+	if(!dry_run){
+		*(bool*)(dst + idx) = oo->is_top;
+	}
+	idx += sizeof(bool);
+
+	if(!dry_run){
+		*(int*)(dst + idx) = oo->nni;
+	}
+	idx += sizeof(int);
+
+	if(oo->is_dense){
+		size_t size = 2*(size_t)dim*(dim + 1)*sizeof(double);
+		idx = opt_raw_align(idx);
+		if(!dry_run){
+			memcpy(dst + idx,oo->mat,size);
+		}
+		return idx + size;
+	}
+	idx += array_comp_list_serialize_common(dst + idx,oo->acl,dry_run);
+	idx = opt_raw_align(idx);
+	comp_list_t * cl = oo->acl->head;
+	while(cl!=NULL){
+		size_t size = 2*(size_t)cl->size*(cl->size + 1)*sizeof(double);
+		if(!dry_run && cl->size){
+			unsigned short int * ca = to_sorted_array(cl,dim);
+			if(oo->mat){
+				opt_block_move(oo->mat,dst + idx,ca,cl->size,0);
+			}
+			else{
+				opt_oct_block_t key, *kp = &key;
+				key.ca = ca;
+				opt_oct_block_t **b = (opt_oct_block_t **)bsearch(&kp,oo->blocks,oo->num_blocks,sizeof(opt_oct_block_t *),cmp_block_first);
+				memcpy(dst + idx,(*b)->data,size);
+			}
+			free(ca);
+		}
+		idx += size;
+		cl = cl->next;
+	}
+	return idx;
+}
+
+/* decomposed matrices come back packed, their blocks point into p when mapped */
+opt_oct_mat_t *opt_hmat_deserialize(void *p, int dim, bool mapped, size_t *size){
+	opt_oct_mat_t * oo = (opt_oct_mat_t *)malloc(sizeof(opt_oct_mat_t));
+	size_t idx = 0;
+
+	oo->is_dense = *(bool*)(p + idx);
+	idx += sizeof(bool);
+
+	oo->is_top = *(bool*)(p + idx);
+	idx += sizeof(bool);
+
+	oo->nni = *(int*)(p + idx);
+	idx += sizeof(int);
+
+	oo->blocks = NULL;
+	oo->num_blocks = 0;
+	if(oo->is_dense){
+		size_t mat_size = 2*(size_t)dim*(dim + 1)*sizeof(double);
+		idx = opt_raw_align(idx);
+		oo->mat = (double *)malloc(mat_size);
+		memcpy(oo->mat,p + idx,mat_size);
+		oo->acl = NULL;
+		oo->ti = true;
+		*size = idx + mat_size;
+		return oo;
+	}
+	size_t acl_size;
+	oo->acl = array_comp_list_deserialize(p + idx,&acl_size);
+	idx = opt_raw_align(idx + acl_size);
+	comp_list_t * cl = oo->acl->head;
+	while(cl!=NULL){
+		oo->num_blocks = oo->num_blocks + (cl->size > 0);
+		cl = cl->next;
+	}
+	oo->blocks = (opt_oct_block_t **)malloc(oo->num_blocks*sizeof(opt_oct_block_t *));
+	int l = 0;
+	cl = oo->acl->head;
+	while(cl!=NULL){
+		size_t block_size = 2*(size_t)cl->size*(cl->size + 1)*sizeof(double);
+		if(cl->size){
+			opt_oct_block_t *b = (opt_oct_block_t *)malloc(sizeof(opt_oct_block_t));
+			b->count = 1;
+			b->size = cl->size;
+			b->ca = to_sorted_array(cl,dim);
+			b->mapped = mapped;
+			if(mapped){
+				b->data = (double *)(p + idx);
+			}
+			else{
+				b->data = (double *)malloc(block_size);
+				memcpy(b->data,p + idx,block_size);
+			}
+			oo->blocks[l++] = b;
+		}
+		idx += block_size;
+		cl = cl->next;
+	}
+	qsort(oo->blocks,oo->num_blocks,sizeof(opt_oct_block_t *),cmp_block_first);
+	oo->mat = NULL;
+	oo->ti = false;
+	*size = idx;
+	return oo;
+}
+
 void opt_hmat_set_array(double *dest, double *src, int size){
 	if(!src){
 		return;
@@ -287,7 +605,7 @@ double recalculate_sparsity(opt_oct_mat_t *oo, int dim){
 	Perform strong closure.
 *****/
 
-bool opt_hmat_strong_closure(opt_oct_mat_t *oo, int dim){
+bool opt_hmat_strong_closure(opt_oct_mat_t *oo, int dim, int num_threads){
 	#if defined(TIMING)
 		start_timing();
 	#endif
@@ -315,7 +633,7 @@ bool opt_hmat_strong_closure(opt_oct_mat_t *oo, int dim){
 		
 		ind1 = (unsigned short int *)calloc(2*(2*dim + 1),sizeof(unsigned short int));
 		ind2 = (unsigned short int *)calloc(2*(2*dim + 1),sizeof(unsigned short int));
-		res = strong_closure_comp_sparse(oo,temp1,temp2,ind1,ind2,dim,flag);
+		res = strong_closure_comp_sparse(oo,temp1,temp2,ind1,ind2,dim,flag,num_threads);
 		free(ind1);
 		ind1 = NULL;
 		free(ind2);
@@ -341,7 +659,7 @@ bool opt_hmat_strong_closure(opt_oct_mat_t *oo, int dim){
 			}
 			ind1 = (unsigned short int *)calloc(2*(2*dim + 1),sizeof(unsigned short int));
 			ind2 = (unsigned short int *)calloc(2*(2*dim + 1),sizeof(unsigned short int));
-			res = strong_closure_comp_sparse(oo,temp1,temp2,ind1, ind2,dim, flag);
+			res = strong_closure_comp_sparse(oo,temp1,temp2,ind1, ind2,dim, flag, num_threads);
 			free(ind1);
 			ind1 = NULL;
 			free(ind2);
@@ -368,7 +686,7 @@ bool opt_hmat_strong_closure(opt_oct_mat_t *oo, int dim){
 			}
 			
 			#if defined(VECTOR)
-				res = strong_closure_dense(oo,temp1,temp2,dim, flag);
+				res = strong_closure_dense(oo,temp1,temp2,dim, flag, num_threads);
 			#else
 				res = strong_closure_dense_scalar(oo,temp1,temp2,dim, flag);
 			#endif
@@ -93,8 +93,16 @@ extern "C" {
 void opt_hmat_free(opt_oct_mat_t *m);
 opt_oct_mat_t * opt_hmat_alloc_top(int dim);
 opt_oct_mat_t *opt_hmat_copy(opt_oct_mat_t * src, int size);
+opt_oct_mat_t *opt_hmat_copy_packed(opt_oct_mat_t * src, int dim);
+size_t opt_hmat_packed_size(opt_oct_mat_t *oo);
+void opt_hmat_pack(opt_oct_mat_t *oo, int dim);
+void opt_hmat_unpack(opt_oct_mat_t *oo, int dim);
+void opt_hmat_release_blocks(opt_oct_mat_t *oo);
+size_t opt_hmat_serialize_common(void *dst, opt_oct_mat_t *oo, int dim, bool dry_run);
+opt_oct_mat_t *opt_hmat_deserialize(void *p, int dim, bool mapped, size_t *size);
+void opt_hmat_share_blocks(opt_oct_mat_t *dst, opt_oct_mat_t *src);
 void opt_hmat_set_array(double *dest, double *src, int size);
-bool opt_hmat_strong_closure(opt_oct_mat_t *m, int dim);
+bool opt_hmat_strong_closure(opt_oct_mat_t *m, int dim, int num_threads);
 bool is_top_half(opt_oct_mat_t *m, int dim);
 bool is_equal_half(opt_oct_mat_t *m1, opt_oct_mat_t *m2, int dim);
 bool is_lequal_half(opt_oct_mat_t *m1, opt_oct_mat_t *m2, int dim);
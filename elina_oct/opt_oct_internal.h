@@ -104,12 +104,28 @@ typedef struct opt_oct_internal_t{
   */
   bool conv;
 
+  /* threads used by the strong closure, 1 closes sequentially */
+  int num_threads;
+
   /* pointer to elina_manager*/
   elina_manager_t* man;
 }opt_oct_internal_t;
 
+/* half-DBM of one independent component, shared between matrices */
+typedef struct opt_oct_block_t{
+	size_t count;  /* reference counter */
+	unsigned short int size;  /* number of variables */
+	unsigned short int *ca;  /* sorted variables */
+	double *data;
+	bool mapped;  /* data points into a buffer given to opt_oct_map_raw */
+}opt_oct_block_t;
+
 typedef struct opt_oct_mat_t{
 	double *mat;
+	/* component blocks sorted by first variable, they are the matrix
+	   while mat is NULL, otherwise a snapshot that packing may share */
+	opt_oct_block_t **blocks;
+	int num_blocks;
 	array_comp_list_t *acl;
 	int nni;
 	bool is_top;
@@ -464,6 +480,7 @@ opt_oct_t* opt_oct_top(elina_manager_t* man, int intdim, int realdim);
 opt_oct_t* opt_oct_of_box(elina_manager_t* man, size_t intdim, size_t realdim, elina_interval_t ** t);
 elina_dimension_t opt_oct_dimension(elina_manager_t* man, opt_oct_t* o);
 void opt_oct_cache_closure(opt_oct_internal_t *pr, opt_oct_t *o);
+void opt_oct_unpack(opt_oct_t *o);
 void opt_oct_close(opt_oct_internal_t *pr, opt_oct_t *o);
 opt_oct_t* opt_oct_closure(elina_manager_t *man, bool destructive, opt_oct_t *o);
 void opt_oct_internal_free(opt_oct_internal_t *pr);
@@ -473,6 +490,9 @@ void opt_oct_minimize(elina_manager_t* man, opt_oct_t* o);
 void opt_oct_canonicalize(elina_manager_t* man, opt_oct_t* o);
 int opt_oct_hash(elina_manager_t* man, opt_oct_t* o);
 void opt_oct_approximate(elina_manager_t* man, opt_oct_t* o, int algorithm);
+elina_membuf_t opt_oct_serialize_raw(elina_manager_t* man, opt_oct_t* o);
+opt_oct_t* opt_oct_deserialize_raw(elina_manager_t* man, void* p, size_t* size);
+opt_oct_t* opt_oct_map_raw(elina_manager_t* man, void* p, size_t* size);
 
 
 /**************
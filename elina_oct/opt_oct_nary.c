@@ -29,6 +29,8 @@ opt_oct_t* opt_oct_meet(elina_manager_t* man, bool destructive, opt_oct_t* o1, o
 {
   
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_MEET,0);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
   opt_oct_mat_t* oo;
   
    if((o1->dim != o2->dim) || (o1->intdim != o2->intdim))return NULL;
@@ -41,6 +43,7 @@ opt_oct_t* opt_oct_meet(elina_manager_t* man, bool destructive, opt_oct_t* o1, o
     opt_oct_mat_t * oo2 = o2->closed ? o2->closed : o2->m;
     oo = destructive ? oo1 : opt_hmat_alloc(size);
     meet_half(oo,oo1,oo2,o1->dim,destructive);
+    if (!destructive) opt_hmat_share_blocks(oo,oo1);
     /* optimal, but not closed */
     return opt_oct_set_mat(pr,o1,oo,NULL,destructive);
   }
@@ -60,6 +63,8 @@ opt_oct_t* opt_oct_join(elina_manager_t* man, bool destructive, opt_oct_t* o1, o
   elina_lincons0_array_clear(&arr2);
   fflush(stdout);*/
  opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_JOIN,0);
+ opt_oct_unpack(o1);
+ opt_oct_unpack(o2);
  
  if((o1->dim != o2->dim) || (o1->intdim != o2->intdim))return NULL;
  int size = 2*(o1->dim)*(o1->dim + 1);
@@ -91,6 +96,7 @@ opt_oct_t* opt_oct_join(elina_manager_t* man, bool destructive, opt_oct_t* o1, o
    size_t i;
    man->result.flag_exact = false;
    join_half(oo,oo1,oo2,o1->dim,destructive);
+   if (!destructive) opt_hmat_share_blocks(oo,oo1);
    opt_oct_t *r = NULL;
    if (o1->closed && o2->closed) {
      /* result is closed and optimal on Q */
@@ -127,6 +133,7 @@ opt_oct_t* opt_oct_join_array(elina_manager_t* man, opt_oct_t** tab, size_t size
   if(size <= 0){
 	return NULL;
   }
+  for (i=0;i<size;i++) opt_oct_unpack(tab[i]);
   r = opt_oct_alloc_internal(pr,tab[0]->dim,tab[0]->intdim);
   for (k=0;k<size;k++) {
     if((tab[k]->dim != r->dim) || (tab[k]->intdim != r->intdim)){
@@ -175,6 +182,7 @@ opt_oct_t* opt_oct_meet_array(elina_manager_t* man, opt_oct_t** tab, size_t size
   if(size <= 0){
 	return NULL;
   }
+  for (i=0;i<size;i++) opt_oct_unpack(tab[i]);
   r = opt_oct_alloc_internal(pr,tab[0]->dim,tab[0]->intdim);
   /* check whether there is an empty element */
   for (k=0;k<size;k++)
@@ -207,6 +215,8 @@ opt_oct_t* opt_oct_widening(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
   elina_lincons0_array_clear(&arr2);
   fflush(stdout);*/
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_WIDENING,0);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
   int algo = pr->funopt->algorithm;
   opt_oct_t* r;
   
@@ -239,6 +249,7 @@ opt_oct_t* opt_oct_widening(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
       /* standard widening */
         widening_half(r->m,oo1,oo2,o1->dim);
     }
+    opt_hmat_share_blocks(r->m,oo1);
   }
   /*printf("Widening OUTPUT\n");
   elina_lincons0_array_t arr3 = opt_oct_to_lincons_array(man,r);
@@ -254,6 +265,8 @@ opt_oct_t* opt_oct_widening(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
 opt_oct_t* opt_oct_widening_thresholds(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2, elina_scalar_t** array, size_t nb)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_WIDENING,nb+1);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
   int algo = pr->funopt->algorithm;
   opt_oct_t* r;
   if((o1->dim != o2->dim) || (o1->intdim != o2->intdim)){
@@ -278,6 +291,7 @@ opt_oct_t* opt_oct_widening_thresholds(elina_manager_t* man, opt_oct_t* o1, opt_
     }
     pr->tmp[nb] = INFINITY;
     widening_thresholds_half(r->m,oo1,oo2,pr->tmp,nb,r->dim);
+    opt_hmat_share_blocks(r->m,oo1);
   }
   return r;
 }
@@ -289,6 +303,8 @@ opt_oct_t* opt_oct_widening_thresholds(elina_manager_t* man, opt_oct_t* o1, opt_
 opt_oct_t* opt_oct_narrowing(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_WIDENING,0);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
   opt_oct_t* r;
   if((o1->dim != o2->dim) && (o1->intdim != o2->intdim)){
 	return NULL;
@@ -353,6 +369,7 @@ elina_abstract0_t* elina_abstract0_opt_oct_narrowing( elina_manager_t* man,
 opt_oct_t* opt_oct_add_epsilon(elina_manager_t* man, opt_oct_t* o, elina_scalar_t* epsilon)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_WIDENING,2);
+  opt_oct_unpack(o);
   opt_oct_t* r = opt_oct_alloc_internal(pr,o->dim,o->intdim);
   opt_oct_mat_t * oo;
   oo = o->m ? o->m : o->closed;
@@ -491,6 +508,8 @@ opt_oct_t* opt_oct_add_epsilon_bin(elina_manager_t* man, opt_oct_t* o1, opt_oct_
 			   elina_scalar_t* epsilon)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_WIDENING,2);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
   opt_oct_t* r;
   if((o1->dim!=o2->dim) || (o1->intdim!=o2->intdim)){
 	return NULL;
@@ -0,0 +1,109 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+#include <stdlib.h>
+#include <assert.h>
+#include <fenv.h>
+#include <unistd.h>
+#include "opt_oct_parallel.h"
+
+typedef struct opt_oct_task_t{
+	void *(*function)(void *);
+	void *args;
+	int rounding;
+}opt_oct_task_t;
+
+/******
+	Counting barrier, pthread_barrier_t is not available on every
+	platform ELINA builds on.
+******/
+void opt_oct_barrier_init(opt_oct_barrier_t *barrier, int count){
+	pthread_mutex_init(&barrier->mutex, NULL);
+	pthread_cond_init(&barrier->cond, NULL);
+	barrier->count = count;
+	barrier->waiting = 0;
+	barrier->generation = 0;
+}
+
+void opt_oct_barrier_wait(opt_oct_barrier_t *barrier){
+	pthread_mutex_lock(&barrier->mutex);
+	unsigned long generation = barrier->generation;
+	barrier->waiting++;
+	if(barrier->waiting==barrier->count){
+		barrier->waiting = 0;
+		barrier->generation++;
+		pthread_cond_broadcast(&barrier->cond);
+	}
+	else{
+		while(generation==barrier->generation){
+			pthread_cond_wait(&barrier->cond, &barrier->mutex);
+		}
+	}
+	pthread_mutex_unlock(&barrier->mutex);
+}
+
+void opt_oct_barrier_destroy(opt_oct_barrier_t *barrier){
+	pthread_mutex_destroy(&barrier->mutex);
+	pthread_cond_destroy(&barrier->cond);
+}
+
+int opt_oct_num_online_cpus(void){
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return num_cpus < 1 ? 1 : (int)num_cpus;
+}
+
+static void *opt_oct_task_run(void *args){
+	opt_oct_task_t *task = (opt_oct_task_t *)args;
+	/* the closure is only sound with the rounding mode of the caller */
+	if(fegetround()!=task->rounding){
+		fesetround(task->rounding);
+	}
+	return task->function(task->args);
+}
+
+/******
+	Run function on num_threads threads, thread t gets
+	args + t*arg_size. The calling thread runs t = 0.
+******/
+void opt_oct_parallel_run(void *(*function)(void *), void *args, size_t arg_size, int num_threads){
+	if(num_threads <= 1){
+		function(args);
+		return;
+	}
+	pthread_t *threads = (pthread_t *)malloc((num_threads - 1)*sizeof(pthread_t));
+	opt_oct_task_t *tasks = (opt_oct_task_t *)malloc((num_threads - 1)*sizeof(opt_oct_task_t));
+	assert(threads && tasks);
+	int rounding = fegetround();
+	for(int t = 1; t < num_threads; t++){
+		opt_oct_task_t *task = tasks + t - 1;
+		task->function = function;
+		task->args = (char *)args + t*arg_size;
+		task->rounding = rounding;
+		int rc = pthread_create(threads + t - 1, NULL, opt_oct_task_run, task);
+		assert(rc==0);
+	}
+	function(args);
+	for(int t = 1; t < num_threads; t++){
+		pthread_join(threads[t - 1], NULL);
+	}
+	free(tasks);
+	free(threads);
+}
@@ -0,0 +1,65 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+#ifndef __OPT_OCT_PARALLEL_H_INCLUDED__
+#define __OPT_OCT_PARALLEL_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <pthread.h>
+
+/******
+	Closures with fewer min-plus updates than this
+	are not worth starting threads for.
+******/
+#define OPT_OCT_PAR_MIN_WORK (1<<21)
+
+/******
+	The dense Floyd-Warshall synchronizes its threads twice
+	per iteration, rows are only distributed for matrices
+	of at least this dimension.
+******/
+#define OPT_OCT_PAR_MIN_DIM 128
+
+typedef struct opt_oct_barrier_t{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+	int waiting;
+	unsigned long generation;
+}opt_oct_barrier_t;
+
+void opt_oct_barrier_init(opt_oct_barrier_t *barrier, int count);
+void opt_oct_barrier_wait(opt_oct_barrier_t *barrier);
+void opt_oct_barrier_destroy(opt_oct_barrier_t *barrier);
+
+int opt_oct_num_online_cpus(void);
+
+void opt_oct_parallel_run(void *(*function)(void *), void *args, size_t arg_size, int num_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
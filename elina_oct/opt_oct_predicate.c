@@ -25,6 +25,7 @@
 bool opt_oct_is_bottom(elina_manager_t* man, opt_oct_t* o)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_IS_BOTTOM,0);
+  opt_oct_unpack(o);
   if (pr->funopt->algorithm>=0){ opt_oct_cache_closure(pr,o);}
   //m = o->closed ? o->closed : o->m;
   if (o->closed) {
@@ -46,6 +47,7 @@ bool opt_oct_is_bottom(elina_manager_t* man, opt_oct_t* o)
 bool opt_oct_is_top(elina_manager_t* man, opt_oct_t* o)
 {
   int i,j;
+  opt_oct_unpack(o);
   opt_oct_mat_t* m = o->m ? o->m : o->closed;
   if (!m) return false;
   return is_top_half(m,o->dim);
@@ -54,6 +56,8 @@ bool opt_oct_is_top(elina_manager_t* man, opt_oct_t* o)
 bool opt_oct_is_leq(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_IS_LEQ,0);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
    if((o1->dim != o2->dim) || (o1->intdim != o2->intdim))return false;
   if (pr->funopt->algorithm>=0){ opt_oct_cache_closure(pr,o1);}
   if (!o1->closed && !o1->m) {
@@ -94,6 +98,8 @@ bool opt_oct_is_leq(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
 bool opt_oct_is_eq(elina_manager_t* man, opt_oct_t* o1, opt_oct_t* o2)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_IS_EQ,0);
+  opt_oct_unpack(o1);
+  opt_oct_unpack(o2);
    if((o1->dim != o2->dim) || (o1->intdim != o2->intdim))return false;
   if (pr->funopt->algorithm>=0) {
     opt_oct_cache_closure(pr,o1);
@@ -142,6 +148,7 @@ elina_tcons0_array_t opt_oct_to_tcons_array(elina_manager_t* man, opt_oct_t* o)
 elina_interval_t** opt_oct_to_box(elina_manager_t* man, opt_oct_t* o)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_TO_BOX,0);
+  opt_oct_unpack(o);
   elina_interval_t** in = elina_interval_array_alloc(o->dim);
   size_t i;
   int j;
@@ -209,6 +216,7 @@ elina_interval_t* opt_oct_bound_dimension(elina_manager_t* man,
 				   opt_oct_t* o, elina_dim_t dim)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_BOUND_DIMENSION,0);
+  opt_oct_unpack(o);
   elina_interval_t* r = elina_interval_alloc();
   if((int)dim>=o->dim){
 	elina_interval_free(r);
@@ -267,6 +275,7 @@ elina_interval_t* opt_oct_bound_dimension(elina_manager_t* man,
 
 elina_interval_t* opt_oct_bound_linexpr(elina_manager_t* man,opt_oct_t* o, elina_linexpr0_t* expr){
 	opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_BOUND_DIMENSION,2*(o->dim+5));
+	opt_oct_unpack(o);
   	elina_interval_t* r = elina_interval_alloc();
   	if (pr->funopt->algorithm>=0) opt_oct_cache_closure(pr,o);
   	if (!o->closed && !o->m) {
@@ -361,6 +370,7 @@ elina_lincons0_array_t opt_oct_to_lincons_array(elina_manager_t* man, opt_oct_t*
 {
   elina_lincons0_array_t ar;
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_TO_LINCONS_ARRAY,0);
+  opt_oct_unpack(o);
   
   if (!o->closed && !o->m) {
     /* definitively empty */
@@ -432,6 +442,7 @@ bool opt_oct_sat_interval(elina_manager_t* man, opt_oct_t* o,
 		      elina_dim_t dim, elina_interval_t* i)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_SAT_INTERVAL,0);
+  opt_oct_unpack(o);
   if((int)dim >= o->dim){
 	return false;
   }
@@ -485,6 +496,7 @@ bool opt_oct_is_dimension_unconstrained(elina_manager_t* man, opt_oct_t* o,
   if((int)dim>=o->dim){
 	return false;
   }
+  opt_oct_unpack(o);
   if (!o->closed && !o->m)
     /* definitively empty */
     return false;
@@ -716,6 +728,7 @@ bool opt_oct_sat_lincons_timing(elina_manager_t* man, opt_oct_t* o,
 
    opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_SAT_LINCONS,
 					     2*(o->dim+1));
+   opt_oct_unpack(o);
    if (pr->funopt->algorithm>=0) opt_oct_cache_closure(pr,o);
    if (!o->closed && !o->m) {
     	/* really empty */
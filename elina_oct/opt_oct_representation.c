@@ -23,8 +23,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 #include "opt_oct_hmat.h"
 #include "opt_oct_closure_comp_sparse.h"
+#include "opt_oct_parallel.h"
 
 
 opt_oct_t * opt_oct_alloc_internal(opt_oct_internal_t *pr, int dim, int intdim){
@@ -40,6 +42,7 @@ opt_oct_t * opt_oct_alloc_internal(opt_oct_internal_t *pr, int dim, int intdim){
 int opt_oct_size(elina_manager_t* man, opt_oct_t* o)
 {
   if (!o->m) return 1;
+  if (!o->m->mat) return opt_hmat_packed_size(o->m);
   int size = 2*(o->dim)*(o->dim + 1);
   return size;
 }
@@ -119,7 +122,10 @@ opt_oct_t* opt_oct_set_mat(opt_oct_internal_t* pr, opt_oct_t* o, opt_oct_mat_t*
 opt_oct_t* opt_oct_copy(elina_manager_t* man, opt_oct_t* o)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_COPY,0);
-  opt_oct_t *res = opt_oct_copy_internal(pr,o);
+  /* copies of decomposed octagons only keep the component blocks */
+  opt_oct_t *res = opt_oct_alloc_internal(pr,o->dim,o->intdim);
+  res->m = opt_hmat_copy_packed(o->m,o->dim);
+  res->closed = opt_hmat_copy_packed(o->closed,o->dim);
   return res;
 }
 
@@ -203,7 +209,7 @@ void opt_oct_cache_closure(opt_oct_internal_t *pr, opt_oct_t *o){
 	}
 	
 	o->closed = opt_hmat_copy(o->m,o->dim);
-	if(opt_hmat_strong_closure(o->closed,o->dim)){
+	if(opt_hmat_strong_closure(o->closed,o->dim,pr->num_threads)){
 		opt_hmat_free(o->closed);
 		opt_hmat_free(o->m);
 		o->closed = NULL;
@@ -211,6 +217,19 @@ void opt_oct_cache_closure(opt_oct_internal_t *pr, opt_oct_t *o){
 	}
 }
 
+/******
+	Rebuild the half matrices of a packed octagon,
+	called by the operators before they access them
+******/
+void opt_oct_unpack(opt_oct_t *o){
+	if(o->m){
+		opt_hmat_unpack(o->m,o->dim);
+	}
+	if(o->closed){
+		opt_hmat_unpack(o->closed,o->dim);
+	}
+}
+
 void opt_oct_close(opt_oct_internal_t *pr, opt_oct_t *o){
 	if(!o->m){
 		return;
@@ -222,19 +241,19 @@ void opt_oct_close(opt_oct_internal_t *pr, opt_oct_t *o){
 	}
 	o->closed = o->m;
 	o->m = NULL;
-	if(opt_hmat_strong_closure(o->closed,o->dim)){
+	if(opt_hmat_strong_closure(o->closed,o->dim,pr->num_threads)){
 		opt_hmat_free(o->closed);
 		o->closed = NULL;
 		return;
 	}
 }
 
-/*We throw an exception just like APRON */
+/* Decomposed matrices are packed into their component blocks */
 void opt_oct_minimize(elina_manager_t* man, opt_oct_t* o)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_MINIMIZE,0);
-  elina_manager_raise_exception(man,ELINA_EXC_NOT_IMPLEMENTED,pr->funid,
-			     "not implemented");
+  if (o->m) opt_hmat_pack(o->m,o->dim);
+  if (o->closed) opt_hmat_pack(o->closed,o->dim);
 }
 
 
@@ -250,6 +269,7 @@ void opt_oct_canonicalize(elina_manager_t* man, opt_oct_t* o)
 int opt_oct_hash(elina_manager_t* man, opt_oct_t* o)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_HASH,0);
+  opt_oct_unpack(o);
   if (pr->funopt->algorithm>=0) opt_oct_cache_closure(pr,o);
   if (o->closed || o->m) {
     int r = 0;
@@ -264,6 +284,87 @@ int opt_oct_hash(elina_manager_t* man, opt_oct_t* o)
   return 0;
 }
 
+/******
+	Raw serialization: the dimensions, then m and closed. Each matrix is
+	tagged absent or present, a present one starts at an offset aligned
+	for doubles. Both matrices are always written in full, so the result
+	of a deserialization never aliases them.
+******/
+static size_t opt_oct_serialize_common(void *dst, opt_oct_t *o, bool dry_run){
+  size_t idx = 0;
+
+  if(!dry_run){
+    *(int*)(dst + idx) = o->intdim;
+  }
+  idx += sizeof(int);
+
+  if(!dry_run){
+    *(int*)(dst + idx) = o->dim;
+  }
+  idx += sizeof(int);
+
+  opt_oct_mat_t *mats[2] = {o->m, o->closed};
+  for(int k = 0; k < 2; k++){
+    char tag = mats[k]!=NULL;
+    if(!dry_run){
+      *(char*)(dst + idx) = tag;
+    }
+    idx += sizeof(char);
+    if(tag==1){
+      idx = (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+      idx += opt_hmat_serialize_common(dst + idx, mats[k], o->dim, dry_run);
+    }
+  }
+  return idx;
+}
+
+elina_membuf_t opt_oct_serialize_raw(elina_manager_t* man, opt_oct_t* o){
+  opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_SERIALIZE_RAW,0);
+  elina_membuf_t buf;
+  buf.size = opt_oct_serialize_common(NULL, o, true);
+  buf.ptr = malloc(buf.size);
+  opt_oct_serialize_common(buf.ptr, o, false);
+  return buf;
+}
+
+static opt_oct_t* opt_oct_deserialize_common(opt_oct_internal_t *pr, void* p, bool mapped, size_t* size){
+  size_t idx = 0;
+  int intdim = *(int*)(p + idx);
+  idx += sizeof(int);
+
+  int dim = *(int*)(p + idx);
+  idx += sizeof(int);
+
+  opt_oct_t *o = opt_oct_alloc_internal(pr, dim, intdim);
+  opt_oct_mat_t *mats[2] = {NULL, NULL};
+  for(int k = 0; k < 2; k++){
+    char tag = *(char*)(p + idx);
+    idx += sizeof(char);
+    if(tag==1){
+      size_t mat_size;
+      idx = (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+      mats[k] = opt_hmat_deserialize(p + idx, dim, mapped, &mat_size);
+      idx += mat_size;
+    }
+  }
+  o->m = mats[0];
+  o->closed = mats[1];
+  *size = idx;
+  return o;
+}
+
+opt_oct_t* opt_oct_deserialize_raw(elina_manager_t* man, void* p, size_t* size){
+  opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_DESERIALIZE_RAW,0);
+  return opt_oct_deserialize_common(pr, p, false, size);
+}
+
+/* The component blocks keep pointing into p, see opt_oct.h */
+opt_oct_t* opt_oct_map_raw(elina_manager_t* man, void* p, size_t* size){
+  opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_DESERIALIZE_RAW,0);
+  bool mapped = ((uintptr_t)p % sizeof(double))==0;
+  return opt_oct_deserialize_common(pr, p, mapped, size);
+}
+
 /* We throw an exception just like APRON */
 void opt_oct_approximate(elina_manager_t* man, opt_oct_t* o, int algorithm)
 {
@@ -349,6 +450,7 @@ elina_manager_t* opt_oct_manager_alloc(void)
   init_array(pr->tmp,pr->tmp_size);
   pr->tmp2 = calloc(pr->tmp_size,sizeof(long));
   assert(pr->tmp2);
+  pr->num_threads = 1;
   
   man = elina_manager_alloc("opt_oct","1.1 with double", pr,
 			 (void (*)(void*))opt_oct_internal_free);
@@ -365,8 +467,8 @@ elina_manager_t* opt_oct_manager_alloc(void)
   man->funptr[ELINA_FUNID_FPRINT] = &opt_oct_fprint;
   //man->funptr[ELINA_FUNID_FPRINTDIFF] = &opt_oct_fprintdiff;
   //man->funptr[ELINA_FUNID_FDUMP] = &opt_oct_fdump;
-  //man->funptr[ELINA_FUNID_SERIALIZE_RAW] = &opt_oct_serialize_raw;
-  //man->funptr[ELINA_FUNID_DESERIALIZE_RAW] = &opt_oct_deserialize_raw;
+  man->funptr[ELINA_FUNID_SERIALIZE_RAW] = &opt_oct_serialize_raw;
+  man->funptr[ELINA_FUNID_DESERIALIZE_RAW] = &opt_oct_deserialize_raw;
   man->funptr[ELINA_FUNID_BOTTOM] = &opt_oct_bottom;
   man->funptr[ELINA_FUNID_TOP] = &opt_oct_top;
   man->funptr[ELINA_FUNID_OF_BOX] = &opt_oct_of_box;
@@ -413,6 +515,12 @@ elina_manager_t* opt_oct_manager_alloc(void)
   return man;
 }
 
+void opt_oct_manager_set_num_threads(elina_manager_t* man, int num_threads)
+{
+  opt_oct_internal_t* pr = (opt_oct_internal_t*) man->internal;
+  pr->num_threads = num_threads > 0 ? num_threads : opt_oct_num_online_cpus();
+}
+
 opt_oct_t* opt_oct_of_abstract0(elina_abstract0_t* a)
 {
   return (opt_oct_t*)a->value;
@@ -427,3 +535,8 @@ elina_abstract0_t* abstract0_of_opt_oct(elina_manager_t* man, opt_oct_t* oct)
   return r;
 }
 
+
+elina_abstract0_t* elina_abstract0_opt_oct_map_raw(elina_manager_t* man, void* p, size_t* size)
+{
+  return abstract0_of_opt_oct(man,opt_oct_map_raw(man,p,size));
+}
@@ -31,6 +31,7 @@ opt_oct_t* opt_oct_forget_array(elina_manager_t* man,
 			bool project)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_FORGET_ARRAY,0);
+  opt_oct_unpack(o);
   if (pr->funopt->algorithm>=0) opt_oct_cache_closure(pr,o);
   if (!o->closed && !o->m)
     /* definitively empty */
@@ -76,6 +77,7 @@ opt_oct_t* opt_oct_add_dimensions(elina_manager_t* man,
   elina_lincons0_array_clear(&arr1);
   fflush(stdout);*/
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_ADD_DIMENSIONS,0);
+  opt_oct_unpack(o);
   opt_oct_mat_t* src = o->closed ? o->closed : o->m;
   opt_oct_mat_t* dst;
   size_t i, nb = dimchange->intdim+dimchange->realdim;
@@ -137,6 +139,7 @@ opt_oct_t* opt_oct_remove_dimensions(elina_manager_t* man,
   elina_lincons0_array_clear(&arr1);
   fflush(stdout);*/
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_REMOVE_DIMENSIONS,0);
+  opt_oct_unpack(o);
   opt_oct_mat_t *src, *dst;
   size_t i, nb = dimchange->intdim+dimchange->realdim;
   opt_oct_t* r;
@@ -196,6 +199,7 @@ opt_oct_t* opt_oct_permute_dimensions(elina_manager_t* man,
   elina_lincons0_array_clear(&arr1);
   fflush(stdout);*/
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_ADD_DIMENSIONS,0);
+  opt_oct_unpack(o);
   opt_oct_mat_t* src = o->closed ? o->closed : o->m;
   opt_oct_mat_t* dst;
   if((int)permutation->size!=o->dim)return NULL;
@@ -235,6 +239,7 @@ opt_oct_t* opt_oct_expand(elina_manager_t* man,
 		  size_t n)
 {
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_EXPAND,0);
+  opt_oct_unpack(o);
   opt_oct_mat_t* src = o->closed ? o->closed : o->m;
   size_t i, j;
   if(n==0){
@@ -405,6 +410,7 @@ opt_oct_t* opt_oct_fold(elina_manager_t* man,
 {
   
   opt_oct_internal_t* pr = opt_oct_init_from_manager(man,ELINA_FUNID_FOLD,0);
+  opt_oct_unpack(o);
   opt_oct_mat_t* src;
   opt_oct_mat_t* dst;
   opt_oct_t* r;
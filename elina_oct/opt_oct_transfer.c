@@ -28,6 +28,8 @@ opt_oct_t* opt_oct_assign_linexpr(elina_manager_t* man,
 {
   opt_oct_internal_t* pr =
     opt_oct_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY,2*(o->dim+1+5));
+  opt_oct_unpack(o);
+  if (dest) opt_oct_unpack(dest);
   opt_uexpr u = opt_oct_uexpr_of_linexpr(pr,pr->tmp,lexpr,o->intdim,o->dim);
   opt_oct_mat_t* src;
   bool respect_closure;
@@ -93,6 +95,8 @@ opt_oct_t* opt_oct_assign_linexpr_array(elina_manager_t* man,
 
   opt_oct_internal_t* pr =
     opt_oct_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY,2*(o->dim+size+5));
+  opt_oct_unpack(o);
+  if (dest) opt_oct_unpack(dest);
   elina_dim_t* d = (elina_dim_t*) pr->tmp2;
   opt_oct_mat_t *src, *dst;
   size_t i;
@@ -165,7 +169,7 @@ opt_oct_t* opt_oct_assign_linexpr_array(elina_manager_t* man,
   #endif
   /* now close & remove temporary variables */
   if (pr->funopt->algorithm>=0) {
-    if (opt_hmat_strong_closure(dst,o->dim+size)) {
+    if (opt_hmat_strong_closure(dst,o->dim+size,pr->num_threads)) {
       /* empty */
 	
       opt_hmat_free(dst);
@@ -212,6 +216,7 @@ opt_oct_t* opt_oct_meet_lincons_array(elina_manager_t* man,
   //fflush(stdout);
   opt_oct_internal_t* pr =
     opt_oct_init_from_manager(man,ELINA_FUNID_MEET_LINCONS_ARRAY,2*(o->dim+8));
+  opt_oct_unpack(o);
   if (!o->closed && !o->m)
     /* definitively empty */
     return opt_oct_set_mat(pr,o,NULL,NULL,destructive);
@@ -398,6 +403,8 @@ opt_oct_t* opt_oct_substitute_linexpr(elina_manager_t* man,
 {
   opt_oct_internal_t* pr =
     opt_oct_init_from_manager(man,ELINA_FUNID_SUBSTITUTE_LINEXPR_ARRAY,2*(o->dim+1+5));
+  opt_oct_unpack(o);
+  if (dest) opt_oct_unpack(dest);
   opt_uexpr u = opt_oct_uexpr_of_linexpr(pr,pr->tmp,expr,o->intdim,o->dim);
   opt_oct_mat_t * oo, *oo2;
   bool respect_closure;
@@ -477,6 +484,8 @@ opt_oct_t* opt_oct_substitute_linexpr_array(elina_manager_t* man,
   opt_oct_internal_t* pr =
     opt_oct_init_from_manager(man,ELINA_FUNID_SUBSTITUTE_LINEXPR_ARRAY,
 			  2*(o->dim+size+5));
+  opt_oct_unpack(o);
+  if (dest) opt_oct_unpack(dest);
   elina_dim_t* d = (elina_dim_t*) pr->tmp2;
   opt_oct_mat_t *oo, *oo1, *oo2;
   size_t i,j;
@@ -558,7 +567,7 @@ opt_oct_t* opt_oct_substitute_linexpr_array(elina_manager_t* man,
 
   /* now close */
   if (pr->funopt->algorithm>=0) {
-    if (opt_hmat_strong_closure(oo1,o->dim+size)) {
+    if (opt_hmat_strong_closure(oo1,o->dim+size,pr->num_threads)) {
       /* empty */
       opt_hmat_free(oo1);
       return opt_oct_set_mat(pr,o,NULL,NULL,destructive);
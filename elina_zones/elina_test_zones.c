@@ -0,0 +1,196 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+#include <time.h>
+#include "opt_zones.h"
+#include "opt_zones_internal.h"
+#include "opt_mat.h"
+#include "opt_zones_closure.h"
+
+/* checks that compare results rather than print them */
+int num_failed = 0;
+
+void report(const char *name, bool ok){
+	printf("%s: %s\n",name,ok ? "ok" : "FAILED");
+	if(!ok){
+		num_failed++;
+	}
+}
+
+
+/******
+	Random constraints v1 - v2 + c >= 0 with c >= 0, always satisfiable
+******/
+elina_lincons0_array_t generate_random_lincons0_array(unsigned short int dim, size_t nbcons){
+	size_t i;
+	elina_lincons0_array_t  lincons0 = elina_lincons0_array_make(nbcons);
+	for(i=0; i < nbcons; i++){
+		lincons0.p[i].constyp = ELINA_CONS_SUPEQ;
+		int v1 = rand()%dim;
+		int v2 = (v1 + 1 + rand()%(dim - 1))%dim;
+		elina_linexpr0_t * linexpr0 = elina_linexpr0_alloc(ELINA_LINEXPR_SPARSE,2);
+		elina_scalar_set_to_int(linexpr0->cst.val.scalar,rand()%10,ELINA_SCALAR_DOUBLE);
+		// the terms of a sparse expression are sorted by dimension
+		linexpr0->p.linterm[0].dim = v1 < v2 ? v1 : v2;
+		elina_scalar_set_to_int(linexpr0->p.linterm[0].coeff.val.scalar,v1 < v2 ? 1 : -1,ELINA_SCALAR_DOUBLE);
+		linexpr0->p.linterm[1].dim = v1 < v2 ? v2 : v1;
+		elina_scalar_set_to_int(linexpr0->p.linterm[1].coeff.val.scalar,v1 < v2 ? -1 : 1,ELINA_SCALAR_DOUBLE);
+		lincons0.p[i].linexpr0 = linexpr0;
+	}
+	return lincons0;
+}
+
+
+/******
+	Dense matrix of dimension dim with non-negative integer bounds,
+	a quarter of them top
+******/
+opt_zones_mat_t * generate_random_dense_mat(unsigned short int dim){
+	opt_zones_mat_t *oz = opt_zones_mat_alloc_top(dim);
+	free_array_comp_list(oz->acl);
+	oz->acl = NULL;
+	oz->is_dense = true;
+	oz->ti = true;
+	oz->is_top = false;
+	int n = dim + 1;
+	oz->nni = n*n;
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j < n; j++){
+			oz->mat[i*n + j] = i==j ? 0 : (rand()%4 ? rand()%20 + 1 : INFINITY);
+		}
+	}
+	return oz;
+}
+
+
+bool same_mat(double *m1, double *m2, unsigned short int dim){
+	int size = (dim + 1)*(dim + 1);
+	for(int i = 0; i < size; i++){
+		if(m1[i]!=m2[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/******
+	The dense closure, tile by tile for large matrices in the vector
+	build, must equal the scalar Floyd-Warshall entry by entry
+******/
+void test_closure(unsigned short int dim){
+	opt_zones_mat_t *oz1 = generate_random_dense_mat(dim);
+	opt_zones_mat_t *oz2 = opt_zones_mat_copy(oz1,dim);
+	bool empty1 = closure_dense(oz1,dim);
+	bool empty2 = closure_dense_scalar(oz2,dim);
+	char buf[128];
+	snprintf(buf,sizeof(buf),"dense closure dim %d",dim);
+	report(buf,empty1==empty2 && same_mat(oz1->mat,oz2->mat,dim));
+	opt_zones_mat_free(oz1);
+	opt_zones_mat_free(oz2);
+}
+
+
+/******
+	Both matrices absent, or present with the same entries
+******/
+bool same_zones_mat(opt_zones_mat_t *oz1, opt_zones_mat_t *oz2, unsigned short int dim){
+	if(!oz1 || !oz2){
+		return oz1==oz2;
+	}
+	return oz1->is_dense==oz2->is_dense && is_equal_zones_mat(oz1,oz2,dim);
+}
+
+
+void check_serialize(const char *name, elina_manager_t *man, opt_zones_t *oz){
+	elina_membuf_t buf = opt_zones_serialize_raw(man,oz);
+	size_t size = 0;
+	opt_zones_t *res = opt_zones_deserialize_raw(man,buf.ptr,&size);
+	bool ok = size==buf.size && res->dim==oz->dim && res->intdim==oz->intdim;
+	ok = ok && (!res->m || res->m!=res->closed);
+	ok = ok && same_zones_mat(res->m,oz->m,oz->dim) && same_zones_mat(res->closed,oz->closed,oz->dim);
+	char str[128];
+	snprintf(str,sizeof(str),"%s serialize round trip",name);
+	report(str,ok);
+	opt_zones_free(man,res);
+	free(buf.ptr);
+}
+
+
+void test_serialize(unsigned short int dim, size_t nbcons){
+	elina_manager_t * man = opt_zones_manager_alloc();
+	elina_lincons0_array_t lincons = generate_random_lincons0_array(dim,nbcons);
+	opt_zones_t * top = opt_zones_top(man,dim,0);
+	opt_zones_t * bottom = opt_zones_bottom(man,dim,0);
+	check_serialize("top",man,top);
+	check_serialize("bottom",man,bottom);
+
+	opt_zones_t * oz1 = opt_zones_meet_lincons_array(man,false,top,&lincons);
+	check_serialize("closed",man,oz1);
+
+	// meet without closing, then keep both the matrix and its closure
+	man->option.funopt[ELINA_FUNID_MEET_LINCONS_ARRAY].algorithm = -1;
+	opt_zones_t * oz2 = opt_zones_meet_lincons_array(man,false,top,&lincons);
+	check_serialize("unclosed",man,oz2);
+	if(oz2->m && !oz2->closed){
+		oz2->closed = opt_zones_mat_copy(oz2->m,dim);
+		if(opt_zones_mat_closure(oz2->closed,dim)){
+			opt_zones_mat_free(oz2->closed);
+			oz2->closed = NULL;
+		}
+	}
+	check_serialize("unclosed and closed",man,oz2);
+
+	opt_zones_t * oz3 = opt_zones_top(man,dim,0);
+	opt_zones_mat_free(oz3->closed);
+	oz3->closed = NULL;
+	oz3->m = generate_random_dense_mat(dim);
+	check_serialize("dense",man,oz3);
+
+	opt_zones_free(man,top);
+	opt_zones_free(man,bottom);
+	opt_zones_free(man,oz1);
+	opt_zones_free(man,oz2);
+	opt_zones_free(man,oz3);
+	elina_lincons0_array_clear(&lincons);
+	elina_manager_free(man);
+}
+
+
+int main(int argc, char **argv){
+	if(argc < 3){
+		printf("The test requires two positive integers: (a) Number of variables and (b) Number of constraints");
+		return 0;
+	}
+	unsigned short int dim = atoi(argv[1]);
+	size_t nbcons = atoi(argv[2]);
+	if(dim <=0 || nbcons <=0){
+		printf("The Input parameters should be positive\n");
+		return 0;
+	}
+	printf("Testing Closure\n");
+	test_closure(dim);
+	// dense matrices of this size are closed tile by tile
+	test_closure(OPT_ZONES_TILE_MIN_DIM + 45);
+	printf("Testing Serialization\n");
+	test_serialize(dim,nbcons);
+	return num_failed;
+}
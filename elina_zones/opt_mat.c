@@ -20,6 +20,7 @@
 
 
 
+#include <string.h>
 #include "opt_mat.h"
 #include "opt_zones_incr_closure.h"
 
@@ -312,6 +313,121 @@ opt_zones_mat_t* opt_zones_mat_copy(opt_zones_mat_t * oz, unsigned short int dim
 	return res;
 }
 
+/******
+	Raw serialization. A dense matrix is written as a whole, a decomposed
+	one as its component list followed, for every component, by the
+	square block over the zero variable and its sorted variables.
+	Offsets of the doubles are multiples of 8 from the start of the record.
+******/
+static size_t opt_zones_raw_align(size_t idx){
+	return (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+}
+
+/* copy the block of a component from m to p, or back when scatter is set */
+static void opt_zones_comp_move(double *m, double *p, unsigned short int *ca, unsigned short int comp_size, unsigned short int dim, bool scatter){
+	unsigned short int n = dim + 1;
+	for(int i = 0; i <= comp_size; i++){
+		int i1 = i ? ca[i-1] + 1 : 0;
+		for(int j = 0; j <= comp_size; j++){
+			int j1 = j ? ca[j-1] + 1 : 0;
+			if(scatter){
+				m[n*i1 + j1] = *p;
+			}
+			else{
+				*p = m[n*i1 + j1];
+			}
+			p++;
+		}
+	}
+}
+
+size_t opt_zones_mat_serialize_common(void *dst, opt_zones_mat_t *oz, unsigned short int dim, bool dry_run){
+	size_t idx = 0;
+	if(!dry_run){
+		*(bool*)(dst + idx) = oz->is_dense;
+	}
+	idx += sizeof(bool);
+
+	if(!dry_run){
+		*(bool*)(dst + idx) = oz->is_top;
+	}
+	idx += sizeof(bool);
+
+	if(!dry_run){
+		*(int*)(dst + idx) = oz->nni;
+	}
+	idx += sizeof(int);
+
+	if(!dry_run){
+		*(int*)(dst + idx) = oz->ind;
+	}
+	idx += sizeof(int);
+
+	if(oz->is_dense){
+		size_t size = (size_t)(dim + 1)*(dim + 1)*sizeof(double);
+		idx = opt_zones_raw_align(idx);
+		if(!dry_run){
+			memcpy(dst + idx,oz->mat,size);
+		}
+		return idx + size;
+	}
+	idx += array_comp_list_serialize_common(dst + idx,oz->acl,dry_run);
+	idx = opt_zones_raw_align(idx);
+	comp_list_t * cl = oz->acl->head;
+	while(cl!=NULL){
+		if(!dry_run){
+			unsigned short int * ca = to_sorted_array(cl,dim);
+			opt_zones_comp_move(oz->mat,dst + idx,ca,cl->size,dim,false);
+			free(ca);
+		}
+		idx += (size_t)(cl->size + 1)*(cl->size + 1)*sizeof(double);
+		cl = cl->next;
+	}
+	return idx;
+}
+
+opt_zones_mat_t* opt_zones_mat_deserialize(void *p, unsigned short int dim, size_t *size){
+	opt_zones_mat_t * oz = opt_zones_mat_alloc(dim);
+	size_t idx = 0;
+
+	oz->is_dense = *(bool*)(p + idx);
+	idx += sizeof(bool);
+
+	oz->is_top = *(bool*)(p + idx);
+	idx += sizeof(bool);
+
+	oz->nni = *(int*)(p + idx);
+	idx += sizeof(int);
+
+	oz->ind = *(int*)(p + idx);
+	idx += sizeof(int);
+
+	free_array_comp_list(oz->acl);
+	if(oz->is_dense){
+		size_t mat_size = (size_t)(dim + 1)*(dim + 1)*sizeof(double);
+		idx = opt_zones_raw_align(idx);
+		memcpy(oz->mat,p + idx,mat_size);
+		oz->acl = NULL;
+		oz->ti = true;
+		*size = idx + mat_size;
+		return oz;
+	}
+	size_t acl_size;
+	oz->acl = array_comp_list_deserialize(p + idx,&acl_size);
+	idx = opt_zones_raw_align(idx + acl_size);
+	oz->mat[0] = 0;
+	comp_list_t * cl = oz->acl->head;
+	while(cl!=NULL){
+		unsigned short int * ca = to_sorted_array(cl,dim);
+		opt_zones_comp_move(oz->mat,p + idx,ca,cl->size,dim,true);
+		free(ca);
+		idx += (size_t)(cl->size + 1)*(cl->size + 1)*sizeof(double);
+		cl = cl->next;
+	}
+	*size = idx;
+	return oz;
+}
+
 double recalculate_zones_sparsity(opt_zones_mat_t *oz, unsigned short int dim){
 	unsigned short int n = dim + 1;
 	int size = n*n;
@@ -73,6 +73,8 @@ opt_zones_mat_t* opt_zones_mat_alloc(unsigned short int dim);
 opt_zones_mat_t* opt_zones_mat_copy(opt_zones_mat_t * oz, unsigned short int dim);
 bool opt_zones_mat_closure(opt_zones_mat_t * oz, unsigned short int dim);
 void opt_zones_mat_free(opt_zones_mat_t * oz);
+size_t opt_zones_mat_serialize_common(void *dst, opt_zones_mat_t *oz, unsigned short int dim, bool dry_run);
+opt_zones_mat_t* opt_zones_mat_deserialize(void *p, unsigned short int dim, size_t *size);
 
 /********************* Predciate operators *****************/
 bool is_top_zones_mat(opt_zones_mat_t *oz, unsigned short int dim);
@@ -135,11 +135,120 @@ bool check_negative_cycle(opt_zones_mat_t * oz, unsigned short int dim){
 	return false;
 }
 
+#if defined (VECTOR)
+/******
+	Cache-blocked Floyd-Warshall for large matrices. The matrix is
+	split in OPT_ZONES_TILE x OPT_ZONES_TILE tiles. For every diagonal
+	tile K the tile is closed, then the row and the column of tiles
+	through K, and all other tiles only read the final row and column
+	so that they are updated with the pivots kept in cache.
+******/
+static inline void floyd_warshall_tile_row(double *q, double *p, double a, int j0, int j1){
+	v_double_type op1 = v_set1_double(a);
+	int j = j0;
+	for(; j + v_length <= j1; j += v_length){
+		v_double_type op2 = v_load_double(p + j);
+		v_double_type op3 = v_add_double(op1,op2);
+		v_double_type op4 = v_load_double(q + j);
+		v_store_double(q + j, v_min_double(op3,op4));
+	}
+	for(; j < j1; j++){
+		q[j] = min(q[j], a + p[j]);
+	}
+}
+
+/* tile [i0,i1)x[j0,j1) through pivots [k0,k1), in place for tiles sharing rows or columns with the pivots */
+static void floyd_warshall_tile_closure(double *m, int n, int i0, int i1, int j0, int j1, int k0, int k1){
+	for(int k = k0; k < k1; k++){
+		double *p = m + (size_t)k*n;
+		for(int i = i0; i < i1; i++){
+			double *q = m + (size_t)i*n;
+			floyd_warshall_tile_row(q,p,q[k],j0,j1);
+		}
+	}
+}
+
+/******
+	Tile [i0,i1)x[j0,j1) through pivots [k0,k1) whose row and column
+	tiles are final. Blocks of OPT_ZONES_TILE_REG vectors of row i stay
+	in registers while the pivots are applied.
+******/
+static void floyd_warshall_tile_mult(double *m, int n, int i0, int i1, int j0, int j1, int k0, int k1){
+	const int w = OPT_ZONES_TILE_REG*v_length;
+	for(int i = i0; i < i1; i++){
+		double *q = m + (size_t)i*n;
+		int j = j0;
+		for(; j + w <= j1; j += w){
+			v_double_type res[OPT_ZONES_TILE_REG];
+			for(int r = 0; r < OPT_ZONES_TILE_REG; r++){
+				res[r] = v_load_double(q + j + r*v_length);
+			}
+			for(int k = k0; k < k1; k++){
+				double a = q[k];
+				if(a==INFINITY){
+					continue;
+				}
+				v_double_type op1 = v_set1_double(a);
+				double *p = m + (size_t)k*n + j;
+				for(int r = 0; r < OPT_ZONES_TILE_REG; r++){
+					v_double_type op3 = v_add_double(op1,v_load_double(p + r*v_length));
+					res[r] = v_min_double(op3,res[r]);
+				}
+			}
+			for(int r = 0; r < OPT_ZONES_TILE_REG; r++){
+				v_store_double(q + j + r*v_length, res[r]);
+			}
+		}
+		if(j < j1){
+			for(int k = k0; k < k1; k++){
+				double a = q[k];
+				if(a==INFINITY){
+					continue;
+				}
+				floyd_warshall_tile_row(q,m + (size_t)k*n,a,j,j1);
+			}
+		}
+	}
+}
+
+static void floyd_warshall_tiled(double *m, unsigned short int n){
+	int nt = (n + OPT_ZONES_TILE - 1)/OPT_ZONES_TILE;
+	#define TILE_END(T) ((T)*OPT_ZONES_TILE + OPT_ZONES_TILE < n ? (T)*OPT_ZONES_TILE + OPT_ZONES_TILE : n)
+	for(int K = 0; K < nt; K++){
+		int k0 = K*OPT_ZONES_TILE, k1 = TILE_END(K);
+		floyd_warshall_tile_closure(m,n,k0,k1,k0,k1,k0,k1);
+		for(int T = 0; T < nt; T++){
+			if(T==K){
+				continue;
+			}
+			floyd_warshall_tile_closure(m,n,k0,k1,T*OPT_ZONES_TILE,TILE_END(T),k0,k1);
+			floyd_warshall_tile_closure(m,n,T*OPT_ZONES_TILE,TILE_END(T),k0,k1,k0,k1);
+		}
+		for(int I = 0; I < nt; I++){
+			if(I==K){
+				continue;
+			}
+			for(int J = 0; J < nt; J++){
+				if(J==K){
+					continue;
+				}
+				floyd_warshall_tile_mult(m,n,I*OPT_ZONES_TILE,TILE_END(I),J*OPT_ZONES_TILE,TILE_END(J),k0,k1);
+			}
+		}
+	}
+	#undef TILE_END
+}
+#endif
+
 /*********************
 	vectorized dense closure
 ***********************/
 void floyd_warshall_vector(double *m, unsigned short int n){
 	#if defined (VECTOR)
+	if(n >= OPT_ZONES_TILE_MIN_DIM){
+		floyd_warshall_tiled(m,n);
+		return;
+	}
 	unsigned short int i,j,k;
 	for(k=0; k < n; k++){
 		// load the k-th row
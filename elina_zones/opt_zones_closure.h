@@ -28,6 +28,15 @@ extern "C" {
 
 #include "opt_zones_internal.h"
 
+/* tile size of the blocked closure, a multiple of v_length */
+#define OPT_ZONES_TILE 64
+
+/* vectors of a tile row kept in registers by the tile update */
+#define OPT_ZONES_TILE_REG 8
+
+/* matrices of at least this size are closed tile by tile */
+#define OPT_ZONES_TILE_MIN_DIM 256
+
 bool check_negative_cycle(opt_zones_mat_t * oz, unsigned short int dim);
 
 bool closure_dense(opt_zones_mat_t * oz, unsigned short int dim);
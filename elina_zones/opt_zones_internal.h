@@ -299,6 +299,8 @@ void opt_zones_minimize(elina_manager_t* man, opt_zones_t* o);
 void opt_zones_canonicalize(elina_manager_t* man, opt_zones_t* o);
 int opt_zones_hash(elina_manager_t* man, opt_zones_t* o);
 void opt_zones_approximate(elina_manager_t* man, opt_zones_t* o, int algorithm);
+elina_membuf_t opt_zones_serialize_raw(elina_manager_t* man, opt_zones_t* o);
+opt_zones_t* opt_zones_deserialize_raw(elina_manager_t* man, void* p, size_t* size);
 void opt_zones_sparse_weak_closure(opt_zones_internal_t *pr,  opt_zones_t *o);
 void opt_zones_cache_closure(opt_zones_internal_t *pr, opt_zones_t *o);
 opt_zones_t* opt_zones_closure(elina_manager_t *man, bool destructive, opt_zones_t *o);
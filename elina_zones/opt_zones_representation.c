@@ -241,6 +241,76 @@ void opt_zones_approximate(elina_manager_t* man, opt_zones_t* o, int algorithm)
   elina_manager_raise_exception(man,ELINA_EXC_NOT_IMPLEMENTED,pr->funid,
 			     "not implemented");
 }
+/******
+	Raw serialization: the dimensions, then m and closed. Each matrix is
+	tagged absent or present, a present one starts at an offset aligned
+	for doubles. Both matrices are always written in full, so the result
+	of a deserialization never aliases them.
+******/
+static size_t opt_zones_serialize_common(void *dst, opt_zones_t *o, bool dry_run){
+  size_t idx = 0;
+
+  if(!dry_run){
+    *(unsigned short int*)(dst + idx) = o->intdim;
+  }
+  idx += sizeof(unsigned short int);
+
+  if(!dry_run){
+    *(unsigned short int*)(dst + idx) = o->dim;
+  }
+  idx += sizeof(unsigned short int);
+
+  opt_zones_mat_t *mats[2] = {o->m, o->closed};
+  for(int k = 0; k < 2; k++){
+    char tag = mats[k]!=NULL;
+    if(!dry_run){
+      *(char*)(dst + idx) = tag;
+    }
+    idx += sizeof(char);
+    if(tag==1){
+      idx = (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+      idx += opt_zones_mat_serialize_common(dst + idx, mats[k], o->dim, dry_run);
+    }
+  }
+  return idx;
+}
+
+elina_membuf_t opt_zones_serialize_raw(elina_manager_t* man, opt_zones_t* o){
+  opt_zones_internal_t* pr = opt_zones_init_from_manager(man,ELINA_FUNID_SERIALIZE_RAW,0);
+  elina_membuf_t buf;
+  buf.size = opt_zones_serialize_common(NULL, o, true);
+  buf.ptr = malloc(buf.size);
+  opt_zones_serialize_common(buf.ptr, o, false);
+  return buf;
+}
+
+opt_zones_t* opt_zones_deserialize_raw(elina_manager_t* man, void* p, size_t* size){
+  opt_zones_internal_t* pr = opt_zones_init_from_manager(man,ELINA_FUNID_DESERIALIZE_RAW,0);
+  size_t idx = 0;
+  unsigned short int intdim = *(unsigned short int*)(p + idx);
+  idx += sizeof(unsigned short int);
+
+  unsigned short int dim = *(unsigned short int*)(p + idx);
+  idx += sizeof(unsigned short int);
+
+  opt_zones_t *o = opt_zones_alloc_internal(pr, dim, intdim);
+  opt_zones_mat_t *mats[2] = {NULL, NULL};
+  for(int k = 0; k < 2; k++){
+    char tag = *(char*)(p + idx);
+    idx += sizeof(char);
+    if(tag==1){
+      size_t mat_size;
+      idx = (idx + sizeof(double) - 1) & ~(sizeof(double) - 1);
+      mats[k] = opt_zones_mat_deserialize(p + idx, dim, &mat_size);
+      idx += mat_size;
+    }
+  }
+  o->m = mats[0];
+  o->closed = mats[1];
+  *size = idx;
+  return o;
+}
+
 /****
 
 Topological closure
@@ -340,8 +410,8 @@ elina_manager_t* opt_zones_manager_alloc(void)
   man->funptr[ELINA_FUNID_FPRINT] = &opt_zones_fprint;
   //man->funptr[ELINA_FUNID_FPRINTDIFF] = &opt_zones_fprintdiff;
   //man->funptr[ELINA_FUNID_FDUMP] = &opt_zones_fdump;
-  //man->funptr[ELINA_FUNID_SERIALIZE_RAW] = &opt_zones_serialize_raw;
-  //man->funptr[ELINA_FUNID_DESERIALIZE_RAW] = &opt_zones_deserialize_raw;
+  man->funptr[ELINA_FUNID_SERIALIZE_RAW] = &opt_zones_serialize_raw;
+  man->funptr[ELINA_FUNID_DESERIALIZE_RAW] = &opt_zones_deserialize_raw;
   man->funptr[ELINA_FUNID_BOTTOM] = &opt_zones_bottom;
   man->funptr[ELINA_FUNID_TOP] = &opt_zones_top;
   //man->funptr[ELINA_FUNID_OF_BOX] = &opt_zones_of_box;
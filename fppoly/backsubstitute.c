@@ -1,4 +1,5 @@
 #include "backsubstitute.h"
+#include "matrix_backsubstitute.h"
 
 void * update_state_using_previous_layers(void *args){
 	nn_thread_t * data = (nn_thread_t *)args;
@@ -16,12 +17,24 @@ void * update_state_using_previous_layers(void *args){
 	
 	for(i=idx_start; i < idx_end; i++){
 		bool already_computed= false;
-		expr_t *lexpr = copy_expr(out_neurons[i]->lexpr);
-		expr_t *uexpr = copy_expr(out_neurons[i]->uexpr);
+		// a layer that is analysed again replaces its back-substituted expressions
+		if(out_neurons[i]->backsubstituted_lexpr){
+			free_expr(out_neurons[i]->backsubstituted_lexpr);
+			out_neurons[i]->backsubstituted_lexpr = NULL;
+		}
+		if(out_neurons[i]->backsubstituted_uexpr){
+			free_expr(out_neurons[i]->backsubstituted_uexpr);
+			out_neurons[i]->backsubstituted_uexpr = NULL;
+		}
+		/* temporaries of one neuron live in the arena, the results are kept */
+		expr_arena_begin();
+		expr_t *lexpr = copy_layer_neuron_expr(fp->layers[layerno], i, true);
+		expr_t *uexpr = copy_layer_neuron_expr(fp->layers[layerno], i, false);
 		out_neurons[i]->lb = get_lb_using_previous_layers(man, fp, &lexpr, layerno);
 		out_neurons[i]->ub = get_ub_using_previous_layers(man, fp, &uexpr, layerno);
-		out_neurons[i]->backsubstituted_lexpr = lexpr;
-		out_neurons[i]->backsubstituted_uexpr = uexpr;
+		out_neurons[i]->backsubstituted_lexpr = expr_arena_persist(lexpr);
+		out_neurons[i]->backsubstituted_uexpr = expr_arena_persist(uexpr);
+		expr_arena_end();
 		//free_expr(lexpr);
 		//free_expr(uexpr);
 		
@@ -31,57 +44,17 @@ void * update_state_using_previous_layers(void *args){
 
 
 void update_state_using_previous_layers_parallel(elina_manager_t *man, fppoly_t *fp, size_t layerno){
-	//size_t NUM_THREADS = get_nprocs();
-  	size_t NUM_THREADS = sysconf(_SC_NPROCESSORS_ONLN);
-	nn_thread_t args[NUM_THREADS];
-	pthread_t threads[NUM_THREADS];
-	size_t num_out_neurons = fp->layers[layerno]->dims;
-	size_t i;
-	if(num_out_neurons < NUM_THREADS){
-		for (i = 0; i < num_out_neurons; i++){
-	    		args[i].start = i; 
-	    		args[i].end = i+1;   
-			args[i].man = man;
-			args[i].fp = fp;
-			args[i].layerno = layerno;
-			args[i].linexpr0 = NULL;
-			args[i].res = NULL;
-	    		pthread_create(&threads[i], NULL,update_state_using_previous_layers, (void*)&args[i]);
-			
-	  	}
-		for (i = 0; i < num_out_neurons; i = i + 1){
-			pthread_join(threads[i], NULL);
-		}
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
+	if(pr->backsubstitution==FPPOLY_BACKSUBSTITUTE_MATRIX && matrix_backsubstitute_supported(fp, layerno)){
+		matrix_backsubstitute_layer(man, fp, layerno);
 	}
 	else{
-		size_t idx_start = 0;
-		size_t idx_n = num_out_neurons / NUM_THREADS;
-		size_t idx_end = idx_start + idx_n;
-		
-		
-	  	for (i = 0; i < NUM_THREADS; i++){
-	    		args[i].start = idx_start; 
-	    		args[i].end = idx_end;   
-			args[i].man = man;
-			args[i].fp = fp;
-			args[i].layerno = layerno;
-			args[i].linexpr0 = NULL;
-			args[i].res = NULL;
-	    		pthread_create(&threads[i], NULL,update_state_using_previous_layers, (void*)&args[i]);
-			idx_start = idx_end;
-			idx_end = idx_start + idx_n;
-	    		if(idx_end>num_out_neurons){
-				idx_end = num_out_neurons;
-			}
-			if((i==NUM_THREADS-2)){
-				idx_end = num_out_neurons;
-				
-			}
-	  	}
-		for (i = 0; i < NUM_THREADS; i = i + 1){
-			pthread_join(threads[i], NULL);
-		}
+		size_t num_out_neurons = fp->layers[layerno]->dims;
+		fppoly_parallel_for(man, fp, layerno, 0, num_out_neurons, NULL, NULL, update_state_using_previous_layers);
 	}
+	fppoly_stats_stop(pr, fp, layerno, &timer);
 }
 
 
@@ -103,7 +76,10 @@ void * update_state_layer_by_layer_lb(void *args)
 	for (i = idx_start; i < idx_end; i++)
 	{
 		bool already_computed = false;
+		expr_arena_begin();
 		out_neurons[i]->lb = fmin(out_neurons[i]->lb, get_lb_using_prev_layer(man, fp, &out_neurons[i]->backsubstituted_lexpr, k));
+		out_neurons[i]->backsubstituted_lexpr = expr_arena_persist(out_neurons[i]->backsubstituted_lexpr);
+		expr_arena_end();
 		// printf("lower bound is %.6f\n", out_neurons[i]->lb);
 	}
 	return NULL;
@@ -125,7 +101,10 @@ void *update_state_layer_by_layer_ub(void *args)
 	for (i = idx_start; i < idx_end; i++)
 	{
 		bool already_computed = false;
+		expr_arena_begin();
 		out_neurons[i]->ub = fmin(out_neurons[i]->ub, get_ub_using_prev_layer(man, fp, &out_neurons[i]->backsubstituted_uexpr, k));
+		out_neurons[i]->backsubstituted_uexpr = expr_arena_persist(out_neurons[i]->backsubstituted_uexpr);
+		expr_arena_end();
 		// printf("upper bound is %.6f\n", out_neurons[i]->ub);
 	}
 	return NULL;
@@ -133,11 +112,7 @@ void *update_state_layer_by_layer_ub(void *args)
 
 void update_state_layer_by_layer_parallel(elina_manager_t *man, fppoly_t *fp, size_t layerno)
 {
-	size_t NUM_THREADS = sysconf(_SC_NPROCESSORS_ONLN);
-	nn_thread_t args[NUM_THREADS];
-	pthread_t threads[NUM_THREADS];
 	size_t num_out_neurons = fp->layers[layerno]->dims;
-	size_t i;
 	int k;
 	if (fp->numlayers == layerno)
 	{
@@ -153,108 +128,8 @@ void update_state_layer_by_layer_parallel(elina_manager_t *man, fppoly_t *fp, si
 	}
 	while (k >= -1)
 	{
-		if (num_out_neurons < NUM_THREADS)
-		{
-			for (i = 0; i < num_out_neurons; i++)
-			{
-				args[i].start = i;
-				args[i].end = i + 1;
-				args[i].man = man;
-				args[i].fp = fp;
-				args[i].layerno = layerno;
-				args[i].k = k;
-				args[i].linexpr0 = NULL;
-				args[i].res = NULL;
-				pthread_create(&threads[i], NULL, update_state_layer_by_layer_lb, (void *)&args[i]);
-			}
-			for (i = 0; i < num_out_neurons; i = i + 1)
-			{
-				pthread_join(threads[i], NULL);
-			}
-		}
-		else
-		{
-			size_t idx_start = 0;
-			size_t idx_n = num_out_neurons / NUM_THREADS;
-			size_t idx_end = idx_start + idx_n;
-			for (i = 0; i < NUM_THREADS; i++)
-			{
-				args[i].start = idx_start;
-				args[i].end = idx_end;
-				args[i].man = man;
-				args[i].fp = fp;
-				args[i].layerno = layerno;
-				args[i].k = k;
-				args[i].linexpr0 = NULL;
-				args[i].res = NULL;
-				pthread_create(&threads[i], NULL, update_state_layer_by_layer_lb, (void *)&args[i]);
-				idx_start = idx_end;
-				idx_end = idx_start + idx_n;
-				if (idx_end > num_out_neurons)
-				{
-					idx_end = num_out_neurons;
-				}
-				if ((i == NUM_THREADS - 2))
-				{
-					idx_end = num_out_neurons;
-				}
-			}
-			for (i = 0; i < NUM_THREADS; i = i + 1)
-			{
-				pthread_join(threads[i], NULL);
-			}
-		}
-		if (num_out_neurons < NUM_THREADS)
-		{
-			for (i = 0; i < num_out_neurons; i++)
-			{
-				args[i].start = i;
-				args[i].end = i + 1;
-				args[i].man = man;
-				args[i].fp = fp;
-				args[i].layerno = layerno;
-				args[i].k = k;
-				args[i].linexpr0 = NULL;
-				args[i].res = NULL;
-				pthread_create(&threads[i], NULL, update_state_layer_by_layer_ub, (void *)&args[i]);
-			}
-			for (i = 0; i < num_out_neurons; i = i + 1)
-			{
-				pthread_join(threads[i], NULL);
-			}
-		}
-		else
-		{
-			size_t idx_start = 0;
-			size_t idx_n = num_out_neurons / NUM_THREADS;
-			size_t idx_end = idx_start + idx_n;
-			for (i = 0; i < NUM_THREADS; i++)
-			{
-				args[i].start = idx_start;
-				args[i].end = idx_end;
-				args[i].man = man;
-				args[i].fp = fp;
-				args[i].layerno = layerno;
-				args[i].k = k;
-				args[i].linexpr0 = NULL;
-				args[i].res = NULL;
-				pthread_create(&threads[i], NULL, update_state_layer_by_layer_ub, (void *)&args[i]);
-				idx_start = idx_end;
-				idx_end = idx_start + idx_n;
-				if (idx_end > num_out_neurons)
-				{
-					idx_end = num_out_neurons;
-				}
-				if ((i == NUM_THREADS - 2))
-				{
-					idx_end = num_out_neurons;
-				}
-			}
-			for (i = 0; i < NUM_THREADS; i = i + 1)
-			{
-				pthread_join(threads[i], NULL);
-			}
-		}
+		fppoly_parallel_for(man, fp, layerno, k, num_out_neurons, NULL, NULL, update_state_layer_by_layer_lb);
+		fppoly_parallel_for(man, fp, layerno, k, num_out_neurons, NULL, NULL, update_state_layer_by_layer_ub);
 		if (k < 0)
 			break;
 		else{
@@ -36,6 +36,10 @@ extern "C" {
 #include "log_approx.h"
 #include "pool_approx.h"
 #include "lstm_approx.h"
+#include "thread_pool.h"
+#include "spatial_lp.h"
+#include "conv_backsubstitute.h"
+#include "fppoly_stats.h"
 
 void update_state_using_previous_layers_parallel(elina_manager_t *man, fppoly_t *fp, size_t layerno);
 
@@ -0,0 +1,197 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#include "compiled_network.h"
+#include "relu_approx.h"
+
+
+fppoly_network_t * fppoly_network_alloc(size_t num_pixels){
+	fppoly_network_t *net = (fppoly_network_t *)malloc(sizeof(fppoly_network_t));
+	net->num_pixels = num_pixels;
+	net->numlayers = 0;
+	net->capacity = 0;
+	net->layers = NULL;
+	return net;
+}
+
+
+static fppoly_network_layer_t * fppoly_network_add_layer(fppoly_network_t *net, fppoly_network_op_t op, size_t dims, size_t *predecessors, size_t num_predecessors){
+	if(net->numlayers==net->capacity){
+		net->capacity = net->capacity ? 2*net->capacity : 8;
+		net->layers = (fppoly_network_layer_t *)realloc(net->layers, net->capacity*sizeof(fppoly_network_layer_t));
+	}
+	fppoly_network_layer_t *layer = &net->layers[net->numlayers++];
+	layer->op = op;
+	layer->dims = dims;
+	// the analysed elements keep pointing to the predecessors, so the network owns a copy
+	layer->predecessors = (size_t *)malloc(num_predecessors*sizeof(size_t));
+	memcpy(layer->predecessors, predecessors, num_predecessors*sizeof(size_t));
+	layer->num_predecessors = num_predecessors;
+	layer->exprs = NULL;
+	layer->use_default_heuristic = false;
+	return layer;
+}
+
+
+void fppoly_network_free(fppoly_network_t *net){
+	size_t i, j;
+	for(i=0; i < net->numlayers; i++){
+		fppoly_network_layer_t *layer = &net->layers[i];
+		if(layer->exprs){
+			for(j=0; j < layer->dims; j++){
+				free_expr(layer->exprs[j]);
+			}
+			free(layer->exprs);
+		}
+		free(layer->predecessors);
+	}
+	free(net->layers);
+	free(net);
+}
+
+
+void fppoly_network_add_fully_connected(fppoly_network_t *net, double **weights, double *bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors){
+	assert(num_predecessors==1);
+	fppoly_network_layer_t *layer = fppoly_network_add_layer(net, FPPOLY_NETWORK_AFFINE, num_out_neurons, predecessors, num_predecessors);
+	layer->exprs = (expr_t **)malloc(num_out_neurons*sizeof(expr_t *));
+	size_t i;
+	for(i=0; i < num_out_neurons; i++){
+		layer->exprs[i] = create_dense_expr(weights[i], bias[i], num_in_neurons);
+	}
+}
+
+
+void fppoly_network_add_fully_connected_buffer(fppoly_network_t *net, const void *weights, fppoly_dtype_t dtype, ptrdiff_t row_stride, ptrdiff_t col_stride, double *bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors){
+	assert(num_predecessors==1);
+	fppoly_network_layer_t *layer = fppoly_network_add_layer(net, FPPOLY_NETWORK_AFFINE, num_out_neurons, predecessors, num_predecessors);
+	layer->exprs = (expr_t **)malloc(num_out_neurons*sizeof(expr_t *));
+	size_t i;
+	for(i=0; i < num_out_neurons; i++){
+		layer->exprs[i] = create_strided_dense_expr((const char *)weights + i*row_stride, dtype, col_stride, bias[i], num_in_neurons);
+	}
+}
+
+
+void fppoly_network_add_convolutional(fppoly_network_t *net, double *filter_weights, double *filter_bias, size_t *input_size, size_t *filter_size, size_t num_filters, size_t *strides, size_t *output_size,
+				size_t pad_top, size_t pad_left, bool has_bias, size_t *predecessors, size_t num_predecessors){
+	assert(num_predecessors==1);
+	output_size[2] = num_filters;
+	size_t num_out_neurons = output_size[0]*output_size[1]*output_size[2];
+	fppoly_network_layer_t *layer = fppoly_network_add_layer(net, FPPOLY_NETWORK_AFFINE, num_out_neurons, predecessors, num_predecessors);
+	layer->exprs = (expr_t **)malloc(num_out_neurons*sizeof(expr_t *));
+	create_convolutional_exprs(layer->exprs, filter_weights, filter_bias, input_size, filter_size, strides, output_size, pad_top, pad_left, has_bias);
+}
+
+
+void fppoly_network_add_relu(fppoly_network_t *net, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristic){
+	fppoly_network_layer_t *layer = fppoly_network_add_layer(net, FPPOLY_NETWORK_RELU, num_neurons, predecessors, num_predecessors);
+	layer->use_default_heuristic = use_default_heuristic;
+}
+
+
+/* the analysis on a bare element, pool workers must not create abstract0
+   wrappers as those update the reference count of the manager */
+static fppoly_t * fppoly_network_analyze_fppoly(elina_manager_t *man, fppoly_network_t *net, double *inf_array, double *sup_array){
+	fppoly_t *fp = (fppoly_t *)malloc(sizeof(fppoly_t));
+	fppoly_from_network_input_box(fp, 0, net->num_pixels, inf_array, sup_array);
+	size_t i, j;
+	for(i=0; i < net->numlayers; i++){
+		fppoly_network_layer_t *layer = &net->layers[i];
+		if(layer->op==FPPOLY_NETWORK_RELU){
+			fppoly_relu_layer(man, fp, layer->dims, layer->predecessors, layer->num_predecessors, layer->use_default_heuristic);
+			continue;
+		}
+		size_t numlayers = fp->numlayers;
+		fppoly_add_new_layer(fp, layer->dims, layer->predecessors, layer->num_predecessors, false);
+		neuron_t **out_neurons = fp->layers[numlayers]->neurons;
+		for(j=0; j < layer->dims; j++){
+			out_neurons[j]->lexpr = share_expr(layer->exprs[j]);
+			out_neurons[j]->uexpr = out_neurons[j]->lexpr;
+		}
+		update_state_using_previous_layers_parallel(man, fp, numlayers);
+	}
+	return fp;
+}
+
+
+elina_abstract0_t * fppoly_network_analyze(elina_manager_t *man, fppoly_network_t *net, double *inf_array, double *sup_array){
+	return abstract0_of_fppoly(man, fppoly_network_analyze_fppoly(man, net, inf_array, sup_array));
+}
+
+
+typedef struct fppoly_network_batch_t{
+	fppoly_network_t *net;
+	double **inf;
+	double **sup;
+	elina_dim_t *labels;
+	bool *results;
+}fppoly_network_batch_t;
+
+
+static void * fppoly_network_verify_thread(void *args){
+	nn_thread_t *data = (nn_thread_t *)args;
+	fppoly_network_batch_t *batch = (fppoly_network_batch_t *)data->data;
+	elina_manager_t *man = data->man;
+	size_t num_out_neurons = batch->net->layers[batch->net->numlayers-1].dims;
+	elina_dim_t *xs = (elina_dim_t *)malloc(num_out_neurons*sizeof(elina_dim_t));
+	size_t r, j;
+	for(r=data->start; r < data->end; r++){
+		fppoly_t *fp = fppoly_network_analyze_fppoly(man, batch->net, batch->inf[r], batch->sup[r]);
+		elina_dim_t y = batch->labels[r];
+		size_t num_xs = 0;
+		for(j=0; j < num_out_neurons; j++){
+			if(j!=y){
+				xs[num_xs++] = j;
+			}
+		}
+		batch->results[r] = fppoly_is_greater_batch(man, fp, y, xs, num_xs, NULL);
+		fppoly_free(man, fp);
+	}
+	free(xs);
+	return NULL;
+}
+
+
+void fppoly_network_verify_batch(elina_manager_t *man, fppoly_network_t *net, size_t num_regions, double **inf, double **sup, elina_dim_t *labels, bool *results){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	fppoly_network_batch_t batch;
+	batch.net = net;
+	batch.inf = inf;
+	batch.sup = sup;
+	batch.labels = labels;
+	batch.results = results;
+	nn_thread_t arg;
+	arg.start = 0;
+	arg.end = num_regions;
+	arg.man = man;
+	arg.fp = NULL;
+	arg.layerno = 0;
+	arg.k = 0;
+	arg.linexpr0 = NULL;
+	arg.res = NULL;
+	arg.data = &batch;
+	/* a task takes several regions like the neuron loops do, idle threads
+	   still steal from the others when the costs of the regions differ */
+	size_t num_threads = fppoly_thread_pool_size(pr->pool);
+	fppoly_thread_pool_run_range(pr->pool, fppoly_network_verify_thread, &arg, num_regions, num_regions/(num_threads*FPPOLY_CHUNKS_PER_THREAD));
+}
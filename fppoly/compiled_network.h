@@ -0,0 +1,90 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+
+#ifndef __COMPILED_NETWORK_H_INCLUDED__
+#define __COMPILED_NETWORK_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "backsubstitute.h"
+
+/* A network whose weight dependent setup is done once. The expressions of the
+   affine layers are built and sorted when the layer is added and every analysis
+   shares them by reference count, so analysing an input region only costs the
+   back-substitution. Layers are numbered in the order they are added, the
+   predecessor indices follow the convention of the handle_*_layer functions. */
+
+typedef enum fppoly_network_op_t{
+	FPPOLY_NETWORK_AFFINE,
+	FPPOLY_NETWORK_RELU,
+}fppoly_network_op_t;
+
+typedef struct fppoly_network_layer_t{
+	fppoly_network_op_t op;
+	size_t dims;
+	size_t *predecessors;
+	size_t num_predecessors;
+	/* one expression per neuron, NULL for activations */
+	expr_t **exprs;
+	bool use_default_heuristic;
+}fppoly_network_layer_t;
+
+typedef struct fppoly_network_t{
+	size_t num_pixels;
+	size_t numlayers;
+	size_t capacity;
+	fppoly_network_layer_t *layers;
+}fppoly_network_t;
+
+fppoly_network_t * fppoly_network_alloc(size_t num_pixels);
+
+void fppoly_network_free(fppoly_network_t *net);
+
+void fppoly_network_add_fully_connected(fppoly_network_t *net, double **weights, double *bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors);
+
+/* the weights as a strided buffer, see handle_fully_connected_layer_buffer */
+void fppoly_network_add_fully_connected_buffer(fppoly_network_t *net, const void *weights, fppoly_dtype_t dtype, ptrdiff_t row_stride, ptrdiff_t col_stride, double *bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors);
+
+void fppoly_network_add_convolutional(fppoly_network_t *net, double *filter_weights, double *filter_bias, size_t *input_size, size_t *filter_size, size_t num_filters, size_t *strides, size_t *output_size,
+				size_t pad_top, size_t pad_left, bool has_bias, size_t *predecessors, size_t num_predecessors);
+
+void fppoly_network_add_relu(fppoly_network_t *net, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristic);
+
+/* runs DeepPoly on the box [inf_array, sup_array] of the inputs, the result is
+   the same as building the element with the handle_*_layer functions */
+elina_abstract0_t * fppoly_network_analyze(elina_manager_t *man, fppoly_network_t *net, double *inf_array, double *sup_array);
+
+/* results[r] is true if label labels[r] is proved to be greater than every other
+   output on the box [inf[r], sup[r]]. The regions are analysed in parallel, each
+   pool task takes a run of neighbouring regions and the layers of a region run
+   sequentially on its thread. */
+void fppoly_network_verify_batch(elina_manager_t *man, fppoly_network_t *net, size_t num_regions, double **inf, double **sup, elina_dim_t *labels, bool *results);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
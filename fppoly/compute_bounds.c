@@ -1,9 +1,3 @@
-#ifdef GUROBI
-#include <stdlib.h>
-#include <stdio.h>
-#include "gurobi_c.h"
-#endif
-
 #include "compute_bounds.h"
 #include "math.h"
 
@@ -160,235 +154,81 @@ expr_t * replace_input_poly_cons_in_uexpr(fppoly_internal_t *pr, expr_t * expr,
 	return res;
 }
 
-#ifdef GUROBI
-void handle_gurobi_error(int error, GRBenv *env) {
-    if (error) {
-        printf("Gurobi error: %s\n", GRBgeterrormsg(env));
-        exit(1);
-    }
-}
-
-double substitute_spatial_gurobi(expr_t *expr, fppoly_t *fp, const int opt_sense) {
-
-    GRBenv *env = NULL;
-    GRBmodel *model = NULL;
-
-    int error;
-
-    error = GRBemptyenv(&env);
-    handle_gurobi_error(error, env);
-    error = GRBsetintparam(env, "OutputFlag", 0);
-    handle_gurobi_error(error, env);
-    error = GRBsetintparam(env, "NumericFocus", 2);
-    handle_gurobi_error(error, env);
-    error = GRBstartenv(env);
-    handle_gurobi_error(error, env);
-
-    double *lb, *ub, *obj;
-    const size_t dims = expr->size;
-    const size_t numvars = 3 * dims;
-
-    lb = malloc(numvars * sizeof(double));
-    ub = malloc(numvars * sizeof(double));
-    obj = malloc(numvars * sizeof(double));
-
-    for (size_t i = 0; i < dims; ++i) {
-        const size_t k = expr->type == DENSE ? i : expr->dim[i];
-        lb[i] = -fp->input_inf[k];
-        ub[i] = fp->input_sup[k];
-        obj[i] = opt_sense == GRB_MINIMIZE ? -expr->inf_coeff[i] : expr->sup_coeff[i];
-
-        for (size_t j = 0; j < 2; ++j) {
-            const size_t l = fp->input_uexpr[k]->dim[j];
-            lb[dims + 2 * i + j] = -fp->input_inf[l];
-            ub[dims + 2 * i + j] = fp->input_sup[l];
-            obj[dims + 2 * i + j] = 0;
-        }
-    }
-
-    error = GRBnewmodel(env, &model, NULL, numvars, obj, lb, ub, NULL, NULL);
-    handle_gurobi_error(error, env);
-    error = GRBsetintattr(model, "ModelSense", opt_sense);
-    handle_gurobi_error(error, env);
-
-    for (size_t i = 0; i < dims; ++i) {
-        const size_t k = expr->type == DENSE ? i : expr->dim[i];
-
-        int ind[] = {i, dims + 2 * i, dims + 2 * i + 1};
-
-        double lb_val[] = {
-            -1, -fp->input_lexpr[k]->inf_coeff[0], -fp->input_lexpr[k]->inf_coeff[1]
-        };
-        error = GRBaddconstr(model, 3, ind, lb_val, GRB_LESS_EQUAL, fp->input_lexpr[k]->inf_cst, NULL);
-        handle_gurobi_error(error, env);
-
-        double ub_val[] = {
-            1, -fp->input_uexpr[k]->sup_coeff[0], -fp->input_uexpr[k]->sup_coeff[1]
-        };
-        error = GRBaddconstr(model, 3, ind, ub_val, GRB_LESS_EQUAL, fp->input_uexpr[k]->sup_cst, NULL);
-        handle_gurobi_error(error, env);
-    }
-
-    size_t idx, nbr, s_idx, s_nbr;
-    const size_t num_pixels = fp->num_pixels;
-
-    for (size_t i = 0; i < fp->spatial_size; ++i) {
-        idx = fp->spatial_indices[i];
-        nbr = fp->spatial_neighbors[i];
-
-        if (expr->type == DENSE) {
-            s_idx = idx;
-            s_nbr = nbr;
-        } else {
-            s_idx = s_nbr = num_pixels;
-
-            for (size_t j = 0; j < dims; ++j) {
-                if (expr->dim[j] == idx) {
-                    s_idx = j;
-                }
-                if (expr->dim[j] == nbr) {
-                    s_nbr = j;
-                }
-            }
-
-            if ((s_idx == num_pixels) || (s_nbr == num_pixels)) {
-                continue;
-            }
-        }
-
-        int ind_x[] = {dims + 2 * s_idx, dims + 2 * s_nbr};
-        int ind_y[] = {dims + 2 * s_idx + 1, dims + 2 * s_nbr + 1};
-        double val[] = {1., -1.};
-
-        error = GRBaddconstr(model, 2, ind_x, val, GRB_LESS_EQUAL, fp->spatial_gamma, NULL);
-        handle_gurobi_error(error, env);
-        error = GRBaddconstr(model, 2, ind_y, val, GRB_LESS_EQUAL, fp->spatial_gamma, NULL);
-        handle_gurobi_error(error, env);
-        error = GRBaddconstr(model, 2, ind_x, val, GRB_GREATER_EQUAL, -fp->spatial_gamma, NULL);
-        handle_gurobi_error(error, env);
-        error = GRBaddconstr(model, 2, ind_y, val, GRB_GREATER_EQUAL, -fp->spatial_gamma, NULL);
-        handle_gurobi_error(error, env);
-    }
-
-    int opt_status;
-    double obj_val;
-
-    error = GRBoptimize(model);
-    handle_gurobi_error(error, env);
-    error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &opt_status);
-    handle_gurobi_error(error, env);
-    error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &obj_val);
-    handle_gurobi_error(error, env);
-
-    if (opt_status != GRB_OPTIMAL) {
-        printf("Gurobi model status not optimal %i\n", opt_status);
-        exit(1);
-    }
-
-    free(lb);
-    free(ub);
-    free(obj);
+/* adds the bounds of the coefficients of expr over the neurons of layerno
+   (the input box for -1) to res_inf or res_sup, the neuron bounds are gathered
+   in chunks so that the dense kernel can run over contiguous blocks */
+#define CONCRETIZE_CHUNK 512
 
-    GRBfreemodel(model);
-    GRBfreeenv(env);
-
-    return obj_val;
+static void concretize_expr(expr_t *expr, fppoly_t *fp, int layerno, double *res_inf, double *res_sup){
+	size_t dims = expr->size;
+	if(layerno==-1 && expr->type==DENSE){
+		expr_dense_concretize(expr->inf_coeff,expr->sup_coeff,fp->input_inf,fp->input_sup,dims,res_inf,res_sup);
+		return;
+	}
+	neuron_t *neurons = layerno==-1 ? NULL : fp->layers[layerno]->neuron_block;
+	double inf[CONCRETIZE_CHUNK];
+	double sup[CONCRETIZE_CHUNK];
+	size_t i, j;
+	for(i=0; i < dims; i+=CONCRETIZE_CHUNK){
+		size_t n = dims - i < CONCRETIZE_CHUNK ? dims - i : CONCRETIZE_CHUNK;
+		for(j=0; j < n; j++){
+			size_t k = expr->type==DENSE ? i + j : expr->dim[i+j];
+			if(layerno==-1){
+				inf[j] = fp->input_inf[k];
+				sup[j] = fp->input_sup[k];
+			}
+			else{
+				inf[j] = neurons[k].lb;
+				sup[j] = neurons[k].ub;
+			}
+		}
+		expr_dense_concretize(expr->inf_coeff+i,expr->sup_coeff+i,inf,sup,n,res_inf,res_sup);
+	}
 }
-#endif
+
 
 double compute_lb_from_expr(fppoly_internal_t *pr, expr_t * expr, fppoly_t * fp, int layerno){
 
-#ifdef GUROBI
-    if ((fp->input_lexpr!=NULL) && (fp->input_uexpr!=NULL) && layerno==-1 && fp->spatial_size > 0) {
-        return expr->inf_cst - substitute_spatial_gurobi(expr, fp, GRB_MINIMIZE);
+    /* the substitution below keeps input variables shared by the input
+       constraints of several pixels, the LP does not, keep the tighter */
+    double res_lp = INFINITY;
+    if (layerno==-1 && fp->spatial_lp!=NULL) {
+        res_lp = expr->inf_cst + spatial_lp_bound(fp->spatial_lp, expr, true);
     }
-#endif
 
-	size_t i,k;
-	double tmp1, tmp2;
-        //printf("start\n");
-        //fflush(stdout);
 	if((fp->input_lexpr!=NULL) && (fp->input_uexpr!=NULL) && layerno==-1){
 		expr =  replace_input_poly_cons_in_lexpr(pr, expr, fp);
 	}
-        //expr_print(expr);
-	//fflush(stdout);
-	size_t dims = expr->size;
 	double res_inf = expr->inf_cst;
-	if(expr->inf_coeff==NULL || expr->sup_coeff==NULL){
-		return res_inf;
-	}
-	for(i=0; i < dims; i++){
-		//if(expr->inf_coeff[i]<0){
-		if(expr->type==DENSE){
-			k = i;
-		}
-		else{
-			k = expr->dim[i];
-		}
-			if(layerno==-1){
-				elina_double_interval_mul(&tmp1,&tmp2,expr->inf_coeff[i],expr->sup_coeff[i],fp->input_inf[k],fp->input_sup[k]);
-			}
-			else{
-				elina_double_interval_mul(&tmp1,&tmp2,expr->inf_coeff[i],expr->sup_coeff[i],fp->layers[layerno]->neurons[k]->lb,fp->layers[layerno]->neurons[k]->ub);
-			}
-			//printf("tmp1: %g\n",tmp1);
-			res_inf = res_inf + tmp1;
-			
+	if(expr->inf_coeff!=NULL && expr->sup_coeff!=NULL){
+		concretize_expr(expr,fp,layerno,&res_inf,NULL);
 	}
-//	printf("inf: %g\n",-res_inf);
-//	fflush(stdout);
-        if(fp->input_lexpr!=NULL && fp->input_uexpr!=NULL && layerno==-1){
+	if(fp->input_lexpr!=NULL && fp->input_uexpr!=NULL && layerno==-1){
 		free_expr(expr);
 	}
-        //printf("finish\n");
-        //fflush(stdout);
-	return res_inf;
+	return fmin(res_inf,res_lp);
 }
 
 double compute_ub_from_expr(fppoly_internal_t *pr, expr_t * expr, fppoly_t * fp, int layerno){
 
-#ifdef GUROBI
-    if ((fp->input_lexpr!=NULL) && (fp->input_uexpr!=NULL) && layerno==-1 && fp->spatial_size > 0) {
-        return expr->sup_cst + substitute_spatial_gurobi(expr, fp, GRB_MAXIMIZE);
+    /* the substitution below keeps input variables shared by the input
+       constraints of several pixels, the LP does not, keep the tighter */
+    double res_lp = INFINITY;
+    if (layerno==-1 && fp->spatial_lp!=NULL) {
+        res_lp = expr->sup_cst + spatial_lp_bound(fp->spatial_lp, expr, false);
     }
-#endif
-
-	size_t i,k;
-	double tmp1, tmp2;
 
 	if((fp->input_lexpr!=NULL) && (fp->input_uexpr!=NULL) && layerno==-1){
 		expr =  replace_input_poly_cons_in_uexpr(pr, expr, fp);
 	}
-
-	size_t dims = expr->size;
 	double res_sup = expr->sup_cst;
-	if(expr->inf_coeff==NULL || expr->sup_coeff==NULL){
-		return res_sup;
-	}
-	for(i=0; i < dims; i++){
-		//if(expr->inf_coeff[i]<0){
-		if(expr->type==DENSE){
-			k = i;
-		}
-		else{
-			k = expr->dim[i];
-		}		
-		if(layerno==-1){
-			elina_double_interval_mul(&tmp1,&tmp2,expr->inf_coeff[i],expr->sup_coeff[i],fp->input_inf[k],fp->input_sup[k]);
-		}
-		else{
-			elina_double_interval_mul(&tmp1,&tmp2,expr->inf_coeff[i],expr->sup_coeff[i],fp->layers[layerno]->neurons[k]->lb,fp->layers[layerno]->neurons[k]->ub);
-		}
-		res_sup = res_sup + tmp2;
-			
+	if(expr->inf_coeff!=NULL && expr->sup_coeff!=NULL){
+		concretize_expr(expr,fp,layerno,NULL,&res_sup);
 	}
-	//printf("sup: %g\n",res_sup);
-	//fflush(stdout);
 	if(fp->input_lexpr!=NULL && fp->input_uexpr!=NULL && layerno==-1){
 		free_expr(expr);
 	}
-	return res_sup;
+	return fmin(res_sup,res_lp);
 }
 
 
@@ -399,7 +239,12 @@ double get_lb_using_predecessor_layer(fppoly_internal_t * pr,fppoly_t *fp, expr_
 	double res = INFINITY;
 	res = compute_lb_from_expr(pr,lexpr,fp,k);
 	tmp_l = lexpr;
-	*lexpr_ptr = lexpr_replace_bounds(pr,lexpr,aux_neurons, fp->layers[k]->is_activation);
+	if(fp->layers[k]->conv){
+		*lexpr_ptr = conv_expr_replace_bounds(pr,lexpr,fp->layers[k],true);
+	}
+	else{
+		*lexpr_ptr = lexpr_replace_bounds(pr,lexpr,aux_neurons, fp->layers[k]->is_activation);
+	}
 	free_expr(tmp_l);
 	return res;
 }
@@ -412,7 +257,12 @@ double get_ub_using_predecessor_layer(fppoly_internal_t * pr,fppoly_t *fp, expr_
 	double res = INFINITY;
 	tmp_u = uexpr;
 	res = compute_ub_from_expr(pr,uexpr,fp,k);
-	*uexpr_ptr = uexpr_replace_bounds(pr,uexpr,aux_neurons, fp->layers[k]->is_activation);
+	if(fp->layers[k]->conv){
+		*uexpr_ptr = conv_expr_replace_bounds(pr,uexpr,fp->layers[k],false);
+	}
+	else{
+		*uexpr_ptr = uexpr_replace_bounds(pr,uexpr,aux_neurons, fp->layers[k]->is_activation);
+	}
 	free_expr(tmp_u);
 	return res;
 }
@@ -471,7 +321,7 @@ int get_lb_using_non_concatenate_layers(fppoly_internal_t * pr,fppoly_t *fp, exp
 	return k;
 }
 
-double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno){
+double get_lb_using_previous_layers_until(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno, double threshold){
 	size_t i;
 	int k;
 	//size_t numlayers = fp->numlayers;
@@ -512,7 +362,7 @@ double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t *
 					iter = fp->layers[iter]->predecessors[0]-1;
 				}
 			}
-			for(int i=k; i >=0; i-- ){
+			for(int i=k-1; i >=0; i-- ){
 				if(predecessor_map[i]==num_predecessors){
 					common_predecessor = i;
 					break;
@@ -583,10 +433,16 @@ double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t *
 			k = get_lb_using_non_concatenate_layers(pr, fp, &lexpr, k, &res);
 		
 		}
+		// res is the negated lower bound
+		if(-res > threshold){
+			break;
+		}
 			
 	}
 		
-	res = fmin(res,compute_lb_from_expr(pr,lexpr,fp,-1)); 
+	if(k < 0){
+		res = fmin(res,compute_lb_from_expr(pr,lexpr,fp,-1)); 
+	}
         //free_expr(lexpr);
         //if(fp->layers[layerno]->is_concat == true){
 		//printf("res: %g\n",res);
@@ -601,6 +457,11 @@ double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t *
 }
 
 
+double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno){
+	return get_lb_using_previous_layers_until(man, fp, expr, layerno, INFINITY);
+}
+
+
 elina_linexpr0_t *get_output_uexpr_defined_over_previous_layers(elina_manager_t *man, elina_abstract0_t *element, int neuron_no, int prev_layer){
 	fppoly_t * fp = fppoly_of_abstract0(element);
 	if(prev_layer<0 || prev_layer> (int)(fp->numlayers-1)){
@@ -614,8 +475,7 @@ elina_linexpr0_t *get_output_uexpr_defined_over_previous_layers(elina_manager_t
 	int k;
         fppoly_internal_t * pr = fppoly_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
         
-	neuron_t ** out_neurons = fp->layers[fp->numlayers-1]->neurons;
-	expr_t *uexpr = copy_expr(out_neurons[neuron_no]->uexpr);
+	expr_t *uexpr = copy_layer_neuron_expr(fp->layers[fp->numlayers-1], neuron_no, false);
 	
 	k = fp->layers[fp->numlayers-1]->predecessors[0]-1;
 	while(k >=prev_layer){
@@ -740,8 +600,7 @@ elina_linexpr0_t * get_output_lexpr_defined_over_previous_layers(elina_manager_t
 	size_t i;
 	int k;
         fppoly_internal_t * pr = fppoly_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
-	neuron_t ** out_neurons = fp->layers[fp->numlayers-1]->neurons;
-	expr_t *lexpr = copy_expr(out_neurons[neuron_no]->lexpr);
+	expr_t *lexpr = copy_layer_neuron_expr(fp->layers[fp->numlayers-1], neuron_no, true);
 	k = fp->layers[fp->numlayers-1]->predecessors[0]-1;
 	while(k >=prev_layer){
 	        if(fp->layers[k]->is_concat==true){
@@ -951,7 +810,7 @@ double get_ub_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t *
 					iter = fp->layers[iter]->predecessors[0]-1;
 				}
 			 }
-			 for(int i=k; i >=0; i-- ){
+			 for(int i=k-1; i >=0; i-- ){
 				if(predecessor_map[i]==num_predecessors){
 					common_predecessor = i;
 					break;
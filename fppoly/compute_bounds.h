@@ -39,6 +39,11 @@ double compute_ub_from_expr(fppoly_internal_t *pr, expr_t * expr, fppoly_t * fp,
 
 double get_lb_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno);
 
+/* like get_lb_using_previous_layers but stops after the first layer whose
+   concretization shows a lower bound above threshold, *expr is then only
+   back-substituted up to that layer */
+double get_lb_using_previous_layers_until(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno, double threshold);
+
 double get_ub_using_previous_layers(elina_manager_t *man, fppoly_t *fp, expr_t **expr, size_t layerno);
 
 double get_lb_using_prev_layer(elina_manager_t *man, fppoly_t *fp, expr_t **expr, int k);
@@ -0,0 +1,316 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#include "conv_backsubstitute.h"
+
+
+conv_op_t * conv_op_alloc(double *filter_weights, double *filter_bias, size_t *input_size, size_t *filter_size, size_t *strides, size_t *output_size,
+			size_t pad_top, size_t pad_left, bool has_bias){
+	conv_op_t *conv = (conv_op_t *)malloc(sizeof(conv_op_t));
+	size_t i;
+	for(i=0; i < 3; i++){
+		conv->input_size[i] = input_size[i];
+		conv->output_size[i] = output_size[i];
+	}
+	for(i=0; i < 2; i++){
+		conv->filter_size[i] = filter_size[i];
+		conv->strides[i] = strides[i];
+	}
+	conv->pad_top = pad_top;
+	conv->pad_left = pad_left;
+	size_t num_weights = filter_size[0]*filter_size[1]*input_size[2]*output_size[2];
+	conv->filter_weights = (double *)malloc(num_weights*sizeof(double));
+	memcpy(conv->filter_weights, filter_weights, num_weights*sizeof(double));
+	if(has_bias){
+		conv->filter_bias = (double *)malloc(output_size[2]*sizeof(double));
+		memcpy(conv->filter_bias, filter_bias, output_size[2]*sizeof(double));
+	}
+	else{
+		conv->filter_bias = NULL;
+	}
+	return conv;
+}
+
+
+void conv_op_free(conv_op_t *conv){
+	free(conv->filter_weights);
+	free(conv->filter_bias);
+	free(conv);
+}
+
+
+/* rows and columns of the input read by output neuron i, clipped to the input */
+static void conv_op_window(conv_op_t *conv, size_t i, long int *x_lo, long int *x_hi, long int *y_lo, long int *y_hi){
+	size_t out_x = i / (conv->output_size[1]*conv->output_size[2]);
+	size_t out_y = (i / conv->output_size[2]) % conv->output_size[1];
+	*x_lo = (long int)(out_x*conv->strides[0]) - (long int)conv->pad_top;
+	*x_hi = *x_lo + (long int)conv->filter_size[0] - 1;
+	*y_lo = (long int)(out_y*conv->strides[1]) - (long int)conv->pad_left;
+	*y_hi = *y_lo + (long int)conv->filter_size[1] - 1;
+	if(*x_lo < 0){
+		*x_lo = 0;
+	}
+	if(*x_hi >= (long int)conv->input_size[0]){
+		*x_hi = conv->input_size[0] - 1;
+	}
+	if(*y_lo < 0){
+		*y_lo = 0;
+	}
+	if(*y_hi >= (long int)conv->input_size[1]){
+		*y_hi = conv->input_size[1] - 1;
+	}
+}
+
+
+static double conv_op_bias(conv_op_t *conv, size_t i){
+	return conv->filter_bias ? conv->filter_bias[i % conv->output_size[2]] : 0;
+}
+
+
+expr_t * conv_op_neuron_expr(conv_op_t *conv, size_t i){
+	size_t in_y = conv->input_size[1];
+	size_t in_z = conv->input_size[2];
+	size_t out_z = conv->output_size[2];
+	size_t fy = conv->filter_size[1];
+	size_t filter_z = i % out_z;
+	long int x_lo, x_hi, y_lo, y_hi, x, y;
+	size_t z;
+	conv_op_window(conv, i, &x_lo, &x_hi, &y_lo, &y_hi);
+	long int x_shift = x_lo - ((long int)((i / (conv->output_size[1]*out_z))*conv->strides[0]) - (long int)conv->pad_top);
+	long int y_shift = y_lo - ((long int)(((i / out_z) % conv->output_size[1])*conv->strides[1]) - (long int)conv->pad_left);
+	size_t num_coeff = 0;
+	if(x_hi >= x_lo && y_hi >= y_lo){
+		num_coeff = (x_hi-x_lo+1)*(y_hi-y_lo+1)*in_z;
+	}
+	double *coeff = (double *)malloc(num_coeff*sizeof(double));
+	size_t *dim = (size_t *)malloc(num_coeff*sizeof(size_t));
+	size_t k = 0;
+	// visiting the window row by row gives the input indices in increasing order
+	for(x=x_lo; x <= x_hi; x++){
+		for(y=y_lo; y <= y_hi; y++){
+			size_t filter_index = ((x-x_lo+x_shift)*fy + (y-y_lo+y_shift))*in_z*out_z + filter_z;
+			size_t input_index = (x*in_y + y)*in_z;
+			for(z=0; z < in_z; z++){
+				coeff[k] = conv->filter_weights[filter_index + z*out_z];
+				dim[k] = input_index + z;
+				k++;
+			}
+		}
+	}
+	expr_t *res = create_sparse_expr(coeff, conv_op_bias(conv, i), dim, num_coeff);
+	free(coeff);
+	free(dim);
+	return res;
+}
+
+
+expr_t * copy_layer_neuron_expr(layer_t *layer, size_t i, bool is_lower){
+	if(layer->conv){
+		return conv_op_neuron_expr(layer->conv, i);
+	}
+	return copy_expr(is_lower ? layer->neurons[i]->lexpr : layer->neurons[i]->uexpr);
+}
+
+
+/* accumulation of exprA = exprA + exprB in add_expr and add_cst_expr */
+static void conv_add_cst(fppoly_internal_t *pr, double *inf_cst, double *sup_cst, double inf, double sup, bool has_coeff){
+	double maxA = fmax(fabs(*inf_cst),fabs(*sup_cst));
+	double maxB = fmax(fabs(inf),fabs(sup));
+	if(has_coeff){
+		*inf_cst += inf + (maxA + maxB)*pr->ulp + pr->min_denormal;
+		*sup_cst += sup + (maxA + maxB)*pr->ulp + pr->min_denormal;
+	}
+	else{
+		*inf_cst = *inf_cst + inf + (maxA + maxB)*pr->ulp + pr->min_denormal;
+		*sup_cst = *sup_cst + sup + (maxA + maxB)*pr->ulp + pr->min_denormal;
+	}
+}
+
+
+/* Follows expr_replace_bounds_affine step by step: the coefficients that have a
+   sign substitute the expression of their neuron, the others are concretized
+   with the bounds of the neuron. A coefficient of an input is set by the first
+   row that reaches it and accumulated afterwards, as the merges of add_expr do. */
+expr_t * conv_expr_replace_bounds(fppoly_internal_t *pr, expr_t *expr, layer_t *layer, bool is_lower){
+	if(expr->size==0){
+		return copy_cst_expr(expr);
+	}
+	if(expr->inf_coeff==NULL || expr->sup_coeff==NULL){
+		return alloc_expr();
+	}
+	conv_op_t *conv = layer->conv;
+	neuron_t **neurons = layer->neurons;
+	size_t in_y = conv->input_size[1];
+	size_t in_z = conv->input_size[2];
+	size_t out_z = conv->output_size[2];
+	size_t fy = conv->filter_size[1];
+	size_t num_neurons = expr->size;
+	size_t i, z;
+	long int x, y;
+
+	long int win_x_lo = conv->input_size[0], win_x_hi = -1, win_y_lo = in_y, win_y_hi = -1;
+	for(i=0; i < num_neurons; i++){
+		if(expr->sup_coeff[i] < 0 || expr->inf_coeff[i] < 0){
+			size_t k = expr->type==DENSE ? i : expr->dim[i];
+			long int x_lo, x_hi, y_lo, y_hi;
+			conv_op_window(conv, k, &x_lo, &x_hi, &y_lo, &y_hi);
+			if(x_hi < x_lo || y_hi < y_lo){
+				continue;
+			}
+			win_x_lo = x_lo < win_x_lo ? x_lo : win_x_lo;
+			win_x_hi = x_hi > win_x_hi ? x_hi : win_x_hi;
+			win_y_lo = y_lo < win_y_lo ? y_lo : win_y_lo;
+			win_y_hi = y_hi > win_y_hi ? y_hi : win_y_hi;
+		}
+	}
+	size_t win_y = 0, win_size = 0;
+	if(win_x_hi >= win_x_lo){
+		win_y = win_y_hi - win_y_lo + 1;
+		win_size = (win_x_hi - win_x_lo + 1)*win_y*in_z;
+	}
+	double *win_inf = (double *)malloc(win_size*sizeof(double));
+	double *win_sup = (double *)malloc(win_size*sizeof(double));
+	char *touched = (char *)calloc(win_size, sizeof(char));
+	double inf_cst = 0, sup_cst = 0;
+	bool has_coeff = false;
+	// a concretized first coefficient leaves input 0 with a zero coefficient
+	bool zero_dim0 = false;
+
+	for(i=0; i < num_neurons; i++){
+		size_t k = expr->type==DENSE ? i : expr->dim[i];
+		double c_inf = expr->inf_coeff[i];
+		double c_sup = expr->sup_coeff[i];
+		if(c_sup < 0 || c_inf < 0){
+			double bias = conv_op_bias(conv, k);
+			double tmp1, tmp2;
+			long int x_lo, x_hi, y_lo, y_hi;
+			conv_op_window(conv, k, &x_lo, &x_hi, &y_lo, &y_hi);
+			bool row_has_coeff = x_hi >= x_lo && y_hi >= y_lo;
+			elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,c_inf,c_sup,-bias,bias);
+			if(i==0){
+				inf_cst = tmp1;
+				sup_cst = tmp2;
+			}
+			else{
+				conv_add_cst(pr, &inf_cst, &sup_cst, tmp1, tmp2, row_has_coeff);
+			}
+			if(!row_has_coeff){
+				continue;
+			}
+			has_coeff = true;
+			size_t filter_z = k % out_z;
+			long int x_shift = x_lo - ((long int)((k / (conv->output_size[1]*out_z))*conv->strides[0]) - (long int)conv->pad_top);
+			long int y_shift = y_lo - ((long int)(((k / out_z) % conv->output_size[1])*conv->strides[1]) - (long int)conv->pad_left);
+			for(x=x_lo; x <= x_hi; x++){
+				for(y=y_lo; y <= y_hi; y++){
+					double *weights = conv->filter_weights + ((x-x_lo+x_shift)*fy + (y-y_lo+y_shift))*in_z*out_z + filter_z;
+					size_t w = ((x-win_x_lo)*win_y + (y-win_y_lo))*in_z;
+					for(z=0; z < in_z; z++, w++){
+						double weight = weights[z*out_z];
+						elina_double_interval_mul_expr_coeff(pr,&tmp1,&tmp2,c_inf,c_sup,-weight,weight);
+						if(touched[w]){
+							double maxA = fmax(fabs(win_inf[w]),fabs(win_sup[w]));
+							double maxB = fmax(fabs(tmp1),fabs(tmp2));
+							win_inf[w] = win_inf[w] + tmp1 + (maxA + maxB)*pr->ulp;
+							win_sup[w] = win_sup[w] + tmp2 + (maxA + maxB)*pr->ulp;
+						}
+						else{
+							win_inf[w] = tmp1;
+							win_sup[w] = tmp2;
+							touched[w] = 1;
+						}
+					}
+				}
+			}
+		}
+		else if(i==0){
+			double tmp1 = 0.0, tmp2 = 0.0;
+			if(c_inf!=0 || c_sup!=0){
+				elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,neurons[k]->lb,neurons[k]->ub,c_inf,c_sup);
+			}
+			inf_cst = is_lower ? tmp1 : -tmp2;
+			sup_cst = is_lower ? -tmp1 : tmp2;
+			has_coeff = true;
+			if(win_size > 0 && win_x_lo==0 && win_y_lo==0){
+				win_inf[0] = -0.0;
+				win_sup[0] = 0.0;
+				touched[0] = 1;
+			}
+			else{
+				zero_dim0 = true;
+			}
+		}
+		else if(c_inf!=0 || c_sup!=0){
+			double tmp1, tmp2;
+			elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,neurons[k]->lb,neurons[k]->ub,c_inf,c_sup);
+			if(is_lower){
+				inf_cst = inf_cst + tmp1;
+				sup_cst = sup_cst - tmp1;
+			}
+			else{
+				inf_cst = inf_cst - tmp2;
+				sup_cst = sup_cst + tmp2;
+			}
+		}
+	}
+
+	expr_t *res = alloc_expr();
+	res->type = SPARSE;
+	res->size = 0;
+	if(has_coeff){
+		size_t size = zero_dim0 ? 1 : 0;
+		size_t w;
+		for(w=0; w < win_size; w++){
+			size += touched[w];
+		}
+		res->inf_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+		res->sup_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+		res->dim = (size_t *)expr_arena_malloc(size*sizeof(size_t));
+		if(zero_dim0){
+			res->inf_coeff[0] = -0.0;
+			res->sup_coeff[0] = 0.0;
+			res->dim[0] = 0;
+			res->size = 1;
+		}
+		w = 0;
+		for(x=win_x_lo; x <= win_x_hi; x++){
+			for(y=win_y_lo; y <= win_y_hi; y++){
+				size_t input_index = (x*in_y + y)*in_z;
+				for(z=0; z < in_z; z++, w++){
+					if(touched[w]){
+						res->inf_coeff[res->size] = win_inf[w];
+						res->sup_coeff[res->size] = win_sup[w];
+						res->dim[res->size] = input_index + z;
+						res->size++;
+					}
+				}
+			}
+		}
+	}
+	free(win_inf);
+	free(win_sup);
+	free(touched);
+	res->inf_cst = inf_cst + expr->inf_cst;
+	res->sup_cst = sup_cst + expr->sup_cst;
+	return res;
+}
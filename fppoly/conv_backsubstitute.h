@@ -0,0 +1,59 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+
+#ifndef __CONV_BACKSUBSTITUTE_H_INCLUDED__
+#define __CONV_BACKSUBSTITUTE_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+#include "expr.h"
+
+/* Convolutions stored as their filters. The expression of an output neuron is
+   rebuilt from the filter when it is needed, and an expression over the outputs
+   is mapped to the inputs by a transposed convolution into a dense window of the
+   input tensor, instead of merging one sparse row per output neuron. The result
+   is the same expression, with the same rounding, as with the per-neuron rows. */
+
+conv_op_t * conv_op_alloc(double *filter_weights, double *filter_bias, size_t *input_size, size_t *filter_size, size_t *strides, size_t *output_size,
+			size_t pad_top, size_t pad_left, bool has_bias);
+
+void conv_op_free(conv_op_t *conv);
+
+/* the sorted sparse expression of output neuron i */
+expr_t * conv_op_neuron_expr(conv_op_t *conv, size_t i);
+
+/* lexpr_replace_bounds and uexpr_replace_bounds for a layer with a conv operator */
+expr_t * conv_expr_replace_bounds(fppoly_internal_t *pr, expr_t *expr, layer_t *layer, bool is_lower);
+
+/* a copy of the lower or upper expression of neuron i, built from the filter for conv operators */
+expr_t * copy_layer_neuron_expr(layer_t *layer, size_t i, bool is_lower);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
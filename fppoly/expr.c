@@ -71,18 +71,22 @@ void expr_print(expr_t * expr){
 }
 
 expr_t * alloc_expr(void){
-	expr_t *expr = (expr_t *)malloc(sizeof(expr_t));
+	expr_t *expr = (expr_t *)expr_arena_malloc(sizeof(expr_t));
 	expr->inf_coeff = NULL;
 	expr->sup_coeff = NULL;
 	expr->dim = NULL;
+	expr->refcount = 1;
+	expr->borrowed = false;
 	return expr;
 }
 
 expr_t * create_dense_expr(double *coeff, double cst, size_t size){
-	expr_t *expr = (expr_t *)malloc(sizeof(expr_t));
-	expr->inf_coeff = (double *)malloc(size*sizeof(double));
-	expr->sup_coeff = (double *)malloc(size*sizeof(double));
+	expr_t *expr = (expr_t *)expr_arena_malloc(sizeof(expr_t));
+	expr->inf_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+	expr->sup_coeff = (double *)expr_arena_malloc(size*sizeof(double));
 	expr->dim= NULL;
+	expr->refcount = 1;
+	expr->borrowed = false;
 	size_t i;
 	expr->size = size;
 	expr->inf_cst = -cst;
@@ -96,11 +100,64 @@ expr_t * create_dense_expr(double *coeff, double cst, size_t size){
 }
 
 
+expr_t * create_borrowed_dense_expr(double *coeff, double cst, size_t size){
+	expr_t *expr = (expr_t *)expr_arena_malloc(sizeof(expr_t));
+	expr->inf_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+	expr->sup_coeff = coeff;
+	expr->dim= NULL;
+	expr->refcount = 1;
+	expr->borrowed = true;
+	size_t i;
+	expr->size = size;
+	expr->inf_cst = -cst;
+	expr->sup_cst = cst;
+	expr->type = DENSE;
+	for(i=0; i < size; i++){
+		expr->inf_coeff[i] = -coeff[i];
+	}
+	return expr;
+}
+
+
+expr_t * create_strided_dense_expr(const void *coeff, fppoly_dtype_t dtype, ptrdiff_t stride, double cst, size_t size){
+	expr_t *expr = (expr_t *)expr_arena_malloc(sizeof(expr_t));
+	expr->inf_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+	expr->sup_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+	expr->dim= NULL;
+	expr->refcount = 1;
+	expr->borrowed = false;
+	size_t i;
+	expr->size = size;
+	expr->inf_cst = -cst;
+	expr->sup_cst = cst;
+	expr->type = DENSE;
+	const char *p = (const char *)coeff;
+	if(dtype==FPPOLY_FLOAT32){
+		// every float is a double, the coefficients are exact
+		for(i=0; i < size; i++){
+			double c = *(const float *)(p + i*stride);
+			expr->inf_coeff[i] = -c;
+			expr->sup_coeff[i] = c;
+		}
+	}
+	else{
+		for(i=0; i < size; i++){
+			double c = *(const double *)(p + i*stride);
+			expr->inf_coeff[i] = -c;
+			expr->sup_coeff[i] = c;
+		}
+	}
+	return expr;
+}
+
+
 expr_t * create_cst_expr(double l, double u){
-	expr_t *expr = (expr_t*)malloc(sizeof(expr_t));
+	expr_t *expr = (expr_t*)expr_arena_malloc(sizeof(expr_t));
 	expr->inf_coeff = NULL;
 	expr->sup_coeff = NULL;
 	expr->dim = NULL;
+	expr->refcount = 1;
+	expr->borrowed = false;
 	expr->type = SPARSE;
 	expr->size = 0;
 	expr->inf_cst = l;
@@ -109,17 +166,19 @@ expr_t * create_cst_expr(double l, double u){
 }
 
 expr_t * create_sparse_expr(double *coeff, double cst, size_t *dim, size_t size){
-	expr_t *expr = (expr_t *)malloc(sizeof(expr_t));
+	expr_t *expr = (expr_t *)expr_arena_malloc(sizeof(expr_t));
 	if(size>0){
-		expr->inf_coeff = (double *)malloc(size*sizeof(double));
-		expr->sup_coeff = (double *)malloc(size*sizeof(double));
-		expr->dim = (size_t *)malloc(size*sizeof(size_t));
+		expr->inf_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+		expr->sup_coeff = (double *)expr_arena_malloc(size*sizeof(double));
+		expr->dim = (size_t *)expr_arena_malloc(size*sizeof(size_t));
 	}
 	else{
 		expr->inf_coeff = NULL;
 		expr->sup_coeff = NULL;
 		expr->dim = NULL;
 	}
+	expr->refcount = 1;
+	expr->borrowed = false;
 	size_t i;
 	expr->size = size;
 	expr->inf_cst = -cst;
@@ -134,25 +193,56 @@ expr_t * create_sparse_expr(double *coeff, double cst, size_t *dim, size_t size)
 }
 
 
+expr_t * share_expr(expr_t *expr){
+	__atomic_add_fetch(&expr->refcount, 1, __ATOMIC_RELAXED);
+	return expr;
+}
+
+
 void free_expr(expr_t *expr){
+	if(expr->refcount > 1 && __atomic_sub_fetch(&expr->refcount, 1, __ATOMIC_ACQ_REL) > 0){
+		return;
+	}
 	if(expr->inf_coeff){
-		free(expr->inf_coeff);
+		expr_arena_free(expr->inf_coeff);
 		expr->inf_coeff = NULL;
 	}
-	if(expr->sup_coeff){
-		free(expr->sup_coeff);
-		expr->sup_coeff = NULL;
+	if(expr->sup_coeff && !expr->borrowed){
+		expr_arena_free(expr->sup_coeff);
 	}
+	expr->sup_coeff = NULL;
 	if(expr->type==SPARSE && expr->dim){
-		free(expr->dim);
+		expr_arena_free(expr->dim);
 	}
 	expr->dim = NULL;
-	free(expr);
+	expr_arena_free(expr);
 	expr = NULL;  
 }
 
+bool expr_equal(expr_t *a, expr_t *b){
+	if(a==b){
+		return true;
+	}
+	if(a==NULL || b==NULL){
+		return false;
+	}
+	if(a->type!=b->type || a->size!=b->size || a->inf_cst!=b->inf_cst || a->sup_cst!=b->sup_cst){
+		return false;
+	}
+	size_t i;
+	for(i=0; i < a->size; i++){
+		if(a->inf_coeff[i]!=b->inf_coeff[i] || a->sup_coeff[i]!=b->sup_coeff[i]){
+			return false;
+		}
+		if(a->type==SPARSE && a->dim[i]!=b->dim[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
 expr_t * copy_cst_expr(expr_t *src){
-	expr_t *dst = (expr_t *)malloc(sizeof(expr_t));
+	expr_t *dst = (expr_t *)expr_arena_malloc(sizeof(expr_t));
 	dst->inf_coeff = NULL;
 	dst->sup_coeff = NULL;
 	dst->inf_cst = src->inf_cst;
@@ -160,16 +250,19 @@ expr_t * copy_cst_expr(expr_t *src){
 	dst->type = src->type;
 	dst->dim = NULL;
 	dst->size = src->size; 
+	dst->refcount = 1;
+	dst->borrowed = false;
 	return dst;
 }
 
 
 
 expr_t * copy_expr(expr_t *src){
-	expr_t *dst = (expr_t *)malloc(sizeof(expr_t));
-	dst->inf_coeff = (double *)malloc(src->size*sizeof(double));
-	dst->sup_coeff = (double *)malloc(src->size*sizeof(double));
-	
+	expr_t *dst = (expr_t *)expr_arena_malloc(sizeof(expr_t));
+	dst->inf_coeff = (double *)expr_arena_malloc(src->size*sizeof(double));
+	dst->sup_coeff = (double *)expr_arena_malloc(src->size*sizeof(double));
+	dst->refcount = 1;
+	dst->borrowed = false;
 	size_t i;
 	dst->inf_cst = src->inf_cst;
 	dst->sup_cst = src->sup_cst; 
@@ -179,7 +272,7 @@ expr_t * copy_expr(expr_t *src){
 		dst->sup_coeff[i] = src->sup_coeff[i];
 	}
 	if(src->type==SPARSE){
-		dst->dim = (size_t *)malloc(src->size*sizeof(size_t));
+		dst->dim = (size_t *)expr_arena_malloc(src->size*sizeof(size_t));
 		for(i=0; i < src->size; i++){
 			dst->dim[i] = src->dim[i];
 		}
@@ -189,9 +282,11 @@ expr_t * copy_expr(expr_t *src){
 }
 
 expr_t* concretize_dense_sub_expr(fppoly_internal_t *pr, expr_t * expr, double *inf, double *sup, size_t start, size_t size){
-	expr_t * res = (expr_t *)malloc(sizeof(expr_t));
-	res->inf_coeff = (double *)malloc(start*sizeof(double));
-	res->sup_coeff = (double *)malloc(start*sizeof(double));
+	expr_t * res = (expr_t *)expr_arena_malloc(sizeof(expr_t));
+	res->inf_coeff = (double *)expr_arena_malloc(start*sizeof(double));
+	res->sup_coeff = (double *)expr_arena_malloc(start*sizeof(double));
+	res->refcount = 1;
+	res->borrowed = false;
 	size_t i;
 	res->inf_cst = expr->inf_cst;
 	res->sup_cst = expr->sup_cst;
@@ -307,8 +402,8 @@ void sort_sparse_expr(expr_t *expr){
 expr_t * multiply_expr(fppoly_internal_t *pr, expr_t *expr, double mul_inf, double mul_sup){
 	expr_t * res = alloc_expr();
 	if(expr->size > 0){
-		res->inf_coeff = malloc(expr->size*sizeof(double));
-		res->sup_coeff = malloc(expr->size*sizeof(double));
+		res->inf_coeff = expr_arena_malloc(expr->size*sizeof(double));
+		res->sup_coeff = expr_arena_malloc(expr->size*sizeof(double));
 	}
 	else{
 		res->inf_coeff = NULL;		
@@ -316,14 +411,10 @@ expr_t * multiply_expr(fppoly_internal_t *pr, expr_t *expr, double mul_inf, doub
 	}
 	res->type = expr->type;
 	size_t i;
-	for(i=0; i < expr->size; i++){
-		//res->coeff[i] = mul_coeff*expr->coeff[i];
-		elina_double_interval_mul_expr_coeff(pr,&res->inf_coeff[i],&res->sup_coeff[i],mul_inf,mul_sup,expr->inf_coeff[i],expr->sup_coeff[i]);
-		
-	}
+	expr_dense_mul(pr,res->inf_coeff,res->sup_coeff,mul_inf,mul_sup,expr->inf_coeff,expr->sup_coeff,expr->size);
 	if(expr->type==SPARSE){
 		if(expr->size>0){
-			res->dim = (size_t*)malloc(expr->size*sizeof(size_t));
+			res->dim = (size_t*)expr_arena_malloc(expr->size*sizeof(size_t));
 			for(i=0; i < expr->size; i++){
 				res->dim[i] = expr->dim[i];
 			}
@@ -385,15 +476,15 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 		double maxB = fmax(fabs(exprB->inf_cst),fabs(exprB->sup_cst));
 		exprA->inf_cst += exprB->inf_cst  + (maxA + maxB)*pr->ulp + pr->min_denormal;
 		exprA->sup_cst += exprB->sup_cst  + (maxA + maxB)*pr->ulp + pr->min_denormal;
-		exprA->inf_coeff = (double *)malloc(sizeB*sizeof(double));
-		exprA->sup_coeff = (double *)malloc(sizeB*sizeof(double));
+		exprA->inf_coeff = (double *)expr_arena_malloc(sizeB*sizeof(double));
+		exprA->sup_coeff = (double *)expr_arena_malloc(sizeB*sizeof(double));
 		for(i=0; i < sizeB; i++){
 			exprA->inf_coeff[i] = exprB->inf_coeff[i];
 			exprA->sup_coeff[i] = exprB->sup_coeff[i];
 		} 
 		exprA->type = exprB->type;
 		if(exprA->type==SPARSE){
-			exprA->dim = (size_t *)malloc(sizeB*sizeof(size_t));
+			exprA->dim = (size_t *)expr_arena_malloc(sizeB*sizeof(size_t));
 			for(i=0; i < sizeB; i++){
 				exprA->dim[i] = exprB->dim[i];
 			}
@@ -412,12 +503,7 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 			if(exprB->type==DENSE){
 				//printf("AA\n");
 				//fflush(stdout);
-				for(i=0; i < sizeB; i++){
-					maxA = fmax(fabs(exprA->inf_coeff[i]),fabs(exprA->sup_coeff[i]));
-					maxB = fmax(fabs(exprB->inf_coeff[i]),fabs(exprB->sup_coeff[i]));
-					exprA->inf_coeff[i] = exprA->inf_coeff[i] + exprB->inf_coeff[i] + (maxA + maxB)*pr->ulp;
-					exprA->sup_coeff[i] = exprA->sup_coeff[i] + exprB->sup_coeff[i] + (maxA + maxB)*pr->ulp;
-				}
+				expr_dense_add(pr,exprA->inf_coeff,exprA->sup_coeff,exprB->inf_coeff,exprB->sup_coeff,sizeB);
 			}
 			else{
 				//printf("AB\n");	
@@ -443,8 +529,8 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 				//printf("BB\n");
 				//fflush(stdout);
 				i=0;
-				new_inf_coeff = (double *)malloc(sizeB*sizeof(double));
-				new_sup_coeff = (double *)malloc(sizeB*sizeof(double));				
+				new_inf_coeff = (double *)expr_arena_malloc(sizeB*sizeof(double));
+				new_sup_coeff = (double *)expr_arena_malloc(sizeB*sizeof(double));				
 				for(k=0; k < sizeB; k++){
 					if(i < sizeA && exprA->dim[i] == k){
 						maxA = fmax(fabs(exprA->inf_coeff[i]),fabs(exprA->sup_coeff[i]));
@@ -460,7 +546,7 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 				}
 				exprA->type = DENSE;
 				exprA->size = sizeB;
-				free(exprA->dim);
+				expr_arena_free(exprA->dim);
 				exprA->dim = NULL;
 			}
 			else{
@@ -479,9 +565,9 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 				//expr_print(exprA);
 				//fflush(stdout);
 				
-				new_inf_coeff = (double *)malloc((sizeA+sizeB)*sizeof(double));
-				new_sup_coeff = (double *)malloc((sizeA+sizeB)*sizeof(double));
-				size_t * new_dim = (size_t *)malloc((sizeA+sizeB)*sizeof(size_t));
+				new_inf_coeff = (double *)expr_arena_malloc((sizeA+sizeB)*sizeof(double));
+				new_sup_coeff = (double *)expr_arena_malloc((sizeA+sizeB)*sizeof(double));
+				size_t * new_dim = (size_t *)expr_arena_malloc((sizeA+sizeB)*sizeof(size_t));
 				while(i < sizeA && k < sizeB){
 					if(exprA->dim[i] < exprB->dim[k]){
 						new_inf_coeff[l] = exprA->inf_coeff[i];
@@ -522,20 +608,20 @@ void add_expr(fppoly_internal_t *pr,expr_t * exprA, expr_t * exprB){
 					l++;
 				}
 				
-				new_inf_coeff = (double*)realloc(new_inf_coeff,l*sizeof(double));
-				new_sup_coeff = (double*)realloc(new_sup_coeff,l*sizeof(double));
-				free(exprA->dim);
+				new_inf_coeff = (double*)expr_arena_realloc(new_inf_coeff,l*sizeof(double));
+				new_sup_coeff = (double*)expr_arena_realloc(new_sup_coeff,l*sizeof(double));
+				expr_arena_free(exprA->dim);
 				exprA->dim = NULL;
-				new_dim = (size_t *)realloc(new_dim,l*sizeof(size_t));
+				new_dim = (size_t *)expr_arena_realloc(new_dim,l*sizeof(size_t));
 				exprA->dim = new_dim;
 				exprA->size = l;
 			}
 			if(exprA->inf_coeff){
-				free(exprA->inf_coeff);
+				expr_arena_free(exprA->inf_coeff);
 				exprA->inf_coeff = NULL;
 			}
 			if(exprA->sup_coeff){
-				free(exprA->sup_coeff);
+				expr_arena_free(exprA->sup_coeff);
 				exprA->sup_coeff = NULL;
 			}
 			exprA->inf_coeff = new_inf_coeff;
@@ -563,8 +649,8 @@ expr_t * extract_subexpr_concatenate(expr_t * expr, size_t index, size_t* C, siz
 	if(expr->type==DENSE){
 		res->type = DENSE;
 		size_t num_neurons_in_layer = C[index] * hw;
-		res->inf_coeff = (double *)malloc(num_neurons_in_layer*sizeof(double));
-		res->sup_coeff = (double *)malloc(num_neurons_in_layer*sizeof(double));
+		res->inf_coeff = (double *)expr_arena_malloc(num_neurons_in_layer*sizeof(double));
+		res->sup_coeff = (double *)expr_arena_malloc(num_neurons_in_layer*sizeof(double));
 		res->size = num_neurons_in_layer;
 		for(i=0; i < hw; i++){
 			//printf("START HERE: %zu %zu\n", i*num_channels+offset, num_neurons_in_layer);
@@ -595,9 +681,9 @@ expr_t * extract_subexpr_concatenate(expr_t * expr, size_t index, size_t* C, siz
 			}
 			
 		}
-		res->inf_coeff = (double *)malloc(res_size*sizeof(double));
-		res->sup_coeff = (double *)malloc(res_size*sizeof(double));
-		res->dim = (size_t *)malloc(res_size*sizeof(size_t));
+		res->inf_coeff = (double *)expr_arena_malloc(res_size*sizeof(double));
+		res->sup_coeff = (double *)expr_arena_malloc(res_size*sizeof(double));
+		res->dim = (size_t *)expr_arena_malloc(res_size*sizeof(size_t));
 		res->size = res_size;
 		res->type = SPARSE;
 		for(i=0; i < expr->size; i++){
@@ -760,8 +846,8 @@ expr_t * expr_replace_bounds_activation(fppoly_internal_t * pr, expr_t * expr, n
 	size_t num_neurons = expr->size;
 	size_t i,k;
 	expr_t * res = alloc_expr();  
-	res->inf_coeff = (double *)malloc(num_neurons*sizeof(double));
-	res->sup_coeff = (double *)malloc(num_neurons*sizeof(double));
+	res->inf_coeff = (double *)expr_arena_malloc(num_neurons*sizeof(double));
+	res->sup_coeff = (double *)expr_arena_malloc(num_neurons*sizeof(double));
 	res->inf_cst = expr->inf_cst;
 	res->sup_cst = expr->sup_cst;
 	res->type = expr->type;
@@ -829,7 +915,7 @@ expr_t * expr_replace_bounds_activation(fppoly_internal_t * pr, expr_t * expr, n
 		}
 	}
 	if(expr->type==SPARSE){
-		res->dim = (size_t*)malloc(num_neurons*sizeof(size_t));
+		res->dim = (size_t*)expr_arena_malloc(num_neurons*sizeof(size_t));
 		for(i=0; i < num_neurons; i++){
 			res->dim[i] = expr->dim[i];
 		}
@@ -865,6 +951,20 @@ expr_t * uexpr_replace_bounds(fppoly_internal_t * pr, expr_t * expr, neuron_t **
 	}
 }
 
+/* acc = acc + [-inf, sup] with the error bound of add_cst_expr, adding to an exact zero is exact */
+void expr_interval_accumulate_cst(fppoly_internal_t *pr, double *acc_inf, double *acc_sup, double inf, double sup){
+	if(*acc_inf==0 && *acc_sup==0){
+		*acc_inf = inf;
+		*acc_sup = sup;
+		return;
+	}
+	double maxA = fmax(fabs(*acc_inf),fabs(*acc_sup));
+	double maxB = fmax(fabs(inf),fabs(sup));
+	*acc_inf = *acc_inf + inf + (maxA + maxB)*pr->ulp + pr->min_denormal;
+	*acc_sup = *acc_sup + sup + (maxA + maxB)*pr->ulp + pr->min_denormal;
+}
+
+
 elina_linexpr0_t *elina_linexpr0_from_expr(expr_t *expr){
 	//assert(expr->type==DENSE);
 	size_t size = expr->size;
@@ -28,6 +28,8 @@ extern "C" {
 #endif
 
 #include "fppoly.h"
+#include "expr_arena.h"
+#include "interval_kernels.h"
 
 void elina_double_interval_add_expr_coeff(fppoly_internal_t *pr, double * res_inf, double *res_sup, double inf, double sup, double inf_expr, double sup_expr);
 
@@ -45,12 +47,25 @@ expr_t * alloc_expr(void);
 
 expr_t * create_dense_expr(double *coeff, double cst, size_t size);
 
+/* like create_dense_expr but sup_coeff points to coeff, which must outlive the expression */
+expr_t * create_borrowed_dense_expr(double *coeff, double cst, size_t size);
+
+/* like create_dense_expr with coefficient i read at byte offset i*stride from coeff */
+expr_t * create_strided_dense_expr(const void *coeff, fppoly_dtype_t dtype, ptrdiff_t stride, double cst, size_t size);
+
 expr_t * create_cst_expr(double l, double u);
 
 expr_t * create_sparse_expr(double *coeff, double cst, size_t *dim, size_t size);
 
+/* adds an owner to expr, it is released by the matching free_expr; shared
+   expressions must not be modified in place */
+expr_t * share_expr(expr_t *expr);
+
 void free_expr(expr_t *expr);
 
+/* true if a and b have the same coefficients and constants */
+bool expr_equal(expr_t *a, expr_t *b);
+
 expr_t * copy_cst_expr(expr_t *src);
 
 expr_t * copy_expr(expr_t *src);
@@ -77,6 +92,8 @@ expr_t * lexpr_replace_bounds(fppoly_internal_t * pr, expr_t * expr, neuron_t **
 
 expr_t * uexpr_replace_bounds(fppoly_internal_t * pr, expr_t * expr, neuron_t ** neurons, bool is_activation);
 
+void expr_interval_accumulate_cst(fppoly_internal_t *pr, double *acc_inf, double *acc_sup, double inf, double sup);
+
 elina_linexpr0_t *elina_linexpr0_from_expr(expr_t *expr);
 
 #ifdef __cplusplus
@@ -0,0 +1,238 @@
+#include "expr_arena.h"
+
+/* every arena allocation is preceded by its size, kept 16 byte aligned */
+#define EXPR_ARENA_HEADER 16
+
+typedef struct expr_arena_block_t{
+	char *data;
+	size_t capacity;
+}expr_arena_block_t;
+
+typedef struct expr_arena_t{
+	expr_arena_block_t *blocks;
+	size_t num_blocks;
+	size_t max_blocks;
+	/* bytes used in the last block */
+	size_t used;
+	/* sum of the capacities of the blocks, at most EXPR_ARENA_MAX_SIZE */
+	size_t capacity;
+	/* nesting depth of begin/end, the arena is active while > 0 */
+	size_t depth;
+}expr_arena_t;
+
+static __thread expr_arena_t *thread_arena = NULL;
+static pthread_key_t expr_arena_key;
+static pthread_once_t expr_arena_key_once = PTHREAD_ONCE_INIT;
+
+
+static void expr_arena_destroy(void *arg){
+	expr_arena_t *arena = (expr_arena_t *)arg;
+	size_t i;
+	for(i=0; i < arena->num_blocks; i++){
+		free(arena->blocks[i].data);
+	}
+	free(arena->blocks);
+	free(arena);
+}
+
+
+static void expr_arena_make_key(void){
+	pthread_key_create(&expr_arena_key, expr_arena_destroy);
+}
+
+
+static expr_arena_t * expr_arena_get(void){
+	if(thread_arena==NULL){
+		pthread_once(&expr_arena_key_once, expr_arena_make_key);
+		expr_arena_t *arena = (expr_arena_t *)malloc(sizeof(expr_arena_t));
+		arena->blocks = NULL;
+		arena->num_blocks = 0;
+		arena->max_blocks = 0;
+		arena->used = 0;
+		arena->capacity = 0;
+		arena->depth = 0;
+		/* released by the key destructor when the thread exits */
+		pthread_setspecific(expr_arena_key, arena);
+		thread_arena = arena;
+	}
+	return thread_arena;
+}
+
+
+static void expr_arena_add_block(expr_arena_t *arena, size_t capacity){
+	if(arena->num_blocks==arena->max_blocks){
+		arena->max_blocks = arena->max_blocks ? 2*arena->max_blocks : 4;
+		arena->blocks = (expr_arena_block_t *)realloc(arena->blocks, arena->max_blocks*sizeof(expr_arena_block_t));
+	}
+	arena->blocks[arena->num_blocks].data = (char *)malloc(capacity);
+	arena->blocks[arena->num_blocks].capacity = capacity;
+	arena->num_blocks++;
+	arena->capacity += capacity;
+	arena->used = 0;
+}
+
+
+/* bytes taken in a block by an allocation of size bytes, header included */
+static size_t expr_arena_bytes(size_t size){
+	return EXPR_ARENA_HEADER + ((size + EXPR_ARENA_HEADER - 1) & ~(size_t)(EXPR_ARENA_HEADER - 1));
+}
+
+
+/* true if ptr is the most recent allocation of the last block */
+static bool expr_arena_is_last(expr_arena_t *arena, char *p, size_t size){
+	expr_arena_block_t *block = &arena->blocks[arena->num_blocks-1];
+	return p > block->data && p - EXPR_ARENA_HEADER + expr_arena_bytes(size) == block->data + arena->used;
+}
+
+
+static bool expr_arena_owns(expr_arena_t *arena, void *ptr){
+	size_t i;
+	char *p = (char *)ptr;
+	for(i=arena->num_blocks; i > 0; i--){
+		expr_arena_block_t *block = &arena->blocks[i-1];
+		if(p >= block->data && p < block->data + block->capacity){
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void expr_arena_begin(void){
+	expr_arena_t *arena = expr_arena_get();
+	arena->depth++;
+}
+
+
+void expr_arena_end(void){
+	expr_arena_t *arena = thread_arena;
+	if(arena==NULL || arena->depth==0){
+		return;
+	}
+	arena->depth--;
+	if(arena->depth > 0){
+		return;
+	}
+	/* coalesce into one block large enough for the whole last region, the
+	   capacity never exceeds EXPR_ARENA_MAX_SIZE */
+	if(arena->num_blocks > 1){
+		size_t i, capacity = arena->capacity;
+		for(i=0; i < arena->num_blocks; i++){
+			free(arena->blocks[i].data);
+		}
+		arena->num_blocks = 0;
+		arena->capacity = 0;
+		expr_arena_add_block(arena, capacity);
+	}
+	arena->used = 0;
+}
+
+
+void * expr_arena_malloc(size_t size){
+	expr_arena_t *arena = thread_arena;
+	if(arena==NULL || arena->depth==0){
+		return malloc(size);
+	}
+	size_t bytes = expr_arena_bytes(size);
+	if(arena->num_blocks==0 || arena->used + bytes > arena->blocks[arena->num_blocks-1].capacity){
+		size_t capacity = arena->num_blocks ? 2*arena->blocks[arena->num_blocks-1].capacity : EXPR_ARENA_MIN_BLOCK_SIZE;
+		if(capacity > EXPR_ARENA_MAX_SIZE - arena->capacity){
+			capacity = EXPR_ARENA_MAX_SIZE - arena->capacity;
+		}
+		if(capacity < bytes){
+			/* the arena is full, the rest of the region uses the heap */
+			return malloc(size);
+		}
+		expr_arena_add_block(arena, capacity);
+	}
+	char *p = arena->blocks[arena->num_blocks-1].data + arena->used;
+	arena->used += bytes;
+	*(size_t *)p = size;
+	return p + EXPR_ARENA_HEADER;
+}
+
+
+void expr_arena_free(void *ptr){
+	expr_arena_t *arena = thread_arena;
+	if(ptr==NULL){
+		return;
+	}
+	if(arena==NULL || arena->num_blocks==0 || !expr_arena_owns(arena, ptr)){
+		free(ptr);
+		return;
+	}
+	/* only the most recent allocation is given back before the region ends */
+	char *p = (char *)ptr;
+	size_t size = *(size_t *)(p - EXPR_ARENA_HEADER);
+	if(expr_arena_is_last(arena, p, size)){
+		arena->used -= expr_arena_bytes(size);
+	}
+}
+
+
+void * expr_arena_realloc(void *ptr, size_t size){
+	expr_arena_t *arena = thread_arena;
+	if(ptr==NULL){
+		return expr_arena_malloc(size);
+	}
+	if(arena==NULL || arena->num_blocks==0 || !expr_arena_owns(arena, ptr)){
+		return realloc(ptr, size);
+	}
+	char *p = (char *)ptr;
+	size_t old_size = *(size_t *)(p - EXPR_ARENA_HEADER);
+	if(size <= old_size){
+		return ptr;
+	}
+	/* the last allocation grows in place while its block has room */
+	if(expr_arena_is_last(arena, p, old_size)){
+		size_t start = arena->used - expr_arena_bytes(old_size);
+		if(start + expr_arena_bytes(size) <= arena->blocks[arena->num_blocks-1].capacity){
+			arena->used = start + expr_arena_bytes(size);
+			*(size_t *)(p - EXPR_ARENA_HEADER) = size;
+			return ptr;
+		}
+	}
+	void *res = expr_arena_malloc(size);
+	memcpy(res, ptr, old_size);
+	expr_arena_free(ptr);
+	return res;
+}
+
+
+expr_t * expr_arena_persist(expr_t *expr){
+	expr_arena_t *arena = thread_arena;
+	if(expr==NULL || arena==NULL || arena->num_blocks==0){
+		return expr;
+	}
+	/* the arena may hold the struct, the arrays, or both */
+	if(!expr_arena_owns(arena, expr) && !expr_arena_owns(arena, expr->inf_coeff) && !expr_arena_owns(arena, expr->sup_coeff) && !expr_arena_owns(arena, expr->dim)){
+		return expr;
+	}
+	size_t size = expr->size;
+	expr_t *res = (expr_t *)malloc(sizeof(expr_t));
+	*res = *expr;
+	res->inf_coeff = NULL;
+	res->sup_coeff = expr->borrowed ? expr->sup_coeff : NULL;
+	res->dim = NULL;
+	if(expr->inf_coeff){
+		res->inf_coeff = (double *)malloc(size*sizeof(double));
+		memcpy(res->inf_coeff, expr->inf_coeff, size*sizeof(double));
+	}
+	if(expr->sup_coeff && !expr->borrowed){
+		res->sup_coeff = (double *)malloc(size*sizeof(double));
+		memcpy(res->sup_coeff, expr->sup_coeff, size*sizeof(double));
+	}
+	if(expr->type==SPARSE && expr->dim){
+		res->dim = (size_t *)malloc(size*sizeof(size_t));
+		memcpy(res->dim, expr->dim, size*sizeof(size_t));
+	}
+	expr_arena_free(expr->inf_coeff);
+	if(!expr->borrowed){
+		expr_arena_free(expr->sup_coeff);
+	}
+	if(expr->type==SPARSE){
+		expr_arena_free(expr->dim);
+	}
+	expr_arena_free(expr);
+	return res;
+}
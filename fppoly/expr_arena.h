@@ -0,0 +1,64 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+#ifndef __EXPR_ARENA_H_INCLUDED__
+#define __EXPR_ARENA_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+
+/* Per-thread bump allocator for the temporary expressions created while one
+   neuron is back-substituted. Between expr_arena_begin and expr_arena_end the
+   allocations of expr.c come from the arena of the calling thread and
+   free_expr is a no-op for them; expr_arena_end releases everything at once.
+   Outside of such a region, and for expressions that were allocated on the
+   heap, the functions fall back to malloc/realloc/free. Expressions that must
+   outlive the region have to be moved out with expr_arena_persist.
+   The most recent allocation is freed or grown in place. An arena never holds
+   more than EXPR_ARENA_MAX_SIZE bytes; once that is used up, the rest of the
+   region is served from the heap, so a thread keeps at most that much between
+   regions. */
+
+#define EXPR_ARENA_MIN_BLOCK_SIZE (1UL << 20)
+
+#define EXPR_ARENA_MAX_SIZE (1UL << 21)
+
+void expr_arena_begin(void);
+
+void expr_arena_end(void);
+
+void * expr_arena_malloc(size_t size);
+
+void * expr_arena_realloc(void *ptr, size_t size);
+
+void expr_arena_free(void *ptr);
+
+expr_t * expr_arena_persist(expr_t *expr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
@@ -19,6 +19,8 @@
  */
 
 #include "backsubstitute.h"
+#include "maxpool_convex_hull.h"
+#include "fppoly_snapshot.h"
 
 
 
@@ -41,6 +43,9 @@ static inline void fppoly_internal_free(fppoly_internal_t* pr)
 {
     if (pr) {
 	pr->funid = ELINA_FUNID_UNKNOWN;
+	fppoly_thread_pool_free(pr->pool);
+	maxpool_hull_cache_free(pr->maxpool_cache);
+	fppoly_stats_free(pr->stats);
 	free(pr);
 	pr = NULL;
     }
@@ -55,6 +60,18 @@ static inline fppoly_internal_t* fppoly_internal_alloc(void)
     pr->funopt = NULL; 
     pr->min_denormal = ldexpl(1.0,-1074);
     pr->ulp = ldexpl(1.0,-52);
+    pr->pool = NULL;
+    pr->backsubstitution = FPPOLY_BACKSUBSTITUTE_NEURON;
+    pr->borrow_weights = false;
+    pr->implicit_conv = false;
+    pr->maxpool_cache = maxpool_hull_cache_alloc(MAXPOOL_HULL_CACHE_SIZE);
+#ifdef GUROBI
+    pr->spatial_solver = FPPOLY_SPATIAL_GUROBI;
+#else
+    pr->spatial_solver = FPPOLY_SPATIAL_NONE;
+#endif
+    pr->single_precision = false;
+    pr->stats = fppoly_stats_alloc();
     return pr;
 }
 
@@ -64,7 +81,8 @@ fppoly_internal_t* fppoly_init_from_manager(elina_manager_t* man, elina_funid_t
 {
 	
     fppoly_internal_t* pr = (fppoly_internal_t*)man->internal;
-    pr->funid = funid;
+    /* pool workers pass the funid their caller set, they only read it */
+    if (pr->funid!=funid) pr->funid = funid;
 	
     if (!(pr->man)) pr->man = man;
 	
@@ -76,6 +94,7 @@ elina_manager_t * fppoly_manager_alloc(void){
 	void** funptr;
 	fesetround(FE_UPWARD);
 	fppoly_internal_t *pr = fppoly_internal_alloc();
+	pr->pool = fppoly_thread_pool_alloc(0, false);
 	elina_manager_t *man = elina_manager_alloc("fppoly",/* Library name */
 			"1.0", /* version */
 			pr, /* internal structure */
@@ -89,14 +108,56 @@ elina_manager_t * fppoly_manager_alloc(void){
 }
 
 
+/* num_threads = 0 uses one thread per online CPU */
+void fppoly_manager_set_num_threads(elina_manager_t *man, size_t num_threads, bool set_affinity){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	fppoly_thread_pool_free(pr->pool);
+	pr->pool = fppoly_thread_pool_alloc(num_threads, set_affinity);
+}
+
+
+void fppoly_manager_set_backsubstitution(elina_manager_t *man, fppoly_backsubstitution_t backsubstitution){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pr->backsubstitution = backsubstitution;
+}
+
+
+void fppoly_manager_set_borrow_weights(elina_manager_t *man, bool borrow){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pr->borrow_weights = borrow;
+}
+
+
+void fppoly_manager_set_spatial_solver(elina_manager_t *man, fppoly_spatial_solver_t solver){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pr->spatial_solver = solver;
+}
+
+
+void fppoly_manager_set_implicit_conv(elina_manager_t *man, bool implicit){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pr->implicit_conv = implicit;
+}
+
+
+void fppoly_manager_set_single_precision(elina_manager_t *man, bool single){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pr->single_precision = single;
+}
+
+
+static void neuron_init(neuron_t *neuron){
+	neuron->lb = -INFINITY;
+	neuron->ub = INFINITY;
+	neuron->lexpr = NULL;
+	neuron->uexpr = NULL;
+	neuron->backsubstituted_lexpr = NULL;
+	neuron->backsubstituted_uexpr = NULL;
+}
+
 neuron_t *neuron_alloc(void){
 	neuron_t *res =  (neuron_t *)malloc(sizeof(neuron_t));
-	res->lb = -INFINITY;
-	res->ub = INFINITY;
-	res->lexpr = NULL;
-	res->uexpr = NULL;
-	res->backsubstituted_lexpr = NULL;
-	res->backsubstituted_uexpr = NULL;
+	neuron_init(res);
 	return res;
 }
 
@@ -105,9 +166,11 @@ layer_t * create_layer(size_t size, bool is_activation){
 	layer->dims = size;
 	layer->is_activation = is_activation;
 	layer->neurons = (neuron_t**)malloc(size*sizeof(neuron_t*));
+	layer->neuron_block = (neuron_t*)malloc(size*sizeof(neuron_t));
 	size_t i;
 	for(i=0; i < size; i++){
-		layer->neurons[i] = neuron_alloc();
+		neuron_init(&layer->neuron_block[i]);
+		layer->neurons[i] = &layer->neuron_block[i];
 	}
 	layer->h_t_inf = NULL;
 	layer->h_t_sup = NULL;
@@ -116,6 +179,7 @@ layer_t * create_layer(size_t size, bool is_activation){
 	layer->is_concat = false;
 	layer->C = NULL;
 	layer->num_channels = 0;
+	layer->conv = NULL;
 	return layer;
 }
 
@@ -142,6 +206,9 @@ void fppoly_from_network_input_box(fppoly_t *res, size_t intdim, size_t realdim,
 	res->num_pixels = num_pixels;
     res->spatial_indices = NULL;
     res->spatial_neighbors = NULL;
+    res->spatial_size = 0;
+    res->spatial_lp = NULL;
+    res->snapshot = NULL;
 }
 
 
@@ -174,6 +241,8 @@ elina_abstract0_t* fppoly_from_network_input_poly(elina_manager_t *man,
 	size_t num_pixels = intdim + realdim;
 	res->input_lexpr = (expr_t **)malloc(num_pixels*sizeof(expr_t *));
 	res->input_uexpr = (expr_t **)malloc(num_pixels*sizeof(expr_t *));
+	free(res->original_input_inf);
+	free(res->original_input_sup);
 	res->original_input_inf = NULL;
 	res->original_input_sup = NULL;
 	size_t i;
@@ -210,6 +279,10 @@ elina_abstract0_t* fppoly_from_network_input_poly(elina_manager_t *man,
     res->spatial_neighbors = malloc(spatial_size * sizeof(size_t));
     memcpy(res->spatial_indices, spatial_indices, spatial_size * sizeof(size_t));
     memcpy(res->spatial_neighbors, spatial_neighbors, spatial_size * sizeof(size_t));
+    if (spatial_size > 0) {
+        fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+        res->spatial_lp = spatial_lp_alloc(res, pr->spatial_solver);
+    }
 
     return abstract0_of_fppoly(man,res);	
 }
@@ -228,8 +301,10 @@ void fppoly_add_new_layer(fppoly_t *fp, size_t size, size_t *predecessors, size_
 }
 
 void neuron_fprint(FILE * stream, neuron_t *neuron, char ** name_of_dim){
-	expr_fprint(stream,neuron->lexpr);
-	expr_fprint(stream, neuron->uexpr);
+	if(neuron->lexpr){
+		expr_fprint(stream,neuron->lexpr);
+		expr_fprint(stream, neuron->uexpr);
+	}
 	fprintf(stream,"[%g, %g]\n",-neuron->lb,neuron->ub);
 }
 
@@ -295,6 +370,7 @@ void handle_fully_connected_layer_with_backsubstitute(elina_manager_t* man, elin
     //fflush(stdout);
     assert(num_predecessors==1);
     fppoly_t *fp = fppoly_of_abstract0(element);
+    fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
     size_t numlayers = fp->numlayers;
     if(alloc){
         fppoly_add_new_layer(fp,num_out_neurons, predecessors, num_predecessors, false);
@@ -317,7 +393,12 @@ void handle_fully_connected_layer_with_backsubstitute(elina_manager_t* man, elin
         }
         else{
             double * weight_i = weights[i];
+            if(pr->borrow_weights){
+                out_neurons[i]->lexpr = create_borrowed_dense_expr(weight_i,cst_i,num_in_neurons);
+            }
+            else{
                 out_neurons[i]->lexpr = create_dense_expr(weight_i,cst_i,num_in_neurons);
+            }
         }
 	    out_neurons[i]->uexpr = out_neurons[i]->lexpr;
     }
@@ -431,6 +512,29 @@ void handle_fully_connected_layer(elina_manager_t* man, elina_abstract0_t * abs,
 
 
 
+void handle_fully_connected_layer_buffer(elina_manager_t* man, elina_abstract0_t* element, void *weights, fppoly_dtype_t dtype, ptrdiff_t row_stride, ptrdiff_t col_stride, bool may_borrow, double * bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors){
+    assert(num_predecessors==1);
+    fppoly_t *fp = fppoly_of_abstract0(element);
+    fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+    size_t numlayers = fp->numlayers;
+    fppoly_add_new_layer(fp,num_out_neurons, predecessors, num_predecessors, false);
+    neuron_t **out_neurons = fp->layers[numlayers]->neurons;
+    bool borrow = pr->borrow_weights && may_borrow && dtype==FPPOLY_FLOAT64 && col_stride==sizeof(double);
+    size_t i;
+    for(i=0; i < num_out_neurons; i++){
+        char *row = (char *)weights + i*row_stride;
+        if(borrow){
+            out_neurons[i]->lexpr = create_borrowed_dense_expr((double *)row,bias[i],num_in_neurons);
+        }
+        else{
+            out_neurons[i]->lexpr = create_strided_dense_expr(row,dtype,col_stride,bias[i],num_in_neurons);
+        }
+        out_neurons[i]->uexpr = out_neurons[i]->lexpr;
+    }
+    update_state_using_previous_layers_parallel(man,fp,numlayers);
+}
+
+
 void coeff_to_interval(elina_coeff_t *coeff, double *inf, double *sup){
 	double d;
 	if(coeff->discr==ELINA_COEFF_SCALAR){
@@ -456,6 +560,8 @@ expr_t * elina_linexpr0_to_expr(elina_linexpr0_t *linexpr0){
 	res->inf_coeff = (double*)malloc(size*sizeof(double));
 	res->sup_coeff = (double*)malloc(size*sizeof(double));
 	res->size = size;
+	res->refcount = 1;
+	res->borrowed = false;
 	if(linexpr0->discr==ELINA_LINEXPR_SPARSE){
 		res->type = SPARSE;
 		res->dim = (size_t *)malloc(size*sizeof(size_t));
@@ -500,16 +606,22 @@ void *get_upper_bound_for_linexpr0_parallel(void *args){
 	double * res = data->res;
 	size_t i;
 	for(i=idx_start; i < idx_end; i++){
+		expr_arena_begin();
 		expr_t * tmp = elina_linexpr0_to_expr(linexpr0[i]);
 		double ub = compute_ub_from_expr(pr,tmp,fp,layerno);
         	if(linexpr0[i]->size==1){
 			res[i] = ub;
+			free_expr(tmp);
+			expr_arena_end();
 			continue;
 		}
 		expr_t * uexpr = NULL;
 		if(fp->layers[layerno]->num_predecessors==2){
 			uexpr = copy_expr(tmp);
 		}
+		else if(fp->layers[layerno]->conv){
+			uexpr = conv_expr_replace_bounds(pr, tmp, fp->layers[layerno], false);
+		}
 		else{
 			uexpr = uexpr_replace_bounds(pr, tmp,fp->layers[layerno]->neurons, false);
 		}
@@ -518,6 +630,7 @@ void *get_upper_bound_for_linexpr0_parallel(void *args){
 	
 		free_expr(uexpr);
     		free_expr(tmp);
+		expr_arena_end();
 		res[i] = ub;
 	}
 	return NULL;
@@ -526,66 +639,10 @@ void *get_upper_bound_for_linexpr0_parallel(void *args){
 
 double *get_upper_bound_for_linexpr0(elina_manager_t *man, elina_abstract0_t *element, elina_linexpr0_t **linexpr0, size_t size, size_t layerno){
 	fppoly_t * fp = fppoly_of_abstract0(element);
-	size_t NUM_THREADS = sysconf(_SC_NPROCESSORS_ONLN);
-	nn_thread_t args[NUM_THREADS];
-	pthread_t threads[NUM_THREADS];
-	size_t i;
 	//printf("layerno %zu %zu\n",layerno,fp->layers[layerno]->predecessors[0]-1);
 	//fflush(stdout);
 	double * res = (double *)malloc(size*sizeof(double));
-	if(size < NUM_THREADS){
-		for (i = 0; i < size; i++){
-	    		args[i].start = i;
-	    		args[i].end = i+1;
-			args[i].man = man;
-			args[i].fp = fp;
-			args[i].layerno = layerno;
-			args[i].linexpr0 = linexpr0;
-			args[i].res = res;
-	    		pthread_create(&threads[i], NULL,get_upper_bound_for_linexpr0_parallel, (void*)&args[i]);
-
-	  	}
-		for (i = 0; i < size; i = i + 1){
-			pthread_join(threads[i], NULL);
-		}
-	}
-	else{
-		size_t idx_start = 0;
-		size_t idx_n = size / NUM_THREADS;
-		size_t idx_end = idx_start + idx_n;
-
-
-	  	for (i = 0; i < NUM_THREADS; i++){
-	    		args[i].start = idx_start;
-	    		args[i].end = idx_end;
-			args[i].man = man;
-			args[i].fp = fp;
-			args[i].layerno = layerno;
-			args[i].linexpr0 = linexpr0;
-			args[i].res = res;
-	    		pthread_create(&threads[i], NULL, get_upper_bound_for_linexpr0_parallel, (void*)&args[i]);
-			idx_start = idx_end;
-			idx_end = idx_start + idx_n;
-	    		if(idx_end> size){
-				idx_end = size;
-			}
-			if((i==NUM_THREADS-2)){
-				idx_end = size;
-
-			}
-	  	}
-		//idx_start = idx_end;
-	    	//idx_end = num_out_neurons;
-		//args[i].start = idx_start;
-	    	//args[i].end = idx_end;
-		//args[i].man = man;
-		//args[i].fp = fp;
-		//args[i].layerno = layerno;
-	    	//pthread_create(&threads[i], NULL,update_state_using_previous_layers, (void*)&args[i]);
-		for (i = 0; i < NUM_THREADS; i = i + 1){
-			pthread_join(threads[i], NULL);
-		}
-	}
+	fppoly_parallel_for(man, fp, layerno, 0, size, linexpr0, res, get_upper_bound_for_linexpr0_parallel);
 	return res;
 }
 
@@ -593,6 +650,9 @@ double *get_upper_bound_for_linexpr0(elina_manager_t *man, elina_abstract0_t *el
 void handle_concatenation_layer(elina_manager_t* man, elina_abstract0_t* element, size_t * predecessors, size_t num_predecessors, size_t *C){
     fppoly_t *fp = fppoly_of_abstract0(element);
     size_t numlayers = fp->numlayers;
+    fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+    fppoly_stats_timer_t timer;
+    fppoly_stats_start(pr, &timer);
 
     //printf("Concat starts here: %zu, first input: %zu, last input: %zu\n", numlayers, predecessors[0], predecessors[num_predecessors - 1]);
     //fflush(stdout);
@@ -661,6 +721,7 @@ void handle_concatenation_layer(elina_manager_t* man, elina_abstract0_t* element
     //printf("return here2\n");
     //fppoly_fprint(stdout,man,fp,NULL);
     //fflush(stdout);
+    fppoly_stats_stop(pr, fp, numlayers, &timer);
     return;
 }
 
@@ -670,6 +731,9 @@ void handle_tiling_layer(elina_manager_t* man, elina_abstract0_t* element, size_
     assert(num_predecessors==1);
     fppoly_t *fp = fppoly_of_abstract0(element);
     size_t numlayers = fp->numlayers;
+    fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+    fppoly_stats_timer_t timer;
+    fppoly_stats_start(pr, &timer);
     size_t pred = predecessors[0]-1;
     size_t num_in_neurons = fp->layers[pred]->dims;
     size_t num_out_neurons = repeat*num_in_neurons;
@@ -690,64 +754,134 @@ void handle_tiling_layer(elina_manager_t* man, elina_abstract0_t* element, size_
         }
      }
     
+    fppoly_stats_stop(pr, fp, numlayers, &timer);
     return;
 }
 
 
+static expr_t * create_label_deviation_expr(elina_dim_t y, elina_dim_t x){
+	double coeff[2] = {1, -1};
+	size_t dim[2] = {y, x};
+	return create_sparse_expr(coeff, 0, dim, 2);
+}
+
+
+/* lower bound of the deviation expression sub, decided with respect to threshold:
+   the output box is checked first, then the back-substitution stops early */
+static double label_deviation_lb_of_expr(elina_manager_t *man, fppoly_t *fp, expr_t **sub, double threshold){
+	fppoly_internal_t * pr = fppoly_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	size_t output_layer = fp->numlayers-1;
+	if(compute_ub_from_expr(pr,*sub,fp,output_layer) <= threshold){
+		// the lower bound can never exceed the upper bound
+		return -compute_lb_from_expr(pr,*sub,fp,output_layer);
+	}
+	return -get_lb_using_previous_layers_until(man, fp, sub, fp->numlayers, threshold);
+}
+
+
+/* lower bound of y - x from the expressions of y and x that the analysis already
+   back-substituted to the input, shared by every comparison of a batch, -INFINITY
+   when the output layer keeps none */
+static double label_deviation_lb_of_backsubstituted(fppoly_internal_t *pr, fppoly_t *fp, elina_dim_t y, elina_dim_t x){
+	neuron_t **neurons = fp->layers[fp->numlayers-1]->neurons;
+	expr_t *lexpr = neurons[y]->backsubstituted_lexpr;
+	expr_t *uexpr = neurons[x]->backsubstituted_uexpr;
+	if(lexpr==NULL || uexpr==NULL){
+		return -INFINITY;
+	}
+	expr_arena_begin();
+	/* -uexpr exactly, its intervals stored with swapped ends */
+	expr_t *sub = copy_expr(uexpr);
+	double *coeff = sub->inf_coeff;
+	sub->inf_coeff = sub->sup_coeff;
+	sub->sup_coeff = coeff;
+	double cst = sub->inf_cst;
+	sub->inf_cst = sub->sup_cst;
+	sub->sup_cst = cst;
+	add_expr(pr, sub, lexpr);
+	double lb = -compute_lb_from_expr(pr, sub, fp, -1);
+	expr_arena_end();
+	return lb;
+}
+
+
 bool is_greater(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t x){
-	fppoly_t *fp = fppoly_of_abstract0(element);
+	return label_deviation_lb_until(man, element, y, x, 0) > 0;
+}
+
+
+bool fppoly_is_greater_batch(elina_manager_t* man, fppoly_t *fp, elina_dim_t y, elina_dim_t *xs, size_t num_xs, double *lbs){
 	fppoly_internal_t * pr = fppoly_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
-	//if(1){
-		
-		expr_t * sub = (expr_t *)malloc(sizeof(expr_t));
-		//sub->size = size;
-		sub->inf_cst = 0;
-		sub->sup_cst = 0;
-		sub->inf_coeff = (double*)malloc(2*sizeof(double));
-		sub->sup_coeff = (double*)malloc(2*sizeof(double));
-		sub->dim =(size_t *)malloc(2*sizeof(size_t));
-		sub->size = 2;
-		sub->type = SPARSE;
-		sub->inf_coeff[0] = -1;
-		sub->sup_coeff[0] = 1;
-		sub->dim[0] = y;
-		sub->inf_coeff[1] = 1;
-		sub->sup_coeff[1] = -1;
-		sub->dim[1] = x;
-		
-		//layer_fprint(stdout,fp->layers[3],NULL);
-		double lb = get_lb_using_previous_layers(man, fp, &sub, fp->numlayers);
-		
-		//free_expr(sub);
-		
-		if(lb<0){
-			return true;
+	size_t output_layer = fp->numlayers-1;
+	expr_t ** subs = (expr_t **)malloc(num_xs*sizeof(expr_t *));
+	double * box_ub = (double *)malloc(num_xs*sizeof(double));
+	size_t * order = (size_t *)malloc(num_xs*sizeof(size_t));
+	size_t i, j;
+	bool res = true;
+	for(i=0; i < num_xs; i++){
+		subs[i] = create_label_deviation_expr(y, xs[i]);
+		box_ub[i] = compute_ub_from_expr(pr,subs[i],fp,output_layer);
+		if(box_ub[i] <= 0){
+			res = false;
 		}
-		else{
-			return false;
+	}
+	if(res || lbs!=NULL){
+		// the comparisons closest to failing go first
+		for(i=0; i < num_xs; i++){
+			size_t idx = i;
+			for(j=i; j > 0 && box_ub[order[j-1]] > box_ub[idx]; j--){
+				order[j] = order[j-1];
+			}
+			order[j] = idx;
 		}
-		
-	
+		for(i=0; i < num_xs; i++){
+			size_t idx = order[i];
+			double lb = -INFINITY;
+			if(box_ub[idx] > 0){
+				lb = label_deviation_lb_of_backsubstituted(pr, fp, y, xs[idx]);
+			}
+			if(lb <= 0){
+				lb = label_deviation_lb_of_expr(man, fp, &subs[idx], 0);
+			}
+			if(lbs!=NULL){
+				lbs[idx] = lb;
+			}
+			if(lb <= 0){
+				res = false;
+				if(lbs==NULL){
+					break;
+				}
+			}
+		}
+	}
+	for(i=0; i < num_xs; i++){
+		free_expr(subs[i]);
+	}
+	free(subs);
+	free(box_ub);
+	free(order);
+	return res;
+}
+
+
+bool is_greater_batch(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t *xs, size_t num_xs, double *lbs){
+	return fppoly_is_greater_batch(man, fppoly_of_abstract0(element), y, xs, num_xs, lbs);
+}
+
+
+double label_deviation_lb_until(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t x, double threshold){
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	expr_t * sub = create_label_deviation_expr(y, x);
+	double lb = label_deviation_lb_of_expr(man, fp, &sub, threshold);
+	free_expr(sub);
+	return lb;
 }
 
+
 //begining of function for GPUArena
 double label_deviation_lb(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t x){
 	fppoly_t *fp = fppoly_of_abstract0(element);
-	fppoly_internal_t * pr = fppoly_init_from_manager(man,ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
-	expr_t * sub = (expr_t *)malloc(sizeof(expr_t));
-	sub->inf_cst = 0;
-	sub->sup_cst = 0;
-	sub->inf_coeff = (double*)malloc(2*sizeof(double));
-	sub->sup_coeff = (double*)malloc(2*sizeof(double));
-	sub->dim =(size_t *)malloc(2*sizeof(size_t));
-	sub->size = 2;
-	sub->type = SPARSE;
-	sub->inf_coeff[0] = -1;
-	sub->sup_coeff[0] = 1;
-	sub->dim[0] = y;
-	sub->inf_coeff[1] = 1;
-	sub->sup_coeff[1] = -1;
-	sub->dim[1] = x;
+	expr_t * sub = create_label_deviation_expr(y, x);
 	
 	//layer_fprint(stdout,fp->layers[3],NULL);
 	double lb = get_lb_using_previous_layers(man, fp, &sub, fp->numlayers);
@@ -779,6 +913,47 @@ void* clear_neurons_status(elina_manager_t* man, elina_abstract0_t* element){
 	return NULL;
 }
 
+static void deeppoly_affine_layer(elina_manager_t* man, fppoly_t *fp, size_t j){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	neuron_t **neurons = fp->layers[j]->neurons;
+	size_t i;
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
+	for(i=0; i < fp->layers[j]->dims; i++){
+		// free before new assignment
+		if(neurons[i]->backsubstituted_lexpr){
+			free_expr(neurons[i]->backsubstituted_lexpr);
+		}
+		if(neurons[i]->backsubstituted_uexpr){
+			free_expr(neurons[i]->backsubstituted_uexpr);
+		}
+		if(fp->layers[j]->conv){
+			neurons[i]->backsubstituted_lexpr = conv_op_neuron_expr(fp->layers[j]->conv, i);
+			neurons[i]->backsubstituted_uexpr = share_expr(neurons[i]->backsubstituted_lexpr);
+			continue;
+		}
+		neurons[i]->backsubstituted_lexpr = share_expr(neurons[i]->lexpr);
+		neurons[i]->backsubstituted_uexpr = share_expr(neurons[i]->uexpr);
+	}	
+	update_state_layer_by_layer_parallel(man,fp, j);
+	fppoly_stats_stop(pr, fp, j, &timer);
+}
+
+
+static void deeppoly_relu_neuron(neuron_t *out_neuron, neuron_t *in_neuron, size_t i){
+	out_neuron->lb = -fmax(0.0, -in_neuron->lb);
+	out_neuron->ub = fmax(0,in_neuron->ub);
+	if(out_neuron->lexpr){
+		free_expr(out_neuron->lexpr);
+	}
+	out_neuron->lexpr = create_relu_expr(out_neuron, in_neuron, i, true, true);
+	if(out_neuron->uexpr){
+		free_expr(out_neuron->uexpr);
+	}
+	out_neuron->uexpr = create_relu_expr(out_neuron, in_neuron, i, true, false);
+}
+
+
 void* run_deeppoly(elina_manager_t* man, elina_abstract0_t* element){
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	size_t numlayers = fp->numlayers;
@@ -786,63 +961,114 @@ void* run_deeppoly(elina_manager_t* man, elina_abstract0_t* element){
 	for (j=0; j < numlayers; j++){
 		if(!fp->layers[j]->is_activation){
 			// deeppoly run the affine layer
-			neuron_t **neurons = fp->layers[j]->neurons;
-			for(i=0; i < fp->layers[j]->dims; i++){
-				// free before new assignment
-				if(neurons[i]->backsubstituted_lexpr){
-					free_expr(neurons[i]->backsubstituted_lexpr);
-				}
-				neurons[i]->backsubstituted_lexpr = copy_expr(neurons[i]->lexpr);
-				// expr_print(neurons[i]->backsubstituted_lexpr);
-				if(neurons[i]->backsubstituted_uexpr){
-					free_expr(neurons[i]->backsubstituted_uexpr);
-				}
-				neurons[i]->backsubstituted_uexpr = copy_expr(neurons[i]->uexpr);
-				// expr_print(neurons[i]->backsubstituted_uexpr);
-			}	
-			// printf("before update_state_layer_by_layer_parallel\n");
-			update_state_layer_by_layer_parallel(man,fp, j);
-			// printf("affine 1 's interval is [%.3f, %.3f], affine 2 's interval is [%.3f, %.3f] ", -neurons[0]->lb, neurons[0]->ub, -neurons[1]->lb, neurons[1]->ub);
-			// printf("after update_state_layer_by_layer_parallel\n");
+			deeppoly_affine_layer(man, fp, j);
 		}
 		else{
 			// deeppoly run the relu layer
 			int k = fp->layers[j]->predecessors[0]-1;
-			layer_t *predecessor_layer = fp->layers[k];
 			neuron_t **in_neurons = fp->layers[k]->neurons;
 			neuron_t **out_neurons = fp->layers[j]->neurons;
 			for(i=0; i < fp->layers[j]->dims; i++){
-				out_neurons[i]->lb = -fmax(0.0, -in_neurons[i]->lb);
-				out_neurons[i]->ub = fmax(0,in_neurons[i]->ub);
-				if(out_neurons[i]->lexpr){
-					free_expr(out_neurons[i]->lexpr);
+				deeppoly_relu_neuron(out_neurons[i], in_neurons[i], i);
+			}
+		}
+	}
+	return NULL;
+}
+
+
+/* run_deeppoly for the part of the network that depends on changed bounds:
+   changed[j][i] marks the neurons whose bounds were tightened since the last
+   run. An affine layer is back-substituted again only if the input box or
+   the layer before it changed, a ReLU neuron is rebuilt only if its input
+   neuron changed. Neurons whose bounds or relaxation change are marked in
+   turn, so a layer that comes out as before ends the propagation and the
+   layers after it are kept. Their bounds stay sound, as the relaxations they
+   were computed with only grew tighter, but a full run could still tighten
+   them by back-substituting through the relaxations that did change. */
+static void run_deeppoly_incremental(elina_manager_t* man, fppoly_t *fp, bool input_changed, char **changed){
+	size_t numlayers = fp->numlayers;
+	size_t i, j;
+	bool upstream_changed = input_changed;
+	for (j=0; j < numlayers; j++){
+		layer_t *layer = fp->layers[j];
+		neuron_t **out_neurons = layer->neurons;
+		bool layer_changed = false;
+		if(!layer->is_activation){
+			if(upstream_changed){
+				double *lb = (double *)malloc(layer->dims*sizeof(double));
+				double *ub = (double *)malloc(layer->dims*sizeof(double));
+				for(i=0; i < layer->dims; i++){
+					lb[i] = out_neurons[i]->lb;
+					ub[i] = out_neurons[i]->ub;
+				}
+				deeppoly_affine_layer(man, fp, j);
+				for(i=0; i < layer->dims; i++){
+					if(out_neurons[i]->lb!=lb[i] || out_neurons[i]->ub!=ub[i]){
+						changed[j][i] = 1;
+					}
 				}
-				out_neurons[i]->lexpr = create_relu_expr(out_neurons[i], in_neurons[i], i, true, true);
-				if(out_neurons[i]->uexpr){
-					free_expr(out_neurons[i]->uexpr);
+				free(lb);
+				free(ub);
+			}
+		}
+		else{
+			int k = layer->predecessors[0]-1;
+			neuron_t **in_neurons = fp->layers[k]->neurons;
+			for(i=0; i < layer->dims; i++){
+				if(!changed[k][i]){
+					continue;
+				}
+				neuron_t *out_neuron = out_neurons[i];
+				double lb = out_neuron->lb;
+				double ub = out_neuron->ub;
+				expr_t *lexpr = out_neuron->lexpr;
+				expr_t *uexpr = out_neuron->uexpr;
+				// keep the old relaxation alive for the comparison
+				out_neuron->lexpr = NULL;
+				out_neuron->uexpr = NULL;
+				deeppoly_relu_neuron(out_neuron, in_neurons[i], i);
+				if(out_neuron->lb!=lb || out_neuron->ub!=ub || !expr_equal(out_neuron->lexpr, lexpr) || !expr_equal(out_neuron->uexpr, uexpr)){
+					changed[j][i] = 1;
+				}
+				if(uexpr!=lexpr){
+					free_expr(uexpr);
+				}
+				if(lexpr){
+					free_expr(lexpr);
 				}
-				out_neurons[i]->uexpr = create_relu_expr(out_neurons[i], in_neurons[i], i, true, false);
-				// printf("relu %zu 's upper expression is ", i);
-				// expr_print(out_neurons[i]->uexpr);
 			}
 		}
+		for(i=0; i < layer->dims && !layer_changed; i++){
+			layer_changed = changed[j][i];
+		}
+		upstream_changed = layer_changed;
 	}
-	return NULL;
 }
 
 void update_bounds_from_LPsolve(elina_manager_t* man, elina_abstract0_t* element, int affine_num, size_t * num_each_layer, double * all_lbs, double * all_ubs){
 	//obtain the bounds from GPU LP solve and then update it with ERAN deeppoly backend
 	// handle the input neurons
-	int i, j;
+	size_t i, j;
 	int start_index = 0; int layer_index = 0; int refine_count = 0;
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	size_t numlayers = fp->numlayers;
 	size_t c_inputDim = fp->num_pixels;
 	size_t py_inputDim = num_each_layer[0];
 	assert(c_inputDim == py_inputDim); // ensure dimension match
+	bool input_changed = false;
+	char **changed = (char **)malloc(numlayers*sizeof(char *));
+	for(i=0; i < numlayers; i++){
+		changed[i] = (char *)calloc(fp->layers[i]->dims, sizeof(char));
+	}
 	for(i=0; i < c_inputDim; i++){
-		fp->input_inf[i] = fmin(-all_lbs[i], fp->input_inf[i]);
-		fp->input_sup[i] = fmin(all_ubs[i], fp->input_sup[i]);
+		double inf = fmin(-all_lbs[i], fp->input_inf[i]);
+		double sup = fmin(all_ubs[i], fp->input_sup[i]);
+		if(inf!=fp->input_inf[i] || sup!=fp->input_sup[i]){
+			input_changed = true;
+		}
+		fp->input_inf[i] = inf;
+		fp->input_sup[i] = sup;
 	}
 	start_index += c_inputDim; layer_index++;
 
@@ -858,8 +1084,13 @@ void update_bounds_from_LPsolve(elina_manager_t* man, elina_abstract0_t* element
 				neuron_t * affine_node = aff_neurons[j];
 				if(affine_node->ub > 0.0 && affine_node->lb > 0.0){
 					// only update those unstable neurons
-					affine_node->lb = fmin(-all_lbs[start_index+j], affine_node->lb);
-					affine_node->ub = fmin(all_ubs[start_index+j], affine_node->ub);
+					double lb = fmin(-all_lbs[start_index+j], affine_node->lb);
+					double ub = fmin(all_ubs[start_index+j], affine_node->ub);
+					if(lb!=affine_node->lb || ub!=affine_node->ub){
+						changed[i][j] = 1;
+					}
+					affine_node->lb = lb;
+					affine_node->ub = ub;
 					// printf("lb %lf, ub %lf\n", affine_node->lb, affine_node->ub);
 					if(affine_node->ub <= 0.0 || affine_node->lb <= 0.0){
 						refine_count++;
@@ -870,7 +1101,11 @@ void update_bounds_from_LPsolve(elina_manager_t* man, elina_abstract0_t* element
 		}
 	}
 	printf("Refreshed ReLU neodes number is: %d\n", refine_count);
-	run_deeppoly(man, element);
+	run_deeppoly_incremental(man, fp, input_changed, changed);
+	for(i=0; i < numlayers; i++){
+		free(changed[i]);
+	}
+	free(changed);
 	return;
 }
 // end of my functions
@@ -880,6 +1115,18 @@ long int max(long int a, long int b){
 
 }
 
+void create_convolutional_exprs(expr_t **exprs, double *filter_weights, double * filter_bias, size_t * input_size, size_t *filter_size, size_t *strides, size_t *output_size,
+				size_t pad_top, size_t pad_left, bool has_bias){
+	conv_op_t *conv = conv_op_alloc(filter_weights, filter_bias, input_size, filter_size, strides, output_size, pad_top, pad_left, has_bias);
+	size_t num_out_neurons = output_size[0]*output_size[1]*output_size[2];
+	size_t i;
+	for(i=0; i < num_out_neurons; i++){
+		exprs[i] = conv_op_neuron_expr(conv, i);
+	}
+	conv_op_free(conv);
+}
+
+
 void handle_convolutional_layer(elina_manager_t* man, elina_abstract0_t* element, double *filter_weights, double * filter_bias,  
 				         size_t * input_size, size_t *filter_size, size_t num_filters, size_t *strides, size_t *output_size,
 				         size_t pad_top, size_t pad_left, size_t pad_bottom, size_t pad_right, bool has_bias, size_t *predecessors, size_t num_predecessors){
@@ -888,65 +1135,27 @@ void handle_convolutional_layer(elina_manager_t* man, elina_abstract0_t* element
 	assert(num_predecessors==1);
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	size_t numlayers = fp->numlayers;
-	size_t i, j;
-	size_t num_pixels = input_size[0]*input_size[1]*input_size[2];
+	size_t i;
 	
 	output_size[2] = num_filters;
 	size_t num_out_neurons = output_size[0]*output_size[1]*output_size[2];
 	//printf("num_out_neurons: %zu %zu\n",num_out_neurons,num_pixels);
 	//fflush(stdout);
 	fppoly_add_new_layer(fp,num_out_neurons, predecessors, num_predecessors, false);
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	if(pr->implicit_conv){
+		fp->layers[numlayers]->conv = conv_op_alloc(filter_weights, filter_bias, input_size, filter_size, strides, output_size, pad_top, pad_left, has_bias);
+		update_state_using_previous_layers_parallel(man,fp,numlayers);
+		return;
+	}
 	neuron_t ** out_neurons = fp->layers[numlayers]->neurons;
-	size_t out_x, out_y, out_z;
-        size_t inp_x, inp_y, inp_z;
-	size_t x_shift, y_shift;
-
-	
-	
-	for(out_x=0; out_x < output_size[0]; out_x++) {
-	    for(out_y = 0; out_y < output_size[1]; out_y++) {
-		 for(out_z=0; out_z < output_size[2]; out_z++) {
-		     size_t mat_x = out_x*output_size[1]*output_size[2] + out_y*output_size[2] + out_z;
-		     size_t num_coeff = input_size[2]*filter_size[0]*filter_size[1];
-		     size_t actual_coeff = 0;
-		     double *coeff = (double *)malloc(num_coeff*sizeof(double));
-		     size_t *dim = (size_t *)malloc(num_coeff*sizeof(double));
-		     i=0;
-		     for(inp_z=0; inp_z <input_size[2]; inp_z++) {
-			 for(x_shift = 0; x_shift < filter_size[0]; x_shift++) {
-			     for(y_shift =0; y_shift < filter_size[1]; y_shift++) {
-				     long int x_val = out_x*strides[0]+x_shift-pad_top;	
-			  	     long int y_val = out_y*strides[1]+y_shift-pad_left;
-			  	     if(y_val<0 || y_val >= (long int)input_size[1]){
-			     			continue;
-			  	     }
-
-				     
-			  	     if(x_val<0 || x_val >= (long int)input_size[0]){
-			     			continue;
-			  	     }
-				     size_t mat_y = x_val*input_size[1]*input_size[2] + y_val*input_size[2] + inp_z;
-				     if(mat_y>=num_pixels){		 
-			     			continue;
-
-		          	     }
-				     size_t filter_index = x_shift*filter_size[1]*input_size[2]*output_size[2] + y_shift*input_size[2]*output_size[2] + inp_z*output_size[2] + out_z;
-				     coeff[i] = filter_weights[filter_index];
-				     dim[i] = mat_y;
-				     actual_coeff++;
-				     i++;
-			     }
-			}
-		    }
-		   double cst = has_bias? filter_bias[out_z] : 0;
-	           out_neurons[mat_x]->lexpr = create_sparse_expr(coeff,cst,dim,actual_coeff);
-		   sort_sparse_expr(out_neurons[mat_x]->lexpr); 
-		   out_neurons[mat_x]->uexpr = out_neurons[mat_x]->lexpr;
-		   free(coeff);
-		   free(dim);
-	        }
-	     }
+	expr_t ** exprs = (expr_t **)malloc(num_out_neurons*sizeof(expr_t *));
+	create_convolutional_exprs(exprs, filter_weights, filter_bias, input_size, filter_size, strides, output_size, pad_top, pad_left, has_bias);
+	for(i=0; i < num_out_neurons; i++){
+		out_neurons[i]->lexpr = exprs[i];
+		out_neurons[i]->uexpr = exprs[i];
 	}
+	free(exprs);
 		
 	update_state_using_previous_layers_parallel(man,fp,numlayers);
 	//printf("CONV ends\n");
@@ -1031,11 +1240,8 @@ void handle_residual_layer(elina_manager_t *man, elina_abstract0_t *element, siz
 	//printf("START\n");
 	//fflush(stdout);
 	for(i=0; i < num_neurons; i++){
-		double *coeff = (double*)malloc(sizeof(double));
-		coeff[0] = 1;
-		size_t *dim = (size_t*)malloc(sizeof(size_t));
-		dim[0] = i;
-		neurons[i]->lexpr = create_sparse_expr(coeff,0,dim,1);
+		double coeff = 1;
+		neurons[i]->lexpr = create_sparse_expr(&coeff,0,&i,1);
 		neurons[i]->uexpr = neurons[i]->lexpr;
 	}
 	//printf("FINISH\n");
@@ -1045,19 +1251,24 @@ void handle_residual_layer(elina_manager_t *man, elina_abstract0_t *element, siz
 
 
 
-void free_neuron(neuron_t *neuron){
+static void free_neuron_exprs(neuron_t *neuron){
 	if(neuron->uexpr!=neuron->lexpr){
 		free_expr(neuron->uexpr);
 	}
 	if(neuron->lexpr){
 		free_expr(neuron->lexpr);
 	}
-	if(neuron->backsubstituted_lexpr!=neuron->backsubstituted_uexpr){
+	// the back-substituted expressions are owned separately, even when shared
+	if(neuron->backsubstituted_uexpr){
 		free_expr(neuron->backsubstituted_uexpr);
 	}
 	if(neuron->backsubstituted_lexpr){
 		free_expr(neuron->backsubstituted_lexpr);
 	}
+}
+
+void free_neuron(neuron_t *neuron){
+	free_neuron_exprs(neuron);
 	free(neuron);
 }
 
@@ -1085,10 +1296,16 @@ void layer_free(layer_t * layer){
 	size_t dims = layer->dims;
 	size_t i;
 	for(i=0; i < dims; i++){
-		free_neuron(layer->neurons[i]);
+		free_neuron_exprs(&layer->neuron_block[i]);
 	}
+	free(layer->neuron_block);
+	layer->neuron_block = NULL;
 	free(layer->neurons);
 	layer->neurons = NULL;
+	if(layer->conv!=NULL){
+		conv_op_free(layer->conv);
+		layer->conv = NULL;
+	}
 	if(layer->h_t_inf!=NULL){
 		free(layer->h_t_inf);
 		layer->h_t_inf = NULL;
@@ -1121,18 +1338,19 @@ void layer_free(layer_t * layer){
 
 void fppoly_free(elina_manager_t *man, fppoly_t *fp){
 	size_t i;
-	size_t output_size = fp->layers[fp->numlayers-1]->dims;
 	for(i=0; i < fp->numlayers; i++){
 		layer_free(fp->layers[i]);
 	}
 	free(fp->layers);
 	fp->layers = NULL;
+	spatial_lp_free(fp->spatial_lp);
+	fp->spatial_lp = NULL;
 	free(fp->input_inf);
 	fp->input_inf = NULL;
 	if(fp->input_lexpr!=NULL && fp->input_uexpr!=NULL){
 		for(i=0; i < fp->num_pixels; i++){
-			free(fp->input_lexpr[i]);
-			free(fp->input_uexpr[i]);
+			free_expr(fp->input_lexpr[i]);
+			free_expr(fp->input_uexpr[i]);
 		}
 		free(fp->input_lexpr);
 		fp->input_lexpr = NULL;
@@ -1153,6 +1371,9 @@ void fppoly_free(elina_manager_t *man, fppoly_t *fp){
     fp->spatial_indices = NULL;
     free(fp->spatial_neighbors);
     fp->spatial_neighbors = NULL;
+	// after the layers, their expressions point into the mapping
+	fppoly_snapshot_free(fp->snapshot);
+	fp->snapshot = NULL;
 
 	free(fp);
 	fp = NULL;
@@ -44,6 +44,62 @@ extern "C" {
 #include "elina_box_meetjoin.h"
 
 
+typedef struct fppoly_thread_pool_t fppoly_thread_pool_t;
+
+typedef struct maxpool_hull_cache_t maxpool_hull_cache_t;
+
+typedef struct spatial_lp_t spatial_lp_t;
+
+typedef struct fppoly_stats_t fppoly_stats_t;
+
+typedef struct fppoly_snapshot_t fppoly_snapshot_t;
+
+/* what was measured for one layer index since the statistics were last reset,
+   times add up over all passes over the layer and the sizes are those of the
+   last pass */
+typedef struct fppoly_layer_stats_t{
+	size_t layerno;
+	size_t dims;
+	bool is_activation;
+	/* passes over the layer: creation, back-substitution, reruns */
+	size_t calls;
+	/* seconds; cpu_time is the CPU time of the thread running the pass and of
+	   the workers of the manager, so passes that run at the same time on the
+	   same manager, such as the regions of fppoly_network_verify_batch, also
+	   count the workers busy with the others */
+	double wall_time;
+	double cpu_time;
+	/* coefficients of lexpr and uexpr over all neurons of the layer */
+	size_t expr_size_before;
+	/* coefficients of the back-substituted expressions */
+	size_t expr_size_after;
+	/* activation layers: input neurons with lb < 0 < ub */
+	size_t unstable_relus;
+	/* size of the back-substituted expressions, computed from their
+	   coefficients rather than measured from the allocator */
+	size_t expr_bytes;
+	/* cpu_time / (wall_time * threads of the manager) */
+	double thread_utilisation;
+}fppoly_layer_stats_t;
+
+/* how the neurons of a layer are back-substituted */
+typedef enum fppoly_backsubstitution_t{
+	FPPOLY_BACKSUBSTITUTE_NEURON, /* one expression at a time */
+	FPPOLY_BACKSUBSTITUTE_MATRIX, /* blocks of neurons as interval matrix products */
+}fppoly_backsubstitution_t;
+
+/* how bounds over an input with spatial constraints are computed */
+typedef enum fppoly_spatial_solver_t{
+	FPPOLY_SPATIAL_NONE, /* spatial constraints are ignored, only the input box and constraints are used */
+	FPPOLY_SPATIAL_DUAL_ASCENT, /* in-tree Lagrangian dual of the spatial constraints */
+	FPPOLY_SPATIAL_GUROBI, /* persistent Gurobi model, needs a build with GUROBI */
+}fppoly_spatial_solver_t;
+
+/* element type of the weight buffers passed to the *_buffer layer constructors */
+typedef enum fppoly_dtype_t{
+	FPPOLY_FLOAT64,
+	FPPOLY_FLOAT32,
+}fppoly_dtype_t;
 
 typedef struct fppoly_internal_t{
   /* Name of function */
@@ -59,6 +115,20 @@ typedef struct fppoly_internal_t{
   double ulp;
   /* back pointer to elina_manager*/
   elina_manager_t* man;
+  /* worker threads reused by all parallel back-substitution passes */
+  fppoly_thread_pool_t *pool;
+  fppoly_backsubstitution_t backsubstitution;
+  /* the expressions of fully connected layers point to the weights of the caller */
+  bool borrow_weights;
+  /* convolutions are back-substituted from their filters */
+  bool implicit_conv;
+  /* upper faces of maxpool windows already computed by cdd */
+  maxpool_hull_cache_t *maxpool_cache;
+  fppoly_spatial_solver_t spatial_solver;
+  /* the matrix back-substitution works on floats, ulp and min_denormal are those of float */
+  bool single_precision;
+  /* per-layer statistics, recorded only while enabled */
+  fppoly_stats_t *stats;
 }fppoly_internal_t;
 
 
@@ -84,6 +154,10 @@ typedef struct expr_t{
 	exprtype_t type;
 	size_t * dim;
     size_t size;
+	// number of owners, see share_expr; the last free_expr releases the memory
+	size_t refcount;
+	// sup_coeff is the weight row of the caller and is not freed
+	bool borrowed;
 }expr_t;
 
 typedef struct neuron_t{
@@ -95,9 +169,28 @@ typedef struct neuron_t{
 	expr_t * backsubstituted_uexpr;
 }neuron_t;
 
+/* a convolution kept as its filter instead of one expression per output neuron,
+   see conv_backsubstitute.h */
+typedef struct conv_op_t{
+	double *filter_weights;
+	/* NULL when the convolution has no bias */
+	double *filter_bias;
+	size_t input_size[3];
+	size_t filter_size[2];
+	size_t strides[2];
+	size_t output_size[3];
+	size_t pad_top;
+	size_t pad_left;
+}conv_op_t;
+
+
 typedef struct layer_t{
 	size_t dims;
+	// neurons[i] points to neuron_block[i], the neurons of a layer are one contiguous
+	// array of structs; lb and ub are not split out, the loops that concretize an
+	// expression over the layer gather them from neuron_block into dense arrays
 	neuron_t **neurons;
+	neuron_t *neuron_block;
 	double * h_t_inf;
 	double * h_t_sup;
 	double * c_t_inf;
@@ -108,6 +201,8 @@ typedef struct layer_t{
 	bool is_concat;
 	size_t *C;
 	size_t num_channels;
+	/* set for convolutions without per-neuron expressions, lexpr and uexpr are NULL then */
+	conv_op_t *conv;
 }layer_t;
 
 
@@ -128,6 +223,10 @@ typedef struct fppoly_t{
     size_t *spatial_neighbors;
     size_t spatial_size;
     double spatial_gamma;
+    /* built once for inputs with spatial constraints, NULL otherwise */
+    spatial_lp_t *spatial_lp;
+    /* mapping the element was restored from, NULL otherwise */
+    fppoly_snapshot_t *snapshot;
 }fppoly_t;
 
 
@@ -140,11 +239,65 @@ typedef struct nn_thread_t{
 	int k;
 	elina_linexpr0_t ** linexpr0;
 	double *res;
+	/* context of callers that do not work on a single layer */
+	void *data;
 }nn_thread_t;
 
 
 elina_manager_t* fppoly_manager_alloc(void);
 
+void fppoly_manager_set_num_threads(elina_manager_t *man, size_t num_threads, bool set_affinity);
+
+void fppoly_manager_set_backsubstitution(elina_manager_t *man, fppoly_backsubstitution_t backsubstitution);
+
+/* with borrow set, fully connected layers keep pointers to the weight rows
+   passed by the caller instead of copying them; the weights must then stay
+   alive and unchanged until the abstract element is freed */
+void fppoly_manager_set_borrow_weights(elina_manager_t *man, bool borrow);
+
+/* applies to the inputs created after the call; the default is
+   FPPOLY_SPATIAL_GUROBI in builds with GUROBI and FPPOLY_SPATIAL_NONE
+   otherwise, FPPOLY_SPATIAL_GUROBI is ignored in builds without it */
+void fppoly_manager_set_spatial_solver(elina_manager_t *man, fppoly_spatial_solver_t solver);
+
+/* with implicit set, convolutional layers keep a copy of their filters and
+   back-substitution through them is a transposed convolution; the per-neuron
+   expressions of these layers are not built, and the matrix back-substitution
+   does not apply to networks containing them */
+void fppoly_manager_set_implicit_conv(elina_manager_t *man, bool implicit);
+
+/* with single set, the matrix back-substitution keeps its rows in float and
+   rounds the weights of an affine layer outward to float as it applies them;
+   only these float kernels use the rounding error of float */
+void fppoly_manager_set_single_precision(elina_manager_t *man, bool single);
+
+/* per-layer statistics of the analyses run on the manager, indexed by layer number */
+void fppoly_manager_set_stats(elina_manager_t *man, bool enable);
+
+void fppoly_manager_reset_stats(elina_manager_t *man);
+
+/* copies up to size records to stats (may be NULL), returns the number of layers recorded */
+size_t fppoly_manager_get_stats(elina_manager_t *man, fppoly_layer_stats_t *stats, size_t size);
+
+/* writes the statistics as JSON to buf like snprintf, returns the length of the full text */
+size_t fppoly_manager_stats_json(elina_manager_t *man, char *buf, size_t size);
+
+bool fppoly_manager_dump_stats(elina_manager_t *man, const char *path);
+
+/* writes the bounds, expressions and input constraints of an analysed element
+   to path, see fppoly_snapshot.h for the format */
+bool fppoly_snapshot_save(elina_manager_t *man, elina_abstract0_t *element, const char *path);
+
+/* restores an element saved by fppoly_snapshot_save, NULL if path cannot be
+   mapped or is not a snapshot; the file is mapped privately, so processes
+   restoring the same snapshot share its pages. The headers of all layers are
+   built at load time, the coefficients are read from the mapping when first
+   used */
+elina_abstract0_t* fppoly_snapshot_load(elina_manager_t *man, const char *path);
+
+/* starts reading the coefficients of layer layerno of a restored element ahead of use */
+void fppoly_snapshot_prefetch_layer(elina_manager_t *man, elina_abstract0_t *element, size_t layerno);
+
 elina_abstract0_t* fppoly_from_network_input(elina_manager_t *man, size_t intdim, size_t realdim, double *inf_array, double *sup_array);
 
 void fppoly_set_network_input_box(elina_manager_t *man, elina_abstract0_t* element, size_t intdim, size_t realdim, double *inf_array, double * sup_array);
@@ -162,6 +315,13 @@ void handle_padding_layer(elina_manager_t* man, elina_abstract0_t* element, size
 
 void handle_fully_connected_layer(elina_manager_t* man, elina_abstract0_t* element, double **weights, double * bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors);
 
+/* like handle_fully_connected_layer with the weights given as one buffer, weight
+   (i,j) is at byte offset i*row_stride + j*col_stride from weights as with the
+   strides of a NumPy array; with borrow_weights set and may_borrow true, float64
+   rows with col_stride==sizeof(double) are referenced by the expressions instead
+   of copied. Callers pass may_borrow false for buffers that do not outlive the call */
+void handle_fully_connected_layer_buffer(elina_manager_t* man, elina_abstract0_t* element, void *weights, fppoly_dtype_t dtype, ptrdiff_t row_stride, ptrdiff_t col_stride, bool may_borrow, double * bias, size_t num_out_neurons, size_t num_in_neurons, size_t *predecessors, size_t num_predecessors);
+
 void handle_sparse_layer(elina_manager_t* man, elina_abstract0_t * abs, double **weights, double *bias,   size_t size, size_t num_pixels, size_t *predecessors, size_t num_predecessors);
 
 void handle_right_multiply_with_matrix(elina_manager_t* man, elina_abstract0_t* element, double **weights, size_t num_weight_rows, size_t num_weight_cols, size_t num_out_cols, size_t * predecessors, size_t num_predecessors);
@@ -205,6 +365,22 @@ bool is_greater(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y,
 
 double label_deviation_lb(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t x);
 
+/* lower bound of y - x that is only as tight as needed to compare it with
+   threshold: the back-substitution stops after the first layer proving
+   y - x > threshold, and is skipped when the output bounds show y - x <= threshold */
+double label_deviation_lb_until(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t x, double threshold);
+
+/* is_greater for y against every label in xs, the comparisons most likely to
+   fail are tried first. Each comparison first subtracts the expressions of y and
+   xs[i] already back-substituted to the input, which are shared by the batch,
+   and back-substitutes y - xs[i] only when that does not prove it. Without lbs
+   it returns at the first failure, otherwise lbs[i] receives a lower bound of
+   y - xs[i] decided with respect to 0 like label_deviation_lb_until */
+bool is_greater_batch(elina_manager_t* man, elina_abstract0_t* element, elina_dim_t y, elina_dim_t *xs, size_t num_xs, double *lbs);
+
+/* is_greater_batch on the element itself, for callers that own it without an abstract0 */
+bool fppoly_is_greater_batch(elina_manager_t* man, fppoly_t *fp, elina_dim_t y, elina_dim_t *xs, size_t num_xs, double *lbs);
+
 void* clear_neurons_status(elina_manager_t* man, elina_abstract0_t* element);
 
 void* run_deeppoly(elina_manager_t* man, elina_abstract0_t* element);
@@ -214,6 +390,11 @@ void update_bounds_from_LPsolve(elina_manager_t* man, elina_abstract0_t* element
 void handle_convolutional_layer(elina_manager_t* man, elina_abstract0_t* element, double *filter_weights, double * filter_bias,  
 				         size_t * input_size, size_t *filter_size, size_t num_filters, size_t *strides, size_t *output_size, size_t pad_top, size_t pad_left, size_t pad_bottom, size_t pad_right, bool has_bias, size_t *predecessors, size_t num_predecessors);
 
+/* fills exprs[0..output_size[0]*output_size[1]*output_size[2]) with the sorted sparse rows of a convolution,
+   output_size[2] must already hold the number of filters */
+void create_convolutional_exprs(expr_t **exprs, double *filter_weights, double * filter_bias, size_t * input_size, size_t *filter_size, size_t *strides, size_t *output_size,
+				size_t pad_top, size_t pad_left, bool has_bias);
+
 /*void conv_handle_intermediate_affine_layer(elina_manager_t* man, elina_abstract0_t* element, double *filter_weights, double * filter_bias,  
 				         size_t * input_size, size_t *filter_size, size_t num_filters, size_t *strides, size_t *output_size, size_t pad_top, size_t pad_left, bool has_bias, size_t *predecessors, bool use_area_heuristic);*/
 
@@ -258,6 +439,11 @@ void handle_tiling_layer(elina_manager_t* man, elina_abstract0_t* element, size_
 
 fppoly_t* fppoly_of_abstract0(elina_abstract0_t* a);
 
+elina_abstract0_t* abstract0_of_fppoly(elina_manager_t* man, fppoly_t* fp);
+
+/* initialises res to the box [inf_array, sup_array] of the inputs without layers */
+void fppoly_from_network_input_box(fppoly_t *res, size_t intdim, size_t realdim, double *inf_array, double *sup_array);
+
 void fppoly_add_new_layer(fppoly_t *fp, size_t size, size_t *predecessors, size_t num_predecessors, bool is_activation);
 
 void update_activation_upper_bound_for_neuron(elina_manager_t *man, elina_abstract0_t *abs, size_t layerno, size_t neuron_no, double* coeff, size_t *dim, size_t size);
@@ -0,0 +1,844 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+
+/* Benchmark driver for fppoly. Networks are built layer by layer through the
+   public handle_*_layer API, either from one of the synthetic suites or from
+   a trace file, and every run reports the analysis time, neurons per second,
+   the peak RSS of the process and checksums of the bounds so that speed and
+   precision of two builds can be compared line by line.
+
+   Trace files are plain text, one layer per line, predecessors numbered as in
+   the handle_* functions (0 is the input):
+
+     fppoly-trace 1
+     input N lo_1 hi_1 ... lo_N hi_N
+     fc OUT IN P w_1 ... w_{OUT*IN} b_1 ... b_OUT
+     conv H W C FH FW NF SH SW PT PL PB PR P w_1 ... w_{FH*FW*C*NF} b_1 ... b_NF
+     relu N P
+     sigmoid N P
+     tanh N P
+     maxpool H W C PH PW SH SW P
+     residual N P1 P2
+     concat K P_1 ... P_K C_1 ... C_K
+
+   fc weights are row major (output, input), conv filters are laid out as in
+   handle_convolutional_layer. -w writes the network of a synthetic suite in
+   this format and -R replays a trace file. fppoly does not record the layers
+   of an analysis, so a trace of another network has to be written by the
+   caller that builds it. */
+
+#include <getopt.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "fppoly.h"
+
+#define BENCH_MAX_PREDECESSORS 8
+
+
+typedef enum bench_op_type_t{
+	BENCH_FC,
+	BENCH_CONV,
+	BENCH_RELU,
+	BENCH_SIGMOID,
+	BENCH_TANH,
+	BENCH_MAXPOOL,
+	BENCH_RESIDUAL,
+	BENCH_CONCAT,
+}bench_op_type_t;
+
+
+static const char *bench_op_names[] = {"fc", "conv", "relu", "sigmoid", "tanh", "maxpool", "residual", "concat"};
+
+
+typedef struct bench_op_t{
+	bench_op_type_t type;
+	size_t predecessors[BENCH_MAX_PREDECESSORS];
+	size_t num_predecessors;
+	/* neurons of the layer */
+	size_t out;
+	/* fc: inputs, concat: channels of every predecessor */
+	size_t in;
+	size_t channels[BENCH_MAX_PREDECESSORS];
+	double *weights;
+	double *bias;
+	/* conv and maxpool */
+	size_t input_size[3];
+	size_t filter_size[2];
+	size_t num_filters;
+	size_t strides[2];
+	size_t pad[4];
+	size_t output_size[3];
+}bench_op_t;
+
+
+typedef struct bench_net_t{
+	size_t num_pixels;
+	double *inf;
+	double *sup;
+	bench_op_t *ops;
+	size_t num_ops;
+	size_t capacity;
+}bench_net_t;
+
+
+typedef struct bench_options_t{
+	size_t num_threads;
+	fppoly_backsubstitution_t backsubstitution;
+	bool single_precision;
+	size_t repetitions;
+	size_t depth;
+	size_t width;
+	double epsilon;
+	unsigned long seed;
+	const char *trace_out;
+	const char *stats_out;
+}bench_options_t;
+
+
+/* ---------------------------------------------------------------------- */
+/* networks                                                                */
+/* ---------------------------------------------------------------------- */
+
+static unsigned long long bench_rng_state;
+
+
+/* xorshift64*, the synthetic networks are the same on every platform */
+static double bench_uniform(void){
+	bench_rng_state ^= bench_rng_state >> 12;
+	bench_rng_state ^= bench_rng_state << 25;
+	bench_rng_state ^= bench_rng_state >> 27;
+	unsigned long long x = bench_rng_state * 2685821657736338717ULL;
+	return (double)(x >> 11) * (1.0/9007199254740992.0);
+}
+
+
+static double bench_weight(size_t fan_in){
+	return (2*bench_uniform() - 1)*sqrt(3.0/fan_in)*1.5;
+}
+
+
+static void bench_net_init(bench_net_t *net, size_t num_pixels, double epsilon){
+	size_t i;
+	net->num_pixels = num_pixels;
+	net->inf = (double *)malloc(num_pixels*sizeof(double));
+	net->sup = (double *)malloc(num_pixels*sizeof(double));
+	for(i=0; i < num_pixels; i++){
+		double x = bench_uniform();
+		net->inf[i] = x - epsilon;
+		net->sup[i] = x + epsilon;
+	}
+	net->ops = NULL;
+	net->num_ops = 0;
+	net->capacity = 0;
+}
+
+
+static void bench_net_free(bench_net_t *net){
+	size_t i;
+	for(i=0; i < net->num_ops; i++){
+		free(net->ops[i].weights);
+		free(net->ops[i].bias);
+	}
+	free(net->ops);
+	free(net->inf);
+	free(net->sup);
+}
+
+
+/* appends a layer and returns it, its number for the predecessors of later layers is num_ops */
+static bench_op_t * bench_net_add(bench_net_t *net, bench_op_type_t type, size_t out, size_t pred){
+	if(net->num_ops==net->capacity){
+		net->capacity = net->capacity ? 2*net->capacity : 16;
+		net->ops = (bench_op_t *)realloc(net->ops, net->capacity*sizeof(bench_op_t));
+	}
+	bench_op_t *op = &net->ops[net->num_ops++];
+	memset(op, 0, sizeof(bench_op_t));
+	op->type = type;
+	op->out = out;
+	op->predecessors[0] = pred;
+	op->num_predecessors = 1;
+	return op;
+}
+
+
+static size_t bench_net_dims(bench_net_t *net, size_t layer){
+	return layer==0 ? net->num_pixels : net->ops[layer-1].out;
+}
+
+
+static size_t bench_fc(bench_net_t *net, size_t out, size_t pred){
+	size_t i, in = bench_net_dims(net, pred);
+	bench_op_t *op = bench_net_add(net, BENCH_FC, out, pred);
+	op->in = in;
+	op->weights = (double *)malloc(out*in*sizeof(double));
+	op->bias = (double *)malloc(out*sizeof(double));
+	for(i=0; i < out*in; i++){
+		op->weights[i] = bench_weight(in);
+	}
+	for(i=0; i < out; i++){
+		op->bias[i] = 0.1*(2*bench_uniform() - 1);
+	}
+	return net->num_ops;
+}
+
+
+static size_t bench_activation(bench_net_t *net, bench_op_type_t type, size_t pred){
+	bench_net_add(net, type, bench_net_dims(net, pred), pred);
+	return net->num_ops;
+}
+
+
+/* same padding for odd filters */
+static size_t bench_conv(bench_net_t *net, size_t *input_size, size_t filter, size_t num_filters, size_t stride, size_t pred){
+	size_t i, pad = filter/2;
+	size_t oh = (input_size[0] + 2*pad - filter)/stride + 1;
+	size_t ow = (input_size[1] + 2*pad - filter)/stride + 1;
+	bench_op_t *op = bench_net_add(net, BENCH_CONV, oh*ow*num_filters, pred);
+	memcpy(op->input_size, input_size, 3*sizeof(size_t));
+	op->filter_size[0] = filter;
+	op->filter_size[1] = filter;
+	op->num_filters = num_filters;
+	op->strides[0] = stride;
+	op->strides[1] = stride;
+	for(i=0; i < 4; i++){
+		op->pad[i] = pad;
+	}
+	op->output_size[0] = oh;
+	op->output_size[1] = ow;
+	op->output_size[2] = num_filters;
+	size_t num_weights = filter*filter*input_size[2]*num_filters;
+	op->weights = (double *)malloc(num_weights*sizeof(double));
+	op->bias = (double *)malloc(num_filters*sizeof(double));
+	for(i=0; i < num_weights; i++){
+		op->weights[i] = bench_weight(filter*filter*input_size[2]);
+	}
+	for(i=0; i < num_filters; i++){
+		op->bias[i] = 0.1*(2*bench_uniform() - 1);
+	}
+	input_size[0] = oh;
+	input_size[1] = ow;
+	input_size[2] = num_filters;
+	return net->num_ops;
+}
+
+
+static size_t bench_maxpool(bench_net_t *net, size_t *input_size, size_t pool, size_t pred){
+	size_t oh = (input_size[0] - pool)/pool + 1;
+	size_t ow = (input_size[1] - pool)/pool + 1;
+	bench_op_t *op = bench_net_add(net, BENCH_MAXPOOL, oh*ow*input_size[2], pred);
+	memcpy(op->input_size, input_size, 3*sizeof(size_t));
+	op->filter_size[0] = pool;
+	op->filter_size[1] = pool;
+	op->strides[0] = pool;
+	op->strides[1] = pool;
+	op->output_size[0] = oh;
+	op->output_size[1] = ow;
+	op->output_size[2] = input_size[2];
+	input_size[0] = oh;
+	input_size[1] = ow;
+	return net->num_ops;
+}
+
+
+static size_t bench_residual(bench_net_t *net, size_t pred1, size_t pred2){
+	bench_op_t *op = bench_net_add(net, BENCH_RESIDUAL, bench_net_dims(net, pred1), pred1);
+	op->predecessors[1] = pred2;
+	op->num_predecessors = 2;
+	return net->num_ops;
+}
+
+
+/* the predecessors are treated as 1x1 images, so every neuron is a channel */
+static size_t bench_concat(bench_net_t *net, size_t *preds, size_t num_preds){
+	size_t i, out = 0;
+	for(i=0; i < num_preds; i++){
+		out += bench_net_dims(net, preds[i]);
+	}
+	bench_op_t *op = bench_net_add(net, BENCH_CONCAT, out, preds[0]);
+	op->num_predecessors = num_preds;
+	for(i=0; i < num_preds; i++){
+		op->predecessors[i] = preds[i];
+		op->channels[i] = bench_net_dims(net, preds[i]);
+	}
+	return net->num_ops;
+}
+
+
+static void bench_suite_mlp(bench_net_t *net, bench_options_t *opts, bench_op_type_t activation){
+	size_t d, layer = 0;
+	bench_net_init(net, 784, opts->epsilon);
+	for(d=0; d < opts->depth; d++){
+		layer = bench_fc(net, opts->width, layer);
+		layer = bench_activation(net, activation, layer);
+	}
+	bench_fc(net, 10, layer);
+}
+
+
+static void bench_suite_conv(bench_net_t *net, bench_options_t *opts){
+	size_t size[3] = {16, 16, 3};
+	size_t d, layer = 0;
+	bench_net_init(net, size[0]*size[1]*size[2], opts->epsilon);
+	layer = bench_conv(net, size, 3, 16, 1, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	for(d=1; d < opts->depth; d++){
+		layer = bench_conv(net, size, 3, 16, d%2 ? 2 : 1, layer);
+		layer = bench_activation(net, BENCH_RELU, layer);
+	}
+	layer = bench_fc(net, opts->width, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	bench_fc(net, 10, layer);
+}
+
+
+static void bench_suite_pool(bench_net_t *net, bench_options_t *opts){
+	size_t size[3] = {16, 16, 3};
+	size_t layer = 0;
+	bench_net_init(net, size[0]*size[1]*size[2], opts->epsilon);
+	layer = bench_conv(net, size, 3, 8, 1, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	layer = bench_maxpool(net, size, 2, layer);
+	layer = bench_conv(net, size, 3, 16, 1, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	layer = bench_maxpool(net, size, 2, layer);
+	layer = bench_fc(net, opts->width, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	bench_fc(net, 10, layer);
+}
+
+
+static void bench_suite_residual(bench_net_t *net, bench_options_t *opts){
+	size_t d, layer = 0;
+	bench_net_init(net, 784, opts->epsilon);
+	layer = bench_fc(net, opts->width, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	for(d=0; d < opts->depth; d++){
+		size_t block = bench_fc(net, opts->width, layer);
+		block = bench_activation(net, BENCH_RELU, block);
+		block = bench_fc(net, opts->width, block);
+		layer = bench_residual(net, layer, block);
+		layer = bench_activation(net, BENCH_RELU, layer);
+	}
+	bench_fc(net, 10, layer);
+}
+
+
+static void bench_suite_concat(bench_net_t *net, bench_options_t *opts){
+	size_t d, layer = 0;
+	bench_net_init(net, 784, opts->epsilon);
+	layer = bench_fc(net, opts->width, layer);
+	layer = bench_activation(net, BENCH_RELU, layer);
+	for(d=0; d < opts->depth; d++){
+		size_t branches[2];
+		branches[0] = bench_fc(net, opts->width/2, layer);
+		branches[1] = bench_fc(net, opts->width - opts->width/2, layer);
+		layer = bench_concat(net, branches, 2);
+		layer = bench_activation(net, BENCH_RELU, layer);
+	}
+	bench_fc(net, 10, layer);
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* traces                                                                  */
+/* ---------------------------------------------------------------------- */
+
+static void bench_write_doubles(FILE *file, double *values, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		fprintf(file, " %.17g", values[i]);
+	}
+}
+
+
+static bool bench_write_trace(bench_net_t *net, const char *path){
+	size_t i, j;
+	FILE *file = fopen(path, "w");
+	if(file==NULL){
+		return false;
+	}
+	fprintf(file, "fppoly-trace 1\ninput %zu", net->num_pixels);
+	for(i=0; i < net->num_pixels; i++){
+		fprintf(file, " %.17g %.17g", net->inf[i], net->sup[i]);
+	}
+	fprintf(file, "\n");
+	for(i=0; i < net->num_ops; i++){
+		bench_op_t *op = &net->ops[i];
+		fprintf(file, "%s", bench_op_names[op->type]);
+		switch(op->type){
+			case BENCH_FC:
+				fprintf(file, " %zu %zu %zu", op->out, op->in, op->predecessors[0]);
+				bench_write_doubles(file, op->weights, op->out*op->in);
+				bench_write_doubles(file, op->bias, op->out);
+				break;
+			case BENCH_CONV:
+				fprintf(file, " %zu %zu %zu %zu %zu %zu %zu %zu %zu %zu %zu %zu %zu", op->input_size[0], op->input_size[1], op->input_size[2],
+					op->filter_size[0], op->filter_size[1], op->num_filters, op->strides[0], op->strides[1],
+					op->pad[0], op->pad[1], op->pad[2], op->pad[3], op->predecessors[0]);
+				bench_write_doubles(file, op->weights, op->filter_size[0]*op->filter_size[1]*op->input_size[2]*op->num_filters);
+				bench_write_doubles(file, op->bias, op->num_filters);
+				break;
+			case BENCH_MAXPOOL:
+				fprintf(file, " %zu %zu %zu %zu %zu %zu %zu %zu", op->input_size[0], op->input_size[1], op->input_size[2],
+					op->filter_size[0], op->filter_size[1], op->strides[0], op->strides[1], op->predecessors[0]);
+				break;
+			case BENCH_RESIDUAL:
+				fprintf(file, " %zu %zu %zu", op->out, op->predecessors[0], op->predecessors[1]);
+				break;
+			case BENCH_CONCAT:
+				fprintf(file, " %zu", op->num_predecessors);
+				for(j=0; j < op->num_predecessors; j++){
+					fprintf(file, " %zu", op->predecessors[j]);
+				}
+				for(j=0; j < op->num_predecessors; j++){
+					fprintf(file, " %zu", op->channels[j]);
+				}
+				break;
+			default:
+				fprintf(file, " %zu %zu", op->out, op->predecessors[0]);
+		}
+		fprintf(file, "\n");
+	}
+	return fclose(file)==0;
+}
+
+
+static bool bench_read_sizes(FILE *file, size_t *values, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		if(fscanf(file, "%zu", &values[i])!=1){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static double * bench_read_doubles(FILE *file, size_t size){
+	size_t i;
+	double *values = (double *)malloc(size*sizeof(double));
+	for(i=0; i < size; i++){
+		if(fscanf(file, "%lf", &values[i])!=1){
+			free(values);
+			return NULL;
+		}
+	}
+	return values;
+}
+
+
+/* predecessors must name earlier layers */
+static bool bench_check_predecessors(bench_net_t *net, bench_op_t *op){
+	size_t i;
+	for(i=0; i < op->num_predecessors; i++){
+		if(op->predecessors[i] > net->num_ops - 1){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool bench_read_op(FILE *file, bench_net_t *net, const char *name){
+	size_t t, v[13];
+	for(t=0; t < sizeof(bench_op_names)/sizeof(bench_op_names[0]); t++){
+		if(strcmp(name, bench_op_names[t])==0){
+			break;
+		}
+	}
+	if(t==sizeof(bench_op_names)/sizeof(bench_op_names[0])){
+		return false;
+	}
+	bench_op_t *op = bench_net_add(net, (bench_op_type_t)t, 0, 0);
+	switch(op->type){
+		case BENCH_FC:
+			if(!bench_read_sizes(file, v, 3)){
+				return false;
+			}
+			op->out = v[0];
+			op->in = v[1];
+			op->predecessors[0] = v[2];
+			op->weights = bench_read_doubles(file, op->out*op->in);
+			op->bias = bench_read_doubles(file, op->out);
+			return op->weights!=NULL && op->bias!=NULL && bench_check_predecessors(net, op) && bench_net_dims(net, v[2])==op->in;
+		case BENCH_CONV:
+			if(!bench_read_sizes(file, v, 13)){
+				return false;
+			}
+			memcpy(op->input_size, v, 3*sizeof(size_t));
+			op->filter_size[0] = v[3];
+			op->filter_size[1] = v[4];
+			op->num_filters = v[5];
+			op->strides[0] = v[6];
+			op->strides[1] = v[7];
+			memcpy(op->pad, v+8, 4*sizeof(size_t));
+			op->predecessors[0] = v[12];
+			if(v[6]==0 || v[7]==0 || v[0] + v[8] + v[10] < v[3] || v[1] + v[9] + v[11] < v[4]){
+				return false;
+			}
+			op->output_size[0] = (v[0] + v[8] + v[10] - v[3])/v[6] + 1;
+			op->output_size[1] = (v[1] + v[9] + v[11] - v[4])/v[7] + 1;
+			op->output_size[2] = v[5];
+			op->out = op->output_size[0]*op->output_size[1]*op->output_size[2];
+			op->weights = bench_read_doubles(file, v[3]*v[4]*v[2]*v[5]);
+			op->bias = bench_read_doubles(file, v[5]);
+			return op->weights!=NULL && op->bias!=NULL && bench_check_predecessors(net, op) && bench_net_dims(net, v[12])==v[0]*v[1]*v[2];
+		case BENCH_MAXPOOL:
+			if(!bench_read_sizes(file, v, 8)){
+				return false;
+			}
+			memcpy(op->input_size, v, 3*sizeof(size_t));
+			op->filter_size[0] = v[3];
+			op->filter_size[1] = v[4];
+			op->strides[0] = v[5];
+			op->strides[1] = v[6];
+			op->predecessors[0] = v[7];
+			if(v[5]==0 || v[6]==0 || v[0] < v[3] || v[1] < v[4]){
+				return false;
+			}
+			op->output_size[0] = (v[0] - v[3])/v[5] + 1;
+			op->output_size[1] = (v[1] - v[4])/v[6] + 1;
+			op->output_size[2] = v[2];
+			op->out = op->output_size[0]*op->output_size[1]*op->output_size[2];
+			return bench_check_predecessors(net, op) && bench_net_dims(net, v[7])==v[0]*v[1]*v[2];
+		case BENCH_RESIDUAL:
+			if(!bench_read_sizes(file, v, 3)){
+				return false;
+			}
+			op->out = v[0];
+			op->predecessors[0] = v[1];
+			op->predecessors[1] = v[2];
+			op->num_predecessors = 2;
+			return bench_check_predecessors(net, op) && bench_net_dims(net, v[1])==v[0] && bench_net_dims(net, v[2])==v[0];
+		case BENCH_CONCAT:
+			if(!bench_read_sizes(file, v, 1) || v[0]==0 || v[0] > BENCH_MAX_PREDECESSORS){
+				return false;
+			}
+			op->num_predecessors = v[0];
+			if(!bench_read_sizes(file, op->predecessors, op->num_predecessors) || !bench_read_sizes(file, op->channels, op->num_predecessors)){
+				return false;
+			}
+			if(!bench_check_predecessors(net, op)){
+				return false;
+			}
+			for(t=0; t < op->num_predecessors; t++){
+				op->out += bench_net_dims(net, op->predecessors[t]);
+			}
+			return true;
+		default:
+			if(!bench_read_sizes(file, v, 2)){
+				return false;
+			}
+			op->out = v[0];
+			op->predecessors[0] = v[1];
+			return bench_check_predecessors(net, op) && bench_net_dims(net, v[1])==v[0];
+	}
+}
+
+
+static bool bench_read_trace(bench_net_t *net, const char *path){
+	char name[32];
+	int version;
+	size_t i, num_pixels;
+	memset(net, 0, sizeof(bench_net_t));
+	FILE *file = fopen(path, "r");
+	if(file==NULL){
+		fprintf(stderr, "could not open %s\n", path);
+		return false;
+	}
+	bool ok = fscanf(file, "fppoly-trace %d input %zu", &version, &num_pixels)==2 && version==1 && num_pixels > 0;
+	if(ok){
+		net->num_pixels = num_pixels;
+		net->inf = (double *)malloc(num_pixels*sizeof(double));
+		net->sup = (double *)malloc(num_pixels*sizeof(double));
+		for(i=0; ok && i < num_pixels; i++){
+			ok = fscanf(file, "%lf %lf", &net->inf[i], &net->sup[i])==2;
+		}
+	}
+	while(ok && fscanf(file, "%31s", name)==1){
+		ok = bench_read_op(file, net, name);
+	}
+	fclose(file);
+	if(!ok || net->num_ops==0){
+		fprintf(stderr, "%s: malformed trace after %zu layers\n", path, net->num_ops);
+		return false;
+	}
+	return true;
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* runs                                                                    */
+/* ---------------------------------------------------------------------- */
+
+static double bench_clock(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+
+/* the layers keep the predecessor and channel arrays, they are freed with the network */
+static void bench_apply(elina_manager_t *man, elina_abstract0_t *element, bench_op_t *op, size_t **kept, size_t *num_kept){
+	size_t i;
+	size_t *preds = (size_t *)malloc(2*BENCH_MAX_PREDECESSORS*sizeof(size_t));
+	size_t *channels = preds + BENCH_MAX_PREDECESSORS;
+	memcpy(preds, op->predecessors, op->num_predecessors*sizeof(size_t));
+	memcpy(channels, op->channels, op->num_predecessors*sizeof(size_t));
+	kept[(*num_kept)++] = preds;
+	switch(op->type){
+		case BENCH_FC:{
+			double **rows = (double **)malloc(op->out*sizeof(double *));
+			for(i=0; i < op->out; i++){
+				rows[i] = op->weights + i*op->in;
+			}
+			handle_fully_connected_layer(man, element, rows, op->bias, op->out, op->in, preds, 1);
+			free(rows);
+			break;
+		}
+		case BENCH_CONV:{
+			size_t output_size[3];
+			memcpy(output_size, op->output_size, 3*sizeof(size_t));
+			handle_convolutional_layer(man, element, op->weights, op->bias, op->input_size, op->filter_size, op->num_filters, op->strides, output_size,
+						   op->pad[0], op->pad[1], op->pad[2], op->pad[3], true, preds, 1);
+			break;
+		}
+		case BENCH_RELU:
+			handle_relu_layer(man, element, op->out, preds, 1, true);
+			break;
+		case BENCH_SIGMOID:
+			handle_sigmoid_layer(man, element, op->out, preds, 1, true);
+			break;
+		case BENCH_TANH:
+			handle_tanh_layer(man, element, op->out, preds, 1, true);
+			break;
+		case BENCH_MAXPOOL:{
+			size_t pool_size[3] = {op->filter_size[0], op->filter_size[1], 1};
+			size_t strides[3] = {op->strides[0], op->strides[1], 1};
+			size_t output_size[3];
+			memcpy(output_size, op->output_size, 3*sizeof(size_t));
+			handle_pool_layer(man, element, pool_size, op->input_size, strides, 0, 0, 0, 0, output_size, preds, 1, true);
+			break;
+		}
+		case BENCH_RESIDUAL:
+			handle_residual_layer(man, element, op->out, preds, 2);
+			break;
+		case BENCH_CONCAT:
+			handle_concatenation_layer(man, element, preds, op->num_predecessors, channels);
+			break;
+	}
+}
+
+
+static long bench_peak_rss_kb(void){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+
+/* one line per repetition: time, throughput, memory and checksums of the bounds */
+static void bench_run(const char *name, bench_net_t *net, bench_options_t *opts){
+	size_t r, i, l;
+	for(r=0; r < opts->repetitions; r++){
+		elina_manager_t *man = fppoly_manager_alloc();
+		fppoly_manager_set_num_threads(man, opts->num_threads, false);
+		fppoly_manager_set_backsubstitution(man, opts->backsubstitution);
+		fppoly_manager_set_single_precision(man, opts->single_precision);
+		fppoly_manager_set_stats(man, opts->stats_out!=NULL);
+		size_t **kept = (size_t **)malloc(net->num_ops*sizeof(size_t *));
+		size_t num_kept = 0;
+		double start = bench_clock();
+		elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->num_pixels, net->inf, net->sup);
+		for(i=0; i < net->num_ops; i++){
+			bench_apply(man, element, &net->ops[i], kept, &num_kept);
+		}
+		double elapsed = bench_clock() - start;
+		fppoly_t *fp = fppoly_of_abstract0(element);
+		size_t neurons = 0;
+		double width = 0, checksum = 0;
+		for(l=0; l < fp->numlayers; l++){
+			layer_t *layer = fp->layers[l];
+			neurons += layer->dims;
+			for(i=0; i < layer->dims; i++){
+				double lb = -layer->neurons[i]->lb;
+				double ub = layer->neurons[i]->ub;
+				width += ub - lb;
+				checksum += (lb + 2*ub)*(1 + (double)(i%7))*1e-3;
+			}
+		}
+		layer_t *out = fp->layers[fp->numlayers-1];
+		size_t proven = 0;
+		for(i=1; i < out->dims; i++){
+			proven += is_greater(man, element, 0, i);
+		}
+		printf("%s layers %zu neurons %zu time %.6f neurons/s %.1f rss_kb %ld width %.17g checksum %.17g proven %zu/%zu\n",
+		       name, fp->numlayers, neurons, elapsed, neurons/elapsed, bench_peak_rss_kb(), width, checksum, proven, out->dims ? out->dims-1 : 0);
+		if(opts->stats_out!=NULL && !fppoly_manager_dump_stats(man, opts->stats_out)){
+			fprintf(stderr, "could not write %s\n", opts->stats_out);
+		}
+		elina_abstract0_free(man, element);
+		elina_manager_free(man);
+		for(i=0; i < num_kept; i++){
+			free(kept[i]);
+		}
+		free(kept);
+	}
+}
+
+
+static bool bench_build_suite(const char *suite, bench_net_t *net, bench_options_t *opts){
+	bench_rng_state = opts->seed ? opts->seed : 1;
+	if(strcmp(suite, "mlp")==0){
+		bench_suite_mlp(net, opts, BENCH_RELU);
+	}
+	else if(strcmp(suite, "sigmoid")==0){
+		bench_suite_mlp(net, opts, BENCH_SIGMOID);
+	}
+	else if(strcmp(suite, "tanh")==0){
+		bench_suite_mlp(net, opts, BENCH_TANH);
+	}
+	else if(strcmp(suite, "conv")==0){
+		bench_suite_conv(net, opts);
+	}
+	else if(strcmp(suite, "pool")==0){
+		bench_suite_pool(net, opts);
+	}
+	else if(strcmp(suite, "residual")==0){
+		bench_suite_residual(net, opts);
+	}
+	else if(strcmp(suite, "concat")==0){
+		bench_suite_concat(net, opts);
+	}
+	else{
+		return false;
+	}
+	return true;
+}
+
+
+static void bench_usage(const char *prog){
+	printf("usage: %s [options] [suite ...]\n"
+	       "suites: mlp conv pool residual concat sigmoid tanh all (default all)\n"
+	       "  -t n      threads of the manager (0: one per CPU, default 0)\n"
+	       "  -m        matrix back-substitution\n"
+	       "  -s        single precision\n"
+	       "  -r n      repetitions (default 1)\n"
+	       "  -d n      depth of the synthetic networks (default 4)\n"
+	       "  -W n      width of the synthetic networks (default 256)\n"
+	       "  -e eps    radius of the input box (default 0.01)\n"
+	       "  -S seed   seed of the synthetic weights (default 1)\n"
+	       "  -w file   write the network of the (single) suite as a trace\n"
+	       "  -R file   replay a trace, may be given several times\n"
+	       "  -j file   dump the per-layer statistics of the last run as JSON\n", prog);
+}
+
+
+int main(int argc, char **argv){
+	static const char *all_suites[] = {"mlp", "conv", "pool", "residual", "concat", "sigmoid", "tanh"};
+	bench_options_t opts;
+	opts.num_threads = 0;
+	opts.backsubstitution = FPPOLY_BACKSUBSTITUTE_NEURON;
+	opts.single_precision = false;
+	opts.repetitions = 1;
+	opts.depth = 4;
+	opts.width = 256;
+	opts.epsilon = 0.01;
+	opts.seed = 1;
+	opts.trace_out = NULL;
+	opts.stats_out = NULL;
+	const char **traces = (const char **)malloc(argc*sizeof(char *));
+	size_t num_traces = 0;
+	int c, i;
+	while((c = getopt(argc, argv, "t:msr:d:W:e:S:w:R:j:h"))!=-1){
+		switch(c){
+			case 't': opts.num_threads = strtoul(optarg, NULL, 10); break;
+			case 'm': opts.backsubstitution = FPPOLY_BACKSUBSTITUTE_MATRIX; break;
+			case 's': opts.single_precision = true; break;
+			case 'r': opts.repetitions = strtoul(optarg, NULL, 10); break;
+			case 'd': opts.depth = strtoul(optarg, NULL, 10); break;
+			case 'W': opts.width = strtoul(optarg, NULL, 10); break;
+			case 'e': opts.epsilon = atof(optarg); break;
+			case 'S': opts.seed = strtoul(optarg, NULL, 10); break;
+			case 'w': opts.trace_out = optarg; break;
+			case 'R': traces[num_traces++] = optarg; break;
+			case 'j': opts.stats_out = optarg; break;
+			default:
+				bench_usage(argv[0]);
+				free(traces);
+				return c=='h' ? 0 : 1;
+		}
+	}
+	if(opts.depth==0 || opts.width < 2){
+		printf("The depth should be positive and the width at least 2\n");
+		free(traces);
+		return 1;
+	}
+	int status = 0;
+	size_t j, num_all = sizeof(all_suites)/sizeof(all_suites[0]);
+	const char **suites = (const char **)malloc((argc*num_all + num_all)*sizeof(char *));
+	size_t num_suites = 0;
+	for(i=optind; i < argc; i++){
+		if(strcmp(argv[i], "all")==0){
+			for(j=0; j < num_all; j++){
+				suites[num_suites++] = all_suites[j];
+			}
+		}
+		else{
+			suites[num_suites++] = argv[i];
+		}
+	}
+	if(optind==argc && num_traces==0){
+		for(j=0; j < num_all; j++){
+			suites[num_suites++] = all_suites[j];
+		}
+	}
+	for(j=0; j < num_suites; j++){
+		bench_net_t net;
+		if(!bench_build_suite(suites[j], &net, &opts)){
+			fprintf(stderr, "unknown suite %s\n", suites[j]);
+			status = 1;
+			continue;
+		}
+		if(opts.trace_out!=NULL && !bench_write_trace(&net, opts.trace_out)){
+			fprintf(stderr, "could not write %s\n", opts.trace_out);
+			status = 1;
+		}
+		bench_run(suites[j], &net, &opts);
+		bench_net_free(&net);
+	}
+	for(i=0; i < (int)num_traces; i++){
+		bench_net_t net;
+		if(!bench_read_trace(&net, traces[i])){
+			bench_net_free(&net);
+			status = 1;
+			continue;
+		}
+		bench_run(traces[i], &net, &opts);
+		bench_net_free(&net);
+	}
+	free(suites);
+	free(traces);
+	return status;
+}
@@ -0,0 +1,587 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#include "fppoly_snapshot.h"
+#include "conv_backsubstitute.h"
+#include "spatial_lp.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* header words, followed by numlayers+1 offsets of the layer sections, the
+   last one being the end of the file */
+enum{
+	SNAPSHOT_MAGIC,
+	SNAPSHOT_VERSION,
+	SNAPSHOT_NUMLAYERS,
+	SNAPSHOT_NUM_PIXELS,
+	SNAPSHOT_SIZE,
+	SNAPSHOT_LSTM_INDEX,
+	SNAPSHOT_HAS_ORIGINAL_INPUT,
+	SNAPSHOT_HAS_INPUT_EXPRS,
+	SNAPSHOT_SPATIAL_SIZE,
+	SNAPSHOT_SPATIAL_GAMMA,
+	SNAPSHOT_NUM_EXPRS,
+	SNAPSHOT_HEADER_WORDS,
+};
+
+/* which coefficient arrays follow an expression */
+#define SNAPSHOT_EXPR_INF 1
+#define SNAPSHOT_EXPR_SUP 2
+#define SNAPSHOT_EXPR_DIM 4
+
+/* which expressions follow the bounds of a neuron, the uexpr that are the same
+   as the lexpr are not written again */
+#define SNAPSHOT_LEXPR 1
+#define SNAPSHOT_UEXPR 2
+#define SNAPSHOT_UEXPR_SHARED 4
+#define SNAPSHOT_BACK_LEXPR 8
+#define SNAPSHOT_BACK_UEXPR 16
+#define SNAPSHOT_BACK_UEXPR_SHARED 32
+#define SNAPSHOT_NEURON_BITS 63
+
+struct fppoly_snapshot_t{
+	void *map;
+	size_t length;
+	/* headers of the pinned expressions of all layers */
+	expr_t *exprs;
+	/* offsets[i] is the start of layer i, offsets[numlayers] the end of the file */
+	const size_t *offsets;
+	size_t numlayers;
+};
+
+
+typedef struct snapshot_writer_t{
+	FILE *file;
+	size_t offset;
+	bool ok;
+}snapshot_writer_t;
+
+
+static void snapshot_write(snapshot_writer_t *w, const void *data, size_t words){
+	if(words==0 || !w->ok){
+		return;
+	}
+	w->ok = fwrite(data, sizeof(size_t), words, w->file)==words;
+	w->offset += words*sizeof(size_t);
+}
+
+
+static void snapshot_write_word(snapshot_writer_t *w, size_t word){
+	snapshot_write(w, &word, 1);
+}
+
+
+static void snapshot_write_double(snapshot_writer_t *w, double d){
+	snapshot_write(w, &d, 1);
+}
+
+
+static void snapshot_write_expr(snapshot_writer_t *w, expr_t *expr){
+	size_t size = expr->size;
+	size_t mask = 0;
+	if(size>0){
+		mask |= expr->inf_coeff ? SNAPSHOT_EXPR_INF : 0;
+		mask |= expr->sup_coeff ? SNAPSHOT_EXPR_SUP : 0;
+		mask |= (expr->type==SPARSE && expr->dim) ? SNAPSHOT_EXPR_DIM : 0;
+	}
+	snapshot_write_word(w, expr->type);
+	snapshot_write_word(w, size);
+	snapshot_write_word(w, mask);
+	snapshot_write_double(w, expr->inf_cst);
+	snapshot_write_double(w, expr->sup_cst);
+	if(mask & SNAPSHOT_EXPR_INF){
+		snapshot_write(w, expr->inf_coeff, size);
+	}
+	if(mask & SNAPSHOT_EXPR_SUP){
+		snapshot_write(w, expr->sup_coeff, size);
+	}
+	if(mask & SNAPSHOT_EXPR_DIM){
+		snapshot_write(w, expr->dim, size);
+	}
+}
+
+
+static size_t snapshot_neuron_mask(neuron_t *neuron){
+	size_t mask = 0;
+	if(neuron->lexpr){
+		mask |= SNAPSHOT_LEXPR;
+	}
+	if(neuron->uexpr){
+		mask |= neuron->uexpr==neuron->lexpr ? SNAPSHOT_UEXPR_SHARED : SNAPSHOT_UEXPR;
+	}
+	if(neuron->backsubstituted_lexpr){
+		mask |= SNAPSHOT_BACK_LEXPR;
+	}
+	if(neuron->backsubstituted_uexpr){
+		mask |= neuron->backsubstituted_uexpr==neuron->backsubstituted_lexpr ? SNAPSHOT_BACK_UEXPR_SHARED : SNAPSHOT_BACK_UEXPR;
+	}
+	return mask;
+}
+
+
+/* number of expressions a layer section holds */
+static size_t snapshot_layer_num_exprs(layer_t *layer){
+	size_t i, count = 0;
+	for(i=0; i < layer->dims; i++){
+		size_t mask = snapshot_neuron_mask(layer->neurons[i]);
+		count += ((mask & SNAPSHOT_LEXPR)!=0) + ((mask & SNAPSHOT_UEXPR)!=0);
+		count += ((mask & SNAPSHOT_BACK_LEXPR)!=0) + ((mask & SNAPSHOT_BACK_UEXPR)!=0);
+	}
+	return count;
+}
+
+
+static void snapshot_write_layer(snapshot_writer_t *w, layer_t *layer){
+	size_t dims = layer->dims;
+	bool has_state = layer->h_t_inf!=NULL;
+	snapshot_write_word(w, dims);
+	snapshot_write_word(w, layer->num_predecessors);
+	snapshot_write_word(w, layer->is_activation);
+	snapshot_write_word(w, layer->is_concat);
+	snapshot_write_word(w, layer->num_channels);
+	snapshot_write_word(w, layer->C!=NULL);
+	snapshot_write_word(w, has_state);
+	snapshot_write_word(w, layer->conv!=NULL);
+	snapshot_write(w, layer->predecessors, layer->num_predecessors);
+	if(layer->C){
+		snapshot_write(w, layer->C, layer->num_predecessors);
+	}
+	if(has_state){
+		snapshot_write(w, layer->h_t_inf, dims);
+		snapshot_write(w, layer->h_t_sup, dims);
+		snapshot_write(w, layer->c_t_inf, dims);
+		snapshot_write(w, layer->c_t_sup, dims);
+	}
+	if(layer->conv){
+		conv_op_t *conv = layer->conv;
+		snapshot_write(w, conv->input_size, 3);
+		snapshot_write(w, conv->filter_size, 2);
+		snapshot_write(w, conv->strides, 2);
+		snapshot_write(w, conv->output_size, 3);
+		snapshot_write_word(w, conv->pad_top);
+		snapshot_write_word(w, conv->pad_left);
+		snapshot_write_word(w, conv->filter_bias!=NULL);
+		snapshot_write(w, conv->filter_weights, conv->filter_size[0]*conv->filter_size[1]*conv->input_size[2]*conv->output_size[2]);
+		if(conv->filter_bias){
+			snapshot_write(w, conv->filter_bias, conv->output_size[2]);
+		}
+	}
+	size_t i;
+	for(i=0; i < dims; i++){
+		neuron_t *neuron = layer->neurons[i];
+		size_t mask = snapshot_neuron_mask(neuron);
+		snapshot_write_double(w, neuron->lb);
+		snapshot_write_double(w, neuron->ub);
+		snapshot_write_word(w, mask);
+		if(mask & SNAPSHOT_LEXPR){
+			snapshot_write_expr(w, neuron->lexpr);
+		}
+		if(mask & SNAPSHOT_UEXPR){
+			snapshot_write_expr(w, neuron->uexpr);
+		}
+		if(mask & SNAPSHOT_BACK_LEXPR){
+			snapshot_write_expr(w, neuron->backsubstituted_lexpr);
+		}
+		if(mask & SNAPSHOT_BACK_UEXPR){
+			snapshot_write_expr(w, neuron->backsubstituted_uexpr);
+		}
+	}
+}
+
+
+bool fppoly_snapshot_save(elina_manager_t *man, elina_abstract0_t *element, const char *path){
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	FILE *file = fopen(path, "wb");
+	if(file==NULL){
+		return false;
+	}
+	size_t numlayers = fp->numlayers;
+	size_t num_pixels = fp->num_pixels;
+	bool has_input_exprs = fp->input_lexpr!=NULL && fp->input_uexpr!=NULL;
+	size_t header[SNAPSHOT_HEADER_WORDS];
+	size_t i, num_exprs = 0;
+	for(i=0; i < numlayers; i++){
+		num_exprs += snapshot_layer_num_exprs(fp->layers[i]);
+	}
+	header[SNAPSHOT_MAGIC] = FPPOLY_SNAPSHOT_MAGIC;
+	header[SNAPSHOT_VERSION] = FPPOLY_SNAPSHOT_VERSION;
+	header[SNAPSHOT_NUMLAYERS] = numlayers;
+	header[SNAPSHOT_NUM_PIXELS] = num_pixels;
+	header[SNAPSHOT_SIZE] = fp->size;
+	header[SNAPSHOT_LSTM_INDEX] = fp->lstm_index;
+	header[SNAPSHOT_HAS_ORIGINAL_INPUT] = fp->original_input_inf!=NULL;
+	header[SNAPSHOT_HAS_INPUT_EXPRS] = has_input_exprs;
+	header[SNAPSHOT_SPATIAL_SIZE] = fp->spatial_size;
+	memcpy(&header[SNAPSHOT_SPATIAL_GAMMA], &fp->spatial_gamma, sizeof(double));
+	header[SNAPSHOT_NUM_EXPRS] = num_exprs;
+
+	snapshot_writer_t w = {file, 0, true};
+	snapshot_write(&w, header, SNAPSHOT_HEADER_WORDS);
+	// the offsets are known once the layers are written, this reserves their place
+	size_t *offsets = (size_t *)calloc(numlayers+1, sizeof(size_t));
+	size_t table = w.offset;
+	snapshot_write(&w, offsets, numlayers+1);
+
+	snapshot_write(&w, fp->input_inf, num_pixels);
+	snapshot_write(&w, fp->input_sup, num_pixels);
+	if(fp->original_input_inf){
+		snapshot_write(&w, fp->original_input_inf, num_pixels);
+		snapshot_write(&w, fp->original_input_sup, num_pixels);
+	}
+	if(has_input_exprs){
+		for(i=0; i < num_pixels; i++){
+			snapshot_write_expr(&w, fp->input_lexpr[i]);
+			snapshot_write_expr(&w, fp->input_uexpr[i]);
+		}
+	}
+	snapshot_write(&w, fp->spatial_indices, fp->spatial_size);
+	snapshot_write(&w, fp->spatial_neighbors, fp->spatial_size);
+
+	for(i=0; i < numlayers; i++){
+		offsets[i] = w.offset;
+		snapshot_write_layer(&w, fp->layers[i]);
+	}
+	offsets[numlayers] = w.offset;
+	if(w.ok){
+		w.ok = fseek(file, table, SEEK_SET)==0;
+		snapshot_write(&w, offsets, numlayers+1);
+	}
+	free(offsets);
+	if(fclose(file)!=0){
+		w.ok = false;
+	}
+	return w.ok;
+}
+
+
+typedef struct snapshot_reader_t{
+	char *base;
+	size_t offset;
+	size_t length;
+	bool ok;
+}snapshot_reader_t;
+
+
+/* pointer to the next words of the mapping, NULL past its end */
+static void * snapshot_read(snapshot_reader_t *r, size_t words){
+	if(!r->ok || words > (r->length - r->offset)/sizeof(size_t)){
+		r->ok = false;
+		return NULL;
+	}
+	void *res = r->base + r->offset;
+	r->offset += words*sizeof(size_t);
+	return res;
+}
+
+
+static size_t snapshot_read_word(snapshot_reader_t *r){
+	size_t *word = (size_t *)snapshot_read(r, 1);
+	return word ? *word : 0;
+}
+
+
+static double snapshot_read_double(snapshot_reader_t *r){
+	double *d = (double *)snapshot_read(r, 1);
+	return d ? *d : 0;
+}
+
+
+/* fills expr with a view of the next expression of the mapping */
+static void snapshot_read_expr(snapshot_reader_t *r, expr_t *expr){
+	expr->type = snapshot_read_word(r)==SPARSE ? SPARSE : DENSE;
+	size_t size = snapshot_read_word(r);
+	size_t mask = snapshot_read_word(r);
+	expr->size = size;
+	expr->inf_cst = snapshot_read_double(r);
+	expr->sup_cst = snapshot_read_double(r);
+	expr->inf_coeff = (mask & SNAPSHOT_EXPR_INF) ? (double *)snapshot_read(r, size) : NULL;
+	expr->sup_coeff = (mask & SNAPSHOT_EXPR_SUP) ? (double *)snapshot_read(r, size) : NULL;
+	expr->dim = (mask & SNAPSHOT_EXPR_DIM) ? (size_t *)snapshot_read(r, size) : NULL;
+	expr->borrowed = false;
+	// never reaches zero, see free_expr
+	expr->refcount = SIZE_MAX/2;
+}
+
+
+static expr_t * snapshot_next_expr(snapshot_reader_t *r, expr_t **next, expr_t *end){
+	if(*next==end){
+		r->ok = false;
+		return NULL;
+	}
+	expr_t *expr = (*next)++;
+	snapshot_read_expr(r, expr);
+	return expr;
+}
+
+
+/* masks that snapshot_neuron_mask can produce: a shared uexpr needs the
+   lexpr, and a lexpr always comes with a uexpr, as free_neuron_exprs
+   expects */
+static bool snapshot_valid_neuron_mask(size_t mask){
+	if(mask & ~(size_t)SNAPSHOT_NEURON_BITS){
+		return false;
+	}
+	bool has_uexpr = (mask & SNAPSHOT_UEXPR)!=0;
+	bool shared_uexpr = (mask & SNAPSHOT_UEXPR_SHARED)!=0;
+	if((has_uexpr && shared_uexpr) || (shared_uexpr && !(mask & SNAPSHOT_LEXPR))){
+		return false;
+	}
+	if((mask & SNAPSHOT_LEXPR) && !has_uexpr && !shared_uexpr){
+		return false;
+	}
+	bool has_back_uexpr = (mask & SNAPSHOT_BACK_UEXPR)!=0;
+	bool shared_back_uexpr = (mask & SNAPSHOT_BACK_UEXPR_SHARED)!=0;
+	return !(has_back_uexpr && shared_back_uexpr) && !(shared_back_uexpr && !(mask & SNAPSHOT_BACK_LEXPR));
+}
+
+
+static void snapshot_read_layer(snapshot_reader_t *r, fppoly_t *fp, expr_t **next, expr_t *end){
+	size_t dims = snapshot_read_word(r);
+	size_t num_predecessors = snapshot_read_word(r);
+	bool is_activation = snapshot_read_word(r);
+	bool is_concat = snapshot_read_word(r);
+	size_t num_channels = snapshot_read_word(r);
+	bool has_C = snapshot_read_word(r);
+	bool has_state = snapshot_read_word(r);
+	bool has_conv = snapshot_read_word(r);
+	// like the callers of the handle_*_layer functions, the mapping owns the predecessors
+	size_t *predecessors = (size_t *)snapshot_read(r, num_predecessors);
+	if(!r->ok){
+		return;
+	}
+	fppoly_add_new_layer(fp, dims, predecessors, num_predecessors, is_activation);
+	layer_t *layer = fp->layers[fp->numlayers-1];
+	layer->is_concat = is_concat;
+	layer->num_channels = num_channels;
+	if(has_C){
+		layer->C = (size_t *)snapshot_read(r, num_predecessors);
+	}
+	if(has_state){
+		double **state[4] = {&layer->h_t_inf, &layer->h_t_sup, &layer->c_t_inf, &layer->c_t_sup};
+		size_t k;
+		for(k=0; k < 4; k++){
+			double *src = (double *)snapshot_read(r, dims);
+			*state[k] = (double *)malloc(dims*sizeof(double));
+			if(src){
+				memcpy(*state[k], src, dims*sizeof(double));
+			}
+		}
+	}
+	if(has_conv){
+		size_t *input_size = (size_t *)snapshot_read(r, 3);
+		size_t *filter_size = (size_t *)snapshot_read(r, 2);
+		size_t *strides = (size_t *)snapshot_read(r, 2);
+		size_t *output_size = (size_t *)snapshot_read(r, 3);
+		size_t pad_top = snapshot_read_word(r);
+		size_t pad_left = snapshot_read_word(r);
+		bool has_bias = snapshot_read_word(r);
+		if(!r->ok){
+			return;
+		}
+		double *filter_weights = (double *)snapshot_read(r, filter_size[0]*filter_size[1]*input_size[2]*output_size[2]);
+		double *filter_bias = has_bias ? (double *)snapshot_read(r, output_size[2]) : NULL;
+		if(!r->ok){
+			return;
+		}
+		layer->conv = conv_op_alloc(filter_weights, filter_bias, input_size, filter_size, strides, output_size, pad_top, pad_left, has_bias);
+	}
+	size_t i;
+	for(i=0; i < dims && r->ok; i++){
+		neuron_t *neuron = layer->neurons[i];
+		neuron->lb = snapshot_read_double(r);
+		neuron->ub = snapshot_read_double(r);
+		size_t mask = snapshot_read_word(r);
+		if(!snapshot_valid_neuron_mask(mask)){
+			r->ok = false;
+			break;
+		}
+		if(mask & SNAPSHOT_LEXPR){
+			neuron->lexpr = snapshot_next_expr(r, next, end);
+		}
+		if(mask & SNAPSHOT_UEXPR){
+			neuron->uexpr = snapshot_next_expr(r, next, end);
+		}
+		else if(mask & SNAPSHOT_UEXPR_SHARED){
+			neuron->uexpr = neuron->lexpr;
+		}
+		if(mask & SNAPSHOT_BACK_LEXPR){
+			neuron->backsubstituted_lexpr = snapshot_next_expr(r, next, end);
+		}
+		if(mask & SNAPSHOT_BACK_UEXPR){
+			neuron->backsubstituted_uexpr = snapshot_next_expr(r, next, end);
+		}
+		else if(mask & SNAPSHOT_BACK_UEXPR_SHARED){
+			neuron->backsubstituted_uexpr = neuron->backsubstituted_lexpr;
+		}
+	}
+}
+
+
+void fppoly_snapshot_free(fppoly_snapshot_t *snapshot){
+	if(snapshot==NULL){
+		return;
+	}
+	munmap(snapshot->map, snapshot->length);
+	free(snapshot->exprs);
+	free(snapshot);
+}
+
+
+static fppoly_snapshot_t * fppoly_snapshot_map(const char *path){
+	int fd = open(path, O_RDONLY);
+	if(fd < 0){
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st)!=0 || (size_t)st.st_size < SNAPSHOT_HEADER_WORDS*sizeof(size_t)){
+		close(fd);
+		return NULL;
+	}
+	// a private writable mapping of a read-only file: writes to the coefficients
+	// copy the page and never reach the file or the other processes
+	void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map==MAP_FAILED){
+		return NULL;
+	}
+	fppoly_snapshot_t *snapshot = (fppoly_snapshot_t *)malloc(sizeof(fppoly_snapshot_t));
+	snapshot->map = map;
+	snapshot->length = st.st_size;
+	snapshot->exprs = NULL;
+	snapshot->offsets = NULL;
+	snapshot->numlayers = 0;
+	return snapshot;
+}
+
+
+elina_abstract0_t * fppoly_snapshot_load(elina_manager_t *man, const char *path){
+	fppoly_snapshot_t *snapshot = fppoly_snapshot_map(path);
+	if(snapshot==NULL){
+		return NULL;
+	}
+	snapshot_reader_t r = {(char *)snapshot->map, 0, snapshot->length, true};
+	size_t *header = (size_t *)snapshot_read(&r, SNAPSHOT_HEADER_WORDS);
+	if(header[SNAPSHOT_MAGIC]!=FPPOLY_SNAPSHOT_MAGIC || header[SNAPSHOT_VERSION]!=FPPOLY_SNAPSHOT_VERSION){
+		fppoly_snapshot_free(snapshot);
+		return NULL;
+	}
+	size_t numlayers = header[SNAPSHOT_NUMLAYERS];
+	size_t num_pixels = header[SNAPSHOT_NUM_PIXELS];
+	size_t num_exprs = header[SNAPSHOT_NUM_EXPRS];
+	// fppoly_add_new_layer allocates room for 2000 layers
+	if(numlayers > 2000){
+		fppoly_snapshot_free(snapshot);
+		return NULL;
+	}
+	snapshot->numlayers = numlayers;
+	snapshot->offsets = (const size_t *)snapshot_read(&r, numlayers+1);
+	double *input_inf = (double *)snapshot_read(&r, num_pixels);
+	double *input_sup = (double *)snapshot_read(&r, num_pixels);
+	double *original_input_inf = NULL;
+	double *original_input_sup = NULL;
+	if(header[SNAPSHOT_HAS_ORIGINAL_INPUT]){
+		original_input_inf = (double *)snapshot_read(&r, num_pixels);
+		original_input_sup = (double *)snapshot_read(&r, num_pixels);
+	}
+	if(!r.ok || snapshot->offsets[numlayers]!=snapshot->length || num_exprs > snapshot->length/sizeof(size_t)){
+		fppoly_snapshot_free(snapshot);
+		return NULL;
+	}
+
+	size_t i;
+	double *inf_array = (double *)malloc(num_pixels*sizeof(double));
+	for(i=0; i < num_pixels; i++){
+		inf_array[i] = -input_inf[i];
+	}
+	elina_abstract0_t *res = fppoly_from_network_input(man, 0, num_pixels, inf_array, input_sup);
+	free(inf_array);
+	fppoly_t *fp = fppoly_of_abstract0(res);
+	fp->snapshot = snapshot;
+	fp->size = header[SNAPSHOT_SIZE];
+	fp->lstm_index = header[SNAPSHOT_LSTM_INDEX];
+	if(original_input_inf){
+		memcpy(fp->original_input_inf, original_input_inf, num_pixels*sizeof(double));
+		memcpy(fp->original_input_sup, original_input_sup, num_pixels*sizeof(double));
+	}
+	else{
+		free(fp->original_input_inf);
+		fp->original_input_inf = NULL;
+		free(fp->original_input_sup);
+		fp->original_input_sup = NULL;
+	}
+	// the input expressions are freed one by one by fppoly_free, only their
+	// coefficients live in the mapping
+	if(header[SNAPSHOT_HAS_INPUT_EXPRS]){
+		fp->input_lexpr = (expr_t **)malloc(num_pixels*sizeof(expr_t *));
+		fp->input_uexpr = (expr_t **)malloc(num_pixels*sizeof(expr_t *));
+		for(i=0; i < num_pixels; i++){
+			fp->input_lexpr[i] = (expr_t *)malloc(sizeof(expr_t));
+			snapshot_read_expr(&r, fp->input_lexpr[i]);
+			fp->input_uexpr[i] = (expr_t *)malloc(sizeof(expr_t));
+			snapshot_read_expr(&r, fp->input_uexpr[i]);
+		}
+	}
+	size_t spatial_size = header[SNAPSHOT_SPATIAL_SIZE];
+	size_t *spatial_indices = (size_t *)snapshot_read(&r, spatial_size);
+	size_t *spatial_neighbors = (size_t *)snapshot_read(&r, spatial_size);
+	if(r.ok && spatial_size > 0){
+		fp->spatial_size = spatial_size;
+		memcpy(&fp->spatial_gamma, &header[SNAPSHOT_SPATIAL_GAMMA], sizeof(double));
+		fp->spatial_indices = (size_t *)malloc(spatial_size*sizeof(size_t));
+		fp->spatial_neighbors = (size_t *)malloc(spatial_size*sizeof(size_t));
+		memcpy(fp->spatial_indices, spatial_indices, spatial_size*sizeof(size_t));
+		memcpy(fp->spatial_neighbors, spatial_neighbors, spatial_size*sizeof(size_t));
+		fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+		fp->spatial_lp = spatial_lp_alloc(fp, pr->spatial_solver);
+	}
+
+	// the expression headers of every layer are built here, the pages that
+	// hold only coefficients are read by the first back-substitution using them
+	snapshot->exprs = (expr_t *)malloc(num_exprs*sizeof(expr_t));
+	expr_t *next = snapshot->exprs;
+	for(i=0; i < numlayers && r.ok; i++){
+		if(snapshot->offsets[i]!=r.offset){
+			r.ok = false;
+			break;
+		}
+		snapshot_read_layer(&r, fp, &next, snapshot->exprs + num_exprs);
+	}
+	if(!r.ok){
+		elina_abstract0_free(man, res);
+		return NULL;
+	}
+	return res;
+}
+
+
+void fppoly_snapshot_prefetch_layer(elina_manager_t *man, elina_abstract0_t *element, size_t layerno){
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	fppoly_snapshot_t *snapshot = fp->snapshot;
+	if(snapshot==NULL || layerno >= snapshot->numlayers){
+		return;
+	}
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t start = snapshot->offsets[layerno] & ~(page-1);
+	madvise((char *)snapshot->map + start, snapshot->offsets[layerno+1] - start, MADV_WILLNEED);
+}
@@ -0,0 +1,62 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#ifndef __FPPOLY_SNAPSHOT_H_INCLUDED__
+#define __FPPOLY_SNAPSHOT_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+
+/* Binary snapshots of analysed elements. The file is a sequence of 8 byte
+   words in the byte order of the machine that wrote it: a header, the offsets
+   of the layer sections, the input box and input expressions, then one
+   section per layer with the bounds and all expressions of its neurons.
+
+   A restored element maps the file privately, so the pages of a snapshot
+   loaded by several processes are shared through the page cache until one of
+   them writes to a coefficient. Loading is not lazy per layer: it walks every
+   layer section and builds the bounds and the expression headers of all
+   neurons, which reads every page that holds a header. Only the coefficient
+   arrays are left in the mapping, the pages that hold nothing else are read
+   when a back-substitution first touches them, and
+   fppoly_snapshot_prefetch_layer asks for a layer ahead of time. The cost of a
+   load is therefore one pass over the headers, not a re-analysis, but it grows
+   with the number of neurons of all layers. The expressions of the layers
+   point into the mapping and are pinned: free_expr never releases them, the
+   mapping and the expression headers go away with the element. Expressions of
+   a restored element must therefore not be shared into elements that outlive
+   it. */
+
+#define FPPOLY_SNAPSHOT_MAGIC 0x31534c4f5050465fUL
+#define FPPOLY_SNAPSHOT_VERSION 1
+
+void fppoly_snapshot_free(fppoly_snapshot_t *snapshot);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
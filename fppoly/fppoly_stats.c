@@ -0,0 +1,211 @@
+#include "fppoly_stats.h"
+#include "thread_pool.h"
+#include <stdarg.h>
+#include <time.h>
+
+struct fppoly_stats_t{
+	pthread_mutex_t mutex;
+	bool enabled;
+	fppoly_layer_stats_t *layers;
+	/* layers[i] is valid for i < size, calls==0 marks layers never seen */
+	size_t size;
+	size_t capacity;
+};
+
+
+static double fppoly_stats_clock(clockid_t clock){
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+
+fppoly_stats_t * fppoly_stats_alloc(void){
+	fppoly_stats_t *stats = (fppoly_stats_t *)malloc(sizeof(fppoly_stats_t));
+	pthread_mutex_init(&stats->mutex, NULL);
+	stats->enabled = false;
+	stats->layers = NULL;
+	stats->size = 0;
+	stats->capacity = 0;
+	return stats;
+}
+
+
+void fppoly_stats_free(fppoly_stats_t *stats){
+	if(stats==NULL){
+		return;
+	}
+	pthread_mutex_destroy(&stats->mutex);
+	free(stats->layers);
+	free(stats);
+}
+
+
+void fppoly_stats_start(fppoly_internal_t *pr, fppoly_stats_timer_t *timer){
+	timer->running = pr->stats->enabled;
+	if(!timer->running){
+		return;
+	}
+	timer->wall = fppoly_stats_clock(CLOCK_MONOTONIC);
+	timer->cpu = fppoly_stats_clock(CLOCK_THREAD_CPUTIME_ID) + fppoly_thread_pool_cpu_time(pr->pool);
+}
+
+
+static size_t fppoly_stats_expr_size(expr_t *expr){
+	return expr==NULL ? 0 : expr->size;
+}
+
+
+static size_t fppoly_stats_expr_bytes(expr_t *expr){
+	if(expr==NULL){
+		return 0;
+	}
+	size_t bytes = sizeof(expr_t) + 2*expr->size*sizeof(double);
+	if(expr->type==SPARSE){
+		bytes += expr->size*sizeof(size_t);
+	}
+	return bytes;
+}
+
+
+void fppoly_stats_stop(fppoly_internal_t *pr, fppoly_t *fp, size_t layerno, fppoly_stats_timer_t *timer){
+	if(!timer->running){
+		return;
+	}
+	double wall = fppoly_stats_clock(CLOCK_MONOTONIC) - timer->wall;
+	double cpu = fppoly_stats_clock(CLOCK_THREAD_CPUTIME_ID) + fppoly_thread_pool_cpu_time(pr->pool) - timer->cpu;
+	layer_t *layer = fp->layers[layerno];
+	size_t i, before = 0, after = 0, bytes = 0, unstable = 0;
+	for(i=0; i < layer->dims; i++){
+		neuron_t *neuron = layer->neurons[i];
+		before += fppoly_stats_expr_size(neuron->lexpr);
+		if(neuron->uexpr!=neuron->lexpr){
+			before += fppoly_stats_expr_size(neuron->uexpr);
+		}
+		after += fppoly_stats_expr_size(neuron->backsubstituted_lexpr);
+		bytes += fppoly_stats_expr_bytes(neuron->backsubstituted_lexpr);
+		if(neuron->backsubstituted_uexpr!=neuron->backsubstituted_lexpr){
+			after += fppoly_stats_expr_size(neuron->backsubstituted_uexpr);
+			bytes += fppoly_stats_expr_bytes(neuron->backsubstituted_uexpr);
+		}
+	}
+	if(layer->is_activation && layer->num_predecessors==1){
+		layer_t *in_layer = fp->layers[layer->predecessors[0]-1];
+		size_t dims = in_layer->dims < layer->dims ? in_layer->dims : layer->dims;
+		for(i=0; i < dims; i++){
+			/* lb is stored negated */
+			if(in_layer->neurons[i]->lb > 0 && in_layer->neurons[i]->ub > 0){
+				unstable++;
+			}
+		}
+	}
+	fppoly_stats_t *stats = pr->stats;
+	pthread_mutex_lock(&stats->mutex);
+	if(layerno >= stats->capacity){
+		size_t capacity = stats->capacity ? stats->capacity : 16;
+		while(capacity <= layerno){
+			capacity *= 2;
+		}
+		stats->layers = (fppoly_layer_stats_t *)realloc(stats->layers, capacity*sizeof(fppoly_layer_stats_t));
+		stats->capacity = capacity;
+	}
+	while(stats->size <= layerno){
+		memset(&stats->layers[stats->size], 0, sizeof(fppoly_layer_stats_t));
+		stats->layers[stats->size].layerno = stats->size;
+		stats->size++;
+	}
+	fppoly_layer_stats_t *rec = &stats->layers[layerno];
+	rec->dims = layer->dims;
+	rec->is_activation = layer->is_activation;
+	rec->calls++;
+	rec->wall_time += wall;
+	rec->cpu_time += cpu;
+	rec->expr_size_before = before;
+	rec->expr_size_after = after;
+	rec->unstable_relus = unstable;
+	rec->expr_bytes = bytes;
+	size_t threads = fppoly_thread_pool_size(pr->pool);
+	rec->thread_utilisation = rec->wall_time > 0 ? rec->cpu_time/(rec->wall_time*threads) : 0;
+	pthread_mutex_unlock(&stats->mutex);
+}
+
+
+void fppoly_manager_set_stats(elina_manager_t *man, bool enable){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pthread_mutex_lock(&pr->stats->mutex);
+	pr->stats->enabled = enable;
+	pthread_mutex_unlock(&pr->stats->mutex);
+}
+
+
+void fppoly_manager_reset_stats(elina_manager_t *man){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pthread_mutex_lock(&pr->stats->mutex);
+	pr->stats->size = 0;
+	pthread_mutex_unlock(&pr->stats->mutex);
+}
+
+
+size_t fppoly_manager_get_stats(elina_manager_t *man, fppoly_layer_stats_t *stats, size_t size){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	pthread_mutex_lock(&pr->stats->mutex);
+	size_t count = pr->stats->size;
+	if(stats!=NULL){
+		memcpy(stats, pr->stats->layers, (size < count ? size : count)*sizeof(fppoly_layer_stats_t));
+	}
+	pthread_mutex_unlock(&pr->stats->mutex);
+	return count;
+}
+
+
+/* snprintf into buf at offset len, the offset keeps counting past the end */
+static size_t fppoly_stats_append(char *buf, size_t size, size_t len, const char *format, ...){
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(len < size ? buf + len : NULL, len < size ? size - len : 0, format, args);
+	va_end(args);
+	return len + (n > 0 ? n : 0);
+}
+
+
+size_t fppoly_manager_stats_json(elina_manager_t *man, char *buf, size_t size){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_UNKNOWN);
+	size_t i, len = 0;
+	if(buf!=NULL && size > 0){
+		buf[0] = '\0';
+	}
+	else{
+		size = 0;
+	}
+	pthread_mutex_lock(&pr->stats->mutex);
+	len = fppoly_stats_append(buf, size, len, "{\"threads\": %zu, \"layers\": [", fppoly_thread_pool_size(pr->pool));
+	for(i=0; i < pr->stats->size; i++){
+		fppoly_layer_stats_t *rec = &pr->stats->layers[i];
+		len = fppoly_stats_append(buf, size, len,
+					  "%s\n  {\"layer\": %zu, \"dims\": %zu, \"activation\": %s, \"calls\": %zu, "
+					  "\"wall_time\": %.9g, \"cpu_time\": %.9g, \"expr_size_before\": %zu, \"expr_size_after\": %zu, "
+					  "\"unstable_relus\": %zu, \"expr_bytes\": %zu, \"thread_utilisation\": %.6g}",
+					  i ? "," : "", rec->layerno, rec->dims, rec->is_activation ? "true" : "false", rec->calls,
+					  rec->wall_time, rec->cpu_time, rec->expr_size_before, rec->expr_size_after,
+					  rec->unstable_relus, rec->expr_bytes, rec->thread_utilisation);
+	}
+	pthread_mutex_unlock(&pr->stats->mutex);
+	len = fppoly_stats_append(buf, size, len, "\n]}\n");
+	return len;
+}
+
+
+bool fppoly_manager_dump_stats(elina_manager_t *man, const char *path){
+	size_t len = fppoly_manager_stats_json(man, NULL, 0);
+	char *buf = (char *)malloc(len+1);
+	fppoly_manager_stats_json(man, buf, len+1);
+	FILE *file = fopen(path, "w");
+	if(file==NULL){
+		free(buf);
+		return false;
+	}
+	bool ok = fwrite(buf, 1, len, file)==len;
+	ok = (fclose(file)==0) && ok;
+	free(buf);
+	return ok;
+}
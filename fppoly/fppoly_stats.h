@@ -0,0 +1,57 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#ifndef __FPPOLY_STATS_H_INCLUDED__
+#define __FPPOLY_STATS_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+
+/* Per-layer instrumentation of the manager. A pass over a layer is bracketed
+   by fppoly_stats_start and fppoly_stats_stop on the calling thread; both do
+   nothing unless the statistics are enabled, so the hooks stay in the hot
+   paths. The expression sizes and unstable neurons are read from the layer
+   when the pass ends. */
+
+typedef struct fppoly_stats_timer_t{
+	bool running;
+	double wall;
+	double cpu;
+}fppoly_stats_timer_t;
+
+fppoly_stats_t * fppoly_stats_alloc(void);
+
+void fppoly_stats_free(fppoly_stats_t *stats);
+
+void fppoly_stats_start(fppoly_internal_t *pr, fppoly_stats_timer_t *timer);
+
+void fppoly_stats_stop(fppoly_internal_t *pr, fppoly_t *fp, size_t layerno, fppoly_stats_timer_t *timer);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
@@ -0,0 +1,1878 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+
+/* Test driver for fppoly. The transformers are checked against concrete
+   executions of the network on inputs sampled from the input box, and
+   analyses that must agree, such as the same network run with a different
+   number of threads, are compared bound by bound. Every check prints one
+   line, the exit status is the number of failed checks.
+
+     fppoly_test [samples] */
+
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fppoly.h"
+#include "backsubstitute.h"
+#include "compiled_network.h"
+#include "maxpool_convex_hull.h"
+#include "interval_kernels.h"
+
+/* slack for the rounding of the concrete executions */
+#define TEST_TOLERANCE 1e-9
+
+
+static double test_uniform(double lo, double hi){
+	return lo + (hi - lo)*(rand()/(double)RAND_MAX);
+}
+
+
+static double ** test_random_matrix(size_t rows, size_t cols, double scale){
+	double **m = (double **)malloc(rows*sizeof(double *));
+	size_t i, j;
+	for(i=0; i < rows; i++){
+		m[i] = (double *)malloc(cols*sizeof(double));
+		for(j=0; j < cols; j++){
+			m[i][j] = test_uniform(-scale, scale);
+		}
+	}
+	return m;
+}
+
+
+static double * test_random_vector(size_t size, double scale){
+	double *v = (double *)malloc(size*sizeof(double));
+	size_t i;
+	for(i=0; i < size; i++){
+		v[i] = test_uniform(-scale, scale);
+	}
+	return v;
+}
+
+
+static void test_free_matrix(double **m, size_t rows){
+	size_t i;
+	for(i=0; i < rows; i++){
+		free(m[i]);
+	}
+	free(m);
+}
+
+
+/* appends the bounds of the neurons of a layer, the lower bound with its sign */
+static double * test_layer_bounds(fppoly_t *fp, size_t layerno, double *bounds){
+	layer_t *layer = fp->layers[layerno];
+	size_t i;
+	for(i=0; i < layer->dims; i++){
+		*bounds++ = -layer->neurons[i]->lb;
+		*bounds++ = layer->neurons[i]->ub;
+	}
+	return bounds;
+}
+
+
+static bool test_contains(double *bounds, double *values, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		if(values[i] < bounds[2*i] - TEST_TOLERANCE || values[i] > bounds[2*i+1] + TEST_TOLERANCE){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool test_same_bounds(double *bounds1, double *bounds2, size_t size){
+	return memcmp(bounds1, bounds2, 2*size*sizeof(double))==0;
+}
+
+
+/* for analyses that only differ in the order of their sums */
+static bool test_close_bounds(double *bounds1, double *bounds2, size_t size, double tolerance){
+	size_t i;
+	for(i=0; i < 2*size; i++){
+		if(fabs(bounds1[i] - bounds2[i]) > tolerance*fmax(1, fabs(bounds1[i]))){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool test_report(const char *name, bool ok){
+	printf("%-48s %s\n", name, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+
+/******
+	LSTM. The rows of the weights are the input, cell, forget and output
+	gates, the first d columns multiply the input and the last h the hidden
+	state of the previous time step. The same input is fed at every step,
+	and a dense layer follows the last one.
+******/
+
+typedef struct test_lstm_t{
+	size_t d;
+	size_t h;
+	size_t out;
+	size_t steps;
+	double **weights;
+	double *bias;
+	double **fc_weights;
+	double *fc_bias;
+	double *inf;
+	double *sup;
+}test_lstm_t;
+
+
+static double test_sigmoid(double x){
+	return 1/(1 + exp(-x));
+}
+
+
+/* the hidden state of every step, then the outputs of the dense layer */
+static void test_lstm_execute(test_lstm_t *net, double *x, double *values){
+	size_t d = net->d;
+	size_t h = net->h;
+	double *h_t = (double *)calloc(h, sizeof(double));
+	double *c_t = (double *)calloc(h, sizeof(double));
+	double *gates = (double *)malloc(4*h*sizeof(double));
+	size_t t, r, i, j;
+	for(t=0; t < net->steps; t++){
+		for(r=0; r < 4*h; r++){
+			double sum = net->bias[r];
+			for(j=0; j < d; j++){
+				sum += net->weights[r][j]*x[j];
+			}
+			for(j=0; j < h; j++){
+				sum += net->weights[r][d+j]*h_t[j];
+			}
+			gates[r] = sum;
+		}
+		for(i=0; i < h; i++){
+			double i_t = test_sigmoid(gates[i]);
+			double g_t = tanh(gates[h+i]);
+			double f_t = test_sigmoid(gates[2*h+i]);
+			double o_t = test_sigmoid(gates[3*h+i]);
+			c_t[i] = f_t*c_t[i] + i_t*g_t;
+			h_t[i] = o_t*tanh(c_t[i]);
+		}
+		memcpy(values + t*h, h_t, h*sizeof(double));
+	}
+	for(i=0; i < net->out; i++){
+		double sum = net->fc_bias[i];
+		for(j=0; j < h; j++){
+			sum += net->fc_weights[i][j]*h_t[j];
+		}
+		values[net->steps*h + i] = sum;
+	}
+	free(h_t);
+	free(c_t);
+	free(gates);
+}
+
+
+static void test_lstm_analyze(test_lstm_t *net, size_t num_threads, double *bounds){
+	elina_manager_t *man = fppoly_manager_alloc();
+	fppoly_manager_set_num_threads(man, num_threads, false);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->d, net->inf, net->sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	size_t lstm_predecessors[1] = {0};
+	size_t fc_predecessors[1] = {1};
+	size_t t;
+	create_lstm_layer(man, element, net->h, lstm_predecessors, 1);
+	for(t=0; t < net->steps; t++){
+		handle_lstm_layer(man, element, net->weights, net->bias, net->d, net->h, lstm_predecessors, 1);
+		bounds = test_layer_bounds(fp, 0, bounds);
+	}
+	handle_fully_connected_layer(man, element, net->fc_weights, net->fc_bias, net->out, net->h, fc_predecessors, 1);
+	test_layer_bounds(fp, 1, bounds);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+}
+
+
+static int test_lstm(size_t d, size_t h, size_t steps, size_t samples){
+	test_lstm_t net;
+	net.d = d;
+	net.h = h;
+	net.out = 10;
+	net.steps = steps;
+	net.weights = test_random_matrix(4*h, d + h, 1/sqrt(d + h));
+	net.bias = test_random_vector(4*h, 0.5);
+	net.fc_weights = test_random_matrix(net.out, h, 1/sqrt(h));
+	net.fc_bias = test_random_vector(net.out, 0.1);
+	net.inf = (double *)malloc(d*sizeof(double));
+	net.sup = (double *)malloc(d*sizeof(double));
+	size_t i, s;
+	for(i=0; i < d; i++){
+		double c = test_uniform(-1, 1);
+		net.inf[i] = c - 0.05;
+		net.sup[i] = c + 0.05;
+	}
+	size_t size = steps*h + net.out;
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	double *bounds_par = (double *)malloc(2*size*sizeof(double));
+	double *x = (double *)malloc(d*sizeof(double));
+	double *values = (double *)malloc(size*sizeof(double));
+	test_lstm_analyze(&net, 1, bounds);
+	test_lstm_analyze(&net, 4, bounds_par);
+	bool sound = true;
+	for(s=0; s < samples && sound; s++){
+		for(i=0; i < d; i++){
+			/* the corners of the box are where the bounds are usually tight */
+			x[i] = s%2 ? test_uniform(net.inf[i], net.sup[i]) : (rand()%2 ? net.inf[i] : net.sup[i]);
+		}
+		test_lstm_execute(&net, x, values);
+		sound = test_contains(bounds, values, size);
+	}
+	char name[64];
+	int failed = 0;
+	snprintf(name, sizeof(name), "lstm d=%zu h=%zu steps=%zu sampled", d, h, steps);
+	failed += !test_report(name, sound);
+	snprintf(name, sizeof(name), "lstm d=%zu h=%zu steps=%zu 1 vs 4 threads", d, h, steps);
+	failed += !test_report(name, test_same_bounds(bounds, bounds_par, size));
+	test_free_matrix(net.weights, 4*h);
+	free(net.bias);
+	test_free_matrix(net.fc_weights, net.out);
+	free(net.fc_bias);
+	free(net.inf);
+	free(net.sup);
+	free(bounds);
+	free(bounds_par);
+	free(x);
+	free(values);
+	return failed;
+}
+
+
+/******
+	Dense layers given as one buffer. The same two layer network is passed
+	as rows and as row major, column major and strided float64 buffers, with
+	and without borrowing the rows, and as a float32 buffer; the weights are
+	floats so that every variant must give the bounds of the rows exactly.
+******/
+
+typedef enum test_layout_t{
+	TEST_ROWS,
+	TEST_ROW_MAJOR,
+	TEST_ROW_MAJOR_BORROWED,
+	TEST_COLUMN_MAJOR,
+	TEST_STRIDED,
+	TEST_FLOAT32,
+	TEST_NUM_LAYOUTS,
+}test_layout_t;
+
+static const char *test_layout_names[TEST_NUM_LAYOUTS] = {"rows", "row major", "row major borrowed", "column major", "strided", "float32"};
+
+
+/* the weights in the given layout, the strides in bytes */
+static void * test_weight_buffer(double **weights, size_t rows, size_t cols, test_layout_t layout, ptrdiff_t *row_stride, ptrdiff_t *col_stride){
+	size_t i, j;
+	if(layout==TEST_FLOAT32){
+		float *buf = (float *)malloc(rows*cols*sizeof(float));
+		for(i=0; i < rows; i++){
+			for(j=0; j < cols; j++){
+				buf[i*cols + j] = (float)weights[i][j];
+			}
+		}
+		*row_stride = cols*sizeof(float);
+		*col_stride = sizeof(float);
+		return buf;
+	}
+	/* strided takes every other column of rows padded by one element */
+	size_t step = layout==TEST_STRIDED ? 2 : 1;
+	size_t width = layout==TEST_STRIDED ? 2*cols + 1 : cols;
+	double *buf = (double *)calloc(rows*width, sizeof(double));
+	for(i=0; i < rows; i++){
+		for(j=0; j < cols; j++){
+			if(layout==TEST_COLUMN_MAJOR){
+				buf[j*rows + i] = weights[i][j];
+			}
+			else{
+				buf[i*width + j*step] = weights[i][j];
+			}
+		}
+	}
+	if(layout==TEST_COLUMN_MAJOR){
+		*row_stride = sizeof(double);
+		*col_stride = rows*sizeof(double);
+	}
+	else{
+		*row_stride = width*sizeof(double);
+		*col_stride = step*sizeof(double);
+	}
+	return buf;
+}
+
+
+static void test_buffer_analyze(double ***weights, double **bias, size_t *dims, double *inf, double *sup, test_layout_t layout, double *bounds){
+	elina_manager_t *man = fppoly_manager_alloc();
+	fppoly_manager_set_borrow_weights(man, layout==TEST_ROW_MAJOR_BORROWED);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, dims[0], inf, sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	/* borrowed buffers must outlive the element */
+	void *buffers[2];
+	size_t predecessors[3] = {0, 1, 2};
+	size_t l;
+	for(l=0; l < 2; l++){
+		buffers[l] = NULL;
+		if(layout==TEST_ROWS){
+			handle_fully_connected_layer(man, element, weights[l], bias[l], dims[l+1], dims[l], &predecessors[2*l], 1);
+		}
+		else{
+			ptrdiff_t row_stride, col_stride;
+			buffers[l] = test_weight_buffer(weights[l], dims[l+1], dims[l], layout, &row_stride, &col_stride);
+			handle_fully_connected_layer_buffer(man, element, buffers[l], layout==TEST_FLOAT32 ? FPPOLY_FLOAT32 : FPPOLY_FLOAT64, row_stride, col_stride, layout==TEST_ROW_MAJOR_BORROWED, bias[l], dims[l+1], dims[l], &predecessors[2*l], 1);
+		}
+		if(l==0){
+			handle_relu_layer(man, element, dims[1], &predecessors[1], 1, true);
+		}
+	}
+	for(l=0; l < fp->numlayers; l++){
+		bounds = test_layer_bounds(fp, l, bounds);
+	}
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	free(buffers[0]);
+	free(buffers[1]);
+}
+
+
+static int test_weight_buffers(size_t in, size_t hidden, size_t out){
+	size_t dims[3] = {in, hidden, out};
+	double **weights[2];
+	double *bias[2];
+	size_t l, i, j;
+	for(l=0; l < 2; l++){
+		weights[l] = test_random_matrix(dims[l+1], dims[l], 1/sqrt(dims[l]));
+		for(i=0; i < dims[l+1]; i++){
+			for(j=0; j < dims[l]; j++){
+				weights[l][i][j] = (float)weights[l][i][j];
+			}
+		}
+		bias[l] = test_random_vector(dims[l+1], 0.1);
+	}
+	double *inf = (double *)malloc(in*sizeof(double));
+	double *sup = (double *)malloc(in*sizeof(double));
+	for(i=0; i < in; i++){
+		double c = test_uniform(0, 1);
+		inf[i] = c - 0.02;
+		sup[i] = c + 0.02;
+	}
+	size_t size = 2*hidden + out;
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	test_buffer_analyze(weights, bias, dims, inf, sup, TEST_ROWS, expected);
+	char name[64];
+	int failed = 0;
+	test_layout_t layout;
+	for(layout=TEST_ROW_MAJOR; layout < TEST_NUM_LAYOUTS; layout++){
+		test_buffer_analyze(weights, bias, dims, inf, sup, layout, bounds);
+		snprintf(name, sizeof(name), "dense %zux%zux%zu %s", in, hidden, out, test_layout_names[layout]);
+		failed += !test_report(name, test_same_bounds(expected, bounds, size));
+	}
+	for(l=0; l < 2; l++){
+		test_free_matrix(weights[l], dims[l+1]);
+		free(bias[l]);
+	}
+	free(inf);
+	free(sup);
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+/******
+	Feed-forward networks of dense, convolutional and ReLU layers. The same
+	network is analysed under different manager settings, layer i+1 of the
+	element is layer i of the network.
+******/
+
+#define TEST_MAX_LAYERS 16
+
+typedef enum test_op_t{
+	TEST_FC,
+	TEST_CONV,
+	TEST_RELU,
+}test_op_t;
+
+typedef struct test_layer_t{
+	test_op_t op;
+	size_t in;
+	size_t out;
+	/* layers keep a pointer to their predecessors */
+	size_t predecessors[1];
+	/* fc */
+	double **weights;
+	double *bias;
+	/* conv, the filters are laid out as in handle_convolutional_layer */
+	double *filter;
+	size_t input_size[3];
+	size_t filter_size[2];
+	size_t num_filters;
+	size_t strides[2];
+	size_t pad;
+	size_t output_size[3];
+}test_layer_t;
+
+typedef struct test_net_t{
+	size_t in;
+	double *inf;
+	double *sup;
+	test_layer_t layers[TEST_MAX_LAYERS];
+	size_t numlayers;
+}test_net_t;
+
+typedef struct test_config_t{
+	size_t num_threads;
+	fppoly_backsubstitution_t backsubstitution;
+	bool single_precision;
+	bool borrow_weights;
+	bool implicit_conv;
+}test_config_t;
+
+
+static test_config_t test_default_config(void){
+	test_config_t config;
+	config.num_threads = 1;
+	config.backsubstitution = FPPOLY_BACKSUBSTITUTE_NEURON;
+	config.single_precision = false;
+	config.borrow_weights = false;
+	config.implicit_conv = false;
+	return config;
+}
+
+
+static elina_manager_t * test_manager(test_config_t *config){
+	elina_manager_t *man = fppoly_manager_alloc();
+	fppoly_manager_set_num_threads(man, config->num_threads, false);
+	fppoly_manager_set_backsubstitution(man, config->backsubstitution);
+	fppoly_manager_set_single_precision(man, config->single_precision);
+	fppoly_manager_set_borrow_weights(man, config->borrow_weights);
+	fppoly_manager_set_implicit_conv(man, config->implicit_conv);
+	return man;
+}
+
+
+static void test_net_init(test_net_t *net, size_t in, double eps){
+	size_t i;
+	net->in = in;
+	net->inf = (double *)malloc(in*sizeof(double));
+	net->sup = (double *)malloc(in*sizeof(double));
+	for(i=0; i < in; i++){
+		double c = test_uniform(0, 1);
+		net->inf[i] = c - eps;
+		net->sup[i] = c + eps;
+	}
+	net->numlayers = 0;
+}
+
+
+static test_layer_t * test_net_add(test_net_t *net, test_op_t op, size_t out){
+	test_layer_t *layer = &net->layers[net->numlayers];
+	memset(layer, 0, sizeof(test_layer_t));
+	layer->op = op;
+	layer->in = net->numlayers ? net->layers[net->numlayers-1].out : net->in;
+	layer->out = out;
+	layer->predecessors[0] = net->numlayers;
+	net->numlayers++;
+	return layer;
+}
+
+
+static void test_net_fc(test_net_t *net, size_t out){
+	test_layer_t *layer = test_net_add(net, TEST_FC, out);
+	layer->weights = test_random_matrix(out, layer->in, 1.5/sqrt(layer->in));
+	layer->bias = test_random_vector(out, 0.1);
+}
+
+
+static void test_net_relu(test_net_t *net){
+	test_net_add(net, TEST_RELU, net->layers[net->numlayers-1].out);
+}
+
+
+/* same padding for odd filters, size is updated to the output size */
+static void test_net_conv(test_net_t *net, size_t *size, size_t filter, size_t num_filters, size_t stride){
+	size_t pad = filter/2;
+	size_t oh = (size[0] + 2*pad - filter)/stride + 1;
+	size_t ow = (size[1] + 2*pad - filter)/stride + 1;
+	test_layer_t *layer = test_net_add(net, TEST_CONV, oh*ow*num_filters);
+	memcpy(layer->input_size, size, 3*sizeof(size_t));
+	layer->filter_size[0] = filter;
+	layer->filter_size[1] = filter;
+	layer->num_filters = num_filters;
+	layer->strides[0] = stride;
+	layer->strides[1] = stride;
+	layer->pad = pad;
+	layer->output_size[0] = oh;
+	layer->output_size[1] = ow;
+	layer->output_size[2] = num_filters;
+	size_t fan_in = filter*filter*size[2];
+	layer->filter = test_random_vector(fan_in*num_filters, 1.5/sqrt(fan_in));
+	layer->bias = test_random_vector(num_filters, 0.1);
+	size[0] = oh;
+	size[1] = ow;
+	size[2] = num_filters;
+}
+
+
+static void test_net_mlp(test_net_t *net, size_t in, size_t width, size_t depth){
+	size_t d;
+	test_net_init(net, in, 0.02);
+	for(d=0; d < depth; d++){
+		test_net_fc(net, width);
+		test_net_relu(net);
+	}
+	test_net_fc(net, 10);
+}
+
+
+static void test_net_cnn(test_net_t *net, size_t depth){
+	size_t size[3] = {8, 8, 2};
+	size_t d;
+	test_net_init(net, size[0]*size[1]*size[2], 0.02);
+	for(d=0; d < depth; d++){
+		test_net_conv(net, size, 3, 4, d%2 ? 2 : 1);
+		test_net_relu(net);
+	}
+	test_net_fc(net, 20);
+	test_net_relu(net);
+	test_net_fc(net, 10);
+}
+
+
+static void test_net_free(test_net_t *net){
+	size_t l;
+	for(l=0; l < net->numlayers; l++){
+		test_layer_t *layer = &net->layers[l];
+		if(layer->weights){
+			test_free_matrix(layer->weights, layer->out);
+		}
+		free(layer->bias);
+		free(layer->filter);
+	}
+	free(net->inf);
+	free(net->sup);
+}
+
+
+/* neurons over all layers */
+static size_t test_net_size(test_net_t *net){
+	size_t l, size = 0;
+	for(l=0; l < net->numlayers; l++){
+		size += net->layers[l].out;
+	}
+	return size;
+}
+
+
+/* adds layers [from, to) of the network to element */
+static void test_net_apply(elina_manager_t *man, elina_abstract0_t *element, test_net_t *net, size_t from, size_t to){
+	size_t l;
+	for(l=from; l < to; l++){
+		test_layer_t *layer = &net->layers[l];
+		size_t output_size[3];
+		switch(layer->op){
+			case TEST_FC:
+				handle_fully_connected_layer(man, element, layer->weights, layer->bias, layer->out, layer->in, layer->predecessors, 1);
+				break;
+			case TEST_CONV:
+				memcpy(output_size, layer->output_size, 3*sizeof(size_t));
+				handle_convolutional_layer(man, element, layer->filter, layer->bias, layer->input_size, layer->filter_size, layer->num_filters, layer->strides, output_size,
+							   layer->pad, layer->pad, layer->pad, layer->pad, true, layer->predecessors, 1);
+				break;
+			case TEST_RELU:
+				handle_relu_layer(man, element, layer->out, layer->predecessors, 1, true);
+				break;
+		}
+	}
+}
+
+
+static double * test_element_bounds(elina_abstract0_t *element, double *bounds){
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	size_t l;
+	for(l=0; l < fp->numlayers; l++){
+		bounds = test_layer_bounds(fp, l, bounds);
+	}
+	return bounds;
+}
+
+
+static void test_net_analyze(test_net_t *net, test_config_t *config, double *bounds){
+	elina_manager_t *man = test_manager(config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	test_element_bounds(element, bounds);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+}
+
+
+/******
+	Matrix back-substitution. It sums in another order than the neuron-wise
+	path, so the bounds agree up to rounding. Analysing the layers again
+	must replace the back-substituted expressions and give the same bounds.
+******/
+
+static int test_matrix(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	double *again = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	test_net_analyze(net, &config, expected);
+	config.backsubstitution = FPPOLY_BACKSUBSTITUTE_MATRIX;
+	config.num_threads = 4;
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	test_element_bounds(element, bounds);
+	size_t l;
+	for(l=0; l < fp->numlayers; l++){
+		if(!fp->layers[l]->is_activation){
+			update_state_using_previous_layers_parallel(man, fp, l);
+		}
+	}
+	test_element_bounds(element, again);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	char str[64];
+	int failed = 0;
+	snprintf(str, sizeof(str), "%s matrix vs neuron", name);
+	failed += !test_report(str, test_close_bounds(expected, bounds, size, 1e-9));
+	snprintf(str, sizeof(str), "%s matrix analysed again", name);
+	failed += !test_report(str, test_same_bounds(bounds, again, size));
+	free(expected);
+	free(bounds);
+	free(again);
+	return failed;
+}
+
+
+
+/******
+	Interval kernels. The AVX2 and AVX-512 kernels must give the products and
+	sums of the scalar ones bit for bit; concretization sums in lanes, so
+	only its rounding may differ. The size is not a multiple of any vector
+	width so that the scalar tails run too. The same holds for the float
+	kernels, whose results must also contain those of the double kernels on
+	the same operands.
+******/
+
+#define TEST_KERNEL_SIZE 37
+
+static const char *test_isa_names[] = {"scalar", "avx2", "avx512"};
+
+typedef struct test_kernel_data_t{
+	double mul_inf;
+	double mul_sup;
+	double inf_coeff[TEST_KERNEL_SIZE];
+	double sup_coeff[TEST_KERNEL_SIZE];
+	double res_inf[2*TEST_KERNEL_SIZE];
+	double res_sup[2*TEST_KERNEL_SIZE];
+	size_t dim[TEST_KERNEL_SIZE];
+	double box_inf[TEST_KERNEL_SIZE];
+	double box_sup[TEST_KERNEL_SIZE];
+}test_kernel_data_t;
+
+typedef struct test_kernel_result_t{
+	double mul_inf[TEST_KERNEL_SIZE];
+	double mul_sup[TEST_KERNEL_SIZE];
+	double mul_add_inf[TEST_KERNEL_SIZE];
+	double mul_add_sup[TEST_KERNEL_SIZE];
+	double sparse_inf[2*TEST_KERNEL_SIZE];
+	double sparse_sup[2*TEST_KERNEL_SIZE];
+	double add_inf[TEST_KERNEL_SIZE];
+	double add_sup[TEST_KERNEL_SIZE];
+	/* concretization, not compared bit for bit */
+	double cst_inf;
+	double cst_sup;
+}test_kernel_result_t;
+
+
+/* an interval as (-lower, upper), every eighth one is exactly zero */
+static void test_random_interval(double *inf, double *sup, double scale){
+	if(rand()%8==0){
+		*inf = 0;
+		*sup = 0;
+		return;
+	}
+	double lo = test_uniform(-scale, scale);
+	*inf = -lo;
+	*sup = lo + test_uniform(0, scale/10);
+}
+
+
+static void test_kernel_data(test_kernel_data_t *data){
+	size_t i;
+	test_random_interval(&data->mul_inf, &data->mul_sup, 2);
+	for(i=0; i < TEST_KERNEL_SIZE; i++){
+		test_random_interval(&data->inf_coeff[i], &data->sup_coeff[i], 1);
+		test_random_interval(&data->box_inf[i], &data->box_sup[i], 1);
+		data->dim[i] = 2*i + rand()%2;
+	}
+	for(i=0; i < 2*TEST_KERNEL_SIZE; i++){
+		test_random_interval(&data->res_inf[i], &data->res_sup[i], 1);
+	}
+}
+
+
+static void test_kernel_run(fppoly_internal_t *pr, test_kernel_data_t *data, test_kernel_result_t *res){
+	size_t n = TEST_KERNEL_SIZE;
+	expr_dense_mul(pr, res->mul_inf, res->mul_sup, data->mul_inf, data->mul_sup, data->inf_coeff, data->sup_coeff, n);
+	memcpy(res->mul_add_inf, data->res_inf, n*sizeof(double));
+	memcpy(res->mul_add_sup, data->res_sup, n*sizeof(double));
+	expr_dense_mul_add(pr, res->mul_add_inf, res->mul_add_sup, data->mul_inf, data->mul_sup, data->inf_coeff, data->sup_coeff, n);
+	memcpy(res->sparse_inf, data->res_inf, 2*n*sizeof(double));
+	memcpy(res->sparse_sup, data->res_sup, 2*n*sizeof(double));
+	expr_sparse_mul_add(pr, res->sparse_inf, res->sparse_sup, data->mul_inf, data->mul_sup, data->inf_coeff, data->sup_coeff, data->dim, n);
+	memcpy(res->add_inf, data->res_inf, n*sizeof(double));
+	memcpy(res->add_sup, data->res_sup, n*sizeof(double));
+	expr_dense_add(pr, res->add_inf, res->add_sup, data->inf_coeff, data->sup_coeff, n);
+	res->cst_inf = data->res_inf[0];
+	res->cst_sup = data->res_sup[0];
+	expr_dense_concretize(data->inf_coeff, data->sup_coeff, data->box_inf, data->box_sup, n, &res->cst_inf, &res->cst_sup);
+}
+
+
+/* rounds every operand to float, outward */
+static void test_kernel_data_to_float(test_kernel_data_t *data){
+	double *fields[] = {data->inf_coeff, data->sup_coeff, data->box_inf, data->box_sup};
+	size_t i, f;
+	data->mul_inf = (float)data->mul_inf;
+	data->mul_sup = (float)data->mul_sup;
+	for(f=0; f < 4; f++){
+		for(i=0; i < TEST_KERNEL_SIZE; i++){
+			fields[f][i] = (float)fields[f][i];
+		}
+	}
+	for(i=0; i < 2*TEST_KERNEL_SIZE; i++){
+		data->res_inf[i] = (float)data->res_inf[i];
+		data->res_sup[i] = (float)data->res_sup[i];
+	}
+}
+
+
+/* the float kernels on data, which must be exact in float; expr_dense_add has
+   no float version, add_inf and add_sup are left zero */
+static void test_kernel_run_f(fppoly_internal_t *pr, test_kernel_data_t *data, test_kernel_result_t *res){
+	size_t n = TEST_KERNEL_SIZE;
+	float inf_coeff[TEST_KERNEL_SIZE], sup_coeff[TEST_KERNEL_SIZE], box_inf[TEST_KERNEL_SIZE], box_sup[TEST_KERNEL_SIZE];
+	float res_inf[2*TEST_KERNEL_SIZE], res_sup[2*TEST_KERNEL_SIZE];
+	size_t i;
+	memset(res, 0, sizeof(test_kernel_result_t));
+	for(i=0; i < n; i++){
+		inf_coeff[i] = data->inf_coeff[i];
+		sup_coeff[i] = data->sup_coeff[i];
+		box_inf[i] = data->box_inf[i];
+		box_sup[i] = data->box_sup[i];
+	}
+	expr_dense_mul_f(pr, res_inf, res_sup, data->mul_inf, data->mul_sup, inf_coeff, sup_coeff, n);
+	for(i=0; i < n; i++){
+		res->mul_inf[i] = res_inf[i];
+		res->mul_sup[i] = res_sup[i];
+		res_inf[i] = data->res_inf[i];
+		res_sup[i] = data->res_sup[i];
+	}
+	expr_dense_mul_add_f(pr, res_inf, res_sup, data->mul_inf, data->mul_sup, inf_coeff, sup_coeff, n);
+	for(i=0; i < n; i++){
+		res->mul_add_inf[i] = res_inf[i];
+		res->mul_add_sup[i] = res_sup[i];
+	}
+	for(i=0; i < 2*n; i++){
+		res_inf[i] = data->res_inf[i];
+		res_sup[i] = data->res_sup[i];
+	}
+	expr_sparse_mul_add_f(pr, res_inf, res_sup, data->mul_inf, data->mul_sup, inf_coeff, sup_coeff, data->dim, n);
+	for(i=0; i < 2*n; i++){
+		res->sparse_inf[i] = res_inf[i];
+		res->sparse_sup[i] = res_sup[i];
+	}
+	res->cst_inf = data->res_inf[0];
+	res->cst_sup = data->res_sup[0];
+	expr_dense_concretize_f(inf_coeff, sup_coeff, box_inf, box_sup, n, &res->cst_inf, &res->cst_sup);
+}
+
+
+/* every interval of outer contains the one of inner, except the sums of
+   expr_dense_add */
+static bool test_kernel_contains(test_kernel_result_t *outer, test_kernel_result_t *inner){
+	double *o = (double *)outer;
+	double *in = (double *)inner;
+	size_t add = offsetof(test_kernel_result_t, add_inf)/sizeof(double);
+	size_t cst = offsetof(test_kernel_result_t, cst_inf)/sizeof(double);
+	size_t i;
+	for(i=0; i < sizeof(test_kernel_result_t)/sizeof(double); i++){
+		if((i < add || i >= cst) && o[i] < in[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static int test_interval_kernels(size_t trials){
+	elina_manager_t *man = fppoly_manager_alloc();
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	interval_kernels_isa_t isa;
+	int failed = 0;
+	for(isa=INTERVAL_KERNELS_AVX2; isa <= INTERVAL_KERNELS_AVX512; isa++){
+		char name[64];
+		if(interval_kernels_select(isa)!=isa){
+			snprintf(name, sizeof(name), "kernels %s", test_isa_names[isa]);
+			printf("%-48s %s\n", name, "not supported");
+			continue;
+		}
+		bool same = true, close = true, same_f = true, close_f = true;
+		size_t t;
+		for(t=0; t < trials; t++){
+			test_kernel_data_t data;
+			test_kernel_result_t expected, res;
+			test_kernel_data(&data);
+			interval_kernels_select(INTERVAL_KERNELS_SCALAR);
+			test_kernel_run(pr, &data, &expected);
+			interval_kernels_select(isa);
+			test_kernel_run(pr, &data, &res);
+			same = same && memcmp(&expected, &res, offsetof(test_kernel_result_t, cst_inf))==0;
+			close = close && test_close_bounds(&expected.cst_inf, &res.cst_inf, 1, 1e-12);
+			test_kernel_data_to_float(&data);
+			interval_kernels_select(INTERVAL_KERNELS_SCALAR);
+			test_kernel_run_f(pr, &data, &expected);
+			interval_kernels_select(isa);
+			test_kernel_run_f(pr, &data, &res);
+			same_f = same_f && memcmp(&expected, &res, offsetof(test_kernel_result_t, cst_inf))==0;
+			close_f = close_f && test_close_bounds(&expected.cst_inf, &res.cst_inf, 1, 1e-12);
+		}
+		snprintf(name, sizeof(name), "kernels %s products vs scalar", test_isa_names[isa]);
+		failed += !test_report(name, same);
+		snprintf(name, sizeof(name), "kernels %s concretize vs scalar", test_isa_names[isa]);
+		failed += !test_report(name, close);
+		snprintf(name, sizeof(name), "kernels %s float products vs scalar", test_isa_names[isa]);
+		failed += !test_report(name, same_f);
+		snprintf(name, sizeof(name), "kernels %s float concretize vs scalar", test_isa_names[isa]);
+		failed += !test_report(name, close_f);
+	}
+	/* the float kernels against the double ones, both scalar */
+	interval_kernels_select(INTERVAL_KERNELS_SCALAR);
+	bool contains = true;
+	size_t t;
+	for(t=0; t < trials; t++){
+		test_kernel_data_t data;
+		test_kernel_result_t expected, res;
+		test_kernel_data(&data);
+		test_kernel_data_to_float(&data);
+		test_kernel_run(pr, &data, &expected);
+		test_kernel_run_f(pr, &data, &res);
+		contains = contains && test_kernel_contains(&res, &expected);
+	}
+	failed += !test_report("kernels float contain double", contains);
+	/* back to the best isa of the CPU */
+	interval_kernels_select(INTERVAL_KERNELS_AVX512);
+	elina_manager_free(man);
+	return failed;
+}
+
+
+/* whole analyses with the vector kernels against the scalar ones */
+static int test_kernel_analysis(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	int failed = 0;
+	int m;
+	for(m=0; m < 2; m++){
+		config.backsubstitution = m ? FPPOLY_BACKSUBSTITUTE_MATRIX : FPPOLY_BACKSUBSTITUTE_NEURON;
+		interval_kernels_select(INTERVAL_KERNELS_SCALAR);
+		test_net_analyze(net, &config, expected);
+		interval_kernels_isa_t isa = interval_kernels_select(INTERVAL_KERNELS_AVX512);
+		test_net_analyze(net, &config, bounds);
+		char str[64];
+		snprintf(str, sizeof(str), "%s %s %s vs scalar", name, m ? "matrix" : "neuron", test_isa_names[isa]);
+		failed += !test_report(str, test_close_bounds(expected, bounds, size, 1e-9));
+	}
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+
+/* the matrix back-substitution in float must contain the bounds it gets in double */
+static int test_single_precision(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	config.backsubstitution = FPPOLY_BACKSUBSTITUTE_MATRIX;
+	test_net_analyze(net, &config, expected);
+	config.single_precision = true;
+	test_net_analyze(net, &config, bounds);
+	bool contains = true;
+	size_t i;
+	for(i=0; i < size; i++){
+		contains = contains && bounds[2*i] <= expected[2*i] && bounds[2*i+1] >= expected[2*i+1];
+	}
+	char str[64];
+	snprintf(str, sizeof(str), "%s single precision contains double", name);
+	int failed = !test_report(str, contains);
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+
+/******
+	Implicit convolutions. Back-substituting through the filters instead of
+	one expression per output neuron sums the same products in another
+	order, so the bounds agree up to rounding.
+******/
+
+static int test_implicit_conv(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	char str[64];
+	int failed = 0;
+	int m;
+	for(m=0; m < 2; m++){
+		config.backsubstitution = m ? FPPOLY_BACKSUBSTITUTE_MATRIX : FPPOLY_BACKSUBSTITUTE_NEURON;
+		config.num_threads = 4;
+		config.implicit_conv = false;
+		test_net_analyze(net, &config, expected);
+		config.implicit_conv = true;
+		test_net_analyze(net, &config, bounds);
+		snprintf(str, sizeof(str), "%s %s implicit vs dense conv", name, m ? "matrix" : "neuron");
+		failed += !test_report(str, test_close_bounds(expected, bounds, size, 1e-9));
+	}
+	/* the convolutions really are kept as filters */
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	bool implicit = true;
+	size_t l;
+	for(l=0; l < net->numlayers; l++){
+		if(net->layers[l].op==TEST_CONV){
+			implicit = implicit && fp->layers[l]->conv!=NULL && fp->layers[l]->neurons[0]->lexpr==NULL;
+		}
+	}
+	snprintf(str, sizeof(str), "%s implicit conv keeps filters", name);
+	failed += !test_report(str, implicit);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+
+/******
+	Maxpool upper faces. A face is checked at every vertex of the box, which
+	covers the whole box as max(x) is convex and the face is linear. The
+	closed form must give the tightest face of the hull, found by brute force
+	over the planes through the lifted vertices of small windows, and the
+	face cdd selects. A permuted window must hit the cache and get the
+	permuted face.
+******/
+
+#define TEST_MAX_POOL 14
+
+static bool test_face_valid(double *lb, double *ub, size_t n, double *coeff, double cst){
+	size_t v, i;
+	for(v=0; v < ((size_t)1 << n); v++){
+		double y = -INFINITY;
+		double face = cst;
+		for(i=0; i < n; i++){
+			double x = (v >> i) & 1 ? ub[i] : lb[i];
+			y = fmax(y, x);
+			face += coeff[i]*x;
+		}
+		if(y > face + TEST_TOLERANCE){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static double test_face_max(double *lb, double *ub, size_t n, double *coeff, double cst){
+	size_t i;
+	for(i=0; i < n; i++){
+		cst += coeff[i]*(coeff[i] > 0 ? ub[i] : lb[i]);
+	}
+	return cst;
+}
+
+
+/* the plane y = cst + coeff.x through the lifted vertices in set, false if they do not span one */
+static bool test_plane(double *lb, double *ub, size_t n, size_t *set, double *coeff, double *cst){
+	double a[TEST_MAX_POOL+1][TEST_MAX_POOL+2];
+	size_t r, c, k;
+	for(r=0; r <= n; r++){
+		double y = -INFINITY;
+		a[r][0] = 1;
+		for(c=0; c < n; c++){
+			a[r][c+1] = (set[r] >> c) & 1 ? ub[c] : lb[c];
+			y = fmax(y, a[r][c+1]);
+		}
+		a[r][n+1] = y;
+	}
+	for(c=0; c <= n; c++){
+		size_t p = c;
+		for(r=c+1; r <= n; r++){
+			if(fabs(a[r][c]) > fabs(a[p][c])){
+				p = r;
+			}
+		}
+		if(fabs(a[p][c]) < 1e-9){
+			return false;
+		}
+		for(k=0; k <= n+1; k++){
+			double tmp = a[c][k];
+			a[c][k] = a[p][k];
+			a[p][k] = tmp;
+		}
+		for(r=0; r <= n; r++){
+			if(r!=c){
+				double f = a[r][c]/a[c][c];
+				for(k=c; k <= n+1; k++){
+					a[r][k] -= f*a[c][k];
+				}
+			}
+		}
+	}
+	*cst = a[0][n+1]/a[0][0];
+	for(c=0; c < n; c++){
+		coeff[c] = a[c+1][n+1]/a[c+1][c+1];
+	}
+	return true;
+}
+
+
+/* the valid face depending on x with the smallest maximum over the box, by
+   trying every plane through n+1 vertices of the lifted box */
+static bool test_brute_force_face(double *lb, double *ub, size_t n, double *coeff, double *cst){
+	size_t set[TEST_MAX_POOL+1];
+	size_t num_vertices = (size_t)1 << n;
+	double best = INFINITY;
+	double face[TEST_MAX_POOL], face_cst;
+	size_t i;
+	for(i=0; i <= n; i++){
+		set[i] = i;
+	}
+	while(true){
+		if(test_plane(lb, ub, n, set, face, &face_cst)){
+			bool depends = false;
+			for(i=0; i < n; i++){
+				depends = depends || fabs(face[i]) > 1e-9;
+			}
+			double max = test_face_max(lb, ub, n, face, face_cst);
+			if(depends && max < best - 1e-9 && test_face_valid(lb, ub, n, face, face_cst)){
+				best = max;
+				memcpy(coeff, face, n*sizeof(double));
+				*cst = face_cst;
+			}
+		}
+		/* next subset in lexicographic order */
+		i = n + 1;
+		while(i > 0 && set[i-1]==num_vertices - (n + 1) + (i-1)){
+			i--;
+		}
+		if(i==0){
+			break;
+		}
+		set[i-1]++;
+		for(; i <= n; i++){
+			set[i] = set[i-1] + 1;
+		}
+	}
+	return best < INFINITY;
+}
+
+
+static bool test_same_face(double *coeff1, double cst1, double *coeff2, double cst2, size_t n){
+	size_t i;
+	bool same = fabs(cst1 - cst2) <= 1e-9;
+	for(i=0; i < n; i++){
+		same = same && fabs(coeff1[i] - coeff2[i]) <= 1e-9;
+	}
+	return same;
+}
+
+
+/* ties > 1 gives the largest upper bound to that many inputs */
+static void test_pool_window(double *lb, double *ub, size_t n, size_t ties){
+	size_t i;
+	double top = -INFINITY;
+	for(i=0; i < n; i++){
+		lb[i] = test_uniform(-1, 1);
+		ub[i] = lb[i] + test_uniform(0.1, 1);
+		top = fmax(top, ub[i]);
+	}
+	for(i=0; i < ties && ties > 1; i++){
+		ub[i] = top;
+	}
+}
+
+
+static int test_maxpool(size_t trials){
+	double lb[TEST_MAX_POOL], ub[TEST_MAX_POOL], plb[TEST_MAX_POOL], pub[TEST_MAX_POOL];
+	double coeff[TEST_MAX_POOL], other[TEST_MAX_POOL], pcoeff[TEST_MAX_POOL], ucoeff[TEST_MAX_POOL];
+	double cst, other_cst, pcst, ucst;
+	size_t perm[TEST_MAX_POOL];
+	bool brute = true, large = true, cached = true, closed = true;
+	/* cdd must find the face y <= x_0 + x_1 of the unit square */
+	lb[0] = lb[1] = 0;
+	ub[0] = ub[1] = 1;
+	bool has_cdd = maxpool_hull_upper_face(lb, ub, 2, coeff, &cst);
+	maxpool_hull_cache_t *cache = maxpool_hull_cache_alloc(MAXPOOL_HULL_CACHE_SIZE);
+	size_t t, i, n;
+	for(t=0; t < trials; t++){
+		/* a unique top, against brute force and cdd */
+		n = 2 + t%3;
+		test_pool_window(lb, ub, n, 1);
+		bool found = maxpool_upper_face(NULL, lb, ub, n, coeff, &cst);
+		brute = brute && found && test_face_valid(lb, ub, n, coeff, cst) && test_brute_force_face(lb, ub, n, other, &other_cst);
+		brute = brute && test_same_face(coeff, cst, other, other_cst, n);
+		n = 2 + t%9;
+		test_pool_window(lb, ub, n, 1);
+		found = maxpool_upper_face(NULL, lb, ub, n, coeff, &cst);
+		if(has_cdd){
+			closed = closed && found && maxpool_hull_upper_face(lb, ub, n, other, &other_cst);
+			closed = closed && test_same_face(coeff, cst, other, other_cst, n);
+		}
+		/* beyond the windows cdd gets */
+		n = 11 + t%4;
+		test_pool_window(lb, ub, n, 1);
+		large = large && maxpool_upper_face(NULL, lb, ub, n, coeff, &cst) && test_face_valid(lb, ub, n, coeff, cst);
+		/* a shared top goes to cdd, the reversed window must be looked up */
+		n = 3 + t%6;
+		test_pool_window(lb, ub, n, 2);
+		size_t size = maxpool_hull_cache_size(cache);
+		found = maxpool_upper_face(cache, lb, ub, n, coeff, &cst);
+		for(i=0; i < n; i++){
+			perm[i] = n - 1 - i;
+			plb[i] = lb[perm[i]];
+			pub[i] = ub[perm[i]];
+		}
+		bool pfound = maxpool_upper_face(cache, plb, pub, n, pcoeff, &pcst);
+		bool ufound = maxpool_upper_face(NULL, plb, pub, n, ucoeff, &ucst);
+		cached = cached && maxpool_hull_cache_size(cache)==size+1 && found==pfound && found==ufound;
+		if(found){
+			cached = cached && test_face_valid(lb, ub, n, coeff, cst) && pcst==cst && ucst==cst;
+			for(i=0; i < n; i++){
+				cached = cached && pcoeff[i]==coeff[perm[i]] && ucoeff[i]==pcoeff[i];
+			}
+		}
+	}
+	maxpool_hull_cache_free(cache);
+	int failed = 0;
+	failed += !test_report("maxpool closed form vs brute force", brute);
+	if(has_cdd){
+		failed += !test_report("maxpool closed form vs cdd", closed);
+	}
+	else{
+		printf("%-48s %s\n", "maxpool closed form vs cdd", "cdd not usable");
+	}
+	failed += !test_report("maxpool closed form beyond cdd windows", large);
+	failed += !test_report("maxpool cache of permuted windows", cached);
+	return failed;
+}
+
+
+
+/******
+	Shared and borrowed expressions. With borrowed weights the expressions of
+	dense layers point to the rows of the caller and must give the bounds of
+	copied rows exactly. run_deeppoly starts the back-substituted expressions
+	as shared references to lexpr and uexpr, which it must never modify.
+******/
+
+static bool test_borrows_rows(elina_abstract0_t *element, test_net_t *net){
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	size_t l, i;
+	for(l=0; l < net->numlayers; l++){
+		if(net->layers[l].op!=TEST_FC){
+			continue;
+		}
+		for(i=0; i < net->layers[l].out; i++){
+			expr_t *expr = fp->layers[l]->neurons[i]->lexpr;
+			if(!expr->borrowed || expr->sup_coeff!=net->layers[l].weights[i]){
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+static int test_borrow(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	double *again = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	char str[64];
+	int failed = 0;
+	int m;
+	for(m=0; m < 2; m++){
+		config.backsubstitution = m ? FPPOLY_BACKSUBSTITUTE_MATRIX : FPPOLY_BACKSUBSTITUTE_NEURON;
+		config.borrow_weights = false;
+		test_net_analyze(net, &config, expected);
+		config.borrow_weights = true;
+		elina_manager_t *man = test_manager(&config);
+		elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+		test_net_apply(man, element, net, 0, net->numlayers);
+		test_element_bounds(element, bounds);
+		snprintf(str, sizeof(str), "%s %s borrowed rows", name, m ? "matrix" : "neuron");
+		failed += !test_report(str, test_borrows_rows(element, net));
+		snprintf(str, sizeof(str), "%s %s borrowed vs copied", name, m ? "matrix" : "neuron");
+		failed += !test_report(str, test_same_bounds(expected, bounds, size));
+		elina_abstract0_free(man, element);
+		elina_manager_free(man);
+	}
+	/* run_deeppoly twice on the borrowed element, the relaxations stay as they were */
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	expr_t **lexprs = (expr_t **)malloc(size*sizeof(expr_t *));
+	size_t l, i, n = 0;
+	for(l=0; l < fp->numlayers; l++){
+		for(i=0; i < fp->layers[l]->dims; i++){
+			lexprs[n++] = copy_expr(fp->layers[l]->neurons[i]->lexpr);
+		}
+	}
+	run_deeppoly(man, element);
+	test_element_bounds(element, bounds);
+	run_deeppoly(man, element);
+	test_element_bounds(element, again);
+	bool unchanged = test_borrows_rows(element, net);
+	n = 0;
+	for(l=0; l < fp->numlayers; l++){
+		for(i=0; i < fp->layers[l]->dims; i++){
+			unchanged = unchanged && expr_equal(lexprs[n], fp->layers[l]->neurons[i]->lexpr);
+			free_expr(lexprs[n++]);
+		}
+	}
+	snprintf(str, sizeof(str), "%s run_deeppoly keeps shared exprs", name);
+	failed += !test_report(str, unchanged);
+	snprintf(str, sizeof(str), "%s run_deeppoly twice", name);
+	failed += !test_report(str, test_same_bounds(bounds, again, size));
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	free(lexprs);
+	free(expected);
+	free(bounds);
+	free(again);
+	return failed;
+}
+
+
+
+/******
+	Batched robustness queries. is_greater_batch may prove a comparison from
+	the back-substituted expressions of the two labels instead of y - x, so
+	its bounds are checked against concrete executions and its decisions
+	against the ones of label_deviation_lb_until.
+******/
+
+/* outputs of a network of dense and ReLU layers */
+static void test_net_execute(test_net_t *net, double *x, double *values){
+	double *in = (double *)malloc(net->in*sizeof(double));
+	size_t l, i, j;
+	memcpy(in, x, net->in*sizeof(double));
+	for(l=0; l < net->numlayers; l++){
+		test_layer_t *layer = &net->layers[l];
+		double *out = (double *)malloc(layer->out*sizeof(double));
+		for(i=0; i < layer->out; i++){
+			if(layer->op==TEST_RELU){
+				out[i] = fmax(in[i], 0);
+				continue;
+			}
+			out[i] = layer->bias[i];
+			for(j=0; j < layer->in; j++){
+				out[i] += layer->weights[i][j]*in[j];
+			}
+		}
+		free(in);
+		in = out;
+	}
+	memcpy(values, in, net->layers[net->numlayers-1].out*sizeof(double));
+	free(in);
+}
+
+
+static int test_batch(test_net_t *net, const char *name, size_t samples){
+	size_t num_out = net->layers[net->numlayers-1].out;
+	double *lbs = (double *)malloc(num_out*num_out*sizeof(double));
+	elina_dim_t *xs = (elina_dim_t *)malloc(num_out*sizeof(elina_dim_t));
+	test_config_t config = test_default_config();
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	bool agree = true;
+	size_t y, i, s;
+	for(y=0; y < num_out; y++){
+		size_t n = 0;
+		for(i=0; i < num_out; i++){
+			if(i!=y){
+				xs[n++] = i;
+			}
+		}
+		double *lbs_y = lbs + y*num_out;
+		bool batch = is_greater_batch(man, element, y, xs, n, lbs_y);
+		bool proved = true;
+		for(i=0; i < n; i++){
+			/* the batch falls back to y - x, it proves at least as much */
+			double lb = label_deviation_lb_until(man, element, y, xs[i], 0);
+			agree = agree && (lb <= 0 || lbs_y[i] > 0);
+			proved = proved && lbs_y[i] > 0;
+		}
+		agree = agree && batch==proved;
+		agree = agree && is_greater_batch(man, element, y, xs, n, NULL)==batch;
+	}
+	double *x = (double *)malloc(net->in*sizeof(double));
+	double *values = (double *)malloc(num_out*sizeof(double));
+	bool sound = true;
+	for(s=0; s < samples; s++){
+		for(i=0; i < net->in; i++){
+			x[i] = test_uniform(net->inf[i], net->sup[i]);
+		}
+		test_net_execute(net, x, values);
+		for(y=0; y < num_out; y++){
+			size_t n = 0;
+			for(i=0; i < num_out; i++){
+				if(i!=y){
+					sound = sound && values[y] - values[i] >= lbs[y*num_out+n] - TEST_TOLERANCE;
+					n++;
+				}
+			}
+		}
+	}
+	char str[64];
+	int failed = 0;
+	snprintf(str, sizeof(str), "%s is_greater_batch sampled", name);
+	failed += !test_report(str, sound);
+	snprintf(str, sizeof(str), "%s is_greater_batch vs single", name);
+	failed += !test_report(str, agree);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	free(x);
+	free(values);
+	free(xs);
+	free(lbs);
+	return failed;
+}
+
+
+
+/******
+	Compiled networks. fppoly_network_verify_batch analyses the regions in
+	the pool workers, several per task, and must decide every region as
+	is_greater does on an element built layer by layer.
+******/
+
+static fppoly_network_t * test_net_compile(test_net_t *net){
+	fppoly_network_t *compiled = fppoly_network_alloc(net->in);
+	size_t l;
+	for(l=0; l < net->numlayers; l++){
+		test_layer_t *layer = &net->layers[l];
+		size_t output_size[3];
+		switch(layer->op){
+			case TEST_FC:
+				fppoly_network_add_fully_connected(compiled, layer->weights, layer->bias, layer->out, layer->in, layer->predecessors, 1);
+				break;
+			case TEST_CONV:
+				memcpy(output_size, layer->output_size, 3*sizeof(size_t));
+				fppoly_network_add_convolutional(compiled, layer->filter, layer->bias, layer->input_size, layer->filter_size, layer->num_filters, layer->strides, output_size,
+								 layer->pad, layer->pad, true, layer->predecessors, 1);
+				break;
+			case TEST_RELU:
+				fppoly_network_add_relu(compiled, layer->out, layer->predecessors, 1, true);
+				break;
+		}
+	}
+	return compiled;
+}
+
+
+static int test_compiled(test_net_t *net, const char *name, size_t num_regions){
+	size_t num_out = net->layers[net->numlayers-1].out;
+	double **inf = (double **)malloc(num_regions*sizeof(double *));
+	double **sup = (double **)malloc(num_regions*sizeof(double *));
+	elina_dim_t *labels = (elina_dim_t *)malloc(num_regions*sizeof(elina_dim_t));
+	bool *results = (bool *)malloc(num_regions*sizeof(bool));
+	double *values = (double *)malloc(num_out*sizeof(double));
+	size_t r, i;
+	for(r=0; r < num_regions; r++){
+		/* the label of the centre, on boxes from easy to hopeless */
+		double eps = 0.001*(r%20 + 1);
+		inf[r] = (double *)malloc(net->in*sizeof(double));
+		sup[r] = (double *)malloc(net->in*sizeof(double));
+		for(i=0; i < net->in; i++){
+			double c = test_uniform(0, 1);
+			inf[r][i] = c;
+			sup[r][i] = c;
+		}
+		test_net_execute(net, inf[r], values);
+		labels[r] = 0;
+		for(i=1; i < num_out; i++){
+			if(values[i] > values[labels[r]]){
+				labels[r] = i;
+			}
+		}
+		for(i=0; i < net->in; i++){
+			inf[r][i] -= eps;
+			sup[r][i] += eps;
+		}
+	}
+	test_config_t config = test_default_config();
+	config.num_threads = 4;
+	elina_manager_t *man = test_manager(&config);
+	fppoly_network_t *compiled = test_net_compile(net);
+	fppoly_network_verify_batch(man, compiled, num_regions, inf, sup, labels, results);
+	bool same = true;
+	size_t proved = 0;
+	for(r=0; r < num_regions; r++){
+		elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, inf[r], sup[r]);
+		test_net_apply(man, element, net, 0, net->numlayers);
+		bool expected = true;
+		for(i=0; i < num_out && expected; i++){
+			expected = i==labels[r] || is_greater(man, element, labels[r], i);
+		}
+		same = same && results[r]==expected;
+		proved += expected;
+		elina_abstract0_free(man, element);
+		free(inf[r]);
+		free(sup[r]);
+	}
+	char str[64];
+	snprintf(str, sizeof(str), "%s compiled vs is_greater (%zu/%zu)", name, proved, num_regions);
+	int failed = !test_report(str, same);
+	fppoly_network_free(compiled);
+	elina_manager_free(man);
+	free(inf);
+	free(sup);
+	free(labels);
+	free(results);
+	free(values);
+	return failed;
+}
+
+
+
+/******
+	Incremental analysis after LP refinement. Tightening a neuron whose ReLU
+	feeds only zero weights changes the ReLU but not the dense layer after
+	it, so the layers from there on must be kept as they are and still give
+	the bounds of a full run.
+******/
+
+/* the bounds in the order of update_bounds_from_LPsolve, +-INFINITY keeps a bound */
+static double * test_lp_bounds(fppoly_t *fp, size_t *num_each_layer, size_t *count, bool upper){
+	size_t l, i, n = fp->num_pixels;
+	for(l=0; l+1 < fp->numlayers; l++){
+		if(!fp->layers[l]->is_activation && fp->layers[l+1]->is_activation){
+			n += fp->layers[l]->dims;
+		}
+	}
+	double *bounds = (double *)malloc(n*sizeof(double));
+	for(i=0; i < n; i++){
+		bounds[i] = upper ? INFINITY : -INFINITY;
+	}
+	num_each_layer[0] = fp->num_pixels;
+	*count = 1;
+	for(l=0; l+1 < fp->numlayers; l++){
+		if(!fp->layers[l]->is_activation && fp->layers[l+1]->is_activation){
+			num_each_layer[(*count)++] = fp->layers[l]->dims;
+		}
+	}
+	return bounds;
+}
+
+
+static int test_incremental(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	test_config_t config = test_default_config();
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	fppoly_t *fp = fppoly_of_abstract0(element);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	run_deeppoly(man, element);
+	/* an unstable neuron of the first dense layer, its ReLU feeds nothing */
+	neuron_t **neurons = fp->layers[0]->neurons;
+	size_t u = 0, i, l;
+	while(u < net->layers[0].out && !(neurons[u]->lb > 0 && neurons[u]->ub > 0)){
+		u++;
+	}
+	double *column = (double *)malloc(net->layers[2].out*sizeof(double));
+	for(i=0; i < net->layers[2].out; i++){
+		column[i] = net->layers[2].weights[i][u];
+		net->layers[2].weights[i][u] = 0;
+	}
+	elina_abstract0_free(man, element);
+	element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	fp = fppoly_of_abstract0(element);
+	test_net_apply(man, element, net, 0, net->numlayers);
+	run_deeppoly(man, element);
+	expr_t **kept = (expr_t **)malloc(size*sizeof(expr_t *));
+	size_t n = 0;
+	for(l=3; l < fp->numlayers; l++){
+		for(i=0; i < fp->layers[l]->dims; i++){
+			kept[n++] = fp->layers[l]->neurons[i]->backsubstituted_lexpr;
+		}
+	}
+	size_t num_each_layer[TEST_MAX_LAYERS], count;
+	double *all_lbs = test_lp_bounds(fp, num_each_layer, &count, false);
+	double *all_ubs = test_lp_bounds(fp, num_each_layer, &count, true);
+	all_ubs[fp->num_pixels + u] = fp->layers[0]->neurons[u]->ub/2;
+	expr_t *relu = copy_expr(fp->layers[1]->neurons[u]->uexpr);
+	update_bounds_from_LPsolve(man, element, count, num_each_layer, all_lbs, all_ubs);
+	bool reused = !expr_equal(relu, fp->layers[1]->neurons[u]->uexpr);
+	n = 0;
+	for(l=3; l < fp->numlayers; l++){
+		for(i=0; i < fp->layers[l]->dims; i++){
+			reused = reused && kept[n++]==fp->layers[l]->neurons[i]->backsubstituted_lexpr;
+		}
+	}
+	test_element_bounds(element, bounds);
+	run_deeppoly(man, element);
+	test_element_bounds(element, expected);
+	char str[64];
+	int failed = 0;
+	snprintf(str, sizeof(str), "%s incremental keeps unchanged suffix", name);
+	failed += !test_report(str, reused);
+	snprintf(str, sizeof(str), "%s incremental vs run_deeppoly", name);
+	failed += !test_report(str, test_same_bounds(expected, bounds, size));
+	free_expr(relu);
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	for(i=0; i < net->layers[2].out; i++){
+		net->layers[2].weights[i][u] = column[i];
+	}
+	free(column);
+	free(kept);
+	free(all_lbs);
+	free(all_ubs);
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+
+/******
+	Snapshots. An element analysed up to some layer, saved and loaded again,
+	must have the same bounds, and extending it with the remaining layers
+	must give the bounds of the element it was saved from. A truncated file
+	must be rejected.
+******/
+
+static int test_snapshot(test_net_t *net, const char *name){
+	size_t size = test_net_size(net);
+	size_t cut = net->numlayers - 2;
+	double *expected = (double *)malloc(2*size*sizeof(double));
+	double *bounds = (double *)malloc(2*size*sizeof(double));
+	char path[] = "/tmp/fppoly_test_XXXXXX";
+	int fd = mkstemp(path);
+	if(fd >= 0){
+		close(fd);
+	}
+	test_config_t config = test_default_config();
+	elina_manager_t *man = test_manager(&config);
+	elina_abstract0_t *element = fppoly_from_network_input(man, 0, net->in, net->inf, net->sup);
+	test_net_apply(man, element, net, 0, cut);
+	bool saved = fd >= 0 && fppoly_snapshot_save(man, element, path);
+	elina_abstract0_t *restored = saved ? fppoly_snapshot_load(man, path) : NULL;
+	char str[64];
+	int failed = 0;
+	snprintf(str, sizeof(str), "%s snapshot save and load", name);
+	failed += !test_report(str, restored!=NULL);
+	if(restored){
+		size_t prefix = (test_element_bounds(element, expected) - expected)/2;
+		test_element_bounds(restored, bounds);
+		snprintf(str, sizeof(str), "%s snapshot restores bounds", name);
+		failed += !test_report(str, test_same_bounds(expected, bounds, prefix));
+
+		test_net_apply(man, element, net, cut, net->numlayers);
+		test_net_apply(man, restored, net, cut, net->numlayers);
+		run_deeppoly(man, element);
+		run_deeppoly(man, restored);
+		test_element_bounds(element, expected);
+		test_element_bounds(restored, bounds);
+		snprintf(str, sizeof(str), "%s snapshot extended vs original", name);
+		failed += !test_report(str, test_same_bounds(expected, bounds, size));
+		elina_abstract0_free(man, restored);
+
+		struct stat st;
+		bool truncated = stat(path, &st)==0 && truncate(path, st.st_size/2)==0;
+		restored = truncated ? fppoly_snapshot_load(man, path) : NULL;
+		snprintf(str, sizeof(str), "%s snapshot rejects truncated file", name);
+		failed += !test_report(str, truncated && restored==NULL);
+		if(restored){
+			elina_abstract0_free(man, restored);
+		}
+	}
+	if(fd >= 0){
+		unlink(path);
+	}
+	elina_abstract0_free(man, element);
+	elina_manager_free(man);
+	free(expected);
+	free(bounds);
+	return failed;
+}
+
+
+/******
+	Spatial constraints. The dual bound of a random grid of pixels, each with
+	two flow components, must lie above the optimum of the LP found by the
+	simplex method, and close to it.
+******/
+
+#define TEST_GRID 3
+#define TEST_GRID_PIXELS (TEST_GRID*TEST_GRID)
+#define TEST_GRID_DIMS (3*TEST_GRID_PIXELS)
+#define TEST_GRID_PAIRS (2*TEST_GRID*(TEST_GRID-1))
+#define TEST_GRID_ROWS (TEST_GRID_DIMS + 2*TEST_GRID_PIXELS + 4*TEST_GRID_PAIRS)
+
+
+/* max c.z subject to a z <= b and lo <= z <= hi, where z = lo must be
+   feasible; tableau simplex with Bland's rule over y = z - lo */
+static double test_simplex_max(double a[][TEST_GRID_DIMS], double *b, size_t m, double *c, double *lo, double *hi){
+	size_t rows = m + TEST_GRID_DIMS;
+	size_t cols = TEST_GRID_DIMS + rows + 1;
+	double *t = (double *)calloc(rows*cols, sizeof(double));
+	double *obj = (double *)calloc(cols, sizeof(double));
+	size_t *basis = (size_t *)malloc(rows*sizeof(size_t));
+	double res = 0;
+	size_t i, j, k;
+	for(i=0; i < rows; i++){
+		double rhs;
+		if(i < m){
+			rhs = b[i];
+			for(j=0; j < TEST_GRID_DIMS; j++){
+				t[i*cols+j] = a[i][j];
+				rhs -= a[i][j]*lo[j];
+			}
+		}
+		else{
+			t[i*cols+i-m] = 1;
+			rhs = hi[i-m] - lo[i-m];
+		}
+		t[i*cols+TEST_GRID_DIMS+i] = 1;
+		t[i*cols+cols-1] = rhs;
+		basis[i] = TEST_GRID_DIMS + i;
+	}
+	for(j=0; j < TEST_GRID_DIMS; j++){
+		obj[j] = c[j];
+		res += c[j]*lo[j];
+	}
+	while(true){
+		size_t enter = cols;
+		for(j=0; j < cols-1 && enter==cols; j++){
+			if(obj[j] > 1e-12){
+				enter = j;
+			}
+		}
+		if(enter==cols){
+			break;
+		}
+		size_t leave = rows;
+		double ratio = INFINITY;
+		for(i=0; i < rows; i++){
+			double v = t[i*cols+enter];
+			if(v > 1e-12){
+				double r = fmax(t[i*cols+cols-1], 0)/v;
+				if(r < ratio || (r==ratio && basis[i] < basis[leave])){
+					ratio = r;
+					leave = i;
+				}
+			}
+		}
+		double pivot = t[leave*cols+enter];
+		for(k=0; k < cols; k++){
+			t[leave*cols+k] /= pivot;
+		}
+		for(i=0; i < rows; i++){
+			double f = t[i*cols+enter];
+			if(i!=leave && f!=0){
+				for(k=0; k < cols; k++){
+					t[i*cols+k] -= f*t[leave*cols+k];
+				}
+			}
+		}
+		double f = obj[enter];
+		for(k=0; k < cols; k++){
+			obj[k] -= f*t[leave*cols+k];
+		}
+		basis[leave] = enter;
+	}
+	res -= obj[cols-1];
+	free(t);
+	free(obj);
+	free(basis);
+	return res;
+}
+
+
+static int test_spatial(size_t trials){
+	/* pixel k, its flow components are dims TEST_GRID_PIXELS + 2k and + 2k + 1 */
+	double inf[TEST_GRID_DIMS], sup[TEST_GRID_DIMS];
+	double lw[2*TEST_GRID_DIMS], uw[2*TEST_GRID_DIMS], lc[TEST_GRID_DIMS], uc[TEST_GRID_DIMS];
+	size_t dims[2*TEST_GRID_DIMS];
+	size_t indices[TEST_GRID_PAIRS], neighbors[TEST_GRID_PAIRS];
+	double a[TEST_GRID_ROWS][TEST_GRID_DIMS], b[TEST_GRID_ROWS];
+	double coeff[TEST_GRID_DIMS], neg[TEST_GRID_DIMS];
+	double gamma = 0.1;
+	size_t num_pairs = 0;
+	size_t t, i, k, d;
+	bool ignored = true, sound = true, tight = true;
+	for(k=0; k < TEST_GRID_PIXELS; k++){
+		if(k%TEST_GRID + 1 < TEST_GRID){
+			indices[num_pairs] = k;
+			neighbors[num_pairs++] = k + 1;
+		}
+		if(k + TEST_GRID < TEST_GRID_PIXELS){
+			indices[num_pairs] = k;
+			neighbors[num_pairs++] = k + TEST_GRID;
+		}
+	}
+	for(t=0; t < trials; t++){
+		size_t m = 0;
+		memset(a, 0, sizeof(a));
+		for(k=0; k < TEST_GRID_DIMS; k++){
+			bool pixel = k < TEST_GRID_PIXELS;
+			inf[k] = pixel ? 0 : -1;
+			sup[k] = 1;
+			dims[2*k] = pixel ? TEST_GRID_PIXELS + 2*k : TEST_GRID_PIXELS;
+			dims[2*k+1] = dims[2*k] + 1;
+			lw[2*k] = lw[2*k+1] = uw[2*k] = uw[2*k+1] = 0;
+			lc[k] = inf[k];
+			uc[k] = sup[k];
+			if(pixel){
+				/* the input constraints hold at the lower corner of the box */
+				for(d=0; d < 2; d++){
+					lw[2*k+d] = test_uniform(-0.5, 0.5);
+					uw[2*k+d] = test_uniform(-0.5, 0.5);
+				}
+				lc[k] = -0.1 + lw[2*k] + lw[2*k+1];
+				uc[k] = test_uniform(0, 0.5) + uw[2*k] + uw[2*k+1];
+				a[m][k] = -1;
+				a[m][dims[2*k]] = lw[2*k];
+				a[m][dims[2*k+1]] = lw[2*k+1];
+				b[m++] = -lc[k];
+				a[m][k] = 1;
+				a[m][dims[2*k]] = -uw[2*k];
+				a[m][dims[2*k+1]] = -uw[2*k+1];
+				b[m++] = uc[k];
+			}
+			coeff[k] = pixel ? test_uniform(-1, 1) : 0;
+			neg[k] = -coeff[k];
+		}
+		for(i=0; i < num_pairs; i++){
+			for(d=0; d < 2; d++){
+				size_t x = TEST_GRID_PIXELS + 2*indices[i] + d;
+				size_t y = TEST_GRID_PIXELS + 2*neighbors[i] + d;
+				a[m][x] = 1;
+				a[m][y] = -1;
+				b[m++] = gamma;
+				a[m][x] = -1;
+				a[m][y] = 1;
+				b[m++] = gamma;
+			}
+		}
+
+		elina_manager_t *man = fppoly_manager_alloc();
+		elina_abstract0_t *element = fppoly_from_network_input_poly(man, 0, TEST_GRID_DIMS, inf, sup, lw, lc, dims, uw, uc, dims, 2, indices, neighbors, num_pairs, gamma);
+		ignored = ignored && fppoly_of_abstract0(element)->spatial_lp==NULL;
+		elina_abstract0_free(man, element);
+		fppoly_manager_set_spatial_solver(man, FPPOLY_SPATIAL_DUAL_ASCENT);
+		element = fppoly_from_network_input_poly(man, 0, TEST_GRID_DIMS, inf, sup, lw, lc, dims, uw, uc, dims, 2, indices, neighbors, num_pairs, gamma);
+		fppoly_t *fp = fppoly_of_abstract0(element);
+		expr_t *expr = create_dense_expr(coeff, 0, TEST_GRID_DIMS);
+		double ub = spatial_lp_bound(fp->spatial_lp, expr, false);
+		double lb = spatial_lp_bound(fp->spatial_lp, expr, true);
+		double exact_ub = test_simplex_max(a, b, m, coeff, inf, sup);
+		double exact_lb = test_simplex_max(a, b, m, neg, inf, sup);
+		sound = sound && ub >= exact_ub - TEST_TOLERANCE && lb >= exact_lb - TEST_TOLERANCE;
+		tight = tight && ub - exact_ub <= 1e-2*(1 + fabs(exact_ub)) && lb - exact_lb <= 1e-2*(1 + fabs(exact_lb));
+		free_expr(expr);
+		elina_abstract0_free(man, element);
+		elina_manager_free(man);
+	}
+	int failed = 0;
+	failed += !test_report("spatial constraints ignored by default", ignored);
+	failed += !test_report("spatial dual bound above exact LP", sound);
+	failed += !test_report("spatial dual bound close to exact LP", tight);
+	return failed;
+}
+
+
+
+int main(int argc, char **argv){
+	size_t samples = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+	int failed = 0;
+	srand(42);
+	failed += test_lstm(8, 4, 1, samples);
+	failed += test_lstm(16, 32, 5, samples);
+	failed += test_lstm(32, 64, 20, samples);
+	failed += test_weight_buffers(30, 50, 10);
+	failed += test_weight_buffers(200, 100, 10);
+	test_net_t mlp, cnn;
+	test_net_mlp(&mlp, 30, 40, 3);
+	test_net_cnn(&cnn, 3);
+	failed += test_matrix(&mlp, "mlp");
+	failed += test_matrix(&cnn, "cnn");
+	failed += test_interval_kernels(100);
+	failed += test_kernel_analysis(&mlp, "mlp");
+	failed += test_kernel_analysis(&cnn, "cnn");
+	failed += test_single_precision(&mlp, "mlp");
+	failed += test_single_precision(&cnn, "cnn");
+	failed += test_implicit_conv(&cnn, "cnn");
+	failed += test_maxpool(200);
+	failed += test_borrow(&mlp, "mlp");
+	failed += test_batch(&mlp, "mlp", samples);
+	failed += test_incremental(&mlp, "mlp");
+	failed += test_compiled(&mlp, "mlp", 100);
+	failed += test_snapshot(&mlp, "mlp");
+	failed += test_snapshot(&cnn, "cnn");
+	failed += test_spatial(50);
+	test_net_free(&mlp);
+	test_net_free(&cnn);
+	return failed;
+}
@@ -0,0 +1,740 @@
+#include "interval_kernels.h"
+#include "expr.h"
+
+#if defined(VECTOR) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define INTERVAL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* products are gathered in chunks of this size for the sparse kernel */
+#define INTERVAL_KERNELS_CHUNK 256
+
+static interval_kernels_isa_t kernels_isa = INTERVAL_KERNELS_SCALAR;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+
+static interval_kernels_isa_t interval_kernels_detect(void){
+#if defined(INTERVAL_KERNELS_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")){
+		return INTERVAL_KERNELS_AVX512;
+	}
+	if(__builtin_cpu_supports("avx2")){
+		return INTERVAL_KERNELS_AVX2;
+	}
+#endif
+	return INTERVAL_KERNELS_SCALAR;
+}
+
+
+static void interval_kernels_init(void){
+	kernels_isa = interval_kernels_detect();
+}
+
+
+interval_kernels_isa_t interval_kernels_select(interval_kernels_isa_t isa){
+	pthread_once(&kernels_once, interval_kernels_init);
+	interval_kernels_isa_t best = interval_kernels_detect();
+	kernels_isa = isa <= best ? isa : best;
+	return kernels_isa;
+}
+
+
+static inline interval_kernels_isa_t interval_kernels_isa(void){
+	pthread_once(&kernels_once, interval_kernels_init);
+	return kernels_isa;
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* scalar                                                                  */
+/* ---------------------------------------------------------------------- */
+
+static inline void interval_accumulate(fppoly_internal_t *pr, double *acc_inf, double *acc_sup, double inf, double sup){
+	if(*acc_inf==0 && *acc_sup==0){
+		*acc_inf = inf;
+		*acc_sup = sup;
+		return;
+	}
+	double maxA = fmax(fabs(*acc_inf),fabs(*acc_sup));
+	double maxB = fmax(fabs(inf),fabs(sup));
+	*acc_inf = *acc_inf + inf + (maxA + maxB)*pr->ulp;
+	*acc_sup = *acc_sup + sup + (maxA + maxB)*pr->ulp;
+}
+
+
+static void scalar_dense_mul(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		elina_double_interval_mul_expr_coeff(pr,&res_inf[i],&res_sup[i],mul_inf,mul_sup,inf_coeff[i],sup_coeff[i]);
+	}
+}
+
+
+static void scalar_dense_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		double tmp1, tmp2;
+		elina_double_interval_mul_expr_coeff(pr,&tmp1,&tmp2,mul_inf,mul_sup,inf_coeff[i],sup_coeff[i]);
+		interval_accumulate(pr,&res_inf[i],&res_sup[i],tmp1,tmp2);
+	}
+}
+
+
+static void scalar_dense_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		double maxA = fmax(fabs(res_inf[i]),fabs(res_sup[i]));
+		double maxB = fmax(fabs(inf_coeff[i]),fabs(sup_coeff[i]));
+		res_inf[i] = res_inf[i] + inf_coeff[i] + (maxA + maxB)*pr->ulp;
+		res_sup[i] = res_sup[i] + sup_coeff[i] + (maxA + maxB)*pr->ulp;
+	}
+}
+
+
+static void scalar_dense_concretize(double *inf_coeff, double *sup_coeff, double *inf, double *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	double acc_inf = res_inf ? *res_inf : 0;
+	double acc_sup = res_sup ? *res_sup : 0;
+	for(i=0; i < size; i++){
+		double tmp1, tmp2;
+		elina_double_interval_mul(&tmp1,&tmp2,inf_coeff[i],sup_coeff[i],inf[i],sup[i]);
+		acc_inf = acc_inf + tmp1;
+		acc_sup = acc_sup + tmp2;
+	}
+	if(res_inf){
+		*res_inf = acc_inf;
+	}
+	if(res_sup){
+		*res_sup = acc_sup;
+	}
+}
+
+
+/* ulp of float for the error terms of the single precision kernels, the ulp of
+   the manager stays the one of double */
+#define INTERVAL_KERNELS_ULP_F 0x1p-23f
+
+
+/* single precision: the products are the largest endpoint products as in the
+   vector kernels, 0*inf is 0 */
+static inline float scalar_nz_f(float x){
+	return x!=x ? 0.0f : x;
+}
+
+
+static inline void scalar_interval_mul_f(float *a_inf, float *a_sup, float b_inf, float b_sup, float c_inf, float c_sup){
+	*a_sup = fmaxf(fmaxf(scalar_nz_f(b_sup*c_sup),scalar_nz_f(b_inf*c_inf)),fmaxf(scalar_nz_f(-b_inf*c_sup),scalar_nz_f(-b_sup*c_inf)));
+	*a_inf = fmaxf(fmaxf(scalar_nz_f(b_inf*c_sup),scalar_nz_f(b_sup*c_inf)),fmaxf(scalar_nz_f(-b_inf*c_inf),scalar_nz_f(-b_sup*c_sup)));
+}
+
+
+static inline void scalar_mul_expr_coeff_f(float *a_inf, float *a_sup, float b_inf, float b_sup, float max_b, float ulp, float c_inf, float c_sup){
+	scalar_interval_mul_f(a_inf,a_sup,b_inf,b_sup,c_inf,c_sup);
+	float err = scalar_nz_f(max_b*(fmaxf(fabsf(c_inf),fabsf(c_sup))*ulp));
+	*a_inf = *a_inf + err;
+	*a_sup = *a_sup + err;
+}
+
+
+static void scalar_dense_mul_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	float max_b = fmaxf(fabsf(mul_inf),fabsf(mul_sup));
+	float ulp = INTERVAL_KERNELS_ULP_F;
+	for(i=0; i < size; i++){
+		scalar_mul_expr_coeff_f(&res_inf[i],&res_sup[i],mul_inf,mul_sup,max_b,ulp,inf_coeff[i],sup_coeff[i]);
+	}
+}
+
+
+static void scalar_dense_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	float max_b = fmaxf(fabsf(mul_inf),fabsf(mul_sup));
+	float ulp = INTERVAL_KERNELS_ULP_F;
+	for(i=0; i < size; i++){
+		float tmp1, tmp2;
+		scalar_mul_expr_coeff_f(&tmp1,&tmp2,mul_inf,mul_sup,max_b,ulp,inf_coeff[i],sup_coeff[i]);
+		if(res_inf[i]==0 && res_sup[i]==0){
+			res_inf[i] = tmp1;
+			res_sup[i] = tmp2;
+			continue;
+		}
+		float err = (fmaxf(fabsf(res_inf[i]),fabsf(res_sup[i])) + fmaxf(fabsf(tmp1),fabsf(tmp2)))*ulp;
+		res_inf[i] = res_inf[i] + tmp1 + err;
+		res_sup[i] = res_sup[i] + tmp2 + err;
+	}
+}
+
+
+/* the products of floats are exact in double, only the sum is rounded */
+static void scalar_dense_concretize_f(const float *inf_coeff, const float *sup_coeff, const float *inf, const float *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	double acc_inf = *res_inf;
+	double acc_sup = *res_sup;
+	for(i=0; i < size; i++){
+		double tmp1, tmp2;
+		elina_double_interval_mul(&tmp1,&tmp2,inf_coeff[i],sup_coeff[i],inf[i],sup[i]);
+		acc_inf = acc_inf + tmp1;
+		acc_sup = acc_sup + tmp2;
+	}
+	*res_inf = acc_inf;
+	*res_sup = acc_sup;
+}
+
+
+#if defined(INTERVAL_KERNELS_X86)
+
+/* ---------------------------------------------------------------------- */
+/* AVX2                                                                    */
+/* ---------------------------------------------------------------------- */
+
+/* 0*inf is 0 in elina_double_interval_mul */
+__attribute__((target("avx2"))) static inline __m256d avx2_nz(__m256d x){
+	return _mm256_andnot_pd(_mm256_cmp_pd(x,x,_CMP_UNORD_Q),x);
+}
+
+
+__attribute__((target("avx2"))) static inline __m256d avx2_abs(__m256d x){
+	return _mm256_andnot_pd(_mm256_set1_pd(-0.0),x);
+}
+
+
+__attribute__((target("avx2"))) static inline __m256d avx2_neg(__m256d x){
+	return _mm256_xor_pd(_mm256_set1_pd(-0.0),x);
+}
+
+
+/* [-b_inf,b_sup]*[-c_inf,c_sup], every bound is the largest of the four endpoint products */
+__attribute__((target("avx2"))) static inline void avx2_interval_mul(__m256d *a_inf, __m256d *a_sup, __m256d b_inf, __m256d b_sup, __m256d c_inf, __m256d c_sup){
+	__m256d nb_inf = avx2_neg(b_inf);
+	__m256d nb_sup = avx2_neg(b_sup);
+	*a_sup = _mm256_max_pd(_mm256_max_pd(avx2_nz(_mm256_mul_pd(b_sup,c_sup)),avx2_nz(_mm256_mul_pd(b_inf,c_inf))),
+			       _mm256_max_pd(avx2_nz(_mm256_mul_pd(nb_inf,c_sup)),avx2_nz(_mm256_mul_pd(nb_sup,c_inf))));
+	*a_inf = _mm256_max_pd(_mm256_max_pd(avx2_nz(_mm256_mul_pd(b_inf,c_sup)),avx2_nz(_mm256_mul_pd(b_sup,c_inf))),
+			       _mm256_max_pd(avx2_nz(_mm256_mul_pd(nb_inf,c_inf)),avx2_nz(_mm256_mul_pd(nb_sup,c_sup))));
+}
+
+
+/* elina_double_interval_mul_expr_coeff for a broadcast multiplier */
+__attribute__((target("avx2"))) static inline void avx2_mul_expr_coeff(__m256d *a_inf, __m256d *a_sup, __m256d b_inf, __m256d b_sup, __m256d max_b, __m256d ulp, __m256d c_inf, __m256d c_sup){
+	avx2_interval_mul(a_inf,a_sup,b_inf,b_sup,c_inf,c_sup);
+	__m256d err = _mm256_mul_pd(_mm256_max_pd(avx2_abs(c_inf),avx2_abs(c_sup)),ulp);
+	err = avx2_nz(_mm256_mul_pd(max_b,err));
+	*a_inf = _mm256_add_pd(*a_inf,err);
+	*a_sup = _mm256_add_pd(*a_sup,err);
+}
+
+
+__attribute__((target("avx2"))) static void avx2_dense_mul(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m256d b_inf = _mm256_set1_pd(mul_inf);
+	__m256d b_sup = _mm256_set1_pd(mul_sup);
+	__m256d max_b = _mm256_set1_pd(fmax(fabs(mul_inf),fabs(mul_sup)));
+	__m256d ulp = _mm256_set1_pd(pr->ulp);
+	for(i=0; i+4 <= size; i+=4){
+		__m256d a_inf, a_sup;
+		avx2_mul_expr_coeff(&a_inf,&a_sup,b_inf,b_sup,max_b,ulp,_mm256_loadu_pd(inf_coeff+i),_mm256_loadu_pd(sup_coeff+i));
+		_mm256_storeu_pd(res_inf+i,a_inf);
+		_mm256_storeu_pd(res_sup+i,a_sup);
+	}
+	scalar_dense_mul(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx2"))) static void avx2_dense_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m256d b_inf = _mm256_set1_pd(mul_inf);
+	__m256d b_sup = _mm256_set1_pd(mul_sup);
+	__m256d max_b = _mm256_set1_pd(fmax(fabs(mul_inf),fabs(mul_sup)));
+	__m256d ulp = _mm256_set1_pd(pr->ulp);
+	__m256d zero = _mm256_setzero_pd();
+	for(i=0; i+4 <= size; i+=4){
+		__m256d t_inf, t_sup;
+		avx2_mul_expr_coeff(&t_inf,&t_sup,b_inf,b_sup,max_b,ulp,_mm256_loadu_pd(inf_coeff+i),_mm256_loadu_pd(sup_coeff+i));
+		__m256d acc_inf = _mm256_loadu_pd(res_inf+i);
+		__m256d acc_sup = _mm256_loadu_pd(res_sup+i);
+		__m256d is_zero = _mm256_and_pd(_mm256_cmp_pd(acc_inf,zero,_CMP_EQ_OQ),_mm256_cmp_pd(acc_sup,zero,_CMP_EQ_OQ));
+		__m256d err = _mm256_mul_pd(_mm256_add_pd(_mm256_max_pd(avx2_abs(acc_inf),avx2_abs(acc_sup)),_mm256_max_pd(avx2_abs(t_inf),avx2_abs(t_sup))),ulp);
+		__m256d sum_inf = _mm256_add_pd(_mm256_add_pd(acc_inf,t_inf),err);
+		__m256d sum_sup = _mm256_add_pd(_mm256_add_pd(acc_sup,t_sup),err);
+		_mm256_storeu_pd(res_inf+i,_mm256_blendv_pd(sum_inf,t_inf,is_zero));
+		_mm256_storeu_pd(res_sup+i,_mm256_blendv_pd(sum_sup,t_sup,is_zero));
+	}
+	scalar_dense_mul_add(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx2"))) static void avx2_dense_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m256d ulp = _mm256_set1_pd(pr->ulp);
+	for(i=0; i+4 <= size; i+=4){
+		__m256d a_inf = _mm256_loadu_pd(res_inf+i);
+		__m256d a_sup = _mm256_loadu_pd(res_sup+i);
+		__m256d b_inf = _mm256_loadu_pd(inf_coeff+i);
+		__m256d b_sup = _mm256_loadu_pd(sup_coeff+i);
+		__m256d err = _mm256_mul_pd(_mm256_add_pd(_mm256_max_pd(avx2_abs(a_inf),avx2_abs(a_sup)),_mm256_max_pd(avx2_abs(b_inf),avx2_abs(b_sup))),ulp);
+		_mm256_storeu_pd(res_inf+i,_mm256_add_pd(_mm256_add_pd(a_inf,b_inf),err));
+		_mm256_storeu_pd(res_sup+i,_mm256_add_pd(_mm256_add_pd(a_sup,b_sup),err));
+	}
+	scalar_dense_add(pr,res_inf+i,res_sup+i,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+/* the lanes are summed separately, with upward rounding any order is sound */
+__attribute__((target("avx2"))) static void avx2_dense_concretize(double *inf_coeff, double *sup_coeff, double *inf, double *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	__m256d acc_inf = _mm256_setzero_pd();
+	__m256d acc_sup = _mm256_setzero_pd();
+	for(i=0; i+4 <= size; i+=4){
+		__m256d a_inf, a_sup;
+		avx2_interval_mul(&a_inf,&a_sup,_mm256_loadu_pd(inf_coeff+i),_mm256_loadu_pd(sup_coeff+i),_mm256_loadu_pd(inf+i),_mm256_loadu_pd(sup+i));
+		acc_inf = _mm256_add_pd(acc_inf,a_inf);
+		acc_sup = _mm256_add_pd(acc_sup,a_sup);
+	}
+	double lanes_inf[4], lanes_sup[4];
+	_mm256_storeu_pd(lanes_inf,acc_inf);
+	_mm256_storeu_pd(lanes_sup,acc_sup);
+	double sum_inf = res_inf ? *res_inf : 0;
+	double sum_sup = res_sup ? *res_sup : 0;
+	sum_inf = sum_inf + ((lanes_inf[0] + lanes_inf[1]) + (lanes_inf[2] + lanes_inf[3]));
+	sum_sup = sum_sup + ((lanes_sup[0] + lanes_sup[1]) + (lanes_sup[2] + lanes_sup[3]));
+	scalar_dense_concretize(inf_coeff+i,sup_coeff+i,inf+i,sup+i,size-i,&sum_inf,&sum_sup);
+	if(res_inf){
+		*res_inf = sum_inf;
+	}
+	if(res_sup){
+		*res_sup = sum_sup;
+	}
+}
+
+
+__attribute__((target("avx2"))) static inline __m256 avx2_nz_ps(__m256 x){
+	return _mm256_andnot_ps(_mm256_cmp_ps(x,x,_CMP_UNORD_Q),x);
+}
+
+
+__attribute__((target("avx2"))) static inline __m256 avx2_abs_ps(__m256 x){
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.0f),x);
+}
+
+
+__attribute__((target("avx2"))) static inline __m256 avx2_neg_ps(__m256 x){
+	return _mm256_xor_ps(_mm256_set1_ps(-0.0f),x);
+}
+
+
+__attribute__((target("avx2"))) static inline void avx2_mul_expr_coeff_ps(__m256 *a_inf, __m256 *a_sup, __m256 b_inf, __m256 b_sup, __m256 max_b, __m256 ulp, __m256 c_inf, __m256 c_sup){
+	__m256 nb_inf = avx2_neg_ps(b_inf);
+	__m256 nb_sup = avx2_neg_ps(b_sup);
+	*a_sup = _mm256_max_ps(_mm256_max_ps(avx2_nz_ps(_mm256_mul_ps(b_sup,c_sup)),avx2_nz_ps(_mm256_mul_ps(b_inf,c_inf))),
+			       _mm256_max_ps(avx2_nz_ps(_mm256_mul_ps(nb_inf,c_sup)),avx2_nz_ps(_mm256_mul_ps(nb_sup,c_inf))));
+	*a_inf = _mm256_max_ps(_mm256_max_ps(avx2_nz_ps(_mm256_mul_ps(b_inf,c_sup)),avx2_nz_ps(_mm256_mul_ps(b_sup,c_inf))),
+			       _mm256_max_ps(avx2_nz_ps(_mm256_mul_ps(nb_inf,c_inf)),avx2_nz_ps(_mm256_mul_ps(nb_sup,c_sup))));
+	__m256 err = _mm256_mul_ps(_mm256_max_ps(avx2_abs_ps(c_inf),avx2_abs_ps(c_sup)),ulp);
+	err = avx2_nz_ps(_mm256_mul_ps(max_b,err));
+	*a_inf = _mm256_add_ps(*a_inf,err);
+	*a_sup = _mm256_add_ps(*a_sup,err);
+}
+
+
+__attribute__((target("avx2"))) static void avx2_dense_mul_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	__m256 b_inf = _mm256_set1_ps(mul_inf);
+	__m256 b_sup = _mm256_set1_ps(mul_sup);
+	__m256 max_b = _mm256_set1_ps(fmaxf(fabsf(mul_inf),fabsf(mul_sup)));
+	__m256 ulp = _mm256_set1_ps(INTERVAL_KERNELS_ULP_F);
+	for(i=0; i+8 <= size; i+=8){
+		__m256 a_inf, a_sup;
+		avx2_mul_expr_coeff_ps(&a_inf,&a_sup,b_inf,b_sup,max_b,ulp,_mm256_loadu_ps(inf_coeff+i),_mm256_loadu_ps(sup_coeff+i));
+		_mm256_storeu_ps(res_inf+i,a_inf);
+		_mm256_storeu_ps(res_sup+i,a_sup);
+	}
+	scalar_dense_mul_f(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx2"))) static void avx2_dense_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	__m256 b_inf = _mm256_set1_ps(mul_inf);
+	__m256 b_sup = _mm256_set1_ps(mul_sup);
+	__m256 max_b = _mm256_set1_ps(fmaxf(fabsf(mul_inf),fabsf(mul_sup)));
+	__m256 ulp = _mm256_set1_ps(INTERVAL_KERNELS_ULP_F);
+	__m256 zero = _mm256_setzero_ps();
+	for(i=0; i+8 <= size; i+=8){
+		__m256 t_inf, t_sup;
+		avx2_mul_expr_coeff_ps(&t_inf,&t_sup,b_inf,b_sup,max_b,ulp,_mm256_loadu_ps(inf_coeff+i),_mm256_loadu_ps(sup_coeff+i));
+		__m256 acc_inf = _mm256_loadu_ps(res_inf+i);
+		__m256 acc_sup = _mm256_loadu_ps(res_sup+i);
+		__m256 is_zero = _mm256_and_ps(_mm256_cmp_ps(acc_inf,zero,_CMP_EQ_OQ),_mm256_cmp_ps(acc_sup,zero,_CMP_EQ_OQ));
+		__m256 err = _mm256_mul_ps(_mm256_add_ps(_mm256_max_ps(avx2_abs_ps(acc_inf),avx2_abs_ps(acc_sup)),_mm256_max_ps(avx2_abs_ps(t_inf),avx2_abs_ps(t_sup))),ulp);
+		__m256 sum_inf = _mm256_add_ps(_mm256_add_ps(acc_inf,t_inf),err);
+		__m256 sum_sup = _mm256_add_ps(_mm256_add_ps(acc_sup,t_sup),err);
+		_mm256_storeu_ps(res_inf+i,_mm256_blendv_ps(sum_inf,t_inf,is_zero));
+		_mm256_storeu_ps(res_sup+i,_mm256_blendv_ps(sum_sup,t_sup,is_zero));
+	}
+	scalar_dense_mul_add_f(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+/* the floats are widened and multiplied in double like avx2_dense_concretize */
+__attribute__((target("avx2"))) static void avx2_dense_concretize_f(const float *inf_coeff, const float *sup_coeff, const float *inf, const float *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	__m256d acc_inf = _mm256_setzero_pd();
+	__m256d acc_sup = _mm256_setzero_pd();
+	for(i=0; i+4 <= size; i+=4){
+		__m256d a_inf, a_sup;
+		avx2_interval_mul(&a_inf,&a_sup,_mm256_cvtps_pd(_mm_loadu_ps(inf_coeff+i)),_mm256_cvtps_pd(_mm_loadu_ps(sup_coeff+i)),
+				  _mm256_cvtps_pd(_mm_loadu_ps(inf+i)),_mm256_cvtps_pd(_mm_loadu_ps(sup+i)));
+		acc_inf = _mm256_add_pd(acc_inf,a_inf);
+		acc_sup = _mm256_add_pd(acc_sup,a_sup);
+	}
+	double lanes_inf[4], lanes_sup[4];
+	_mm256_storeu_pd(lanes_inf,acc_inf);
+	_mm256_storeu_pd(lanes_sup,acc_sup);
+	*res_inf = *res_inf + ((lanes_inf[0] + lanes_inf[1]) + (lanes_inf[2] + lanes_inf[3]));
+	*res_sup = *res_sup + ((lanes_sup[0] + lanes_sup[1]) + (lanes_sup[2] + lanes_sup[3]));
+	scalar_dense_concretize_f(inf_coeff+i,sup_coeff+i,inf+i,sup+i,size-i,res_inf,res_sup);
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* AVX-512                                                                 */
+/* ---------------------------------------------------------------------- */
+
+__attribute__((target("avx512f"))) static inline __m512d avx512_nz(__m512d x){
+	return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x,x,_CMP_ORD_Q),x);
+}
+
+
+__attribute__((target("avx512f"))) static inline __m512d avx512_neg(__m512d x){
+	return _mm512_sub_pd(_mm512_setzero_pd(),x);
+}
+
+
+__attribute__((target("avx512f"))) static inline void avx512_interval_mul(__m512d *a_inf, __m512d *a_sup, __m512d b_inf, __m512d b_sup, __m512d c_inf, __m512d c_sup){
+	__m512d nb_inf = avx512_neg(b_inf);
+	__m512d nb_sup = avx512_neg(b_sup);
+	*a_sup = _mm512_max_pd(_mm512_max_pd(avx512_nz(_mm512_mul_pd(b_sup,c_sup)),avx512_nz(_mm512_mul_pd(b_inf,c_inf))),
+			       _mm512_max_pd(avx512_nz(_mm512_mul_pd(nb_inf,c_sup)),avx512_nz(_mm512_mul_pd(nb_sup,c_inf))));
+	*a_inf = _mm512_max_pd(_mm512_max_pd(avx512_nz(_mm512_mul_pd(b_inf,c_sup)),avx512_nz(_mm512_mul_pd(b_sup,c_inf))),
+			       _mm512_max_pd(avx512_nz(_mm512_mul_pd(nb_inf,c_inf)),avx512_nz(_mm512_mul_pd(nb_sup,c_sup))));
+}
+
+
+__attribute__((target("avx512f"))) static inline void avx512_mul_expr_coeff(__m512d *a_inf, __m512d *a_sup, __m512d b_inf, __m512d b_sup, __m512d max_b, __m512d ulp, __m512d c_inf, __m512d c_sup){
+	avx512_interval_mul(a_inf,a_sup,b_inf,b_sup,c_inf,c_sup);
+	__m512d err = _mm512_mul_pd(_mm512_max_pd(_mm512_abs_pd(c_inf),_mm512_abs_pd(c_sup)),ulp);
+	err = avx512_nz(_mm512_mul_pd(max_b,err));
+	*a_inf = _mm512_add_pd(*a_inf,err);
+	*a_sup = _mm512_add_pd(*a_sup,err);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_mul(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m512d b_inf = _mm512_set1_pd(mul_inf);
+	__m512d b_sup = _mm512_set1_pd(mul_sup);
+	__m512d max_b = _mm512_set1_pd(fmax(fabs(mul_inf),fabs(mul_sup)));
+	__m512d ulp = _mm512_set1_pd(pr->ulp);
+	for(i=0; i+8 <= size; i+=8){
+		__m512d a_inf, a_sup;
+		avx512_mul_expr_coeff(&a_inf,&a_sup,b_inf,b_sup,max_b,ulp,_mm512_loadu_pd(inf_coeff+i),_mm512_loadu_pd(sup_coeff+i));
+		_mm512_storeu_pd(res_inf+i,a_inf);
+		_mm512_storeu_pd(res_sup+i,a_sup);
+	}
+	scalar_dense_mul(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m512d b_inf = _mm512_set1_pd(mul_inf);
+	__m512d b_sup = _mm512_set1_pd(mul_sup);
+	__m512d max_b = _mm512_set1_pd(fmax(fabs(mul_inf),fabs(mul_sup)));
+	__m512d ulp = _mm512_set1_pd(pr->ulp);
+	__m512d zero = _mm512_setzero_pd();
+	for(i=0; i+8 <= size; i+=8){
+		__m512d t_inf, t_sup;
+		avx512_mul_expr_coeff(&t_inf,&t_sup,b_inf,b_sup,max_b,ulp,_mm512_loadu_pd(inf_coeff+i),_mm512_loadu_pd(sup_coeff+i));
+		__m512d acc_inf = _mm512_loadu_pd(res_inf+i);
+		__m512d acc_sup = _mm512_loadu_pd(res_sup+i);
+		__mmask8 is_zero = _mm512_cmp_pd_mask(acc_inf,zero,_CMP_EQ_OQ) & _mm512_cmp_pd_mask(acc_sup,zero,_CMP_EQ_OQ);
+		__m512d err = _mm512_mul_pd(_mm512_add_pd(_mm512_max_pd(_mm512_abs_pd(acc_inf),_mm512_abs_pd(acc_sup)),_mm512_max_pd(_mm512_abs_pd(t_inf),_mm512_abs_pd(t_sup))),ulp);
+		__m512d sum_inf = _mm512_add_pd(_mm512_add_pd(acc_inf,t_inf),err);
+		__m512d sum_sup = _mm512_add_pd(_mm512_add_pd(acc_sup,t_sup),err);
+		_mm512_storeu_pd(res_inf+i,_mm512_mask_blend_pd(is_zero,sum_inf,t_inf));
+		_mm512_storeu_pd(res_sup+i,_mm512_mask_blend_pd(is_zero,sum_sup,t_sup));
+	}
+	scalar_dense_mul_add(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	size_t i;
+	__m512d ulp = _mm512_set1_pd(pr->ulp);
+	for(i=0; i+8 <= size; i+=8){
+		__m512d a_inf = _mm512_loadu_pd(res_inf+i);
+		__m512d a_sup = _mm512_loadu_pd(res_sup+i);
+		__m512d b_inf = _mm512_loadu_pd(inf_coeff+i);
+		__m512d b_sup = _mm512_loadu_pd(sup_coeff+i);
+		__m512d err = _mm512_mul_pd(_mm512_add_pd(_mm512_max_pd(_mm512_abs_pd(a_inf),_mm512_abs_pd(a_sup)),_mm512_max_pd(_mm512_abs_pd(b_inf),_mm512_abs_pd(b_sup))),ulp);
+		_mm512_storeu_pd(res_inf+i,_mm512_add_pd(_mm512_add_pd(a_inf,b_inf),err));
+		_mm512_storeu_pd(res_sup+i,_mm512_add_pd(_mm512_add_pd(a_sup,b_sup),err));
+	}
+	scalar_dense_add(pr,res_inf+i,res_sup+i,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_concretize(double *inf_coeff, double *sup_coeff, double *inf, double *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	__m512d acc_inf = _mm512_setzero_pd();
+	__m512d acc_sup = _mm512_setzero_pd();
+	for(i=0; i+8 <= size; i+=8){
+		__m512d a_inf, a_sup;
+		avx512_interval_mul(&a_inf,&a_sup,_mm512_loadu_pd(inf_coeff+i),_mm512_loadu_pd(sup_coeff+i),_mm512_loadu_pd(inf+i),_mm512_loadu_pd(sup+i));
+		acc_inf = _mm512_add_pd(acc_inf,a_inf);
+		acc_sup = _mm512_add_pd(acc_sup,a_sup);
+	}
+	double sum_inf = res_inf ? *res_inf : 0;
+	double sum_sup = res_sup ? *res_sup : 0;
+	sum_inf = sum_inf + _mm512_reduce_add_pd(acc_inf);
+	sum_sup = sum_sup + _mm512_reduce_add_pd(acc_sup);
+	scalar_dense_concretize(inf_coeff+i,sup_coeff+i,inf+i,sup+i,size-i,&sum_inf,&sum_sup);
+	if(res_inf){
+		*res_inf = sum_inf;
+	}
+	if(res_sup){
+		*res_sup = sum_sup;
+	}
+}
+
+
+__attribute__((target("avx512f"))) static inline __m512 avx512_nz_ps(__m512 x){
+	return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x,x,_CMP_ORD_Q),x);
+}
+
+
+__attribute__((target("avx512f"))) static inline void avx512_mul_expr_coeff_ps(__m512 *a_inf, __m512 *a_sup, __m512 b_inf, __m512 b_sup, __m512 max_b, __m512 ulp, __m512 c_inf, __m512 c_sup){
+	__m512 nb_inf = _mm512_sub_ps(_mm512_setzero_ps(),b_inf);
+	__m512 nb_sup = _mm512_sub_ps(_mm512_setzero_ps(),b_sup);
+	*a_sup = _mm512_max_ps(_mm512_max_ps(avx512_nz_ps(_mm512_mul_ps(b_sup,c_sup)),avx512_nz_ps(_mm512_mul_ps(b_inf,c_inf))),
+			       _mm512_max_ps(avx512_nz_ps(_mm512_mul_ps(nb_inf,c_sup)),avx512_nz_ps(_mm512_mul_ps(nb_sup,c_inf))));
+	*a_inf = _mm512_max_ps(_mm512_max_ps(avx512_nz_ps(_mm512_mul_ps(b_inf,c_sup)),avx512_nz_ps(_mm512_mul_ps(b_sup,c_inf))),
+			       _mm512_max_ps(avx512_nz_ps(_mm512_mul_ps(nb_inf,c_inf)),avx512_nz_ps(_mm512_mul_ps(nb_sup,c_sup))));
+	__m512 err = _mm512_mul_ps(_mm512_max_ps(_mm512_abs_ps(c_inf),_mm512_abs_ps(c_sup)),ulp);
+	err = avx512_nz_ps(_mm512_mul_ps(max_b,err));
+	*a_inf = _mm512_add_ps(*a_inf,err);
+	*a_sup = _mm512_add_ps(*a_sup,err);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_mul_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	__m512 b_inf = _mm512_set1_ps(mul_inf);
+	__m512 b_sup = _mm512_set1_ps(mul_sup);
+	__m512 max_b = _mm512_set1_ps(fmaxf(fabsf(mul_inf),fabsf(mul_sup)));
+	__m512 ulp = _mm512_set1_ps(INTERVAL_KERNELS_ULP_F);
+	for(i=0; i+16 <= size; i+=16){
+		__m512 a_inf, a_sup;
+		avx512_mul_expr_coeff_ps(&a_inf,&a_sup,b_inf,b_sup,max_b,ulp,_mm512_loadu_ps(inf_coeff+i),_mm512_loadu_ps(sup_coeff+i));
+		_mm512_storeu_ps(res_inf+i,a_inf);
+		_mm512_storeu_ps(res_sup+i,a_sup);
+	}
+	scalar_dense_mul_f(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	size_t i;
+	__m512 b_inf = _mm512_set1_ps(mul_inf);
+	__m512 b_sup = _mm512_set1_ps(mul_sup);
+	__m512 max_b = _mm512_set1_ps(fmaxf(fabsf(mul_inf),fabsf(mul_sup)));
+	__m512 ulp = _mm512_set1_ps(INTERVAL_KERNELS_ULP_F);
+	__m512 zero = _mm512_setzero_ps();
+	for(i=0; i+16 <= size; i+=16){
+		__m512 t_inf, t_sup;
+		avx512_mul_expr_coeff_ps(&t_inf,&t_sup,b_inf,b_sup,max_b,ulp,_mm512_loadu_ps(inf_coeff+i),_mm512_loadu_ps(sup_coeff+i));
+		__m512 acc_inf = _mm512_loadu_ps(res_inf+i);
+		__m512 acc_sup = _mm512_loadu_ps(res_sup+i);
+		__mmask16 is_zero = _mm512_cmp_ps_mask(acc_inf,zero,_CMP_EQ_OQ) & _mm512_cmp_ps_mask(acc_sup,zero,_CMP_EQ_OQ);
+		__m512 err = _mm512_mul_ps(_mm512_add_ps(_mm512_max_ps(_mm512_abs_ps(acc_inf),_mm512_abs_ps(acc_sup)),_mm512_max_ps(_mm512_abs_ps(t_inf),_mm512_abs_ps(t_sup))),ulp);
+		__m512 sum_inf = _mm512_add_ps(_mm512_add_ps(acc_inf,t_inf),err);
+		__m512 sum_sup = _mm512_add_ps(_mm512_add_ps(acc_sup,t_sup),err);
+		_mm512_storeu_ps(res_inf+i,_mm512_mask_blend_ps(is_zero,sum_inf,t_inf));
+		_mm512_storeu_ps(res_sup+i,_mm512_mask_blend_ps(is_zero,sum_sup,t_sup));
+	}
+	scalar_dense_mul_add_f(pr,res_inf+i,res_sup+i,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,size-i);
+}
+
+
+__attribute__((target("avx512f"))) static void avx512_dense_concretize_f(const float *inf_coeff, const float *sup_coeff, const float *inf, const float *sup, size_t size, double *res_inf, double *res_sup){
+	size_t i;
+	__m512d acc_inf = _mm512_setzero_pd();
+	__m512d acc_sup = _mm512_setzero_pd();
+	for(i=0; i+8 <= size; i+=8){
+		__m512d a_inf, a_sup;
+		avx512_interval_mul(&a_inf,&a_sup,_mm512_cvtps_pd(_mm256_loadu_ps(inf_coeff+i)),_mm512_cvtps_pd(_mm256_loadu_ps(sup_coeff+i)),
+				    _mm512_cvtps_pd(_mm256_loadu_ps(inf+i)),_mm512_cvtps_pd(_mm256_loadu_ps(sup+i)));
+		acc_inf = _mm512_add_pd(acc_inf,a_inf);
+		acc_sup = _mm512_add_pd(acc_sup,a_sup);
+	}
+	*res_inf = *res_inf + _mm512_reduce_add_pd(acc_inf);
+	*res_sup = *res_sup + _mm512_reduce_add_pd(acc_sup);
+	scalar_dense_concretize_f(inf_coeff+i,sup_coeff+i,inf+i,sup+i,size-i,res_inf,res_sup);
+}
+
+#endif
+
+
+/* ---------------------------------------------------------------------- */
+/* dispatch                                                                */
+/* ---------------------------------------------------------------------- */
+
+void expr_dense_mul(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_mul(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_mul(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+#endif
+		default:
+			scalar_dense_mul(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+	}
+}
+
+
+void expr_dense_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_mul_add(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_mul_add(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+#endif
+		default:
+			scalar_dense_mul_add(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+	}
+}
+
+
+void expr_sparse_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t *dim, size_t size){
+	double tmp_inf[INTERVAL_KERNELS_CHUNK];
+	double tmp_sup[INTERVAL_KERNELS_CHUNK];
+	size_t i, j;
+	for(i=0; i < size; i+=INTERVAL_KERNELS_CHUNK){
+		size_t n = size - i < INTERVAL_KERNELS_CHUNK ? size - i : INTERVAL_KERNELS_CHUNK;
+		expr_dense_mul(pr,tmp_inf,tmp_sup,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,n);
+		for(j=0; j < n; j++){
+			size_t k = dim[i+j];
+			interval_accumulate(pr,&res_inf[k],&res_sup[k],tmp_inf[j],tmp_sup[j]);
+		}
+	}
+}
+
+
+void expr_dense_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double *inf_coeff, double *sup_coeff, size_t size){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_add(pr,res_inf,res_sup,inf_coeff,sup_coeff,size);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_add(pr,res_inf,res_sup,inf_coeff,sup_coeff,size);
+			return;
+#endif
+		default:
+			scalar_dense_add(pr,res_inf,res_sup,inf_coeff,sup_coeff,size);
+	}
+}
+
+
+void expr_dense_concretize(double *inf_coeff, double *sup_coeff, double *inf, double *sup, size_t size, double *res_inf, double *res_sup){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_concretize(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_concretize(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+			return;
+#endif
+		default:
+			scalar_dense_concretize(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+	}
+}
+
+
+void expr_dense_mul_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_mul_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_mul_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+#endif
+		default:
+			scalar_dense_mul_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+	}
+}
+
+
+void expr_dense_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_mul_add_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_mul_add_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+			return;
+#endif
+		default:
+			scalar_dense_mul_add_f(pr,res_inf,res_sup,mul_inf,mul_sup,inf_coeff,sup_coeff,size);
+	}
+}
+
+
+void expr_sparse_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t *dim, size_t size){
+	float tmp_inf[INTERVAL_KERNELS_CHUNK];
+	float tmp_sup[INTERVAL_KERNELS_CHUNK];
+	float ulp = INTERVAL_KERNELS_ULP_F;
+	size_t i, j;
+	for(i=0; i < size; i+=INTERVAL_KERNELS_CHUNK){
+		size_t n = size - i < INTERVAL_KERNELS_CHUNK ? size - i : INTERVAL_KERNELS_CHUNK;
+		expr_dense_mul_f(pr,tmp_inf,tmp_sup,mul_inf,mul_sup,inf_coeff+i,sup_coeff+i,n);
+		for(j=0; j < n; j++){
+			size_t k = dim[i+j];
+			if(res_inf[k]==0 && res_sup[k]==0){
+				res_inf[k] = tmp_inf[j];
+				res_sup[k] = tmp_sup[j];
+				continue;
+			}
+			float err = (fmaxf(fabsf(res_inf[k]),fabsf(res_sup[k])) + fmaxf(fabsf(tmp_inf[j]),fabsf(tmp_sup[j])))*ulp;
+			res_inf[k] = res_inf[k] + tmp_inf[j] + err;
+			res_sup[k] = res_sup[k] + tmp_sup[j] + err;
+		}
+	}
+}
+
+
+void expr_dense_concretize_f(const float *inf_coeff, const float *sup_coeff, const float *inf, const float *sup, size_t size, double *res_inf, double *res_sup){
+	switch(interval_kernels_isa()){
+#if defined(INTERVAL_KERNELS_X86)
+		case INTERVAL_KERNELS_AVX512:
+			avx512_dense_concretize_f(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+			return;
+		case INTERVAL_KERNELS_AVX2:
+			avx2_dense_concretize_f(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+			return;
+#endif
+		default:
+			scalar_dense_concretize_f(inf_coeff,sup_coeff,inf,sup,size,res_inf,res_sup);
+	}
+}
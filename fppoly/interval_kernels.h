@@ -0,0 +1,78 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+#ifndef __INTERVAL_KERNELS_H_INCLUDED__
+#define __INTERVAL_KERNELS_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+
+/* Sound interval kernels over contiguous coefficient blocks. Intervals are
+   stored as (-lower, upper) like in expr_t and every result is an upper
+   bound under FE_UPWARD. With VECTOR the AVX2 and AVX-512 versions are
+   picked at runtime from the features of the CPU; they compute the same
+   products as elina_double_interval_mul but take the maximum over all
+   endpoint products instead of branching on signs. */
+
+typedef enum interval_kernels_isa_t{
+	INTERVAL_KERNELS_SCALAR,
+	INTERVAL_KERNELS_AVX2,
+	INTERVAL_KERNELS_AVX512,
+}interval_kernels_isa_t;
+
+/* restricts the kernels to isa (if the CPU supports it), returns the isa in use */
+interval_kernels_isa_t interval_kernels_select(interval_kernels_isa_t isa);
+
+/* res[i] = mul * coeff[i], as elina_double_interval_mul_expr_coeff */
+void expr_dense_mul(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size);
+
+/* res[i] = res[i] + mul * coeff[i], adding to an exact zero is exact */
+void expr_dense_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t size);
+
+/* res[dim[i]] = res[dim[i]] + mul * coeff[i] */
+void expr_sparse_mul_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double mul_inf, double mul_sup, double *inf_coeff, double *sup_coeff, size_t *dim, size_t size);
+
+/* res[i] = res[i] + coeff[i] with the error bound of add_expr */
+void expr_dense_add(fppoly_internal_t *pr, double *res_inf, double *res_sup, double *inf_coeff, double *sup_coeff, size_t size);
+
+/* adds sum_i coeff[i]*[-inf[i], sup[i]] to res_inf and res_sup, either of them may be NULL */
+void expr_dense_concretize(double *inf_coeff, double *sup_coeff, double *inf, double *sup, size_t size, double *res_inf, double *res_sup);
+
+/* single precision versions for the matrix back-substitution, the operands are
+   floats rounded outward and the error terms use the ulp of float */
+void expr_dense_mul_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size);
+
+void expr_dense_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t size);
+
+void expr_sparse_mul_add_f(fppoly_internal_t *pr, float *res_inf, float *res_sup, float mul_inf, float mul_sup, const float *inf_coeff, const float *sup_coeff, size_t *dim, size_t size);
+
+/* the products and the sum are computed in double, res_inf and res_sup must not be NULL */
+void expr_dense_concretize_f(const float *inf_coeff, const float *sup_coeff, const float *inf, const float *sup, size_t size, double *res_inf, double *res_sup);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
@@ -0,0 +1,699 @@
+#include "matrix_backsubstitute.h"
+
+static int matrix_predecessor(fppoly_t *fp, int k){
+	return fp->layers[k]->predecessors[0]-1;
+}
+
+
+static size_t matrix_width(fppoly_t *fp, int k){
+	return k>=0 ? fp->layers[k]->dims : fp->num_pixels;
+}
+
+
+static bool matrix_expr_fits(expr_t *expr, size_t width){
+	size_t i;
+	if(expr==NULL){
+		return false;
+	}
+	if(expr->size==0){
+		return true;
+	}
+	if(expr->inf_coeff==NULL || expr->sup_coeff==NULL){
+		return false;
+	}
+	if(expr->type==DENSE){
+		return expr->size <= width;
+	}
+	for(i=0; i < expr->size; i++){
+		if(expr->dim[i] >= width){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/* band [lo,hi) of the columns an expression can touch */
+static void matrix_expr_band(expr_t *expr, size_t *lo, size_t *hi){
+	size_t i;
+	if(expr->size==0){
+		*lo = 0;
+		*hi = 0;
+		return;
+	}
+	if(expr->type==DENSE){
+		*lo = 0;
+		*hi = expr->size;
+		return;
+	}
+	*lo = expr->dim[0];
+	*hi = expr->dim[0]+1;
+	for(i=1; i < expr->size; i++){
+		if(expr->dim[i] < *lo){
+			*lo = expr->dim[i];
+		}
+		if(expr->dim[i] >= *hi){
+			*hi = expr->dim[i]+1;
+		}
+	}
+}
+
+
+/* only straight chains of layers with per-neuron expressions are handled, concat
+   and residual layers as well as polyhedral input constraints go through the
+   neuron-wise path */
+bool matrix_backsubstitute_supported(fppoly_t *fp, size_t layerno){
+	size_t i;
+	if(fp->input_lexpr!=NULL || fp->input_uexpr!=NULL){
+		return false;
+	}
+#ifdef GUROBI
+	if(fp->spatial_size > 0){
+		return false;
+	}
+#endif
+	layer_t *layer = fp->layers[layerno];
+	if(layer->is_concat || layer->num_predecessors!=1){
+		return false;
+	}
+	int k = matrix_predecessor(fp, layerno);
+	size_t width = matrix_width(fp, k);
+	for(i=0; i < layer->dims; i++){
+		if(!matrix_expr_fits(layer->neurons[i]->lexpr, width) || !matrix_expr_fits(layer->neurons[i]->uexpr, width)){
+			return false;
+		}
+	}
+	while(k >= 0){
+		layer = fp->layers[k];
+		if(layer->is_concat || layer->num_predecessors!=1){
+			return false;
+		}
+		int pk = matrix_predecessor(fp, k);
+		width = matrix_width(fp, pk);
+		if(layer->is_activation && layer->dims!=width){
+			return false;
+		}
+		for(i=0; i < layer->dims; i++){
+			expr_t *lexpr = layer->neurons[i]->lexpr;
+			expr_t *uexpr = layer->neurons[i]->uexpr;
+			if(layer->is_activation){
+				if(lexpr==NULL || uexpr==NULL || lexpr->size==0 || uexpr->size==0 || lexpr->inf_coeff==NULL || uexpr->inf_coeff==NULL){
+					return false;
+				}
+			}
+			else if(!matrix_expr_fits(lexpr, width) || !matrix_expr_fits(uexpr, width)){
+				return false;
+			}
+		}
+		k = pk;
+	}
+	return true;
+}
+
+
+typedef struct matrix_block_t{
+	size_t stride;
+	/* rows are floats in single precision mode, doubles otherwise */
+	bool single;
+	double *cur_inf;
+	double *cur_sup;
+	double *next_inf;
+	double *next_sup;
+	float *cur_inf_f;
+	float *cur_sup_f;
+	float *next_inf_f;
+	float *next_sup_f;
+	double *cst_inf;
+	double *cst_sup;
+	double *res;
+	size_t *lo;
+	size_t *hi;
+	/* bounds of the layer the rows are currently defined over */
+	double *bound_inf;
+	double *bound_sup;
+	float *bound_inf_f;
+	float *bound_sup_f;
+	/* coefficients of the lexpr and uexpr of the column being applied, in float */
+	float *lcoeff_f;
+	float *ucoeff_f;
+	/* bands and constants of the rows being built by an affine step */
+	size_t *nlo;
+	size_t *nhi;
+	double *ncst_inf;
+	double *ncst_sup;
+}matrix_block_t;
+
+
+/* the buffers of a block are carved from one allocation per thread, which is
+   kept for the next chunk and layer and only grows */
+typedef struct matrix_scratch_t{
+	char *data;
+	size_t capacity;
+}matrix_scratch_t;
+
+static __thread matrix_scratch_t *thread_scratch = NULL;
+static pthread_key_t matrix_scratch_key;
+static pthread_once_t matrix_scratch_key_once = PTHREAD_ONCE_INIT;
+
+
+static void matrix_scratch_destroy(void *arg){
+	matrix_scratch_t *scratch = (matrix_scratch_t *)arg;
+	free(scratch->data);
+	free(scratch);
+}
+
+
+static void matrix_scratch_make_key(void){
+	pthread_key_create(&matrix_scratch_key, matrix_scratch_destroy);
+}
+
+
+static char * matrix_scratch_get(size_t bytes){
+	if(thread_scratch==NULL){
+		pthread_once(&matrix_scratch_key_once, matrix_scratch_make_key);
+		matrix_scratch_t *scratch = (matrix_scratch_t *)malloc(sizeof(matrix_scratch_t));
+		scratch->data = NULL;
+		scratch->capacity = 0;
+		/* released by the key destructor when the thread exits */
+		pthread_setspecific(matrix_scratch_key, scratch);
+		thread_scratch = scratch;
+	}
+	if(bytes > thread_scratch->capacity){
+		/* the contents are never kept across calls, so no copy is needed */
+		free(thread_scratch->data);
+		thread_scratch->data = (char *)malloc(bytes);
+		thread_scratch->capacity = bytes;
+	}
+	return thread_scratch->data;
+}
+
+
+/* bytes rounded up so that every buffer starts on a cache line */
+static size_t matrix_scratch_align(size_t bytes){
+	return (bytes + 63) & ~(size_t)63;
+}
+
+
+static void matrix_block_init(matrix_block_t *blk, size_t width, size_t block, bool single){
+	size_t elem = single ? sizeof(float) : sizeof(double);
+	size_t rows_bytes = matrix_scratch_align(4*block*width*elem);
+	size_t bound_bytes = matrix_scratch_align(2*width*sizeof(double));
+	size_t bound_f_bytes = matrix_scratch_align(6*width*sizeof(float));
+	size_t cst_bytes = matrix_scratch_align(5*block*sizeof(double));
+	size_t band_bytes = matrix_scratch_align(4*block*sizeof(size_t));
+	char *next = matrix_scratch_get(rows_bytes + bound_bytes + bound_f_bytes + cst_bytes + band_bytes);
+	blk->stride = width;
+	blk->single = single;
+	blk->cur_inf = NULL;
+	blk->cur_sup = NULL;
+	blk->next_inf = NULL;
+	blk->next_sup = NULL;
+	blk->cur_inf_f = NULL;
+	blk->cur_sup_f = NULL;
+	blk->next_inf_f = NULL;
+	blk->next_sup_f = NULL;
+	if(single){
+		blk->cur_inf_f = (float *)next;
+		blk->cur_sup_f = blk->cur_inf_f + block*width;
+		blk->next_inf_f = blk->cur_sup_f + block*width;
+		blk->next_sup_f = blk->next_inf_f + block*width;
+	}
+	else{
+		blk->cur_inf = (double *)next;
+		blk->cur_sup = blk->cur_inf + block*width;
+		blk->next_inf = blk->cur_sup + block*width;
+		blk->next_sup = blk->next_inf + block*width;
+	}
+	next += rows_bytes;
+	blk->bound_inf = (double *)next;
+	blk->bound_sup = blk->bound_inf + width;
+	next += bound_bytes;
+	blk->bound_inf_f = (float *)next;
+	blk->bound_sup_f = blk->bound_inf_f + width;
+	blk->lcoeff_f = blk->bound_sup_f + width;
+	blk->ucoeff_f = blk->lcoeff_f + 2*width;
+	next += bound_f_bytes;
+	blk->cst_inf = (double *)next;
+	blk->cst_sup = blk->cst_inf + block;
+	blk->res = blk->cst_sup + block;
+	blk->ncst_inf = blk->res + block;
+	blk->ncst_sup = blk->ncst_inf + block;
+	next += cst_bytes;
+	blk->lo = (size_t *)next;
+	blk->hi = blk->lo + block;
+	blk->nlo = blk->hi + block;
+	blk->nhi = blk->nlo + block;
+}
+
+
+static inline void matrix_block_get(matrix_block_t *blk, size_t r, size_t j, double *c_inf, double *c_sup){
+	if(blk->single){
+		*c_inf = blk->cur_inf_f[r*blk->stride + j];
+		*c_sup = blk->cur_sup_f[r*blk->stride + j];
+	}
+	else{
+		*c_inf = blk->cur_inf[r*blk->stride + j];
+		*c_sup = blk->cur_sup[r*blk->stride + j];
+	}
+}
+
+
+/* under FE_UPWARD the conversion to float rounds both -lower and upper up */
+static inline void matrix_block_set(matrix_block_t *blk, size_t r, size_t j, double c_inf, double c_sup){
+	if(blk->single){
+		blk->cur_inf_f[r*blk->stride + j] = (float)c_inf;
+		blk->cur_sup_f[r*blk->stride + j] = (float)c_sup;
+	}
+	else{
+		blk->cur_inf[r*blk->stride + j] = c_inf;
+		blk->cur_sup[r*blk->stride + j] = c_sup;
+	}
+}
+
+
+static void matrix_block_swap(matrix_block_t *blk){
+	double *tmp = blk->cur_inf;
+	blk->cur_inf = blk->next_inf;
+	blk->next_inf = tmp;
+	tmp = blk->cur_sup;
+	blk->cur_sup = blk->next_sup;
+	blk->next_sup = tmp;
+	float *tmp_f = blk->cur_inf_f;
+	blk->cur_inf_f = blk->next_inf_f;
+	blk->next_inf_f = tmp_f;
+	tmp_f = blk->cur_sup_f;
+	blk->cur_sup_f = blk->next_sup_f;
+	blk->next_sup_f = tmp_f;
+}
+
+
+static void matrix_coeff_to_float(float *dst, double *src, size_t size){
+	size_t i;
+	for(i=0; i < size; i++){
+		dst[i] = (float)src[i];
+	}
+}
+
+
+/* the weights are rounded to float when a block applies them, so no float copy
+   of a layer is kept next to its expressions; the rounding mode is upward, which
+   rounds both the negated lower and the upper coefficient outward */
+static float * matrix_expr_to_float(float *dst, size_t stride, expr_t *expr){
+	matrix_coeff_to_float(dst, expr->inf_coeff, expr->size);
+	matrix_coeff_to_float(dst + stride, expr->sup_coeff, expr->size);
+	return dst;
+}
+
+
+static void matrix_block_concretize_f(matrix_block_t *blk, size_t nb, fppoly_t *fp, int k, bool is_lower, size_t ulo, size_t uhi){
+	size_t r, j;
+	neuron_t *neurons = k>=0 ? fp->layers[k]->neuron_block : NULL;
+	for(j=ulo; j < uhi; j++){
+		blk->bound_inf_f[j] = (float)(k>=0 ? neurons[j].lb : fp->input_inf[j]);
+		blk->bound_sup_f[j] = (float)(k>=0 ? neurons[j].ub : fp->input_sup[j]);
+	}
+	for(r=0; r < nb; r++){
+		double res_inf = blk->cst_inf[r];
+		double res_sup = blk->cst_sup[r];
+		size_t lo = blk->lo[r];
+		if(lo < blk->hi[r]){
+			expr_dense_concretize_f(blk->cur_inf_f + r*blk->stride + lo, blk->cur_sup_f + r*blk->stride + lo, blk->bound_inf_f + lo, blk->bound_sup_f + lo, blk->hi[r] - lo, &res_inf, &res_sup);
+		}
+		blk->res[r] = fmin(blk->res[r], is_lower ? res_inf : res_sup);
+	}
+}
+
+
+/* min over the layers of the concretized rows, as in get_lb/ub_using_previous_layers */
+static void matrix_block_concretize(matrix_block_t *blk, size_t nb, fppoly_t *fp, int k, bool is_lower){
+	size_t r, j, ulo = SIZE_MAX, uhi = 0;
+	for(r=0; r < nb; r++){
+		if(blk->lo[r] < blk->hi[r]){
+			ulo = blk->lo[r] < ulo ? blk->lo[r] : ulo;
+			uhi = blk->hi[r] > uhi ? blk->hi[r] : uhi;
+		}
+	}
+	if(blk->single){
+		matrix_block_concretize_f(blk, nb, fp, k, is_lower, ulo, uhi);
+		return;
+	}
+	double *inf, *sup;
+	if(k>=0){
+		neuron_t *neurons = fp->layers[k]->neuron_block;
+		for(j=ulo; j < uhi; j++){
+			blk->bound_inf[j] = neurons[j].lb;
+			blk->bound_sup[j] = neurons[j].ub;
+		}
+		inf = blk->bound_inf;
+		sup = blk->bound_sup;
+	}
+	else{
+		inf = fp->input_inf;
+		sup = fp->input_sup;
+	}
+	for(r=0; r < nb; r++){
+		double res_inf = blk->cst_inf[r];
+		double res_sup = blk->cst_sup[r];
+		size_t lo = blk->lo[r];
+		if(lo < blk->hi[r]){
+			expr_dense_concretize(blk->cur_inf + r*blk->stride + lo, blk->cur_sup + r*blk->stride + lo, inf + lo, sup + lo, blk->hi[r] - lo, &res_inf, &res_sup);
+		}
+		blk->res[r] = fmin(blk->res[r], is_lower ? res_inf : res_sup);
+	}
+}
+
+
+/* the activation relaxations only scale every column, see expr_replace_bounds_activation */
+static void matrix_block_replace_activation(fppoly_internal_t *pr, matrix_block_t *blk, size_t nb, neuron_t **neurons, bool is_lower){
+	size_t r, j;
+	for(r=0; r < nb; r++){
+		for(j=blk->lo[r]; j < blk->hi[r]; j++){
+			double c_inf, c_sup;
+			matrix_block_get(blk, r, j, &c_inf, &c_sup);
+			if(c_sup==0 && c_inf==0){
+				matrix_block_set(blk, r, j, 0.0, 0.0);
+				continue;
+			}
+			neuron_t *neuron_j = neurons[j];
+			double tmp1, tmp2;
+			if(c_sup < 0 || c_inf < 0){
+				expr_t *mul_expr = (is_lower == (c_sup < 0)) ? neuron_j->uexpr : neuron_j->lexpr;
+				elina_double_interval_mul_expr_coeff(pr,&tmp1,&tmp2,mul_expr->inf_coeff[0],mul_expr->sup_coeff[0],c_inf,c_sup);
+				matrix_block_set(blk, r, j, tmp1, tmp2);
+				elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,mul_expr->inf_cst,mul_expr->sup_cst,c_inf,c_sup);
+				blk->cst_inf[r] = blk->cst_inf[r] + tmp1 + pr->min_denormal;
+				blk->cst_sup[r] = blk->cst_sup[r] + tmp2 + pr->min_denormal;
+			}
+			else{
+				matrix_block_set(blk, r, j, 0.0, 0.0);
+				elina_double_interval_mul_expr_coeff(pr,&tmp1,&tmp2,neuron_j->lb,neuron_j->ub,c_inf,c_sup);
+				if(is_lower){
+					blk->cst_inf[r] = blk->cst_inf[r] + tmp1;
+					blk->cst_sup[r] = blk->cst_sup[r] - tmp1;
+				}
+				else{
+					blk->cst_inf[r] = blk->cst_inf[r] - tmp2;
+					blk->cst_sup[r] = blk->cst_sup[r] + tmp2;
+				}
+			}
+		}
+	}
+}
+
+
+/* next = cur * (lexpr/uexpr of layer k), see expr_replace_bounds_affine. The loop
+   runs over the columns of cur so that every predecessor expression is applied
+   to all rows of the block while it is in cache */
+static void matrix_block_replace_affine(fppoly_internal_t *pr, matrix_block_t *blk, size_t nb, layer_t *layer, bool is_lower){
+	size_t r, j;
+	neuron_t **neurons = layer->neurons;
+	size_t num_neurons = layer->dims;
+	size_t ulo = SIZE_MAX, uhi = 0;
+	size_t *nlo = blk->nlo;
+	size_t *nhi = blk->nhi;
+	double *ncst_inf = blk->ncst_inf;
+	double *ncst_sup = blk->ncst_sup;
+	for(r=0; r < nb; r++){
+		nlo[r] = SIZE_MAX;
+		nhi[r] = 0;
+		ncst_inf[r] = 0.0;
+		ncst_sup[r] = 0.0;
+		if(blk->lo[r] < blk->hi[r]){
+			ulo = blk->lo[r] < ulo ? blk->lo[r] : ulo;
+			uhi = blk->hi[r] > uhi ? blk->hi[r] : uhi;
+		}
+	}
+	if(uhi > num_neurons){
+		uhi = num_neurons;
+	}
+	/* bands of the rows after substitution */
+	for(j=ulo; j < uhi; j++){
+		size_t llo, lhi, hlo, hhi;
+		matrix_expr_band(neurons[j]->lexpr, &llo, &lhi);
+		matrix_expr_band(neurons[j]->uexpr, &hlo, &hhi);
+		for(r=0; r < nb; r++){
+			if(j < blk->lo[r] || j >= blk->hi[r]){
+				continue;
+			}
+			double c_inf, c_sup;
+			matrix_block_get(blk, r, j, &c_inf, &c_sup);
+			if(!(c_sup < 0 || c_inf < 0)){
+				continue;
+			}
+			bool use_uexpr = (is_lower == (c_sup < 0));
+			size_t lo = use_uexpr ? hlo : llo;
+			size_t hi = use_uexpr ? hhi : lhi;
+			if(lo < hi){
+				nlo[r] = lo < nlo[r] ? lo : nlo[r];
+				nhi[r] = hi > nhi[r] ? hi : nhi[r];
+			}
+		}
+	}
+	for(r=0; r < nb; r++){
+		if(nlo[r] >= nhi[r]){
+			nlo[r] = 0;
+			nhi[r] = 0;
+		}
+		size_t i;
+		if(blk->single){
+			for(i=nlo[r]; i < nhi[r]; i++){
+				blk->next_inf_f[r*blk->stride + i] = 0.0f;
+				blk->next_sup_f[r*blk->stride + i] = 0.0f;
+			}
+			continue;
+		}
+		for(i=nlo[r]; i < nhi[r]; i++){
+			blk->next_inf[r*blk->stride + i] = 0.0;
+			blk->next_sup[r*blk->stride + i] = 0.0;
+		}
+	}
+	for(j=ulo; j < uhi; j++){
+		neuron_t *neuron_j = neurons[j];
+		float *lexpr_f = NULL;
+		float *uexpr_f = NULL;
+		for(r=0; r < nb; r++){
+			if(j < blk->lo[r] || j >= blk->hi[r]){
+				continue;
+			}
+			double c_inf, c_sup;
+			matrix_block_get(blk, r, j, &c_inf, &c_sup);
+			if(c_sup==0 && c_inf==0){
+				continue;
+			}
+			double tmp1, tmp2;
+			if(c_sup < 0 || c_inf < 0){
+				bool use_uexpr = (is_lower == (c_sup < 0));
+				expr_t *mul_expr = use_uexpr ? neuron_j->uexpr : neuron_j->lexpr;
+				if(mul_expr->size > 0 && blk->single){
+					float *coeff_f;
+					if(use_uexpr){
+						if(uexpr_f==NULL){
+							uexpr_f = neuron_j->uexpr==neuron_j->lexpr && lexpr_f!=NULL ? lexpr_f : matrix_expr_to_float(blk->ucoeff_f, blk->stride, mul_expr);
+						}
+						coeff_f = uexpr_f;
+					}
+					else{
+						if(lexpr_f==NULL){
+							lexpr_f = neuron_j->uexpr==neuron_j->lexpr && uexpr_f!=NULL ? uexpr_f : matrix_expr_to_float(blk->lcoeff_f, blk->stride, mul_expr);
+						}
+						coeff_f = lexpr_f;
+					}
+					float *row_inf = blk->next_inf_f + r*blk->stride;
+					float *row_sup = blk->next_sup_f + r*blk->stride;
+					if(mul_expr->type==DENSE){
+						expr_dense_mul_add_f(pr,row_inf,row_sup,c_inf,c_sup,coeff_f,coeff_f + blk->stride,mul_expr->size);
+					}
+					else{
+						expr_sparse_mul_add_f(pr,row_inf,row_sup,c_inf,c_sup,coeff_f,coeff_f + blk->stride,mul_expr->dim,mul_expr->size);
+					}
+				}
+				else if(mul_expr->size > 0){
+					double *row_inf = blk->next_inf + r*blk->stride;
+					double *row_sup = blk->next_sup + r*blk->stride;
+					if(mul_expr->type==DENSE){
+						expr_dense_mul_add(pr,row_inf,row_sup,c_inf,c_sup,mul_expr->inf_coeff,mul_expr->sup_coeff,mul_expr->size);
+					}
+					else{
+						expr_sparse_mul_add(pr,row_inf,row_sup,c_inf,c_sup,mul_expr->inf_coeff,mul_expr->sup_coeff,mul_expr->dim,mul_expr->size);
+					}
+				}
+				elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,c_inf,c_sup,mul_expr->inf_cst,mul_expr->sup_cst);
+				expr_interval_accumulate_cst(pr,&ncst_inf[r],&ncst_sup[r],tmp1,tmp2);
+			}
+			else{
+				elina_double_interval_mul_cst_coeff(pr,&tmp1,&tmp2,neuron_j->lb,neuron_j->ub,c_inf,c_sup);
+				if(is_lower){
+					ncst_inf[r] = ncst_inf[r] + tmp1;
+					ncst_sup[r] = ncst_sup[r] - tmp1;
+				}
+				else{
+					ncst_inf[r] = ncst_inf[r] - tmp2;
+					ncst_sup[r] = ncst_sup[r] + tmp2;
+				}
+			}
+		}
+	}
+	for(r=0; r < nb; r++){
+		blk->cst_inf[r] = ncst_inf[r] + blk->cst_inf[r];
+		blk->cst_sup[r] = ncst_sup[r] + blk->cst_sup[r];
+		blk->lo[r] = nlo[r];
+		blk->hi[r] = nhi[r];
+	}
+	matrix_block_swap(blk);
+}
+
+
+static expr_t * matrix_block_row_to_expr(matrix_block_t *blk, size_t r, size_t width){
+	size_t i, nnz = 0;
+	double c_inf, c_sup;
+	for(i=blk->lo[r]; i < blk->hi[r]; i++){
+		matrix_block_get(blk, r, i, &c_inf, &c_sup);
+		if(c_inf!=0 || c_sup!=0){
+			nnz++;
+		}
+	}
+	expr_t *res = (expr_t *)malloc(sizeof(expr_t));
+	res->inf_cst = blk->cst_inf[r];
+	res->sup_cst = blk->cst_sup[r];
+	res->refcount = 1;
+	res->borrowed = false;
+	if(2*nnz < width){
+		res->type = SPARSE;
+		res->size = nnz;
+		res->inf_coeff = nnz ? (double *)malloc(nnz*sizeof(double)) : NULL;
+		res->sup_coeff = nnz ? (double *)malloc(nnz*sizeof(double)) : NULL;
+		res->dim = nnz ? (size_t *)malloc(nnz*sizeof(size_t)) : NULL;
+		size_t l = 0;
+		for(i=blk->lo[r]; i < blk->hi[r]; i++){
+			matrix_block_get(blk, r, i, &c_inf, &c_sup);
+			if(c_inf!=0 || c_sup!=0){
+				res->inf_coeff[l] = c_inf;
+				res->sup_coeff[l] = c_sup;
+				res->dim[l] = i;
+				l++;
+			}
+		}
+	}
+	else{
+		res->type = DENSE;
+		res->size = width;
+		res->dim = NULL;
+		res->inf_coeff = (double *)calloc(width,sizeof(double));
+		res->sup_coeff = (double *)calloc(width,sizeof(double));
+		for(i=blk->lo[r]; i < blk->hi[r]; i++){
+			matrix_block_get(blk, r, i, &res->inf_coeff[i], &res->sup_coeff[i]);
+		}
+	}
+	return res;
+}
+
+
+static void matrix_backsubstitute_block(fppoly_internal_t *pr, fppoly_t *fp, size_t layerno, size_t start, size_t nb, matrix_block_t *blk, bool is_lower){
+	size_t r, i;
+	neuron_t **out_neurons = fp->layers[layerno]->neurons;
+	int k = matrix_predecessor(fp, layerno);
+	for(r=0; r < nb; r++){
+		expr_t *expr = is_lower ? out_neurons[start+r]->lexpr : out_neurons[start+r]->uexpr;
+		blk->cst_inf[r] = expr->inf_cst;
+		blk->cst_sup[r] = expr->sup_cst;
+		blk->res[r] = INFINITY;
+		matrix_expr_band(expr, &blk->lo[r], &blk->hi[r]);
+		for(i=blk->lo[r]; i < blk->hi[r]; i++){
+			matrix_block_set(blk, r, i, 0.0, 0.0);
+		}
+		for(i=0; i < expr->size; i++){
+			size_t j = expr->type==DENSE ? i : expr->dim[i];
+			matrix_block_set(blk, r, j, expr->inf_coeff[i], expr->sup_coeff[i]);
+		}
+	}
+	while(k >= 0){
+		layer_t *layer = fp->layers[k];
+		matrix_block_concretize(blk, nb, fp, k, is_lower);
+		if(layer->is_activation){
+			matrix_block_replace_activation(pr, blk, nb, layer->neurons, is_lower);
+		}
+		else{
+			matrix_block_replace_affine(pr, blk, nb, layer, is_lower);
+		}
+		k = matrix_predecessor(fp, k);
+	}
+	matrix_block_concretize(blk, nb, fp, -1, is_lower);
+	for(r=0; r < nb; r++){
+		expr_t *expr = matrix_block_row_to_expr(blk, r, fp->num_pixels);
+		neuron_t *neuron = out_neurons[start+r];
+		// a layer that is analysed again replaces its back-substituted expressions
+		if(is_lower){
+			neuron->lb = blk->res[r];
+			if(neuron->backsubstituted_lexpr){
+				free_expr(neuron->backsubstituted_lexpr);
+			}
+			neuron->backsubstituted_lexpr = expr;
+		}
+		else{
+			neuron->ub = blk->res[r];
+			if(neuron->backsubstituted_uexpr){
+				free_expr(neuron->backsubstituted_uexpr);
+			}
+			neuron->backsubstituted_uexpr = expr;
+		}
+	}
+}
+
+
+static size_t matrix_max_width(fppoly_t *fp, size_t layerno){
+	int k = matrix_predecessor(fp, layerno);
+	size_t width = fp->num_pixels;
+	while(k >= 0){
+		width = fp->layers[k]->dims > width ? fp->layers[k]->dims : width;
+		k = matrix_predecessor(fp, k);
+	}
+	return width;
+}
+
+
+/* float rows take half the bytes, so twice as many fit in the same scratch and cache */
+static size_t matrix_block_size(size_t width, bool single){
+	size_t elem = single ? sizeof(float) : sizeof(double);
+	size_t nb = MATRIX_BACKSUBSTITUTE_SCRATCH/(4*width*elem);
+	if(nb > MATRIX_BACKSUBSTITUTE_BLOCK*sizeof(double)/elem){
+		nb = MATRIX_BACKSUBSTITUTE_BLOCK*sizeof(double)/elem;
+	}
+	return nb ? nb : 1;
+}
+
+
+static void * matrix_backsubstitute_thread(void *args){
+	nn_thread_t *data = (nn_thread_t *)args;
+	fppoly_t *fp = data->fp;
+	fppoly_internal_t *pr = fppoly_init_from_manager(data->man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	size_t layerno = data->layerno;
+	size_t width = matrix_max_width(fp, layerno);
+	size_t block = matrix_block_size(width, pr->single_precision);
+	matrix_block_t blk;
+	matrix_block_init(&blk, width, block, pr->single_precision);
+	size_t start;
+	for(start=data->start; start < data->end; start += block){
+		size_t nb = data->end - start < block ? data->end - start : block;
+		matrix_backsubstitute_block(pr, fp, layerno, start, nb, &blk, true);
+		matrix_backsubstitute_block(pr, fp, layerno, start, nb, &blk, false);
+	}
+	return NULL;
+}
+
+
+void matrix_backsubstitute_layer(elina_manager_t *man, fppoly_t *fp, size_t layerno){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	size_t num_out_neurons = fp->layers[layerno]->dims;
+	nn_thread_t arg;
+	arg.start = 0;
+	arg.end = num_out_neurons;
+	arg.man = man;
+	arg.fp = fp;
+	arg.layerno = layerno;
+	arg.k = 0;
+	arg.linexpr0 = NULL;
+	arg.res = NULL;
+	arg.data = NULL;
+	size_t block = matrix_block_size(matrix_max_width(fp, layerno), pr->single_precision);
+	fppoly_thread_pool_run_range(pr->pool, matrix_backsubstitute_thread, &arg, num_out_neurons, block);
+}
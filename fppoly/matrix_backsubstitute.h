@@ -0,0 +1,53 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+#ifndef __MATRIX_BACKSUBSTITUTE_H_INCLUDED__
+#define __MATRIX_BACKSUBSTITUTE_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "backsubstitute.h"
+
+/* Back-substitutes a block of neurons of one layer together. The expressions of
+   the block are kept as dense interval rows and multiplied through the
+   predecessor layers column by column, so that every predecessor expression is
+   loaded once per block instead of once per neuron. Rows only cover the band
+   of columns that can be non-zero, which keeps conv layers cheap. */
+
+/* neurons back-substituted together */
+#define MATRIX_BACKSUBSTITUTE_BLOCK 32
+
+/* scratch bytes per thread for the rows of one block, the scratch is kept by
+   each pool worker and reused across chunks and layers */
+#define MATRIX_BACKSUBSTITUTE_SCRATCH (16UL << 20)
+
+bool matrix_backsubstitute_supported(fppoly_t *fp, size_t layerno);
+
+void matrix_backsubstitute_layer(elina_manager_t *man, fppoly_t *fp, size_t layerno);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
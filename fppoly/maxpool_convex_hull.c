@@ -106,6 +106,341 @@ _L99:
 	return A;
 }
 
+/* cdd keeps its arithmetic constants in globals */
+static pthread_mutex_t maxpool_cdd_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+typedef struct maxpool_hull_entry_t{
+	size_t pool_size;
+	/* sorted lower bounds followed by the upper bounds in the same order */
+	double *key;
+	bool found;
+	double *coeff;
+	double cst;
+	size_t hash;
+	struct maxpool_hull_entry_t *next_in_bucket;
+	struct maxpool_hull_entry_t *prev;
+	struct maxpool_hull_entry_t *next;
+}maxpool_hull_entry_t;
+
+
+struct maxpool_hull_cache_t{
+	size_t capacity;
+	size_t size;
+	size_t num_buckets;
+	maxpool_hull_entry_t **buckets;
+	/* most recently used first */
+	maxpool_hull_entry_t *head;
+	maxpool_hull_entry_t *tail;
+	pthread_mutex_t lock;
+};
+
+
+maxpool_hull_cache_t * maxpool_hull_cache_alloc(size_t capacity){
+	maxpool_hull_cache_t *cache = (maxpool_hull_cache_t *)malloc(sizeof(struct maxpool_hull_cache_t));
+	cache->capacity = capacity;
+	cache->size = 0;
+	cache->num_buckets = 2*capacity + 1;
+	cache->buckets = (maxpool_hull_entry_t **)calloc(cache->num_buckets,sizeof(maxpool_hull_entry_t *));
+	cache->head = NULL;
+	cache->tail = NULL;
+	pthread_mutex_init(&cache->lock,NULL);
+	return cache;
+}
+
+
+static void maxpool_hull_entry_free(maxpool_hull_entry_t *entry){
+	free(entry->key);
+	free(entry->coeff);
+	free(entry);
+}
+
+
+void maxpool_hull_cache_free(maxpool_hull_cache_t *cache){
+	if(cache==NULL){
+		return;
+	}
+	maxpool_hull_entry_t *entry = cache->head;
+	while(entry!=NULL){
+		maxpool_hull_entry_t *next = entry->next;
+		maxpool_hull_entry_free(entry);
+		entry = next;
+	}
+	pthread_mutex_destroy(&cache->lock);
+	free(cache->buckets);
+	free(cache);
+}
+
+
+static size_t maxpool_hull_hash(double *key, size_t pool_size){
+	size_t hash = 14695981039346656037UL;
+	const unsigned char *bytes = (const unsigned char *)key;
+	size_t i, n = 2*pool_size*sizeof(double);
+	for(i=0; i < n; i++){
+		hash = (hash ^ bytes[i])*1099511628211UL;
+	}
+	return hash ^ pool_size;
+}
+
+
+static void maxpool_hull_unlink(maxpool_hull_cache_t *cache, maxpool_hull_entry_t *entry){
+	if(entry->prev!=NULL){
+		entry->prev->next = entry->next;
+	}
+	else{
+		cache->head = entry->next;
+	}
+	if(entry->next!=NULL){
+		entry->next->prev = entry->prev;
+	}
+	else{
+		cache->tail = entry->prev;
+	}
+}
+
+
+static void maxpool_hull_push_front(maxpool_hull_cache_t *cache, maxpool_hull_entry_t *entry){
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if(cache->head!=NULL){
+		cache->head->prev = entry;
+	}
+	cache->head = entry;
+	if(cache->tail==NULL){
+		cache->tail = entry;
+	}
+}
+
+
+/* copies the entry out under the lock, the entry itself may be evicted afterwards */
+static bool maxpool_hull_lookup(maxpool_hull_cache_t *cache, double *key, size_t pool_size, size_t hash, bool *found, double *coeff, double *cst){
+	bool hit = false;
+	pthread_mutex_lock(&cache->lock);
+	maxpool_hull_entry_t *entry = cache->buckets[hash % cache->num_buckets];
+	while(entry!=NULL){
+		if(entry->hash==hash && entry->pool_size==pool_size && !memcmp(entry->key,key,2*pool_size*sizeof(double))){
+			*found = entry->found;
+			if(entry->found){
+				memcpy(coeff,entry->coeff,pool_size*sizeof(double));
+				*cst = entry->cst;
+			}
+			maxpool_hull_unlink(cache,entry);
+			maxpool_hull_push_front(cache,entry);
+			hit = true;
+			break;
+		}
+		entry = entry->next_in_bucket;
+	}
+	pthread_mutex_unlock(&cache->lock);
+	return hit;
+}
+
+
+static void maxpool_hull_remove_from_bucket(maxpool_hull_cache_t *cache, maxpool_hull_entry_t *entry){
+	maxpool_hull_entry_t **link = &cache->buckets[entry->hash % cache->num_buckets];
+	while(*link!=entry){
+		link = &(*link)->next_in_bucket;
+	}
+	*link = entry->next_in_bucket;
+}
+
+
+static void maxpool_hull_insert(maxpool_hull_cache_t *cache, double *key, size_t pool_size, size_t hash, bool found, double *coeff, double cst){
+	if(cache->capacity==0){
+		return;
+	}
+	maxpool_hull_entry_t *entry = (maxpool_hull_entry_t *)malloc(sizeof(maxpool_hull_entry_t));
+	entry->pool_size = pool_size;
+	entry->key = (double *)malloc(2*pool_size*sizeof(double));
+	memcpy(entry->key,key,2*pool_size*sizeof(double));
+	entry->found = found;
+	entry->coeff = NULL;
+	entry->cst = cst;
+	if(found){
+		entry->coeff = (double *)malloc(pool_size*sizeof(double));
+		memcpy(entry->coeff,coeff,pool_size*sizeof(double));
+	}
+	entry->hash = hash;
+	pthread_mutex_lock(&cache->lock);
+	/* another thread may have computed the same window meanwhile */
+	maxpool_hull_entry_t *other = cache->buckets[hash % cache->num_buckets];
+	while(other!=NULL){
+		if(other->hash==hash && other->pool_size==pool_size && !memcmp(other->key,key,2*pool_size*sizeof(double))){
+			break;
+		}
+		other = other->next_in_bucket;
+	}
+	if(other!=NULL){
+		pthread_mutex_unlock(&cache->lock);
+		maxpool_hull_entry_free(entry);
+		return;
+	}
+	if(cache->size==cache->capacity){
+		maxpool_hull_entry_t *victim = cache->tail;
+		maxpool_hull_unlink(cache,victim);
+		maxpool_hull_remove_from_bucket(cache,victim);
+		maxpool_hull_entry_free(victim);
+		cache->size--;
+	}
+	size_t bucket = hash % cache->num_buckets;
+	entry->next_in_bucket = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+	maxpool_hull_push_front(cache,entry);
+	cache->size++;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+
+size_t maxpool_hull_cache_size(maxpool_hull_cache_t *cache){
+	pthread_mutex_lock(&cache->lock);
+	size_t size = cache->size;
+	pthread_mutex_unlock(&cache->lock);
+	return size;
+}
+
+
+/* among the rows of the hull bounding y from above and depending on x, picks the
+   one with the smallest maximum over the box */
+static bool maxpool_select_upper_face(dd_MatrixPtr M, double *lb, double *ub, size_t pool_size, double max_u, double *coeff, double *cst){
+	size_t i, j;
+	bool rel_flag = false;
+	size_t rel_index = 0;
+	double best_val = INFINITY;
+	size_t nbrows = M->rowsize;
+	for(i=0; i < nbrows; i++){
+		double Miy = dd_get_d(M->matrix[i][pool_size+1]);
+		if(Miy<0){
+			double div = -Miy;
+			double val = dd_get_d(M->matrix[i][0])/div;
+			bool rel_cons = false;
+			for(j=0; j < pool_size; j++){
+				double Mij = dd_get_d(M->matrix[i][j+1])/div;
+				if(Mij<0){
+					rel_cons = true;
+					val = val + Mij*lb[j];
+				}
+				else if (Mij>0){
+					rel_cons = true;
+					val = val + Mij*ub[j];
+				}
+			}
+			if(rel_cons && val<best_val){
+				rel_flag = true;
+				rel_index = i;
+				best_val = val;
+			}
+		}
+	}
+	if(!rel_flag || fabs(best_val-max_u)>=0.01){
+		return false;
+	}
+	double div = -dd_get_d(M->matrix[rel_index][pool_size+1]);
+	for(j=0; j < pool_size; j++){
+		coeff[j] = dd_get_d(M->matrix[rel_index][j+1])/div;
+	}
+	*cst = dd_get_d(M->matrix[rel_index][0])/div;
+	return true;
+}
+
+
+bool maxpool_hull_upper_face(double *lb, double *ub, size_t pool_size, double *coeff, double *cst){
+	size_t i;
+	double max_u = -INFINITY;
+	for(i=0; i < pool_size; i++){
+		max_u = fmax(max_u, ub[i]);
+	}
+	bool found = false;
+	pthread_mutex_lock(&maxpool_cdd_lock);
+	dd_MatrixPtr M = maxpool_deeppoly_approx(lb,ub,pool_size);
+	if(M!=NULL){
+		found = maxpool_select_upper_face(M,lb,ub,pool_size,max_u,coeff,cst);
+		dd_FreeMatrix(M);
+	}
+	pthread_mutex_unlock(&maxpool_cdd_lock);
+	return found;
+}
+
+
+bool maxpool_upper_face(maxpool_hull_cache_t *cache, double *lb, double *ub, size_t pool_size, double *coeff, double *cst){
+	size_t i, j;
+	if(pool_size==0){
+		return false;
+	}
+	size_t top = 0, num_top = 0;
+	double max_u = -INFINITY;
+	bool degenerate = false;
+	for(i=0; i < pool_size; i++){
+		if(ub[i]>max_u){
+			max_u = ub[i];
+			top = i;
+			num_top = 1;
+		}
+		else if(ub[i]==max_u){
+			num_top++;
+		}
+		degenerate = degenerate || (lb[i]==ub[i]);
+	}
+	if(num_top==1 && !degenerate){
+		/* y <= max(x_top, m) is convex in x_top, the chord through its values at
+		   lb[top] and ub[top] is the facet, cst is rounded up at both ends */
+		double m = lb[top];
+		for(i=0; i < pool_size; i++){
+			if(i!=top && ub[i]>m){
+				m = ub[i];
+			}
+		}
+		double slope = (max_u - m)/(ub[top] - lb[top]);
+		for(i=0; i < pool_size; i++){
+			coeff[i] = 0;
+		}
+		coeff[top] = slope;
+		*cst = fmax(max_u + slope*(-ub[top]), m + slope*(-lb[top]));
+		return true;
+	}
+	if(pool_size>MAXPOOL_HULL_MAX_POOL_SIZE){
+		return false;
+	}
+
+	/* the hull only depends on the bounds as a multiset: cdd always runs on the
+	   window sorted by its bounds, so permutations of a window share one cache
+	   entry and get the same face with or without the cache */
+	size_t *perm = (size_t *)malloc(pool_size*sizeof(size_t));
+	for(i=0; i < pool_size; i++){
+		size_t p = i;
+		for(j=i; j > 0; j--){
+			size_t q = perm[j-1];
+			if(lb[q] < lb[p] || (lb[q]==lb[p] && ub[q] <= ub[p])){
+				break;
+			}
+			perm[j] = q;
+		}
+		perm[j] = p;
+	}
+	double *key = (double *)malloc(2*pool_size*sizeof(double));
+	double *sorted_coeff = (double *)malloc(pool_size*sizeof(double));
+	for(i=0; i < pool_size; i++){
+		key[i] = lb[perm[i]];
+		key[pool_size+i] = ub[perm[i]];
+	}
+	size_t hash = maxpool_hull_hash(key,pool_size);
+	bool found = false;
+	if(cache==NULL || !maxpool_hull_lookup(cache,key,pool_size,hash,&found,sorted_coeff,cst)){
+		found = maxpool_hull_upper_face(key,key+pool_size,pool_size,sorted_coeff,cst);
+		if(cache!=NULL){
+			maxpool_hull_insert(cache,key,pool_size,hash,found,sorted_coeff,found ? *cst : 0);
+		}
+	}
+	if(found){
+		for(i=0; i < pool_size; i++){
+			coeff[perm[i]] = sorted_coeff[i];
+		}
+	}
+	free(perm);
+	free(key);
+	free(sorted_coeff);
+	return found;
+}
+
 //int main(){
 //	size_t pool_size = 10;
 //	double lb[pool_size], ub[pool_size];
@@ -7,12 +7,49 @@ extern "C" {
 #endif
 
 
+#include <pthread.h>
+#include "fppoly.h"
 #include "setoper.h"
 #include "cdd.h"
 
 
 dd_MatrixPtr maxpool_deeppoly_approx(double *lb, double * ub, size_t pool_size);
 
+/* largest pool window handed to cdd */
+#define MAXPOOL_HULL_MAX_POOL_SIZE 10
+
+/* pool windows remembered per manager */
+#define MAXPOOL_HULL_CACHE_SIZE 4096
+
+maxpool_hull_cache_t * maxpool_hull_cache_alloc(size_t capacity);
+
+void maxpool_hull_cache_free(maxpool_hull_cache_t *cache);
+
+size_t maxpool_hull_cache_size(maxpool_hull_cache_t *cache);
+
+/* the face maxpool_upper_face looks for, computed by cdd on the window in the
+   given order, without the closed form or the cache */
+bool maxpool_hull_upper_face(double *lb, double *ub, size_t pool_size, double *coeff, double *cst);
+
+/* Finds the face y <= cst + sum_i coeff[i]*x_i of the convex hull of y = max(x)
+   over the box [lb, ub] that has the smallest maximum over the box, among the
+   faces that depend on x. Returns false when there is none within 0.01 of
+   max(ub).
+   When the largest upper bound is attained by a single input this face is
+   y <= m + (max(ub) - m)*(x_i - lb_i)/(ub_i - lb_i), with m the largest of lb_i
+   and the other upper bounds, for windows of any size: no other face reaches
+   max(ub) as its maximum. The slope and the constant are computed in double in
+   the current rounding mode, and the constant is the larger of its values at
+   the two ends of the chord. Under the upward rounding fppoly runs with the
+   face is valid, but it may differ in the last bits from the one cdd gives,
+   whose exact coefficients are divided in double afterwards.
+   Otherwise windows larger than MAXPOOL_HULL_MAX_POOL_SIZE get no face. The
+   others are sorted by their bounds before cdd computes the hull, and the face
+   is cached under the sorted bounds, so permuted and repeated windows are
+   looked up and get the same face as without the cache.
+   Safe to call from several threads. */
+bool maxpool_upper_face(maxpool_hull_cache_t *cache, double *lb, double *ub, size_t pool_size, double *coeff, double *cst);
+
 #ifdef __cplusplus
 }
 #endif
@@ -47,6 +47,8 @@ void handle_parabola_layer(elina_manager_t *man, elina_abstract0_t* element, siz
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
 	size_t numlayers = fp->numlayers;
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
 	fppoly_add_new_layer(fp, num_neurons, predecessors, num_predecessors, true);
 	neuron_t **out_neurons = fp->layers[numlayers]->neurons;
 	int k = predecessors[0]-1;
@@ -56,5 +58,6 @@ void handle_parabola_layer(elina_manager_t *man, elina_abstract0_t* element, siz
 		out_neurons[i]->lexpr = create_parabola_expr(pr, out_neurons[i], in_neurons[i], i, true);
 		out_neurons[i]->uexpr = create_parabola_expr(pr, out_neurons[i], in_neurons[i], i, false);
 	}
+	fppoly_stats_stop(pr, fp, numlayers, &timer);
 }
 
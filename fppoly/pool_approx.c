@@ -1,33 +1,46 @@
 #include "pool_approx.h"
 #include "maxpool_convex_hull.h"
 
-size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element, 
-			   size_t *pool_size, size_t *input_size, size_t *strides, size_t pad_top, size_t pad_left, size_t pad_bottom, size_t pad_right, size_t * output_size,size_t *predecessors, size_t num_predecessors, bool is_maxpool){
-	assert(num_predecessors==1);
-	assert(pool_size[2]==1);
-	//assert(stride[0]==2 && stride[1]==2 && stride[2]==1);
-	
-	size_t i,j,k;
+typedef struct pool_layer_args_t{
+	size_t *pool_size;
+	size_t *input_size;
+	size_t *strides;
+	size_t *output_size;
+	size_t pad_top;
+	size_t pad_left;
+	bool is_maxpool;
+	maxpool_hull_cache_t *maxpool_cache;
+}pool_layer_args_t;
 
 
-	size_t num_input_neurons = input_size[0]*input_size[1]*input_size[2];
-	size_t num_out_neurons = output_size[0]*output_size[1]*output_size[2];
+/* each output of the pool layer only reads the bounds of its own window */
+static void *handle_pool_layer_parallel(void *args){
+	nn_thread_t * data = (nn_thread_t *)args;
+	pool_layer_args_t * pool_args = (pool_layer_args_t *)data->data;
+	elina_manager_t *man = data->man;
+	fppoly_t *fp = data->fp;
+	size_t numlayers = data->layerno;
+	int k1 = data->k;
+	size_t *pool_size = pool_args->pool_size;
+	size_t *input_size = pool_args->input_size;
+	size_t *strides = pool_args->strides;
+	size_t *output_size = pool_args->output_size;
+	size_t pad_top = pool_args->pad_top;
+	size_t pad_left = pool_args->pad_left;
+	bool is_maxpool = pool_args->is_maxpool;
+	size_t j,k;
 
-    size_t o12 = output_size[1]*output_size[2];
-   	size_t i12 = input_size[1]*input_size[2];
-    size_t p01 = pool_size[0]*pool_size[1];
-	
-	fppoly_t * fp = fppoly_of_abstract0(element);
-	size_t numlayers = fp->numlayers;
-	fppoly_add_new_layer(fp,num_out_neurons, predecessors, num_predecessors, false);
+	size_t num_input_neurons = input_size[0]*input_size[1]*input_size[2];
+	size_t o12 = output_size[1]*output_size[2];
+	size_t i12 = input_size[1]*input_size[2];
+	size_t p01 = pool_size[0]*pool_size[1];
 	size_t out_pos;
 	double * inf = (double *) calloc(p01,sizeof(double));
 	double * sup = (double *) calloc(p01,sizeof(double));
 	size_t * pool_map = (size_t *)calloc(p01,sizeof(size_t));
 	neuron_t ** out_neurons = fp->layers[numlayers]->neurons;
-	int k1 = predecessors[0] - 1;
 	neuron_t ** in_neurons = fp->layers[k1]->neurons;
-	for(out_pos=0; out_pos<num_out_neurons; out_pos++){
+	for(out_pos=data->start; out_pos<data->end; out_pos++){
 		size_t out_x = out_pos / o12;
 		size_t out_y = (out_pos-out_x*o12) / output_size[2];
 		size_t out_z = out_pos-out_x*o12 - out_y*output_size[2];
@@ -101,6 +114,8 @@ size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element,
 						sub->dim =(size_t *)malloc(2*sizeof(size_t));
 						sub->size = 2;
 						sub->type = SPARSE;
+						sub->refcount = 1;
+						sub->borrowed = false;
 						sub->inf_coeff[0] = -1;
 						sub->sup_coeff[0] = 1;
 						sub->dim[0] = pool_map[j];
@@ -135,11 +150,6 @@ size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element,
 				//out_neurons[out_pos]->expr = create_sparse_expr(coeff,0,dim,1);
 			}
 			else{
-				dd_MatrixPtr M = NULL;
-				if(l<=10){
-					M = maxpool_deeppoly_approx(inf,sup,l);
-					
-				}
 				//printf("end\n");
 				//fflush(stdout);
 				//dd_WriteMatrix(stdout,M);
@@ -167,78 +177,31 @@ size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element,
 				//	ucoeff[j] = 1.0;
 				//	udim[j] = pool_map[j];
 				//}
-				bool rel_flag = false;
-				size_t rel_index = 0;
-				double best_val = INFINITY;
-				if(M!=NULL){
-					size_t nbrows = M->rowsize;
-					
-					//double best_val = INFINITY;
-					for(i=0; i < nbrows; i++){
-						double Miy = dd_get_d(M->matrix[i][l+1]);
-						if(Miy<0){
-							
-							double div = -Miy;
-							size_t j;
-							double val = dd_get_d(M->matrix[i][0])/div;
-							bool rel_cons = false;
-							for(j=0; j < l; j++){
-								double Mij = dd_get_d(M->matrix[i][j+1])/div;
-								if(Mij<0){
-									rel_cons = true;
-									val = val + Mij*inf[j];
-								}
-								else if (Mij>0){
-									rel_cons = true;
-									val = val + Mij*sup[j];
-								}
-							}
-							
-						//printf("COMING HERE %g %g %g %g %g %g\n",pi[2]/div,pi[3]/div,pi[4]/div,pi[5]/div,val,max_u);
-							if(rel_cons && val<best_val){
-								rel_flag = true;
-						//		printf("HERE: %g %g\n",val,max_u);
-								rel_index = i;
-								best_val = val;
-							}
-						}
-					}
-				
-				}
-				
-				if(rel_flag==true && fabs(best_val-max_u)<0.01){
-				 // if(0){      
-					double *ucoeff = (double *)malloc(l*sizeof(double));
-					size_t *udim = (size_t *)malloc(l*sizeof(double));
-					//double *pi = mat->p[rel_index];
-					double div = -dd_get_d(M->matrix[rel_index][l+1]);
-					size_t j;
+				double *ucoeff = (double *)malloc(l*sizeof(double));
+				double cst;
+				if(maxpool_upper_face(pool_args->maxpool_cache,inf,sup,l,ucoeff,&cst)){
+					size_t *udim = (size_t *)malloc(l*sizeof(size_t));
 					for(j=0; j < l; j++){
-						double Mij = dd_get_d(M->matrix[rel_index][j+1]);
-						ucoeff[j] = Mij/div;
 						udim[j] = pool_map[j];
 					}
-					double cst = dd_get_d(M->matrix[rel_index][0])/div;
-					
-					 out_neurons[out_pos]->uexpr = create_sparse_expr(ucoeff,cst,udim,l);
-					 free(ucoeff);
-					 free(udim);
+					out_neurons[out_pos]->uexpr = create_sparse_expr(ucoeff,cst,udim,l);
+					free(udim);
 				}
 				else{
-					double ucoeff[1];
-					size_t udim[1];
-					ucoeff[0] = 0;
-					udim[0] = 0;
+					double ccoeff[1];
+					size_t cdim[1];
+					ccoeff[0] = 0;
+					cdim[0] = 0;
 					
-					out_neurons[out_pos]->uexpr = create_sparse_expr(ucoeff,max_u,udim,1);
+					out_neurons[out_pos]->uexpr = create_sparse_expr(ccoeff,max_u,cdim,1);
 				}
+				free(ucoeff);
 				//out_neurons[out_pos]->uexpr = create_sparse_expr(ucoeff,max_l-sum_l,udim,p01);
 				//sort_sparse_expr(out_neurons[out_pos]->uexpr);
 				//free(ucoeff);
 				//free(udim);
 				//out_neurons[out_pos]->lexpr = create_cst_expr(-max_l,max_l);
 				//out_neurons[out_pos]->uexpr = create_cst_expr(-max_u,max_u);
-				dd_FreeMatrix(M);
 			}
 			out_neurons[out_pos]->lb = -max_l;
 			out_neurons[out_pos]->ub = max_u;	
@@ -271,10 +234,51 @@ size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element,
 		}
 	}
 	
-	//update_state_using_previous_layers_parallel(man,fp,numlayers);
-        free(inf);
+	free(inf);
 	free(sup);
 	free(pool_map);
+	return NULL;
+}
+
+
+size_t handle_pool_layer(elina_manager_t *man, elina_abstract0_t *element, 
+			   size_t *pool_size, size_t *input_size, size_t *strides, size_t pad_top, size_t pad_left, size_t pad_bottom, size_t pad_right, size_t * output_size,size_t *predecessors, size_t num_predecessors, bool is_maxpool){
+	assert(num_predecessors==1);
+	assert(pool_size[2]==1);
+	//assert(stride[0]==2 && stride[1]==2 && stride[2]==1);
+	
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	size_t num_out_neurons = output_size[0]*output_size[1]*output_size[2];
+	
+	fppoly_t * fp = fppoly_of_abstract0(element);
+	size_t numlayers = fp->numlayers;
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
+	fppoly_add_new_layer(fp,num_out_neurons, predecessors, num_predecessors, false);
+	pool_layer_args_t pool_args;
+	pool_args.pool_size = pool_size;
+	pool_args.input_size = input_size;
+	pool_args.strides = strides;
+	pool_args.output_size = output_size;
+	pool_args.pad_top = pad_top;
+	pool_args.pad_left = pad_left;
+	pool_args.is_maxpool = is_maxpool;
+	pool_args.maxpool_cache = pr->maxpool_cache;
+	nn_thread_t arg;
+	arg.start = 0;
+	arg.end = num_out_neurons;
+	arg.man = man;
+	arg.fp = fp;
+	arg.layerno = numlayers;
+	arg.k = predecessors[0] - 1;
+	arg.linexpr0 = NULL;
+	arg.res = NULL;
+	arg.data = &pool_args;
+	size_t chunk_size = num_out_neurons / (fppoly_thread_pool_size(pr->pool)*FPPOLY_CHUNKS_PER_THREAD);
+	fppoly_thread_pool_run_range(pr->pool, handle_pool_layer_parallel, &arg, num_out_neurons, chunk_size);
+	fppoly_stats_stop(pr, fp, numlayers, &timer);
+	
+	//update_state_using_previous_layers_parallel(man,fp,numlayers);
 	//free(output_size);
 	//fflush(stdout);
 	//fppoly_fprint(stdout,man,fp,NULL);
@@ -55,11 +55,13 @@ expr_t * create_relu_expr(neuron_t *out_neuron, neuron_t *in_neuron, size_t i, b
 }
 
 
-void handle_relu_layer(elina_manager_t *man, elina_abstract0_t* element, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristics){
+void fppoly_relu_layer(elina_manager_t *man, fppoly_t *fp, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristics){
 	
 	assert(num_predecessors==1);
-	fppoly_t *fp = fppoly_of_abstract0(element);
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
 	size_t numlayers = fp->numlayers;
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
 	fppoly_add_new_layer(fp, num_neurons, predecessors, num_predecessors,true);
 	neuron_t **out_neurons = fp->layers[numlayers]->neurons;
 	int k = predecessors[0]-1;
@@ -73,6 +75,11 @@ void handle_relu_layer(elina_manager_t *man, elina_abstract0_t* element, size_t
 		out_neurons[i]->uexpr = create_relu_expr(out_neurons[i], in_neurons[i], i, use_default_heuristics, false);
 		
 	}
-	
+	fppoly_stats_stop(pr, fp, numlayers, &timer);
+}
+
+
+void handle_relu_layer(elina_manager_t *man, elina_abstract0_t* element, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristics){
+	fppoly_relu_layer(man, fppoly_of_abstract0(element), num_neurons, predecessors, num_predecessors, use_default_heuristics);
 }
 
@@ -29,6 +29,9 @@ extern "C" {
 
 #include "backsubstitute.h"
 
+/* handle_relu_layer on the element itself, for callers that own it without an abstract0 */
+void fppoly_relu_layer(elina_manager_t *man, fppoly_t *fp, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristics);
+
 void handle_relu_layer(elina_manager_t *man, elina_abstract0_t* element, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristics);
 
 expr_t * create_relu_expr(neuron_t *out_neuron, neuron_t *in_neuron, size_t i, bool use_default_heuristics, bool is_lower);
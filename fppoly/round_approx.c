@@ -34,6 +34,9 @@ void handle_round_layer(elina_manager_t *man, elina_abstract0_t* element, size_t
 	assert(num_predecessors==1);
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	size_t numlayers = fp->numlayers;
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
 	fppoly_add_new_layer(fp, num_neurons, predecessors, num_predecessors,true);
 	neuron_t **out_neurons = fp->layers[numlayers]->neurons;
 	int k = predecessors[0]-1;
@@ -47,5 +50,6 @@ void handle_round_layer(elina_manager_t *man, elina_abstract0_t* element, size_t
 		out_neurons[i]->uexpr = create_round_expr(out_neurons[i], in_neurons[i], i, use_default_heuristics, false);
 		
 	}
+	fppoly_stats_stop(pr, fp, numlayers, &timer);
 }
 
@@ -273,6 +273,8 @@ void handle_s_curve_layer(elina_manager_t *man, elina_abstract0_t* element, size
 	fppoly_t *fp = fppoly_of_abstract0(element);
 	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
 	size_t numlayers = fp->numlayers;
+	fppoly_stats_timer_t timer;
+	fppoly_stats_start(pr, &timer);
 	fppoly_add_new_layer(fp, num_neurons, predecessors, num_predecessors, true);
 	neuron_t **out_neurons = fp->layers[numlayers]->neurons;
 	int k = predecessors[0]-1;
@@ -282,6 +284,7 @@ void handle_s_curve_layer(elina_manager_t *man, elina_abstract0_t* element, size
         out_neurons[i]->lexpr = create_s_curve_expr(pr, out_neurons[i], in_neurons[i], i, true, is_sigmoid, use_default_heuristic);
         out_neurons[i]->uexpr = create_s_curve_expr(pr, out_neurons[i], in_neurons[i], i, false, is_sigmoid, use_default_heuristic);
 	}
+	fppoly_stats_stop(pr, fp, numlayers, &timer);
 }
 
 void handle_sigmoid_layer(elina_manager_t *man, elina_abstract0_t* element, size_t num_neurons, size_t *predecessors, size_t num_predecessors, bool use_default_heuristic){
@@ -293,16 +296,16 @@ void handle_tanh_layer(elina_manager_t *man, elina_abstract0_t* element, size_t
 }
 
 
+/* replaces the expression of the input of the s-curve by the lower (is_lower)
+   or upper relaxation of its output, and returns the bound of the output on
+   the same side (negated for the lower one) */
 double apply_s_curve_expr(fppoly_internal_t *pr, expr_t **uexpr_p, neuron_t * neuron, bool is_lower, bool is_sigmoid){
 	expr_t * uexpr = *uexpr_p;
 	size_t i;
 	size_t size = uexpr->size;
-	double lb = neuron->lb;
-	double ub = neuron->ub;
 	
 	neuron_t *tmp_neuron = neuron_alloc();
 	expr_t * res = create_s_curve_expr(pr,tmp_neuron, neuron, 0, is_lower, is_sigmoid, true);
-	bool boxify = false;
 	double slope_inf, slope_sup;
 	double intercept_inf, intercept_sup;
 	
@@ -310,31 +313,16 @@ double apply_s_curve_expr(fppoly_internal_t *pr, expr_t **uexpr_p, neuron_t * ne
 	slope_sup = res->sup_coeff[0];
 	intercept_inf = res->inf_cst;
 	intercept_sup = res->sup_cst;
-	fesetround(FE_DOWNWARD);
-	double e_sup_l = is_sigmoid ? -exp(ub) : -tanh(ub);
-	fesetround(FE_UPWARD); 
-	double e_sup_u = is_sigmoid ? exp(ub) : tanh(ub);
-	double f_sup_l, f_sup_u;
-	double den_sup_l, den_sup_u;
-	if(is_sigmoid){
-		den_sup_l = -1 + e_sup_l;
-		den_sup_u = 1 + e_sup_u;					
-		elina_double_interval_div(&f_sup_l, &f_sup_u, e_sup_l, e_sup_u, den_sup_l, den_sup_u);
-	}
-	else{
-		f_sup_l = e_sup_l;
-		f_sup_u = e_sup_u;
-	}
-	
 	
 	for(i=0; i < size; i++){
 		elina_double_interval_mul_expr_coeff(pr,&uexpr->inf_coeff[i],&uexpr->sup_coeff[i],slope_inf,slope_sup,uexpr->inf_coeff[i],uexpr->sup_coeff[i]);
 	}
 	elina_double_interval_mul_cst_coeff(pr, &uexpr->inf_cst, &uexpr->sup_cst, slope_inf, slope_sup, uexpr->inf_cst, uexpr->sup_cst );
 	elina_double_interval_add_cst_coeff(pr,&uexpr->inf_cst,&uexpr->sup_cst,intercept_inf, intercept_sup, uexpr->inf_cst, uexpr->sup_cst);
+	double bound = is_lower ? tmp_neuron->lb : tmp_neuron->ub;
 	free_expr(res);
 	free_neuron(tmp_neuron);
-	return f_sup_u;
+	return bound;
 }
 
 double apply_sigmoid_lexpr(fppoly_internal_t *pr, expr_t **lexpr_p, neuron_t * neuron){
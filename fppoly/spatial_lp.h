@@ -0,0 +1,57 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+
+#ifndef __SPATIAL_LP_H_INCLUDED__
+#define __SPATIAL_LP_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include "fppoly.h"
+#include "expr.h"
+
+/* The LP over the input polyhedron of an input with spatial constraints: every
+   pixel x_k lies between the affine expressions input_lexpr[k] and
+   input_uexpr[k] of its two flow components, and the flow components of
+   neighbouring pixels differ by at most spatial_gamma. The constraints are
+   built once per fppoly_t, each query only changes the objective and starts
+   from the state left by the previous one. Queries from several threads each
+   get their own solver instance. */
+
+/* NULL for FPPOLY_SPATIAL_NONE, and for FPPOLY_SPATIAL_GUROBI in builds
+   without GUROBI */
+spatial_lp_t * spatial_lp_alloc(fppoly_t *fp, fppoly_spatial_solver_t solver);
+
+void spatial_lp_free(spatial_lp_t *lp);
+
+/* upper bound of the maximum over the input polyhedron of the inf (is_lower)
+   or sup coefficients of expr applied to the pixels, without the constant */
+double spatial_lp_bound(spatial_lp_t *lp, expr_t *expr, bool is_lower);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
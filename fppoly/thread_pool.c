@@ -0,0 +1,316 @@
+#include "thread_pool.h"
+#include <time.h>
+
+/* set while a pool thread (or the dispatching thread) executes a task, so that
+   a nested parallel region falls back to running inline instead of deadlocking */
+static __thread bool fppoly_in_parallel_region = false;
+
+/* takes the next chunk of the own range, returns false once it is empty */
+static bool fppoly_work_range_pop(fppoly_work_range_t *range, size_t chunk_size, size_t *start, size_t *end){
+	bool res = false;
+	pthread_mutex_lock(&range->lock);
+	if(range->start < range->end){
+		*start = range->start;
+		*end = range->end - range->start > chunk_size ? range->start + chunk_size : range->end;
+		range->start = *end;
+		res = true;
+	}
+	pthread_mutex_unlock(&range->lock);
+	return res;
+}
+
+
+/* moves the back half of the fullest other range into the own range */
+static bool fppoly_work_range_steal(fppoly_thread_pool_t *pool, size_t slot){
+	size_t i;
+	while(true){
+		size_t victim = pool->num_threads;
+		size_t max_remaining = 0;
+		for(i=0; i < pool->num_threads; i++){
+			if(i==slot){
+				continue;
+			}
+			/* racy read, only used to pick the victim */
+			size_t start = pool->ranges[i].start;
+			size_t end = pool->ranges[i].end;
+			if(end > start && end - start > max_remaining){
+				max_remaining = end - start;
+				victim = i;
+			}
+		}
+		if(victim==pool->num_threads){
+			return false;
+		}
+		fppoly_work_range_t *range = &pool->ranges[victim];
+		size_t start = 0, end = 0;
+		pthread_mutex_lock(&range->lock);
+		if(range->start < range->end){
+			size_t remaining = range->end - range->start;
+			start = range->end - (remaining + 1)/2;
+			end = range->end;
+			range->end = start;
+		}
+		pthread_mutex_unlock(&range->lock);
+		if(start < end){
+			pthread_mutex_lock(&pool->ranges[slot].lock);
+			pool->ranges[slot].start = start;
+			pool->ranges[slot].end = end;
+			pthread_mutex_unlock(&pool->ranges[slot].lock);
+			return true;
+		}
+	}
+}
+
+
+static void fppoly_thread_pool_run_tasks(fppoly_thread_pool_t *pool){
+	if(fegetround()!=pool->rounding){
+		fesetround(pool->rounding);
+	}
+	bool in_region = fppoly_in_parallel_region;
+	fppoly_in_parallel_region = true;
+	if(!pool->steal){
+		while(true){
+			size_t t = __sync_fetch_and_add(&pool->next_task, 1);
+			if(t >= pool->num_tasks){
+				break;
+			}
+			pool->function((void *)&pool->args[t]);
+		}
+	}
+	else{
+		size_t slot = __sync_fetch_and_add(&pool->next_slot, 1);
+		nn_thread_t arg = *pool->args;
+		do{
+			while(fppoly_work_range_pop(&pool->ranges[slot], pool->chunk_size, &arg.start, &arg.end)){
+				pool->function((void *)&arg);
+			}
+		}while(fppoly_work_range_steal(pool, slot));
+	}
+	fppoly_in_parallel_region = in_region;
+}
+
+
+static void * fppoly_thread_pool_worker(void *arg){
+	fppoly_thread_pool_t *pool = (fppoly_thread_pool_t *)arg;
+	unsigned long generation = 0;
+	pthread_mutex_lock(&pool->mutex);
+	while(true){
+		while(!pool->shutdown && pool->generation==generation){
+			pthread_cond_wait(&pool->start_cond, &pool->mutex);
+		}
+		if(pool->shutdown){
+			break;
+		}
+		generation = pool->generation;
+		pthread_mutex_unlock(&pool->mutex);
+		fppoly_thread_pool_run_tasks(pool);
+		pthread_mutex_lock(&pool->mutex);
+		pool->active--;
+		if(pool->active==0){
+			pthread_cond_signal(&pool->finish_cond);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+
+fppoly_thread_pool_t * fppoly_thread_pool_alloc(size_t num_threads, bool set_affinity){
+	fppoly_thread_pool_t *pool = (fppoly_thread_pool_t *)malloc(sizeof(fppoly_thread_pool_t));
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(num_cpus < 1){
+		num_cpus = 1;
+	}
+	if(num_threads==0){
+		num_threads = num_cpus;
+	}
+	pool->num_threads = num_threads;
+	pool->set_affinity = set_affinity;
+	pool->function = NULL;
+	pool->args = NULL;
+	pool->num_tasks = 0;
+	pool->next_task = 0;
+	pool->steal = false;
+	pool->chunk_size = 1;
+	pool->next_slot = 0;
+	pool->active = 0;
+	pool->generation = 0;
+	pool->rounding = fegetround();
+	pool->shutdown = false;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_mutex_init(&pool->dispatch_mutex, NULL);
+	pthread_cond_init(&pool->start_cond, NULL);
+	pthread_cond_init(&pool->finish_cond, NULL);
+	pool->ranges = (fppoly_work_range_t *)malloc(num_threads*sizeof(fppoly_work_range_t));
+	size_t i;
+	for(i=0; i < num_threads; i++){
+		pthread_mutex_init(&pool->ranges[i].lock, NULL);
+		pool->ranges[i].start = 0;
+		pool->ranges[i].end = 0;
+	}
+	/* the dispatching thread acts as worker 0 */
+	size_t num_workers = num_threads - 1;
+	pool->threads = num_workers ? (pthread_t *)malloc(num_workers*sizeof(pthread_t)) : NULL;
+	for(i=0; i < num_workers; i++){
+		if(pthread_create(&pool->threads[i], NULL, fppoly_thread_pool_worker, (void *)pool)){
+			/* run with the workers we managed to create */
+			pool->num_threads = i + 1;
+			size_t j;
+			for(j=pool->num_threads; j < num_threads; j++){
+				pthread_mutex_destroy(&pool->ranges[j].lock);
+			}
+			break;
+		}
+#if defined(__linux__)
+		if(set_affinity){
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			CPU_SET((i+1)%num_cpus, &cpuset);
+			pthread_setaffinity_np(pool->threads[i], sizeof(cpu_set_t), &cpuset);
+		}
+#endif
+	}
+	return pool;
+}
+
+
+void fppoly_thread_pool_free(fppoly_thread_pool_t *pool){
+	if(pool==NULL){
+		return;
+	}
+	size_t i;
+	pthread_mutex_lock(&pool->mutex);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->mutex);
+	for(i=0; i < pool->num_threads - 1; i++){
+		pthread_join(pool->threads[i], NULL);
+	}
+	free(pool->threads);
+	for(i=0; i < pool->num_threads; i++){
+		pthread_mutex_destroy(&pool->ranges[i].lock);
+	}
+	free(pool->ranges);
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_mutex_destroy(&pool->dispatch_mutex);
+	pthread_cond_destroy(&pool->start_cond);
+	pthread_cond_destroy(&pool->finish_cond);
+	free(pool);
+}
+
+
+size_t fppoly_thread_pool_size(fppoly_thread_pool_t *pool){
+	return pool==NULL ? 1 : pool->num_threads;
+}
+
+
+double fppoly_thread_pool_cpu_time(fppoly_thread_pool_t *pool){
+	double res = 0;
+	size_t i;
+	if(pool==NULL){
+		return 0;
+	}
+	for(i=0; i+1 < pool->num_threads; i++){
+		clockid_t clock;
+		struct timespec ts;
+		if(pthread_equal(pool->threads[i], pthread_self()) || pthread_getcpuclockid(pool->threads[i], &clock) || clock_gettime(clock, &ts)){
+			continue;
+		}
+		res += ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+	return res;
+}
+
+
+/* wakes up the workers for the region described in pool, takes part in it
+   and waits until every worker is done; called with dispatch_mutex held */
+static void fppoly_thread_pool_dispatch(fppoly_thread_pool_t *pool){
+	pthread_mutex_lock(&pool->mutex);
+	/* workers inherit the rounding mode of the caller, bounds rely on FE_UPWARD */
+	pool->rounding = fegetround();
+	pool->active = pool->num_threads - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	fppoly_thread_pool_run_tasks(pool);
+
+	pthread_mutex_lock(&pool->mutex);
+	while(pool->active > 0){
+		pthread_cond_wait(&pool->finish_cond, &pool->mutex);
+	}
+	pool->function = NULL;
+	pool->args = NULL;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+
+void fppoly_thread_pool_run(fppoly_thread_pool_t *pool, void *(*function)(void *), nn_thread_t *args, size_t num_tasks){
+	size_t i;
+	if(pool==NULL || pool->num_threads==1 || num_tasks<=1 || fppoly_in_parallel_region){
+		for(i=0; i < num_tasks; i++){
+			function((void *)&args[i]);
+		}
+		return;
+	}
+	pthread_mutex_lock(&pool->dispatch_mutex);
+	pool->function = function;
+	pool->args = args;
+	pool->num_tasks = num_tasks;
+	pool->next_task = 0;
+	pool->steal = false;
+	fppoly_thread_pool_dispatch(pool);
+	pthread_mutex_unlock(&pool->dispatch_mutex);
+}
+
+
+void fppoly_thread_pool_run_range(fppoly_thread_pool_t *pool, void *(*function)(void *), nn_thread_t *arg, size_t num_items, size_t chunk_size){
+	size_t i;
+	if(num_items==0){
+		return;
+	}
+	if(pool==NULL || pool->num_threads==1 || num_items==1 || fppoly_in_parallel_region){
+		nn_thread_t tmp = *arg;
+		tmp.start = 0;
+		tmp.end = num_items;
+		function((void *)&tmp);
+		return;
+	}
+	pthread_mutex_lock(&pool->dispatch_mutex);
+	/* neighbouring neurons stay on the same thread until work gets stolen */
+	size_t num_threads = pool->num_threads;
+	size_t idx_n = num_items / num_threads;
+	size_t rem = num_items % num_threads;
+	size_t idx_start = 0;
+	for(i=0; i < num_threads; i++){
+		size_t idx_end = idx_start + idx_n + (i < rem ? 1 : 0);
+		pool->ranges[i].start = idx_start;
+		pool->ranges[i].end = idx_end;
+		idx_start = idx_end;
+	}
+	pool->function = function;
+	pool->args = arg;
+	pool->chunk_size = chunk_size ? chunk_size : 1;
+	pool->next_slot = 0;
+	pool->steal = true;
+	fppoly_thread_pool_dispatch(pool);
+	pthread_mutex_unlock(&pool->dispatch_mutex);
+}
+
+
+void fppoly_parallel_for(elina_manager_t *man, fppoly_t *fp, size_t layerno, int k, size_t num_out_neurons, elina_linexpr0_t **linexpr0, double *res, void *(*function)(void *)){
+	fppoly_internal_t *pr = fppoly_init_from_manager(man, ELINA_FUNID_ASSIGN_LINEXPR_ARRAY);
+	size_t NUM_THREADS = fppoly_thread_pool_size(pr->pool);
+	nn_thread_t arg;
+	arg.start = 0;
+	arg.end = num_out_neurons;
+	arg.man = man;
+	arg.fp = fp;
+	arg.layerno = layerno;
+	arg.k = k;
+	arg.linexpr0 = linexpr0;
+	arg.res = res;
+	arg.data = NULL;
+	size_t chunk_size = num_out_neurons / (NUM_THREADS*FPPOLY_CHUNKS_PER_THREAD);
+	fppoly_thread_pool_run_range(pr->pool, function, &arg, num_out_neurons, chunk_size);
+}
@@ -0,0 +1,93 @@
+/*
+ *
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright © 2021 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY     
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ *
+ */
+
+
+
+#ifndef __THREAD_POOL_H_INCLUDED__
+#define __THREAD_POOL_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fppoly.h"
+
+/* Range of neuron indices still owned by one thread of a parallel region.
+   The owner takes chunks from the front, idle threads steal the back half. */
+typedef struct fppoly_work_range_t{
+	pthread_mutex_t lock;
+	size_t start;
+	size_t end;
+}fppoly_work_range_t;
+
+/* chunks handed out per thread and parallel region, more chunks balance
+   better when the cost of bounding a neuron varies (e.g. conv borders) */
+#define FPPOLY_CHUNKS_PER_THREAD 8
+
+/* Worker pool owned by the fppoly manager. The workers are created once in
+   fppoly_manager_alloc and are woken up for every parallel region instead of
+   creating fresh pthreads per layer. The calling thread takes part in the
+   work, so a pool of num_threads uses num_threads-1 workers. */
+struct fppoly_thread_pool_t{
+	pthread_t *threads;
+	size_t num_threads;
+	bool set_affinity;
+	pthread_mutex_t mutex;
+	pthread_cond_t start_cond;
+	pthread_cond_t finish_cond;
+	/* serializes parallel regions issued concurrently on the same manager */
+	pthread_mutex_t dispatch_mutex;
+	void *(*function)(void *);
+	nn_thread_t *args;
+	size_t num_tasks;
+	size_t next_task;
+	/* work-stealing mode: args is a template that is copied for every
+	   chunk with start/end filled in */
+	bool steal;
+	fppoly_work_range_t *ranges;
+	size_t chunk_size;
+	size_t next_slot;
+	size_t active;
+	unsigned long generation;
+	int rounding;
+	bool shutdown;
+};
+
+fppoly_thread_pool_t * fppoly_thread_pool_alloc(size_t num_threads, bool set_affinity);
+
+void fppoly_thread_pool_free(fppoly_thread_pool_t *pool);
+
+size_t fppoly_thread_pool_size(fppoly_thread_pool_t *pool);
+
+/* CPU seconds used so far by the workers of the pool, except the calling
+   thread when it is one of them */
+double fppoly_thread_pool_cpu_time(fppoly_thread_pool_t *pool);
+
+void fppoly_thread_pool_run(fppoly_thread_pool_t *pool, void *(*function)(void *), nn_thread_t *args, size_t num_tasks);
+
+void fppoly_thread_pool_run_range(fppoly_thread_pool_t *pool, void *(*function)(void *), nn_thread_t *arg, size_t num_items, size_t chunk_size);
+
+void fppoly_parallel_for(elina_manager_t *man, fppoly_t *fp, size_t layerno, int k, size_t num_out_neurons, elina_linexpr0_t **linexpr0, double *res, void *(*function)(void *));
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
@@ -56,6 +56,9 @@ struct SplashScreen
 #else
 		std::cout << "W";
 #endif
+#ifdef GPUPOLY_CPU
+		std::cout << " CPU";
+#endif
 #ifndef NDEBUG
 		std::cout << " Debug";
 #endif
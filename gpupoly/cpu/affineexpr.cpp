@@ -0,0 +1,146 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*!
+   \file src/cpu/affineexpr.cpp
+   \brief AffineExpr implementation (CPU build).
+
+   CPU counterpart of src/affineexpr.cu.
+  */
+
+#include "../affineexpr.h"
+#include "parallel.h"
+
+template<typename T>
+void makeIdMatrix(T* dest, size_t N, int outputSize, const int* annoyingList, size_t m)
+{
+	cpu::parallelFor(m, cpu::grain(outputSize), [=](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++)
+		{
+			int output = annoyingList[row];
+			for (int col = 0; col < outputSize; col++)
+				dest[row * N + col] = (output == col);
+		}
+		});
+}
+
+template <typename T>
+std::shared_ptr<const Matrix<T>> AffineExpr<T>::getA() const
+{
+	if (!A)
+	{
+		auto res = std::make_shared<Matrix<T>>(m, n, false);
+		makeIdMatrix<T>(*res, res->pitch(), n, rows, m);
+		return res;
+	}
+	else
+		return A;
+}
+template <bool upper, typename TB, typename T>
+void backPropConstantInit(T* dest, const size_t size, const int* annoyingList, const T* exprb, const TB* b)
+{
+	cpu::parallelFor(size, cpu::minWork, [=](size_t begin, size_t end) {
+		for (size_t idx = begin; idx < end; idx++)
+		{
+			T lhs = Intv<T>::template access_dr<upper>(b[annoyingList[idx]]);
+			T rhs = exprb ? exprb[idx] : 0;
+			T res = Intv<T>::template add_dr<upper>(lhs, rhs);
+			dest[idx] = res;
+		}
+		});
+}
+
+template <typename T>
+template <typename Tr>
+Vector<T> AffineExpr<T>::evaluate(const Vector<Tr>& bounds) const
+{
+	Vector<T> res(m, false);
+	if (A)
+		if (up)
+			A->template mvm_dr<true>(res, bounds, b);
+		else
+			A->template mvm_dr<false>(res, bounds, b);
+	else
+		if (bounds.interval())
+			if (up)
+				backPropConstantInit<true, Intv<Tr>, T>(res, m, rows, b ? (const T*)*b : nullptr, bounds);
+			else
+				backPropConstantInit<false, Intv<Tr>, T>(res, m, rows, b ? (const T*)*b : nullptr, bounds);
+		else
+			if (up)
+				backPropConstantInit<true, Tr, T>(res, m, rows, b ? (const T*)*b : nullptr, bounds);
+			else
+				backPropConstantInit<false, Tr, T>(res, m, rows, b ? (const T*)*b : nullptr, bounds);
+	return res;
+}
+
+template Vector<double> AffineExpr<double>::evaluate(const Vector<double>& bounds) const;
+template Vector<float> AffineExpr<float>::evaluate(const Vector<float>& bounds) const;
+template Vector<double> AffineExpr<double>::evaluate(const Vector<float>& bounds) const;
+template Vector<float> AffineExpr<float>::evaluate(const Vector<double>& bounds) const;
+
+template <bool up, typename T>
+void putBack(Intv<T>* dest, const T* bound, const int* annoyingList, int size)
+{
+	// distinct i may not share a row, as annoyingList has no duplicates
+	cpu::parallelFor(size, cpu::minWork, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			int row = annoyingList ? annoyingList[i] : i;
+			Intv<T> cur = dest[row];
+			T u = bound[i];
+			if (up)
+			{
+				if (u < cur.high)
+					cur.high = u;
+			}
+			else
+			{
+				if (u > cur.low)
+					cur.low = u;
+			}
+			dest[row] = cur;
+		}
+		});
+}
+template <typename T>
+void AffineExpr<T>::evaluateAndUpdate(Vector<T>& dest, const Vector<T>& bounds) const
+{
+	assert(bounds.size() == n);
+	auto res = evaluate(bounds);
+	if (up)
+		putBack<true, T>(dest, res, rows, m);
+	else
+		putBack<false, T>(dest, res, rows, m);
+}
+
+template <typename T>
+void AffineExpr<T>::selectRows(size_t size, int* smallRows)
+{
+	A = A ? std::make_shared<const Matrix<T>>(A->template selectRows<T>(size, smallRows, false)) : nullptr;
+	b = b ? std::make_shared<const Vector<T>>(b->template select<T>(size, smallRows, false)) : nullptr;
+	for (size_t idx = 0; idx < size; idx++)
+		smallRows[idx] = rows[smallRows[idx]];
+	cudaMemcpy(rows, smallRows, size * sizeof(int), cudaMemcpyDeviceToDevice);
+	m = size;
+}
+
+template class AffineExpr<double>;
+template class AffineExpr<float>;
@@ -0,0 +1,57 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*!
+	\file src/cpu/filters.cpp
+	\brief Implementation of neuron filter functors (CPU build).
+
+	CPU counterpart of src/filters.cu.
+   */
+
+#include "../filters.h"
+#include <numeric>
+
+
+template <typename T>
+int ContainsZero<T>::listCriticalNeurons(int* dest, const Vector<T>& v, int* tmpInt, const int* oldList, const int oldNbCritical) const
+{
+	size_t m = oldList ? oldNbCritical : v.size();
+	const Intv<T>* intv = v;
+	int an = 0;
+	for (size_t idx = 0; idx < m; idx++)
+	{
+		Intv<T> cur = oldList ? intv[oldList[idx]] : intv[idx];
+		if (cur.high > 0 && cur.low < 0)
+			dest[an++] = idx;
+	}
+	return an;
+}
+
+template <typename T>
+int AlwaysKeep<T>::listCriticalNeurons(int* dest, const Vector<T>& v, int* tmpInt, const int* oldList, const int oldNbCritical) const
+{
+	std::iota(dest, dest + v.size(), 0);
+	return v.size();
+}
+
+template class ContainsZero<double>;
+template class AlwaysKeep<double>;
+template class ContainsZero<float>;
+template class AlwaysKeep<float>;
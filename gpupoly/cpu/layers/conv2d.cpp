@@ -0,0 +1,356 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*!
+   \file src/cpu/layers/conv2d.cpp
+   \brief Conv2D implementation (CPU build).
+
+   CPU counterpart of src/layers/conv2d.cu.
+  */
+
+#include "../../layers/conv2d.h"
+#include "../parallel.h"
+#include <algorithm>
+
+
+template<typename T> void Conv2D<T>::eval(Vector<double>& dest, bool sound, bool precise) { eval<double>(dest, sound); }
+template<typename T> void Conv2D<T>::eval(Vector<float>& dest, bool sound, bool precise) { eval<float>(dest, sound); }
+
+
+
+template<typename T>
+Conv2D<T>::Conv2D(
+	NeuralNetwork& nn,
+	const int filters,
+	const int kernel_size_rows, const int kernel_size_cols,
+	const int input_rows, const int input_cols, const int input_channels,
+	const int stride_rows, const int stride_cols,
+    const int padding_top, const int padding_left,
+    const int padding_bottom, const int padding_right,
+    const Matrix<T>& A,
+	int parent) :
+	NeuralNetwork::Layer(nn, ((input_rows + padding_top + padding_bottom - kernel_size_rows + stride_rows) / stride_rows)* ((input_cols + padding_left + padding_right - kernel_size_cols + stride_cols) / stride_cols)* filters),
+	cs(filters, kernel_size_rows, kernel_size_cols, input_rows, input_cols, input_channels, stride_rows, stride_cols, padding_top, padding_left, padding_bottom, padding_right),
+	inputSize(input_rows* input_cols* input_channels),
+	parent(parent),
+	conv(A), convt(A.transpose())
+{
+	/*std::cout << "Conv2D:" << std::endl;
+	cs.print();*/
+}
+
+
+
+
+template <bool channels_first, typename Tin, typename Tout, typename Tconv, typename Tarith>
+void convBackSubstitute(
+	const Tin* expr, size_t expr_N,
+	const Tconv* conv, size_t convN,
+	Tout* dest, size_t dest_N, int dest_m, int dest_n,
+	ConvShape cs,
+	ConvShape prevShape,
+	ConvShape newShape,
+	const int* rows
+)
+{
+	const size_t work = size_t(cs.input_rows) * cs.input_cols * cs.filters;
+	cpu::parallelFor(size_t(dest_m) * cs.input_channels, cpu::grain(work), [=](size_t begin, size_t end) {
+		for (size_t task = begin; task < end; task++)
+		{
+			const int in_ch = task % cs.input_channels;
+			const int row = task / cs.input_channels;
+			const int realRow = rows[row];
+			int in_row_min = 0;
+			int in_row_max = cs.input_rows;
+			int in_col_min = 0;
+			int in_col_max = cs.input_cols;
+			if (newShape)
+			{
+				const int realOutputCol = channels_first ? realRow % newShape.output_cols : (realRow / newShape.filters) % newShape.output_cols;
+				const int realOutputRow = channels_first ? (realRow / newShape.output_cols) % newShape.output_rows : realRow / (newShape.output_cols * newShape.filters);
+				in_row_min = std::max(0, realOutputRow * newShape.stride_rows - newShape.padding_top);
+				in_row_max = std::min(cs.input_rows, realOutputRow * newShape.stride_rows - newShape.padding_top + newShape.kernel_size_rows);
+				in_col_min = std::max(0, realOutputCol * newShape.stride_cols - newShape.padding_left);
+				in_col_max = std::min(cs.input_cols, realOutputCol * newShape.stride_cols - newShape.padding_left + newShape.kernel_size_cols);
+			}
+			for (int in_row = in_row_min; in_row < in_row_max; in_row++)
+				for (int in_col = in_col_min; in_col < in_col_max; in_col++)
+				{
+					int col = in_row * cs.input_cols + in_col;
+
+					int out_row_min = std::max(0, (in_row + cs.padding_top - cs.kernel_size_rows + cs.stride_rows) / cs.stride_rows);
+					int out_row_max = std::min(cs.output_rows, (in_row + cs.padding_top) / cs.stride_rows + 1);
+					int out_col_min = std::max(0, (in_col + cs.padding_left - cs.kernel_size_cols + cs.stride_cols) / cs.stride_cols);
+					int out_col_max = std::min(cs.output_cols, (in_col + cs.padding_left) / cs.stride_cols + 1);
+
+					if (prevShape) {
+						if (prevShape.isDiagonal())
+						{
+							const int realOutputCol = channels_first ? realRow % cs.output_cols : (realRow / cs.filters) % cs.output_cols;
+							const int realOutputRow = channels_first ? (realRow / cs.output_cols) % cs.output_rows : realRow / (cs.output_cols * cs.filters);
+							out_row_min = std::max(out_row_min, realOutputRow);
+							out_row_max = std::min(out_row_max, realOutputRow + 1);
+							out_col_min = std::max(out_col_min, realOutputCol);
+							out_col_max = std::min(out_col_max, realOutputCol + 1);
+						}
+						else
+						{
+							const int realOutputCol = channels_first ? realRow % prevShape.output_cols : (realRow / prevShape.filters) % prevShape.output_cols;
+							const int realOutputRow = channels_first ? (realRow / prevShape.output_cols) % prevShape.output_rows : realRow / (prevShape.output_cols * prevShape.filters);
+							out_row_min = std::max(out_row_min, realOutputRow * prevShape.stride_rows - prevShape.padding_top);
+							out_row_max = std::min(out_row_max, realOutputRow * prevShape.stride_rows - prevShape.padding_top + prevShape.kernel_size_rows);
+							out_col_min = std::max(out_col_min, realOutputCol * prevShape.stride_cols - prevShape.padding_left);
+							out_col_max = std::min(out_col_max, realOutputCol * prevShape.stride_cols - prevShape.padding_left + prevShape.kernel_size_cols);
+						}
+					}
+
+					Tout res(0);
+					for (int out_row = out_row_min; out_row < out_row_max; out_row++)
+					{
+						const int delta_row = in_row + cs.padding_top - cs.stride_rows * out_row;
+						for (int out_col = out_col_min; out_col < out_col_max; out_col++)
+						{
+							const int delta_col = in_col + cs.padding_left - cs.stride_cols * out_col;
+							for (int out_f = 0; out_f < cs.filters; out_f++)
+							{
+								const Tin a = expr[channels_first ?
+									row * expr_N + (out_f * cs.output_rows + out_row) * cs.output_cols + out_col :
+									row * expr_N + (out_row * cs.output_cols + out_col) * cs.filters + out_f
+								];
+								const Tconv b = conv[channels_first ?
+									(in_ch * cs.filters + out_f) * convN + delta_row * cs.kernel_size_cols + delta_col :
+									(delta_row * cs.kernel_size_cols + delta_col) * convN + in_ch * cs.filters + out_f
+								];
+								Intv<Tarith>::fma(res, a, b, res);
+							}
+						}
+					}
+
+					dest[channels_first ?
+						row * dest_N + in_ch * cs.input_rows * cs.input_cols + col :
+						row * dest_N + col * cs.input_channels + in_ch
+					] = res;
+				}
+		}
+		});
+}
+
+template <typename T, typename Td>
+void convBackSubstituteInit(
+	const T* conv, size_t convN,
+	Td* dest, size_t dest_N, size_t m,
+	ConvShape cs,
+	const int* rows
+)
+{
+	const size_t work = size_t(cs.kernel_size_rows) * cs.kernel_size_cols * cs.input_channels;
+	cpu::parallelFor(m, cpu::grain(work), [=](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++)
+		{
+			const unsigned int realRow = rows[row];
+			const int realOutputFilter = realRow / (cs.output_cols * cs.output_rows);
+			const int realOutputCol = realRow % cs.output_cols;
+			const int realOutputRow = (realRow / cs.output_cols) % cs.output_rows;
+
+			for (int delta_row = 0; delta_row < cs.kernel_size_rows; delta_row++)
+			{
+				int input_row = realOutputRow * cs.stride_rows + delta_row - cs.padding_top;
+				if (input_row >= 0 && input_row < cs.input_rows)
+					for (int delta_col = 0; delta_col < cs.kernel_size_cols; delta_col++)
+					{
+						int input_col = realOutputCol * cs.stride_cols + delta_col - cs.padding_left;
+						if (input_col >= 0 && input_col < cs.input_cols)
+							for (int in_ch = 0; in_ch < cs.input_channels; in_ch++)
+							{
+								const T a = conv[(delta_row * cs.kernel_size_cols + delta_col) * convN + in_ch * cs.filters + realOutputFilter];
+								dest[row * dest_N + (in_ch * cs.input_rows + input_row) * cs.input_cols + input_col] = a;
+							}
+					}
+			}
+		}
+		});
+}
+
+template <typename T, typename Te>
+void convBackSubstitute(typename AffineExpr<Te>::Queue& queue, const AffineExpr<Te>& expr, const Matrix<T>& conv, const Matrix<T>& convt, const ConvShape& cs, const int parent)
+{
+	if (!expr.A)
+	{
+		bool intervalOut = expr.sound && (std::is_same<T, double>() && std::is_same<Te, float>());
+		auto A = std::make_shared<Matrix<Te>>(expr.m, cs.inputSize(), intervalOut);
+		A->zeroFill();
+		if (intervalOut)
+			convBackSubstituteInit<T, Intv<Te>>(
+				conv, conv.pitch(),
+				*A, A->pitch(), expr.m,
+				cs,
+				expr.rows
+				);
+		else
+			convBackSubstituteInit<T, Te>(
+				conv, conv.pitch(),
+				*A, A->pitch(), expr.m,
+				cs,
+				expr.rows
+				);
+		queue.emplace(expr.m, cs.inputSize(), parent, expr.up, expr.rows, A, expr.b, cs, expr.sound);
+		return;
+
+	}
+	ConvShape ncs = expr.cs * cs;
+
+	auto A = std::make_shared<Matrix<Te>>(expr.m, cs.inputSize(), expr.sound);
+	if (ncs)
+		A->zeroFill();
+	if (expr.sound)
+	{
+		if (expr.A->interval())
+			convBackSubstitute<true, Intv<Te>, Intv<Te>, T, Te>(
+				*expr.A, expr.A->pitch(),
+				convt, convt.pitch(),
+				*A, A->pitch(), A->m(), A->n(),
+				cs,
+				expr.cs,
+				ncs,
+				expr.rows
+				);
+		else
+			convBackSubstitute<true, Te, Intv<Te>, T, Te>(
+				*expr.A, expr.A->pitch(),
+				convt, convt.pitch(),
+				*A, A->pitch(), A->m(), A->n(),
+				cs,
+				expr.cs,
+				ncs,
+				expr.rows
+				);
+	}
+	else
+	{
+		assert(!expr.A->interval());
+		convBackSubstitute<true, Te, Te, T, Te>(
+			*expr.A, expr.A->pitch(),
+			convt, convt.pitch(),
+			*A, A->pitch(), A->m(), A->n(),
+			cs,
+			expr.cs,
+			ncs,
+			expr.rows
+			);
+	}
+
+	queue.emplace(expr.m, cs.inputSize(), parent, expr.up, expr.rows, A, expr.b, ncs, expr.sound);
+}
+
+template<typename T> void Conv2D<T>::backSubstitute(typename AffineExpr<double>::Queue& queue, const AffineExpr<double>& expr) const { convBackSubstitute(queue, expr, conv,convt,cs,parent); }
+template<typename T> void Conv2D<T>::backSubstitute(typename AffineExpr<float>::Queue& queue, const AffineExpr<float>& expr) const { convBackSubstitute(queue, expr, conv, convt, cs,parent); }
+#ifdef STRONG_FP_SOUNDNESS
+template<> void Conv2D<double>::backSubstitute(typename AffineExpr<float>::Queue& queue, const AffineExpr<float>& expr) const { convBackSubstitute(queue, expr, *convf, *convtf, cs, parent); }
+#endif
+
+template <typename Tc, typename Td>
+void convRun(
+	Intv<Td>* dest,
+	const Intv<Td>* input,
+	const Tc* conv, size_t convN,
+	ConvShape cs)
+{
+	const size_t work = size_t(cs.kernel_size_rows) * cs.kernel_size_cols * cs.input_channels;
+	cpu::parallelFor(size_t(cs.outputSize()), cpu::grain(work), [=](size_t begin, size_t end) {
+		for (size_t out = begin; out < end; out++)
+		{
+			const int out_col = out % cs.output_cols;
+			const int out_row = (out / cs.output_cols) % cs.output_rows;
+			const int out_f = out / (cs.output_cols * cs.output_rows);
+			Intv<Td> res = 0;
+			for (int delta_row = 0; delta_row < cs.kernel_size_rows; delta_row++)
+			{
+				int input_row = out_row * cs.stride_rows + delta_row - cs.padding_top;
+				if (input_row >= 0 && input_row < cs.input_rows)
+					for (int delta_col = 0; delta_col < cs.kernel_size_cols; delta_col++)
+					{
+						int input_col = out_col * cs.stride_cols + delta_col - cs.padding_left;
+						if (input_col >= 0 && input_col < cs.input_cols)
+							for (int ch = 0; ch < cs.input_channels; ch++)
+							{
+								const Intv<Td> inp = input[ch * cs.input_rows * cs.input_cols + input_row * cs.input_cols + input_col];
+								const Tc a = conv[(delta_row * cs.kernel_size_cols + delta_col) * convN + ch * cs.filters + out_f];
+								Intv<Td>::fma(res, inp, a, res);
+							}
+					}
+			}
+			dest[out] = res;
+		}
+		});
+}
+
+template <typename T>
+template <typename Te>
+void Conv2D<T>::eval(Vector<Te>& dest, bool sound)
+{
+	const Vector<Te>& input = nn.getConcreteBounds<Te>(parent);
+	assert(input.interval());
+	assert(input.size() == inputSize);
+	dest.resize(outputSize, true);
+	convRun<T, Te>(
+		dest,
+		input,
+		conv, conv.pitch(),
+		cs);
+}
+
+
+
+#ifdef STRONG_FP_SOUNDNESS
+
+template<> Conv2D<double>::Conv2D(
+	NeuralNetwork& nn,
+	const int filters,
+	const int kernel_size_rows, const int kernel_size_cols,
+	const int input_rows, const int input_cols, const int input_channels,
+	const int stride_rows, const int stride_cols,
+	const int padding_top, const int padding_left,
+    const int padding_bottom, const int padding_right,
+	const Matrix<double>& A,
+	int parent) :
+	NeuralNetwork::Layer(nn, ((input_rows + padding_top + padding_bottom - kernel_size_rows + stride_rows) / stride_rows)* ((input_cols + padding_left + padding_right - kernel_size_cols + stride_cols) / stride_cols)* filters),
+	cs( filters, kernel_size_rows, kernel_size_cols, input_rows, input_cols, input_channels, stride_rows, stride_cols, padding_top, padding_left, padding_bottom, padding_right),
+	inputSize(input_rows* input_cols* input_channels),
+	parent(parent),
+
+	convf(std::make_shared<const Matrix<float>>(A, false)),
+	convtf(std::make_shared<const Matrix<float>>(A.transpose(), false)),
+
+	conv(A), convt(A.transpose())
+
+{
+	/*std::cout << "Conv2D:" << std::endl;
+	cs.print();*/
+}
+
+
+
+
+#endif
+
+
+
+template class Conv2D<double>;
+template class Conv2D<float>;
\ No newline at end of file
@@ -0,0 +1,362 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*!
+   \file src/cpu/layers/maxpool2d.cpp
+   \brief MaxPool2D implementation (CPU build).
+
+   CPU counterpart of src/layers/maxpool2d.cu.
+  */
+
+#include "../../layers/maxpool2d.h"
+#include "../../filters.h"
+#include "../parallel.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+template<> inline Vector<double>& MaxPool2D::modelCst<double>() { return modelCstD; }
+template<> inline Vector<double>& MaxPool2D::modelFac<double>() { return modelFacD; }
+template<> inline Vector<float>& MaxPool2D::modelCst<float>() { return modelCstS; }
+template<> inline Vector<float>& MaxPool2D::modelFac<float>() { return modelFacS; }
+template<> inline const Vector<double>& MaxPool2D::modelCst<double>()const { return modelCstD; }
+template<> inline const Vector<double>& MaxPool2D::modelFac<double>() const { return modelFacD; }
+template<> inline const Vector<float>& MaxPool2D::modelCst<float>() const { return modelCstS; }
+template<> inline const Vector<float>& MaxPool2D::modelFac<float>() const { return modelFacS; }
+void MaxPool2D::eval(Vector<double>& dest, bool sound, bool precise) { eval<double>(dest, sound,precise); }
+void MaxPool2D::eval(Vector<float>& dest, bool sound, bool precise) { eval<float>(dest, sound,precise); }
+void MaxPool2D::backSubstitute(typename AffineExpr<double>::Queue& queue, const AffineExpr<double>& expr) const { backSubstitute<double>(queue, expr); }
+void MaxPool2D::backSubstitute(typename AffineExpr<float>::Queue& queue, const AffineExpr<float>& expr) const { backSubstitute<float>(queue, expr); }
+
+
+template <typename T>
+void evalMaxPool2D(
+	Intv<T>* dest,
+	Intv<T>* modelCst,
+	Intv<T>* modelFac,
+	size_t* modelNeuron,
+	const Intv<T>* input,
+	ConvShape cs)
+{
+	const size_t work = size_t(cs.kernel_size_rows) * cs.kernel_size_cols;
+	cpu::parallelFor(size_t(cs.outputSize()), cpu::grain(2 * work), [=](size_t begin, size_t end) {
+		for (size_t destAdr = begin; destAdr < end; destAdr++)
+		{
+			const int out_col = destAdr % cs.output_cols;
+			const int out_row = (destAdr / cs.output_cols) % cs.output_rows;
+			const int ch = destAdr / (cs.output_cols * cs.output_rows);
+			const Intv<T>* channel = input + ch * cs.input_rows * cs.input_cols;
+
+			// First look into the current pool for the elements with the highest bounds
+
+			int highestUpId = 0; // Id of the elmenet with the highest upper bound of the pool
+			T highestUp = -HUGE_VAL; // value of the upper bound of that element
+			T highestUpDown = 0; // value of the lower bound of that element
+
+			T highestDown = -HUGE_VAL; // value of the highest lower bound in the pool
+			for (int delta_row = 0; delta_row < cs.kernel_size_rows; delta_row++)
+			{
+				int input_row = out_row * cs.stride_rows + delta_row - cs.padding_top;
+				if (input_row >= 0 && input_row < cs.input_rows)
+					for (int delta_col = 0; delta_col < cs.kernel_size_cols; delta_col++)
+					{
+						int input_col = out_col * cs.stride_cols + delta_col - cs.padding_left;
+						if (input_col >= 0 && input_col < cs.input_cols)
+						{
+							int curId = input_row * cs.input_cols + input_col;
+							const Intv<T> inp = channel[curId];
+							highestDown = Intv<T>::max(highestDown, inp.low);
+							if (highestUp < inp.high)
+							{
+								highestUp = inp.high;
+								highestUpId = curId;
+								highestUpDown = inp.low;
+							}
+						}
+					}
+			}
+
+			// We now check if the neuron with the highest upper bound is uncontested, i.e. if there are no other neuron in the pool that has a higher upper bound than its lower bound. If it is contested, we maintain the best contestant upper bound.
+			bool uncontested = true;
+			T bestContestant = highestUpDown;
+			for (int delta_row = 0; delta_row < cs.kernel_size_rows; delta_row++)
+			{
+				int input_row = out_row * cs.stride_rows + delta_row - cs.padding_top;
+				if (input_row >= 0 && input_row < cs.input_rows)
+					for (int delta_col = 0; delta_col < cs.kernel_size_cols; delta_col++)
+					{
+						int input_col = out_col * cs.stride_cols + delta_col - cs.padding_left;
+						if (input_col >= 0 && input_col < cs.input_cols)
+						{
+							int curId = input_row * cs.input_cols + input_col;
+							const Intv<T> inp = channel[curId];
+							if (curId != highestUpId && bestContestant < inp.high)
+							{
+								uncontested = false;
+								bestContestant = inp.high;
+							}
+						}
+					}
+			}
+
+			dest[destAdr] = Intv<T>(highestDown, highestUp);
+			modelNeuron[destAdr] = highestUpId;
+			if (uncontested)
+			{
+				modelCst[destAdr] = T(0);
+				modelFac[destAdr] = T(1);
+			}
+			else
+			{
+				T facUp = (highestUp - bestContestant) / (highestUp - highestUpDown);
+				T cstUp = Intv<T>::template fma_dr<true>(facUp, -highestUpDown, bestContestant);
+				bool facDown = (highestUp - highestDown) > (highestDown - highestUpDown);
+				T cstDown = facDown ? 0 : highestDown;
+				modelCst[destAdr] = Intv<T>(cstDown, cstUp);
+				modelFac[destAdr] = Intv<T>(facDown, facUp);
+			}
+		}
+		});
+}
+
+template<typename T>
+void MaxPool2D::eval(Vector<T>& dest, bool sound, bool precise)
+{
+	AlwaysKeep<T> filter;
+	if (precise)
+	{
+		nn.reEvaluateLayer<T>(parent, filter, false, sound);
+		nn.reEvaluateLayer<T>(parent, filter, true, sound);
+	}
+	const Vector<T>& input = nn.getConcreteBounds<T>(parent);
+	assert(input.interval());
+	dest.resize(outputSize, true);
+	evalMaxPool2D<T>(
+		dest,
+		modelCst<T>(),
+		modelFac<T>(),
+		modelNeuron,
+		input,
+		cs);
+}
+
+
+
+template <typename Texpr, typename Tdest, typename T>
+void MaxPoolBackPropagate(
+	const Texpr* expr, size_t expr_N,
+	const Intv<T>* modelCst,
+	const Intv<T>* modelFac,
+	const size_t* modelNeuron,
+	Tdest* dest, size_t dest_N, int dest_m, int dest_n,
+	ConvShape cs,
+	ConvShape prevShape,
+	const int* rows,
+	bool upper
+)
+{
+	const size_t channelSize = size_t(cs.input_rows) * cs.input_cols;
+	cpu::parallelFor(size_t(dest_m) * cs.input_channels, cpu::grain(channelSize), [=](size_t begin, size_t end) {
+		for (size_t task = begin; task < end; task++)
+		{
+			const int in_ch = task % cs.input_channels;
+			const int row = task / cs.input_channels;
+			for (int col = 0; col < int(channelSize); col++)
+			{
+				const int in_row = col / cs.input_cols;
+				const int in_col = col % cs.input_cols;
+
+				int out_row_min = std::max(0, (in_row + cs.padding_top - cs.kernel_size_rows + cs.stride_rows) / cs.stride_rows);
+				int out_row_max = std::min(cs.output_rows, (in_row + cs.padding_top) / cs.stride_rows + 1);
+				int out_col_min = std::max(0, (in_col + cs.padding_left - cs.kernel_size_cols + cs.stride_cols) / cs.stride_cols);
+				int out_col_max = std::min(cs.output_cols, (in_col + cs.padding_left) / cs.stride_cols + 1);
+
+
+				if (prevShape) {
+					if (prevShape.isDiagonal())
+					{
+						const int realRow = rows[row];
+						const int realOutputCol = realRow % cs.output_cols;
+						const int realOutputRow = (realRow / cs.output_cols) % cs.output_rows;
+						out_row_min = std::max(out_row_min, realOutputRow);
+						out_row_max = std::min(out_row_max, realOutputRow + 1);
+						out_col_min = std::max(out_col_min, realOutputCol);
+						out_col_max = std::min(out_col_max, realOutputCol + 1);
+					}
+					else
+					{
+						const int realRow = rows[row];
+						const int realOutputCol = realRow % prevShape.output_cols;
+						const int realOutputRow = (realRow / prevShape.output_cols) % prevShape.output_rows;
+						out_row_min = std::max(out_row_min, realOutputRow * prevShape.stride_rows - prevShape.padding_top);
+						out_row_max = std::min(out_row_max, realOutputRow * prevShape.stride_rows - prevShape.padding_top + prevShape.kernel_size_rows);
+						out_col_min = std::max(out_col_min, realOutputCol * prevShape.stride_cols - prevShape.padding_left);
+						out_col_max = std::min(out_col_max, realOutputCol * prevShape.stride_cols - prevShape.padding_left + prevShape.kernel_size_cols);
+					}
+				}
+
+				Tdest res(T(0));
+				for (int out_row = out_row_min; out_row < out_row_max; out_row++)
+				{
+					for (int out_col = out_col_min; out_col < out_col_max; out_col++)
+					{
+						size_t curId = (in_ch * cs.output_rows + out_row) * cs.output_cols + out_col;
+						if (modelNeuron[curId] == size_t(col))
+						{
+							const Texpr in = expr[row * expr_N + curId];
+							const Intv<T> coef = modelFac[curId];
+
+							T in1 = Intv<T>::template access_dr<false>(in);
+							T coef1 = (in1 > 0 == upper) ? coef.high : coef.low;
+							Intv<T>::template access_dr<false>(res) = Intv<T>::template fma_dr<false>(in1, coef1, Intv<T>::template access_dr<false>(res));
+							if (std::is_same<Intv<T>, Texpr>::value)
+							{
+								T in2 = Intv<T>::template access_dr<true>(in);
+								T coef2 = (in2 > 0 == upper) ? coef.high : coef.low;
+								Intv<T>::template access_dr<true>(res) = Intv<T>::template fma_dr<true>(in2, coef2, Intv<T>::template access_dr<true>(res));
+							}
+							else if (std::is_same<Intv<T>, Tdest>::value)
+							{
+								Intv<T>::template access_dr<true>(res) = Intv<T>::template fma_dr<true>(in1, coef1, Intv<T>::template access_dr<true>(res));
+							}
+						}
+					}
+				}
+
+				dest[row * dest_N + in_ch * channelSize + col] = res;
+			}
+		}
+		});
+}
+template <typename TA, bool upper, typename T>
+static void MaxPoolBackSubstituteCst(T* destb, const TA* exprA, const T* exprb, const Intv<T>* modelCst, const size_t expr_N, const size_t m, const size_t n)
+{
+	cpu::parallelFor(m, cpu::grain(n), [=](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++)
+		{
+			T res = exprb ? exprb[row] : 0;
+			for (size_t col = 0; col < n; col++)
+			{
+				T in1 = Intv<T>::template access_dr<false>(exprA[row * expr_N + col]);
+				T off1 = (in1 > 0 == upper) ? modelCst[col].high : modelCst[col].low;
+				T res1 = Intv<T>::template fma_dr<upper>(off1, in1, res);
+				if (std::is_same<Intv<T>, TA>::value)
+				{
+					T in2 = Intv<T>::template access_dr<true>(exprA[row * expr_N + col]);
+					T off2 = (in2 > 0 == upper) ? modelCst[col].high : modelCst[col].low;
+					T res2 = Intv<T>::template fma_dr<upper>(off2, in2, res);
+					res = upper ? Intv<T>::max(res1, res2) : Intv<T>::min(res1, res2);
+				}
+				else
+				{
+					res = res1;
+				}
+			}
+			destb[row] = res;
+		}
+		});
+}
+
+template <typename T>
+void MaxPool2D::backSubstitute(typename AffineExpr<T>::Queue& queue, const AffineExpr<T>& expr) const {
+	assert(expr.A);
+	std::shared_ptr<Matrix<T>> A;
+	ConvShape ncs = expr.cs * cs;
+	if (expr.sound)
+	{
+		A = std::make_shared<Matrix<T>>(expr.m, cs.inputSize(), true);
+		if (expr.A->interval())
+		{
+			MaxPoolBackPropagate<Intv<T>, Intv<T>, T>(
+				*expr.A, expr.A->pitch(),
+				modelCst<T>(),
+				modelFac<T>(),
+				modelNeuron,
+				*A, A->pitch(), A->m(), A->n(),
+				cs,
+				expr.cs,
+				expr.rows,
+				expr.up
+				);
+		}
+		else
+		{
+			MaxPoolBackPropagate<T, Intv<T>, T>(
+				*expr.A, expr.A->pitch(),
+				modelCst<T>(),
+				modelFac<T>(),
+				modelNeuron,
+				*A, A->pitch(), A->m(), A->n(),
+				cs,
+				expr.cs,
+				expr.rows,
+				expr.up
+				);
+		}
+	}
+	else
+	{
+		assert(!expr.A->interval());
+		A = std::make_shared<Matrix<T>>(expr.m, cs.inputSize(), false);
+		MaxPoolBackPropagate<T, T, T>(
+			*expr.A, expr.A->pitch(),
+			modelCst<T>(),
+			modelFac<T>(),
+			modelNeuron,
+			*A, A->pitch(), A->m(), A->n(),
+			cs,
+			expr.cs,
+			expr.rows,
+			expr.up
+			);
+	}
+
+	auto b = std::make_shared<Vector<T>>(expr.m, false);
+
+	if (expr.A->interval())
+		if (expr.up)
+			MaxPoolBackSubstituteCst<Intv<T>, true, T>(*b, (const Intv<T>*)*expr.A, expr.b ? (const T*)*expr.b : nullptr, modelCst<T>(), expr.A->pitch(), expr.m, expr.n);
+		else
+			MaxPoolBackSubstituteCst<Intv<T>, false, T>(*b, (const Intv<T>*)*expr.A, expr.b ? (const T*)*expr.b : nullptr, modelCst<T>(), expr.A->pitch(), expr.m, expr.n);
+	else
+		if (expr.up)
+			MaxPoolBackSubstituteCst<T, true, T>(*b, (const T*)*expr.A, expr.b ? (const T*)*expr.b : nullptr, modelCst<T>(), expr.A->pitch(), expr.m, expr.n);
+		else
+			MaxPoolBackSubstituteCst<T, false, T>(*b, (const T*)*expr.A, expr.b ? (const T*)*expr.b : nullptr, modelCst<T>(), expr.A->pitch(), expr.m, expr.n);
+
+	queue.emplace(expr.m, cs.inputSize(), parent, expr.up, expr.rows, A, b, ncs, expr.sound);
+}
+
+MaxPool2D::MaxPool2D(NeuralNetwork& nn, int pool_rows, int pool_cols, int input_rows, int input_cols, int input_channels, int stride_rows, int stride_cols, int padding_top, int padding_left, int padding_bottom, int padding_right, int parent) :
+	//Layer(input_rows / pool_rows * input_cols / pool_cols * input_channels),
+	NeuralNetwork::Layer(nn,((input_rows + padding_left + padding_bottom - pool_rows + stride_rows) / stride_rows)* ((input_cols + padding_left + padding_right - pool_cols + stride_cols) / stride_cols)* input_channels),
+	parent(parent),
+	cs(input_channels, pool_rows, pool_cols, input_rows, input_cols, input_channels, stride_rows, stride_cols, padding_top, padding_left, padding_bottom, padding_right),
+	modelCstS(outputSize, true), modelCstD(outputSize, true),
+	modelFacS(outputSize, true), modelFacD(outputSize, true)
+{
+	gpuErrchk(cudaMalloc((void**)&modelNeuron,outputSize * sizeof(size_t)));
+	/*std::cout << "MaxPool2D:" << std::endl;
+	cs.print();*/
+}
+
+MaxPool2D::~MaxPool2D() {
+	cudaFree(modelNeuron);
+}
@@ -0,0 +1,331 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*! \file src/cpu/matrix.cpp
+	 \brief Implementation of Matrix (CPU build)
+
+	 CPU counterpart of src/matrix.cu: implementation of non arithmetic members of the class Matrix, defined in src/matrix.h, as well as additions of matrices and vectors.
+ */
+
+#include "../matrix.h"
+#include "parallel.h"
+
+#define GLOBAL_ALIGNMENT_SIZE 128
+
+size_t lowestMultiple(const size_t n, const size_t m)
+{
+	return (n / m + (n % m != 0)) * m;
+}
+
+template<typename T>
+GPUMem<false> Matrix<T>::gpuMem;
+
+template<typename T>
+Matrix<T>::Matrix() :capacity(0), data_(NULL), m_(0), n_(0), N_(0) {}
+
+template<typename T>
+Matrix<T>::Matrix(size_t m, size_t n, bool interval) : capacity(0), data_(NULL)
+{
+	reshape(m, n, interval);
+}
+
+template<typename T>
+Matrix<T>::Matrix(const std::vector<std::vector<T>>& M) : capacity(0), data_(NULL)
+{
+	m_ = M.size();
+	if (m_ == 0)
+	{
+		interval_ = false;
+		n_ = 0;
+		N_ = 0;
+		data_ = NULL;
+		capacity = 0;
+	}
+	else
+	{
+		reshape(m_, M.front().size(), false);
+		for (size_t i = 0; i < m_; i++)
+		{
+			assert(M[i].size() == n_);
+			std::copy(M[i].begin(), M[i].end(), data_ + i * N_);
+		}
+	}
+}
+
+template<typename T>
+Matrix<T>::Matrix(size_t m, size_t n, const T* data) :Matrix<T>(m, n, false)
+{
+	if (m * n > 0)
+		gpuErrchk(cudaMemcpy2D(data_, pitchBytes(), data, n * sizeof(T), n * sizeof(T), m, cudaMemcpyHostToDevice));
+}
+
+template<typename T>
+Matrix<T>::Matrix(const Matrix<T>& other) :Matrix(other.m_, other.n_, other.interval_)
+{
+	if (m_ * n_ > 0)
+		gpuErrchk(cudaMemcpy2D(data_, pitchBytes(), other.data_, other.pitchBytes(), (1 + interval_) * n_ * sizeof(T), m_, cudaMemcpyDeviceToDevice));
+}
+
+template<typename T>
+Matrix<T>::Matrix(Matrix<T>&& other)
+{
+	interval_ = other.interval_;
+	n_ = other.n_;
+	N_ = other.N_;
+	m_ = other.m_;
+	data_ = other.data_;
+	capacity = other.capacity;
+	other.capacity = 0;
+	other.data_ = NULL;
+}
+
+template<typename T>
+Matrix<T>& Matrix<T>::operator= (Matrix<T>&& other)
+{
+	if (&other != this)
+	{
+		n_ = other.n_;
+		N_ = other.N_;
+		m_ = other.m_;
+		interval_ = other.interval_;
+		if (data_)
+			gpuMem.free(data_, capacity);
+		data_ = other.data_;
+		capacity = other.capacity;
+		other.capacity = 0;
+		other.data_ = NULL;
+	}
+	return *this;
+}
+
+template<typename T>
+Matrix<T>& Matrix<T>::operator= (const Matrix<T>& other)
+{
+	if (&other != this)
+	{
+		reshape(other.m_, other.n_, other.interval_);
+		if (m_ * n_ > 0)
+			gpuErrchk(cudaMemcpy2D(data_, N_ * sizeof(T), other.data_, N_ * sizeof(T), (1 + interval_) * n_ * sizeof(T), m_, cudaMemcpyDeviceToDevice));
+	}
+	return *this;
+}
+
+template<typename T>
+void Matrix<T>::reshape(const size_t m, const size_t n, const bool interval)
+{
+	m_ = m;
+	n_ = n;
+	interval_ = interval;
+	N_ = lowestMultiple(interval ? 2 * n : n, GLOBAL_ALIGNMENT_SIZE / sizeof(T));
+	if (capacity < memSize())
+	{
+		if (data_)
+			gpuMem.free(data_, capacity);
+		capacity = memSize();
+		data_ = static_cast<T*>(gpuMem.alloc(capacity));
+	}
+}
+
+template <typename TA, typename TB, typename TD, typename T>
+void addMatrix(
+	TD* dest, const size_t destN,
+	const TA* lhs, const size_t lhsN,
+	const TB* rhs, const size_t rhsN,
+	const size_t m, const size_t n)
+{
+	cpu::parallelFor(m, cpu::grain(n), [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			for (size_t j = 0; j < n; j++)
+				Intv<T>::add(dest[i * destN + j], lhs[i * lhsN + j], rhs[i * rhsN + j]);
+		});
+}
+
+template<typename T>
+void Matrix<T>::add(Matrix<T>& dest, const Matrix<T>& lhs, const Matrix<T>& rhs, bool sound)
+{
+	assert(lhs.n_ == rhs.n_);
+	assert(lhs.m_ == rhs.m_);
+	if (sound)
+	{
+		dest.reshape(lhs.m_, lhs.n_, true);
+		if (lhs.interval_)
+		{
+			if (rhs.interval_)
+				addMatrix<Intv<T>, Intv<T>, Intv<T>, T>(dest, dest.pitch(), lhs, lhs.pitch(), rhs, rhs.pitch(), lhs.m(), lhs.n());
+			else
+				addMatrix<Intv<T>, T, Intv<T>, T>(dest, dest.pitch(), lhs, lhs.pitch(), rhs, rhs.pitch(), lhs.m(), lhs.n());
+		}
+		else
+		{
+			if (rhs.interval_)
+				addMatrix<T, Intv<T>, Intv<T>, T>(dest, dest.pitch(), lhs, lhs.pitch(), rhs, rhs.pitch(), lhs.m(), lhs.n());
+			else
+				addMatrix<T, T, Intv<T>, T>(dest, dest.pitch(), lhs, lhs.pitch(), rhs, rhs.pitch(), lhs.m(), lhs.n());
+		}
+	}
+	else
+	{
+		assert(!lhs.interval());
+		assert(!rhs.interval());
+		dest.reshape(lhs.m_, lhs.n_, false);
+		addMatrix<T, T, T, T>(dest, dest.pitch(), lhs, lhs.pitch(), rhs, rhs.pitch(), lhs.m(), lhs.n());
+	}
+}
+
+template<typename T>
+template<typename Tr>
+void Vector<T>::add(Vector<T>& dest, const Vector<T>& lhs, const Vector<Tr>& rhs)
+{
+	assert(lhs.size() == rhs.size());
+	dest.resize(lhs.n_, true);
+	if (lhs.interval())
+	{
+		if (rhs.interval())
+			addMatrix<Intv<T>, Intv<Tr>, Intv<T>, T>(dest, dest.size(), lhs, lhs.size(), rhs, rhs.size(), 1, lhs.size());
+		else
+			addMatrix<Intv<T>, Tr, Intv<T>, T>(dest, dest.size(), lhs, lhs.size(), rhs, rhs.size(), 1, lhs.size());
+	}
+	else
+	{
+		if (rhs.interval())
+			addMatrix<T, Intv<Tr>, Intv<T>, T>(dest, dest.size(), lhs, lhs.size(), rhs, rhs.size(), 1, lhs.size());
+		else
+			addMatrix<T, Tr, Intv<T>, T>(dest, dest.size(), lhs, lhs.size(), rhs, rhs.size(), 1, lhs.size());
+	}
+}
+template void Vector<double>::add(Vector<double>& dest, const Vector<double>& lhs, const Vector<double>& rhs);
+template void Vector<double>::add(Vector<double>& dest, const Vector<double>& lhs, const Vector<float>& rhs);
+template void Vector<float>::add(Vector<float>& dest, const Vector<float>& lhs, const Vector<double>& rhs);
+template void Vector<float>::add(Vector<float>& dest, const Vector<float>& lhs, const Vector<float>& rhs);
+
+template<typename T>
+template <bool up>
+std::shared_ptr<const Vector<T>> Vector<T>::add_dr(std::shared_ptr<const Vector<T>> lhs, std::shared_ptr<const Vector<T>> rhs, std::shared_ptr<Vector<T>> dest)
+{
+	assert(!lhs || !lhs->interval());
+	assert(!rhs || !rhs->interval());
+	if (!lhs)
+		return rhs;
+	if (!rhs)
+		return lhs;
+	assert(lhs->n_ == rhs->n_);
+	if (dest)
+		dest->resize(lhs->n_, false);
+	else
+		dest = std::make_shared<Vector<T>>(lhs->n_, false);
+	T* d = *dest;
+	const T* l = *lhs;
+	const T* r = *rhs;
+	cpu::parallelFor(lhs->n_, cpu::minWork, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			d[i] = Intv<T>::template add_dr<up>(l[i], r[i]);
+		});
+	return dest;
+}
+
+template
+std::shared_ptr<const Vector<double>> Vector<double>::add_dr<true>(std::shared_ptr<const Vector<double>> lhs, std::shared_ptr<const Vector<double>> rhs, std::shared_ptr<Vector<double>> dest);
+template
+std::shared_ptr<const Vector<double>> Vector<double>::add_dr<false>(std::shared_ptr<const Vector<double>> lhs, std::shared_ptr<const Vector<double>> rhs, std::shared_ptr<Vector<double>> dest);
+
+template
+std::shared_ptr<const Vector<float>> Vector<float>::add_dr<true>(std::shared_ptr<const Vector<float>> lhs, std::shared_ptr<const Vector<float>> rhs, std::shared_ptr<Vector<float>> dest);
+template
+std::shared_ptr<const Vector<float>> Vector<float>::add_dr<false>(std::shared_ptr<const Vector<float>> lhs, std::shared_ptr<const Vector<float>> rhs, std::shared_ptr<Vector<float>> dest);
+
+
+//! Copies (and converts) the rows of a matrix; if annoyingList is not null, the ith row of A is the row annoyingList[i] of oA.
+template <typename Tout, typename Tin>
+void backSubstituteDense(Tout* A, const size_t pitchOut, const int* annoyingList, const size_t m, const size_t n, const Tin* oA, const size_t pitchIn)
+{
+	cpu::parallelFor(m, cpu::grain(n), [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			const size_t row = annoyingList ? annoyingList[i] : i;
+			for (size_t j = 0; j < n; j++)
+				A[i * pitchOut + j] = oA[row * pitchIn + j];
+		}
+		});
+}
+
+template<typename T>
+template<typename Td>
+Matrix<Td> Matrix<T>::selectRows(size_t size, const int* rows, bool forceIntervalOut) const
+{
+	bool intervalOut = interval_ || forceIntervalOut;
+	Matrix<Td> res(size, n_, intervalOut);
+	if (interval_)
+		backSubstituteDense<Intv<Td>, Intv<T>>(res, res.pitch(), rows, size, n_, *this, pitch());
+	else
+		if (intervalOut)
+			backSubstituteDense<Intv<Td>, T>(res, res.pitch(), rows, size, n_, *this, pitch());
+		else
+			backSubstituteDense<Td, T>(res, res.pitch(), rows, size, n_, *this, pitch());
+	return res;
+}
+
+template Matrix<double> Matrix<double>::selectRows(size_t size, const int* rows, bool forceIntervalOut) const;
+template Matrix<float> Matrix<double>::selectRows(size_t size, const int* rows, bool forceIntervalOut) const;
+template Matrix<double> Matrix<float>::selectRows(size_t size, const int* rows, bool forceIntervalOut) const;
+template Matrix<float> Matrix<float>::selectRows(size_t size, const int* rows, bool forceIntervalOut) const;
+
+
+template<typename T>
+template<typename To>
+Matrix<T>::Matrix(const Matrix<To>& other, bool sound) :Matrix(other.m(), other.n(), other.interval() || (sound && std::is_same<T, float>() && std::is_same<To, double>()))
+{
+	if (other.interval())
+		backSubstituteDense<Intv<T>, Intv<To>>(*this, pitch(), nullptr, m_, n_, other, other.pitch());
+	else
+		if (interval())
+			backSubstituteDense<Intv<T>, To>(*this, pitch(), nullptr, m_, n_, other, other.pitch());
+		else
+			backSubstituteDense<T, To>(*this, pitch(), nullptr, m_, n_, other, other.pitch());
+}
+template Matrix<double>::Matrix(const Matrix<float>&, bool);
+template Matrix<float>::Matrix(const Matrix<double>&, bool);
+template Matrix<double>::Matrix(const Matrix<double>&, bool);
+template Matrix<float>::Matrix(const Matrix<float>&, bool);
+
+
+template<typename T>
+Matrix<T> Matrix<T>::transpose() const {
+	assert(!interval());
+	const size_t tile = 32;
+	Matrix<T> res(n(), m(), false);
+	T* dest = res;
+	const T* src = *this;
+	const size_t destN = res.pitch();
+	const size_t srcN = pitch();
+	const size_t m = m_;
+	const size_t n = n_;
+	cpu::parallelFor((n + tile - 1) / tile, cpu::grain(tile * m), [=](size_t begin, size_t end) {
+		for (size_t j0 = begin * tile; j0 < std::min(n, end * tile); j0 += tile)
+			for (size_t i0 = 0; i0 < m; i0 += tile)
+				for (size_t j = j0; j < std::min(n, j0 + tile); j++)
+					for (size_t i = i0; i < std::min(m, i0 + tile); i++)
+						dest[j * destN + i] = src[i * srcN + j];
+		});
+	return res;
+}
+
+template class Matrix<double>;
+
+template class Matrix<float>;
@@ -0,0 +1,118 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*! \file src/cpu/mmm.cpp
+	 \brief Implementation of Matrix-Matrix multiplication (CPU build)
+
+	 CPU counterpart of src/mmm.cu. The product is computed by a blocked kernel: the result is split in tiles of MC x NC elements that are distributed over the thread pool, and the inner dimension is traversed by blocks of KC so that the corresponding rows of the rhs stay in cache.
+  */
+
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+#include "../matrix.h"
+#include "parallel.h"
+
+namespace
+{
+	constexpr size_t MC = 16; // rows of a tile
+	constexpr size_t NC = 128; // columns of a tile
+	constexpr size_t KC = 128; // depth of a block of the inner dimension
+
+	template <typename T>
+	inline bool isZero(const T& a) { return a == 0; }
+	template <typename T>
+	inline bool isZero(const Intv<T>& a) { return a.low == 0 && a.high == 0; }
+}
+
+//! dest = lhs * rhs, where T is the scalar type of dest
+/*!
+  Terms for which the lhs element is exactly zero are skipped, as their product is exactly zero.
+*/
+template <typename TA, typename TB, typename TD, typename T>
+void blockedGemm(
+	const size_t m, const size_t n, const size_t k,
+	const TA* dataA, const size_t pitchA,
+	const TB* dataB, const size_t pitchB,
+	TD* dest, const size_t pitchDest
+)
+{
+	const size_t tilesM = (m + MC - 1) / MC;
+	const size_t tilesN = (n + NC - 1) / NC;
+	cpu::parallelFor(tilesM * tilesN, 1, [=](size_t begin, size_t end) {
+		for (size_t tile = begin; tile < end; tile++)
+		{
+			const size_t i0 = (tile / tilesN) * MC;
+			const size_t i1 = std::min(m, i0 + MC);
+			const size_t j0 = (tile % tilesN) * NC;
+			const size_t j1 = std::min(n, j0 + NC);
+			for (size_t i = i0; i < i1; i++)
+				memset(dest + i * pitchDest + j0, 0, (j1 - j0) * sizeof(TD));
+			for (size_t k0 = 0; k0 < k; k0 += KC)
+			{
+				const size_t k1 = std::min(k, k0 + KC);
+				for (size_t i = i0; i < i1; i++)
+				{
+					TD* d = dest + i * pitchDest;
+					for (size_t kk = k0; kk < k1; kk++)
+					{
+						const TA a = dataA[i * pitchA + kk];
+						if (isZero(a))
+							continue;
+						const TB* b = dataB + kk * pitchB;
+						for (size_t j = j0; j < j1; j++)
+							Intv<T>::fma(d[j], a, b[j], d[j]);
+					}
+				}
+			}
+		}
+		});
+}
+
+template <typename T>
+template <typename Tr>
+void Matrix<T>::mmm(const Matrix<Tr>& rhs, Matrix<T>& dest, bool sound) const
+{
+	assert(rhs.m() == n());
+	if (!sound && !interval() && !rhs.interval())
+	{
+		dest.reshape(m(), rhs.n(), false);
+		blockedGemm<T, Tr, T, T>(m(), rhs.n(), n(), *this, pitch(), rhs, rhs.pitch(), dest, dest.pitch());
+		return;
+	}
+	dest.reshape(m(), rhs.n(), true);
+	if (interval())
+	{
+		assert(!rhs.interval());
+		blockedGemm<Intv<T>, Tr, Intv<T>, T>(m(), rhs.n(), n(), *this, pitch(), rhs, rhs.pitch(), dest, dest.pitch());
+	}
+	else
+	{
+		if (rhs.interval())
+			blockedGemm<T, Intv<Tr>, Intv<T>, T>(m(), rhs.n(), n(), *this, pitch(), rhs, rhs.pitch(), dest, dest.pitch());
+		else
+			blockedGemm<T, Tr, Intv<T>, T>(m(), rhs.n(), n(), *this, pitch(), rhs, rhs.pitch(), dest, dest.pitch());
+	}
+}
+
+template void Matrix<double>::mmm<double>(const Matrix<double>& rhs, Matrix<double>& dest, bool sound) const;
+template void Matrix<float>::mmm<float>(const Matrix<float>& rhs, Matrix<float>& dest, bool sound) const;
+template void Matrix<double>::mmm<float>(const Matrix<float>& rhs, Matrix<double>& dest, bool sound) const;
+template void Matrix<float>::mmm<double>(const Matrix<double>& rhs, Matrix<float>& dest, bool sound) const;
@@ -0,0 +1,117 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+ /*! \file src/cpu/mvm.cpp
+	  \brief Implementation of Matrix-Vector multiplication (CPU build)
+
+	  CPU counterpart of src/mvm.cu. Rows are distributed over the thread pool, and each dot product is accumulated sequentially.
+  */
+
+#include <assert.h>
+#include "../matrix.h"
+#include "parallel.h"
+
+template <bool up, typename TA, typename TB, typename TC, typename T>
+void mvmKernel_dr(T* dest, const TA* A, const TB* b, const TC* c, const size_t m, const size_t n, const size_t N)
+{
+	cpu::parallelFor(m, cpu::grain(n), [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			T res = c ? Intv<T>::template access_dr<up>(c[i]) : 0;
+			for (size_t j = 0; j < n; j++)
+				res = Intv<T>::template fma_dr<up>(A[i * N + j], b[j], res);
+			dest[i] = res;
+		}
+		});
+}
+template <typename T>
+template<bool up, typename Tr>
+void Matrix<T>::mvm_dr(Vector<T>& dest, const Vector<Tr>& rhs, std::shared_ptr<const Vector<T>> offset) const
+{
+	assert(rhs.size() == n_);
+	assert(!offset || offset->size() == m_);
+	assert(!offset || !offset->interval());
+	dest.resize(m_, false);
+	if (interval_)
+	{
+		if (rhs.interval())
+			mvmKernel_dr<up, Intv<T>, Intv<Tr>, T, T>(dest, *this, rhs, offset ? (const T*)*offset : nullptr, m_, n_, pitch());
+		else
+			mvmKernel_dr<up, Intv<T>, Tr, T, T>(dest, *this, rhs, offset ? (const T*)*offset : nullptr, m_, n_, pitch());
+	}
+	else
+	{
+		if (rhs.interval())
+			mvmKernel_dr<up, T, Intv<Tr>, T, T>(dest, *this, rhs, offset ? (const T*)*offset : nullptr, m_, n_, pitch());
+		else
+			mvmKernel_dr<up, T, Tr, T, T>(dest, *this, rhs, offset ? (const T*)*offset : nullptr, m_, n_, pitch());
+	}
+}
+template void Matrix<double>::mvm_dr<false>(Vector<double>& dest, const Vector<double>& rhs, std::shared_ptr<const Vector<double>> offset) const;
+template void Matrix<double>::mvm_dr<true>(Vector<double>& dest, const Vector<double>& rhs, std::shared_ptr<const Vector<double>> offset) const;
+template void Matrix<float>::mvm_dr<false>(Vector<float>& dest, const Vector<float>& rhs, std::shared_ptr<const Vector<float>> offset) const;
+template void Matrix<float>::mvm_dr<true>(Vector<float>& dest, const Vector<float>& rhs, std::shared_ptr<const Vector<float>> offset) const;
+template void Matrix<double>::mvm_dr<false>(Vector<double>& dest, const Vector<float>& rhs, std::shared_ptr<const Vector<double>> offset) const;
+template void Matrix<double>::mvm_dr<true>(Vector<double>& dest, const Vector<float>& rhs, std::shared_ptr<const Vector<double>> offset) const;
+template void Matrix<float>::mvm_dr<false>(Vector<float>& dest, const Vector<double>& rhs, std::shared_ptr<const Vector<float>> offset) const;
+template void Matrix<float>::mvm_dr<true>(Vector<float>& dest, const Vector<double>& rhs, std::shared_ptr<const Vector<float>> offset) const;
+
+
+template <typename TA, typename TB, typename T>
+void mvmKernel(Intv<T>* dest, const TA* A, const TB* b, const size_t m, const size_t n, const size_t N)
+{
+	cpu::parallelFor(m, cpu::grain(n), [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			Intv<T> res(0);
+			for (size_t j = 0; j < n; j++)
+				Intv<T>::fma(res, b[j], A[i * N + j], res);
+			dest[i] = res;
+		}
+		});
+}
+
+template <typename T>
+template <typename Tr>
+void Matrix<T>::mvm(Vector<Tr>& dest, const Vector<Tr>& rhs) const
+{
+	assert(rhs.size() == n_);
+	dest.resize(m_, true);
+	if (interval_)
+	{
+		if (rhs.interval())
+			mvmKernel<Intv<T>, Intv<Tr>, Tr>(dest, *this, rhs, m_, n_, N_ / 2);
+		else
+			mvmKernel<Intv<T>, Tr, Tr>(dest, *this, rhs, m_, n_, N_ / 2);
+	}
+	else
+	{
+		if (rhs.interval())
+			mvmKernel<T, Intv<Tr>, Tr>(dest, *this, rhs, m_, n_, N_);
+		else
+			mvmKernel<T, Tr, Tr>(dest, *this, rhs, m_, n_, N_);
+	}
+}
+
+
+template void Matrix<double>::mvm(Vector<double>& dest, const Vector<double>& rhs) const;
+template void Matrix<float>::mvm(Vector<float>& dest, const Vector<float>& rhs) const;
+template void Matrix<double>::mvm(Vector<float>& dest, const Vector<float>& rhs) const;
+template void Matrix<float>::mvm(Vector<double>& dest, const Vector<double>& rhs) const;
@@ -0,0 +1,146 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+/*!
+  \file src/cpu/parallel.cpp
+  \brief Thread pool of the CPU build.
+
+  Implementation of the thread pool declared in src/cpu/parallel.h.
+*/
+
+#include "parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpu
+{
+	//! Pool of worker threads
+	/*!
+	  All workers take part in each job: a job is a number of chunks that the workers (and the calling thread) grab one after the other.
+	*/
+	class ThreadPool
+	{
+		std::vector<std::thread> workers;
+		std::mutex mutex; // protects the fields below, except nextChunk
+		std::condition_variable wakeUp;
+		std::condition_variable finished;
+		std::mutex jobMutex; // serializes the jobs
+		const std::function<void(size_t)>* job = nullptr;
+		size_t nbChunks = 0;
+		std::atomic<size_t> nextChunk{ 0 };
+		size_t generation = 0; // number of the current job
+		size_t running = 0; // number of workers that did not complete the current job yet
+		bool stop = false;
+
+		static thread_local bool isWorker;
+
+		void work()
+		{
+			isWorker = true;
+			size_t seen = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				wakeUp.wait(lock, [&] { return stop || generation != seen; });
+				if (stop)
+					return;
+				seen = generation;
+				const std::function<void(size_t)>& body = *job;
+				const size_t n = nbChunks;
+				lock.unlock();
+				for (size_t chunk = nextChunk++; chunk < n; chunk = nextChunk++)
+					body(chunk);
+				lock.lock();
+				if (--running == 0)
+					finished.notify_one();
+			}
+		}
+
+	public:
+		ThreadPool()
+		{
+			int nbThreads = std::thread::hardware_concurrency();
+			if (const char* env = std::getenv("GPUPOLY_NUM_THREADS"))
+				nbThreads = std::atoi(env);
+			for (int i = 1; i < nbThreads; i++)
+				workers.emplace_back(&ThreadPool::work, this);
+		}
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			wakeUp.notify_all();
+			for (auto& w : workers)
+				w.join();
+		}
+		int size() const
+		{
+			return workers.size() + 1;
+		}
+		void run(size_t n, const std::function<void(size_t)>& body)
+		{
+			if (workers.empty() || isWorker)
+			{
+				for (size_t chunk = 0; chunk < n; chunk++)
+					body(chunk);
+				return;
+			}
+			std::lock_guard<std::mutex> jobLock(jobMutex);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				job = &body;
+				nbChunks = n;
+				nextChunk = 0;
+				running = workers.size();
+				generation++;
+			}
+			wakeUp.notify_all();
+			for (size_t chunk = nextChunk++; chunk < n; chunk = nextChunk++)
+				body(chunk);
+			// every worker has to acknowledge the job before body goes out of scope
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&] { return running == 0; });
+		}
+	};
+
+	thread_local bool ThreadPool::isWorker = false;
+
+	static ThreadPool& pool()
+	{
+		static ThreadPool p;
+		return p;
+	}
+
+	int numThreads()
+	{
+		return pool().size();
+	}
+
+	void run(size_t nbChunks, const std::function<void(size_t)>& body)
+	{
+		pool().run(nbChunks, body);
+	}
+}
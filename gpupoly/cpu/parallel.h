@@ -0,0 +1,73 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+/*!
+  \file src/cpu/parallel.h
+  \brief Thread pool of the CPU build.
+
+  The kernels of the CPU build (the .cpp files of src/cpu) distribute their iteration space over a pool of worker threads using parallelFor. The number of workers is the number of hardware threads, unless the environment variable GPUPOLY_NUM_THREADS is set.
+*/
+
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+
+namespace cpu
+{
+	//! Number of threads (including the calling one) that execute the kernels.
+	int numThreads();
+
+	//! Executes body(0), ..., body(nbChunks - 1) on the thread pool, and returns once all of them are done.
+	void run(size_t nbChunks, const std::function<void(size_t)>& body);
+
+	//! Minimal amount of scalar operations that is worth handing to a worker thread.
+	constexpr size_t minWork = 1 << 14;
+
+	//! Number of consecutive iterations to group in a chunk, given the amount of scalar operations each iteration performs.
+	inline size_t grain(size_t workPerIteration)
+	{
+		return std::max<size_t>(1, minWork / std::max<size_t>(1, workPerIteration));
+	}
+
+	//! Parallel loop
+	/*!
+	  Calls body(begin, end) on disjoint subranges that cover [0, n). Each subrange contains at most grain iterations.
+	  \param n Number of iterations
+	  \param grain Number of iterations per chunk (see cpu::grain)
+	  \param body Functor called on each chunk
+	*/
+	template <typename F>
+	void parallelFor(size_t n, size_t grain, const F& body)
+	{
+		if (n == 0)
+			return;
+		grain = std::max<size_t>(grain, 1);
+		const size_t nbChunks = (n + grain - 1) / grain;
+		if (nbChunks == 1)
+		{
+			body(size_t(0), n);
+			return;
+		}
+		run(nbChunks, [&](size_t chunk) {
+			body(chunk * grain, std::min(n, (chunk + 1) * grain));
+			});
+	}
+}
@@ -0,0 +1,221 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright  2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+/*!
+  \file src/cpu/runtime.h
+  \brief CPU replacement of the CUDA runtime.
+
+  When GPUPoly is compiled without CUDA (GPUPOLY_CPU is defined), this header replaces the parts of the CUDA runtime used by the host code: the "device" memory is simply host memory, and memory transfers are plain copies.
+  It also provides the directed rounding intrinsics used by Intv (src/intv.h). Those do not change the rounding mode of the FPU: they compute the result rounded to nearest, and use an error-free transformation to decide whether this result has to be moved by one ulp.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <new>
+
+#define __host__
+#define __device__
+#define __global__
+
+enum cudaError_t
+{
+	cudaSuccess = 0,
+	cudaErrorMemoryAllocation = 2
+};
+
+enum cudaMemcpyKind
+{
+	cudaMemcpyHostToHost = 0,
+	cudaMemcpyHostToDevice = 1,
+	cudaMemcpyDeviceToHost = 2,
+	cudaMemcpyDeviceToDevice = 3,
+	cudaMemcpyDefault = 4
+};
+
+//! Alignment of the allocations (same as the alignment of the rows of a Matrix)
+#define CPU_ALIGNMENT_SIZE 128
+
+inline const char* cudaGetErrorString(cudaError_t code)
+{
+	return code == cudaSuccess ? "no error" : "out of memory";
+}
+
+inline cudaError_t cudaPeekAtLastError() { return cudaSuccess; }
+inline cudaError_t cudaDeviceSynchronize() { return cudaSuccess; }
+
+inline cudaError_t cudaMalloc(void** devPtr, size_t size)
+{
+	*devPtr = ::operator new(size, std::align_val_t(CPU_ALIGNMENT_SIZE), std::nothrow);
+	return *devPtr ? cudaSuccess : cudaErrorMemoryAllocation;
+}
+template <typename T>
+inline cudaError_t cudaMalloc(T** devPtr, size_t size)
+{
+	return cudaMalloc(reinterpret_cast<void**>(devPtr), size);
+}
+inline cudaError_t cudaFree(void* devPtr)
+{
+	::operator delete(devPtr, std::align_val_t(CPU_ALIGNMENT_SIZE));
+	return cudaSuccess;
+}
+template <typename T>
+inline cudaError_t cudaMallocHost(T** ptr, size_t size)
+{
+	return cudaMalloc(reinterpret_cast<void**>(ptr), size);
+}
+inline cudaError_t cudaFreeHost(void* ptr)
+{
+	return cudaFree(ptr);
+}
+
+inline cudaError_t cudaMemcpy(void* dst, const void* src, size_t count, cudaMemcpyKind)
+{
+	if (count)
+		memmove(dst, src, count);
+	return cudaSuccess;
+}
+inline cudaError_t cudaMemcpy2D(void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height, cudaMemcpyKind)
+{
+	for (size_t i = 0; i < height; i++)
+		memcpy(static_cast<char*>(dst) + i * dpitch, static_cast<const char*>(src) + i * spitch, width);
+	return cudaSuccess;
+}
+inline cudaError_t cudaMemset(void* devPtr, int value, size_t count)
+{
+	if (count)
+		memset(devPtr, value, count);
+	return cudaSuccess;
+}
+inline cudaError_t cudaMemset2D(void* devPtr, size_t pitch, int value, size_t width, size_t height)
+{
+	for (size_t i = 0; i < height; i++)
+		memset(static_cast<char*>(devPtr) + i * pitch, value, width);
+	return cudaSuccess;
+}
+
+inline float __int_as_float(int i) { float res; memcpy(&res, &i, sizeof(res)); return res; }
+inline double __longlong_as_double(long long i) { double res; memcpy(&res, &i, sizeof(res)); return res; }
+
+namespace cpu
+{
+	//! Smallest representable number bigger than x (x must not be NaN)
+	template <typename T>
+	inline T nextUp(const T x)
+	{
+		return x == std::numeric_limits<T>::infinity() ? x : std::nextafter(x, std::numeric_limits<T>::infinity());
+	}
+	//! Biggest representable number smaller than x (x must not be NaN)
+	template <typename T>
+	inline T nextDown(const T x)
+	{
+		return x == -std::numeric_limits<T>::infinity() ? x : std::nextafter(x, -std::numeric_limits<T>::infinity());
+	}
+
+	//! Sum of a and b, rounded upward (up=true) or downward (up=false)
+	/*!
+	  The sum is computed to nearest, and its rounding error is recovered exactly using Knuth's TwoSum.
+	*/
+	template <bool up, typename T>
+	inline T add_dr(const T a, const T b)
+	{
+		const T s = a + b;
+		if (!std::isfinite(s))
+		{
+			// overflow of a finite sum: the directed result is the biggest finite number on one side
+			if (std::isfinite(a) && std::isfinite(b) && (s > 0) != up)
+				return up ? nextUp(s) : nextDown(s);
+			return s;
+		}
+		const T bb = s - a;
+		const T err = (a - (s - bb)) + (b - bb); // a + b = s + err exactly
+		if (up)
+			return err > 0 ? nextUp(s) : s;
+		else
+			return err < 0 ? nextDown(s) : s;
+	}
+
+	//! Product of a and b, rounded upward (up=true) or downward (up=false)
+	/*!
+	  The product is computed to nearest, and its rounding error is recovered exactly with a fused multiply-add (except when the product underflows, in which case the result is widened by one ulp).
+	*/
+	template <bool up, typename T>
+	inline T mul_dr(const T a, const T b)
+	{
+		const T p = a * b;
+		if (!std::isfinite(p))
+		{
+			if (std::isfinite(a) && std::isfinite(b) && (p > 0) != up)
+				return up ? nextUp(p) : nextDown(p);
+			return p;
+		}
+		if (std::fabs(p) < std::numeric_limits<T>::min() / std::numeric_limits<T>::epsilon())
+			return (a == 0 || b == 0) ? p : (up ? nextUp(p) : nextDown(p));
+		const T err = std::fma(a, b, -p); // a * b = p + err exactly
+		if (up)
+			return err > 0 ? nextUp(p) : p;
+		else
+			return err < 0 ? nextDown(p) : p;
+	}
+
+	//! a * b + c, rounded upward (up=true) or downward (up=false)
+	/*!
+	  The error of a fused multiply-add is not cheaply available, so the result rounded to nearest is widened by one ulp, unless it is exact by construction.
+	*/
+	template <bool up, typename T>
+	inline T fma_dr(const T a, const T b, const T c)
+	{
+		if (a == 0 || b == 0)
+			return c;
+		const T r = std::fma(a, b, c);
+		if (std::isnan(r))
+			return r;
+		return up ? nextUp(r) : nextDown(r);
+	}
+
+	//! Conversion of a double to the nearest float in the given direction
+	template <bool up>
+	inline float double2float_dr(const double x)
+	{
+		const float f = static_cast<float>(x);
+		if (up)
+			return static_cast<double>(f) < x ? nextUp(f) : f;
+		else
+			return static_cast<double>(f) > x ? nextDown(f) : f;
+	}
+}
+
+inline double __dadd_rd(double a, double b) { return cpu::add_dr<false>(a, b); }
+inline double __dadd_ru(double a, double b) { return cpu::add_dr<true>(a, b); }
+inline float __fadd_rd(float a, float b) { return cpu::add_dr<false>(a, b); }
+inline float __fadd_ru(float a, float b) { return cpu::add_dr<true>(a, b); }
+inline double __dmul_rd(double a, double b) { return cpu::mul_dr<false>(a, b); }
+inline double __dmul_ru(double a, double b) { return cpu::mul_dr<true>(a, b); }
+inline float __fmul_rd(float a, float b) { return cpu::mul_dr<false>(a, b); }
+inline float __fmul_ru(float a, float b) { return cpu::mul_dr<true>(a, b); }
+inline double __fma_rd(double a, double b, double c) { return cpu::fma_dr<false>(a, b, c); }
+inline double __fma_ru(double a, double b, double c) { return cpu::fma_dr<true>(a, b, c); }
+inline float __fmaf_rd(float a, float b, float c) { return cpu::fma_dr<false>(a, b, c); }
+inline float __fmaf_ru(float a, float b, float c) { return cpu::fma_dr<true>(a, b, c); }
+inline float __double2float_rd(double x) { return cpu::double2float_dr<false>(x); }
+inline float __double2float_ru(double x) { return cpu::double2float_dr<true>(x); }
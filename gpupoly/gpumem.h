@@ -26,7 +26,11 @@
 */
 
 #pragma once
+#ifdef GPUPOLY_CPU
+#include "cpu/runtime.h"
+#else
 #include "cuda_runtime.h"
+#endif
 #include "utils.h"
 #include <stack>
 #include<utility>
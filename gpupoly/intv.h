@@ -30,7 +30,11 @@
  */
 
 #pragma once
+#ifdef GPUPOLY_CPU
+#include "cpu/runtime.h"
+#else
 #include <cuda.h>
+#endif
 #include "config.h"
 #define CUDART_INF_F            __int_as_float(0x7f800000)
 #define CUDART_INF              __longlong_as_double(0x7ff0000000000000ULL)
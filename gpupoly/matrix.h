@@ -26,15 +26,18 @@
 #pragma once
 #include <vector>
 #include <iostream>
+#ifndef GPUPOLY_CPU
 #include "cublas_v2.h"
+#endif
 #include "intv.h"
 #include "vector.h"
 #include "gpumem.h"
 
-//! Class that represents a matrix stored in GPU memory containing either real or interval values. Methods are implemented in src/matrix.cu, src/mmm.cu and src/mvm.cu.
+//! Class that represents a matrix stored in GPU memory containing either real or interval values. Methods are implemented in src/matrix.cu, src/mmm.cu and src/mvm.cu (or in their counterparts in src/cpu for the CPU build).
 template<typename T>
 class Matrix
 {
+#ifndef GPUPOLY_CPU
 	static class CublasHandle
 	{
 		cublasHandle_t* handle;
@@ -57,6 +60,7 @@ class Matrix
 			return *handle;
 		}
 	} cublasHandle;
+#endif
 public:
 	static GPUMem<false> gpuMem;
 private:
@@ -33,13 +33,19 @@
 #include <assert.h>
 #include <cmath>
 #include <queue>
+#ifdef GPUPOLY_CPU
+#include <numeric>
+#else
 #include <thrust/fill.h>
+#endif
 #include "layers/input.h"
 #include "filters.h"
 #include "network.h"
+#ifndef GPUPOLY_CPU
 #include "cuda.h"
 #include "cuda_runtime.h"
 #include "device_launch_parameters.h"
+#endif
 using namespace std;
 
 
@@ -55,6 +61,23 @@ Vector<double>& NeuralNetwork::getConcreteBounds(int layer)
 	return *concreteBoundsD[layer];
 }
 
+#ifdef GPUPOLY_CPU
+template <typename T>
+void setFinal(T* A, int* rows, int label, size_t outputSize, size_t N)
+{
+	for (size_t i = 0; i + 1 < outputSize; i++)
+	{
+		rows[i] = i;
+		for (int j = 0; j < outputSize; j++)
+			if (j == i + (i >= label))
+				A[i * N + j] = -1;
+			else if (j == label)
+				A[i * N + j] = 1;
+			else
+				A[i * N + j] = 0;
+	}
+}
+#else
 template <typename T>
 __global__ void setFinal(T* A, int* rows, int label, size_t outputSize, size_t N)
 {
@@ -68,6 +91,7 @@ __global__ void setFinal(T* A, int* rows, int label, size_t outputSize, size_t N
 		else
 			A[i * N + j] = 0;
 }
+#endif
 
 
 template <typename T>
@@ -179,6 +203,15 @@ void NeuralNetwork::evaluateAffine(Vector<T>& dest, const NeuronFilter<T>& al, i
 }
 
 
+#ifdef GPUPOLY_CPU
+template<typename T>
+void makeIdMatrix(T* dest, size_t N, int outputSize, int start, int m)
+{
+	for (int row = 0; row < m; row++)
+		for (int col = 0; col < outputSize; col++)
+			dest[row * N + col] = T(row + start == col);
+}
+#else
 template <int lgBlockSize>
 __global__ void getSensitivityExprPrepareRes(int* rows, const int* oldRows, const size_t n)
 {
@@ -198,6 +231,7 @@ __global__ void makeIdMatrix(T* dest, size_t N, int outputSize, int start)
 	if (col < outputSize)
 		dest[row * N + col] = T(output == col);
 }
+#endif
 
 template<typename T>
 void NeuralNetwork::getSensitivity(T* const destA, T* const destb, int layer, bool up, bool sound, int m, const std::shared_ptr<const Matrix<T>>& A, const std::shared_ptr<const Vector<T>>& b)
@@ -228,7 +262,11 @@ void NeuralNetwork::getSensitivity(T* const destA, T* const destb, int layer, bo
 	int maxNeurBP = (1 << 30) / (maxLayerSize * sizeof(Intv<T>));
 
 	// Initialize annoyingNeuronList with a sequence from 0 to n-1
+#ifdef GPUPOLY_CPU
+	std::iota(annoyingNeuronList, annoyingNeuronList + m, 0);
+#else
 	thrust::sequence(thrust::device_pointer_cast<int>(annoyingNeuronList), thrust::device_pointer_cast<int>(annoyingNeuronList + m));
+#endif
 
 	// Initialize buffers for the resulting expression to be stored
 	Matrix<T> resA;
@@ -243,7 +281,11 @@ void NeuralNetwork::getSensitivity(T* const destA, T* const destb, int layer, bo
 		// Encapsulate the expression into an AffineExpr
 		auto partialA = A ? std::make_shared<const Matrix<T>>(A->template selectRows<T>(length, annoyingNeuronList + start,false)) : nullptr;
 		auto partialb = b ? std::make_shared<const Vector<T>>(b->template select<T>(length, annoyingNeuronList + start,false)) : nullptr;
+#ifdef GPUPOLY_CPU
+		std::iota(annoyingNeuronList + start, annoyingNeuronList + start + length, 0);
+#else
 		thrust::sequence(thrust::device_pointer_cast<int>(annoyingNeuronList + start), thrust::device_pointer_cast<int>(annoyingNeuronList + start + length)); // Reindex the chunk so that it starts from 0; this will make the final ordering easier, but we have to take into account start when copying in the buffer.
+#endif
 		auto inExpr = AffineExpr<T>(length, layers[layer]->outputSize, layer, up, annoyingNeuronList + start, partialA, partialb, ConvShape(), sound);
 
 		// Creates a queue that will stack expressions to be added together (in case of residual networks or partial sums). The part with the highest layer number stays on top.
@@ -266,6 +308,12 @@ void NeuralNetwork::getSensitivity(T* const destA, T* const destb, int layer, bo
 				if (!tmp.A)
 				{
 					resA.reshape(tmp.m, tmp.n, sound);
+#ifdef GPUPOLY_CPU
+					if (sound)
+						makeIdMatrix<Intv<T>>(resA, resA.pitch(), tmp.n, start, tmp.m);
+					else
+						makeIdMatrix<T>(resA, resA.pitch(), tmp.n, start, tmp.m);
+#else
 					const int blockSize = 256;
 					dim3 block(blockSize, 1, 1);
 					dim3 grid((tmp.n + blockSize - 1) / blockSize, tmp.m, 1);
@@ -275,6 +323,7 @@ void NeuralNetwork::getSensitivity(T* const destA, T* const destb, int layer, bo
 						makeIdMatrix<T> << <grid, block >> > (resA, resA.pitch(), tmp.n, start);
 					gpuErrchk(cudaPeekAtLastError());
 					gpuErrchk(cudaDeviceSynchronize());
+#endif
 				}
 				else
 					resA = tmp.A->template selectRows<T>(length, tmp.rows, sound);
@@ -398,7 +447,11 @@ bool NeuralNetwork::run(const Vector<T>& input, const int label, bool sound)
 
 	// creates an additional "layer" to check if the neuron "label" is the bigger one
 	auto finalA = std::make_shared<Matrix<T>>(outputSize - 1, outputSize, false);
+#ifdef GPUPOLY_CPU
+	setFinal<T>(*finalA, annoyingNeuronList, label, outputSize, finalA->pitch());
+#else
 	setFinal<T> << <1, outputSize - 1 >> > (*finalA, annoyingNeuronList, label, outputSize, finalA->pitch());
+#endif
 
 	Vector<T> res;
 
@@ -0,0 +1,445 @@
+/*
+ *  GPUPoly library
+ *  This source file is part of ELINA (ETH LIbrary for Numerical Analysis).
+ *  ELINA is Copyright � 2020 Department of Computer Science, ETH Zurich
+ *  This software is distributed under GNU Lesser General Public License Version 3.0.
+ *  For more information, see the ELINA project website at:
+ *  http://elina.ethz.ch
+ *
+ *  THE SOFTWARE IS PROVIDED "AS-IS" WITHOUT ANY WARRANTY OF ANY KIND, EITHER
+ *  EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT LIMITED TO ANY WARRANTY
+ *  THAT THE SOFTWARE WILL CONFORM TO SPECIFICATIONS OR BE ERROR-FREE AND ANY
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE,
+ *  TITLE, OR NON-INFRINGEMENT.  IN NO EVENT SHALL ETH ZURICH BE LIABLE FOR ANY
+ *  DAMAGES, INCLUDING BUT NOT LIMITED TO DIRECT, INDIRECT,
+ *  SPECIAL OR CONSEQUENTIAL DAMAGES, ARISING OUT OF, RESULTING FROM, OR IN
+ *  ANY WAY CONNECTED WITH THIS SOFTWARE (WHETHER OR NOT BASED UPON WARRANTY,
+ *  CONTRACT, TORT OR OTHERWISE).
+ */
+
+
+/*!
+  \file src/test_bounds.cpp
+  \brief Soundness test of the bounds computed by GPUPoly.
+
+  Builds small random networks made of dense, conv2d, relu and maxpool2d layers, in single and double precision, and analyses an input box with single and double precision bounds.
+  Concrete inputs are then sampled in the box, and their image by the network (computed in long double, with a bound on the rounding error of that computation) has to lie within the bounds of every layer.
+
+  Usage: test_bounds [--write file | --compare file]
+  With --write, the bounds are also written to a file; with --compare, they are compared to the ones of such a file.
+  This is used to check that the CPU and the CUDA libraries compute the same bounds.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gpupoly.h"
+
+
+// Concrete value of a neuron: v is computed in long double, and the exact value lies within [v-err, v+err].
+struct Val
+{
+	long double v;
+	long double err;
+};
+
+struct Layer
+{
+	enum Kind { Dense, Conv, ReLU, MaxPool } kind;
+	int inSize;
+	int outSize;
+	std::vector<double> A; // dense: outSize*inSize, row major. conv: same layout as addConv2D.
+	std::vector<double> b;
+	int filters, kr, kc; // conv filters (or maxpool channels), kernel size
+	int rows, cols, ch; // input shape
+	int sr, sc; // strides
+	int pad[4]; // top, left, bottom, right
+	int outRows() const { return (rows + pad[0] + pad[2] - kr + sr) / sr; }
+	int outCols() const { return (cols + pad[1] + pad[3] - kc + sc) / sc; }
+};
+
+struct Net
+{
+	std::string name;
+	int inputSize;
+	std::vector<Layer> layers;
+};
+
+// Deterministic number in [0,1). std::mt19937 is fully specified, so both libraries see the same networks.
+static double uniform(std::mt19937& rng)
+{
+	return rng() / 4294967296.0;
+}
+
+static void randomFill(std::vector<double>& v, size_t n, double scale, bool single, std::mt19937& rng)
+{
+	v.resize(n);
+	for (auto& x : v)
+	{
+		x = (2 * uniform(rng) - 1) * scale;
+		if (single)
+			x = float(x);
+	}
+}
+
+static void pushDense(Net& net, int outSize, bool single, std::mt19937& rng)
+{
+	Layer l = {};
+	l.kind = Layer::Dense;
+	l.inSize = net.layers.empty() ? net.inputSize : net.layers.back().outSize;
+	l.outSize = outSize;
+	randomFill(l.A, size_t(outSize) * l.inSize, 1.5 / std::sqrt(double(l.inSize)), single, rng);
+	randomFill(l.b, outSize, 0.1, single, rng);
+	net.layers.push_back(l);
+}
+
+static void pushConv(Net& net, int rows, int cols, int ch, int filters, int k, int stride, int padding, bool single, std::mt19937& rng)
+{
+	Layer l = {};
+	l.kind = Layer::Conv;
+	l.rows = rows; l.cols = cols; l.ch = ch;
+	l.filters = filters; l.kr = k; l.kc = k;
+	l.sr = stride; l.sc = stride;
+	for (int i = 0; i < 4; i++)
+		l.pad[i] = padding;
+	l.inSize = rows * cols * ch;
+	l.outSize = l.outRows() * l.outCols() * filters;
+	randomFill(l.A, size_t(k) * k * ch * filters, 1.5 / std::sqrt(double(k * k * ch)), single, rng);
+	randomFill(l.b, l.outSize, 0.1, single, rng);
+	net.layers.push_back(l);
+}
+
+static void pushReLU(Net& net)
+{
+	Layer l = {};
+	l.kind = Layer::ReLU;
+	l.inSize = l.outSize = net.layers.back().outSize;
+	net.layers.push_back(l);
+}
+
+static void pushMaxPool(Net& net, int rows, int cols, int ch, int k)
+{
+	Layer l = {};
+	l.kind = Layer::MaxPool;
+	l.rows = rows; l.cols = cols; l.ch = ch;
+	l.filters = ch; l.kr = k; l.kc = k;
+	l.sr = k; l.sc = k;
+	l.inSize = rows * cols * ch;
+	l.outSize = l.outRows() * l.outCols() * ch;
+	net.layers.push_back(l);
+}
+
+static std::vector<Net> makeNets(bool single)
+{
+	std::mt19937 rng(20240611);
+	std::vector<Net> nets(3);
+	const char* prec = single ? " f32" : " f64";
+
+	nets[0].name = std::string("dense") + prec;
+	nets[0].inputSize = 8;
+	pushDense(nets[0], 12, single, rng);
+	pushReLU(nets[0]);
+	pushDense(nets[0], 10, single, rng);
+	pushReLU(nets[0]);
+	pushDense(nets[0], 5, single, rng);
+
+	nets[1].name = std::string("conv") + prec;
+	nets[1].inputSize = 2 * 6 * 6;
+	pushConv(nets[1], 6, 6, 2, 3, 3, 1, 1, single, rng);
+	pushReLU(nets[1]);
+	pushConv(nets[1], 6, 6, 3, 4, 2, 2, 0, single, rng);
+	pushReLU(nets[1]);
+	pushDense(nets[1], 5, single, rng);
+
+	nets[2].name = std::string("maxpool") + prec;
+	nets[2].inputSize = 2 * 6 * 6;
+	pushConv(nets[2], 6, 6, 2, 3, 3, 1, 1, single, rng);
+	pushReLU(nets[2]);
+	pushMaxPool(nets[2], 6, 6, 3, 2);
+	pushDense(nets[2], 5, single, rng);
+	return nets;
+}
+
+// Adds the network to GPUPoly. outputs receives, for each layer of net, the index of the GPUPoly layer holding its output, and all receives every GPUPoly layer in creation order.
+static NeuralNetwork* build(const Net& net, bool single, std::vector<int>& outputs, std::vector<int>& all)
+{
+	NeuralNetwork* nn = create(net.inputSize);
+	if (!nn)
+		return nullptr;
+	int prev = 0;
+	for (const Layer& l : net.layers)
+	{
+		std::vector<float> Af(l.A.begin(), l.A.end());
+		std::vector<float> bf(l.b.begin(), l.b.end());
+		int kernel[2] = { l.kr, l.kc };
+		int input[3] = { l.rows, l.cols, l.ch };
+		int stride[2] = { l.sr, l.sc };
+		int pad[4] = { l.pad[0], l.pad[1], l.pad[2], l.pad[3] };
+		switch (l.kind)
+		{
+		case Layer::Dense:
+			prev = single ? addLinear_s(nn, prev, l.outSize, Af.data()) : addLinear_d(nn, prev, l.outSize, l.A.data());
+			all.push_back(prev);
+			prev = single ? addBias_s(nn, prev, bf.data()) : addBias_d(nn, prev, l.b.data());
+			break;
+		case Layer::Conv:
+			prev = single ? addConv2D_s(nn, prev, l.filters, kernel, input, stride, pad, Af.data()) : addConv2D_d(nn, prev, l.filters, kernel, input, stride, pad, l.A.data());
+			all.push_back(prev);
+			prev = single ? addBias_s(nn, prev, bf.data()) : addBias_d(nn, prev, l.b.data());
+			break;
+		case Layer::ReLU:
+			prev = addReLU(nn, prev, true);
+			break;
+		case Layer::MaxPool:
+			prev = addMaxPool2D(nn, prev, kernel, input, stride, pad);
+			break;
+		}
+		all.push_back(prev);
+		outputs.push_back(prev);
+	}
+	return nn;
+}
+
+// Concrete evaluation of a layer. The rounding error of an affine combination of n terms in long double is below (n+1)*eps times the sum of the magnitudes of the terms.
+static std::vector<Val> forward(const Layer& l, const std::vector<Val>& in)
+{
+	std::vector<Val> out(l.outSize);
+	switch (l.kind)
+	{
+	case Layer::Dense:
+		for (int i = 0; i < l.outSize; i++)
+		{
+			long double v = l.b[i], mag = std::fabs(l.b[i]), err = 0;
+			for (int j = 0; j < l.inSize; j++)
+			{
+				const long double a = l.A[size_t(i) * l.inSize + j];
+				v += a * in[j].v;
+				mag += std::fabs(a * in[j].v);
+				err += std::fabs(a) * in[j].err;
+			}
+			out[i] = { v, err + (l.inSize + 2) * LDBL_EPSILON * mag };
+		}
+		break;
+	case Layer::Conv:
+	{
+		const int orows = l.outRows(), ocols = l.outCols();
+		for (int f = 0; f < l.filters; f++)
+			for (int r = 0; r < orows; r++)
+				for (int c = 0; c < ocols; c++)
+				{
+					const int o = (f * orows + r) * ocols + c;
+					long double v = l.b[o], mag = std::fabs(l.b[o]), err = 0;
+					for (int dr = 0; dr < l.kr; dr++)
+						for (int dc = 0; dc < l.kc; dc++)
+						{
+							const int ir = r * l.sr + dr - l.pad[0];
+							const int ic = c * l.sc + dc - l.pad[1];
+							if (ir < 0 || ir >= l.rows || ic < 0 || ic >= l.cols)
+								continue;
+							for (int ch = 0; ch < l.ch; ch++)
+							{
+								const long double a = l.A[size_t(dr * l.kc + dc) * l.ch * l.filters + ch * l.filters + f];
+								const Val& x = in[(ch * l.rows + ir) * l.cols + ic];
+								v += a * x.v;
+								mag += std::fabs(a * x.v);
+								err += std::fabs(a) * x.err;
+							}
+						}
+					out[o] = { v, err + (l.kr * l.kc * l.ch + 2) * LDBL_EPSILON * mag };
+				}
+		break;
+	}
+	case Layer::ReLU:
+		for (int i = 0; i < l.outSize; i++)
+			out[i] = { in[i].v > 0 ? in[i].v : 0, in[i].err };
+		break;
+	case Layer::MaxPool:
+	{
+		const int orows = l.outRows(), ocols = l.outCols();
+		for (int ch = 0; ch < l.ch; ch++)
+			for (int r = 0; r < orows; r++)
+				for (int c = 0; c < ocols; c++)
+				{
+					Val m = { -INFINITY, 0 };
+					for (int dr = 0; dr < l.kr; dr++)
+						for (int dc = 0; dc < l.kc; dc++)
+						{
+							const Val& x = in[(ch * l.rows + r * l.sr + dr) * l.cols + c * l.sc + dc];
+							if (x.v > m.v)
+								m.v = x.v;
+							if (x.err > m.err)
+								m.err = x.err;
+						}
+					out[(ch * orows + r) * ocols + c] = m;
+				}
+		break;
+	}
+	}
+	return out;
+}
+
+template <typename T> static void setBox(NeuralNetwork* nn, const T* down, const T* up);
+template <> void setBox(NeuralNetwork* nn, const float* down, const float* up) { setLayerBox_s(nn, down, up, 0); }
+template <> void setBox(NeuralNetwork* nn, const double* down, const double* up) { setLayerBox_d(nn, down, up, 0); }
+static void relax(NeuralNetwork* nn, int layer, float) { relax_s(nn, layer, true, true); }
+static void relax(NeuralNetwork* nn, int layer, double) { relax_d(nn, layer, true, true); }
+static void eval(NeuralNetwork* nn, float* dest, int layer, int backsubstitute) { evalAffineExpr_s(nn, dest, layer, getOutputSize(nn, layer), nullptr, nullptr, backsubstitute, true); }
+static void eval(NeuralNetwork* nn, double* dest, int layer, int backsubstitute) { evalAffineExpr_d(nn, dest, layer, getOutputSize(nn, layer), nullptr, nullptr, backsubstitute, true); }
+
+static int report(const std::string& name, bool ok)
+{
+	printf("%-48s %s\n", name.c_str(), ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
+
+// Compares bounds with the ones read from ref, that were written by the other library.
+static bool compareBounds(FILE* ref, const std::string& name, int layer, const std::vector<double>& bounds, double tol)
+{
+	char refName[64];
+	int refLayer, n;
+	if (fscanf(ref, "%63s %d %d", refName, &refLayer, &n) != 3 || name != refName || refLayer != layer || n != int(bounds.size()))
+		return false;
+	bool ok = true;
+	for (int i = 0; i < n; i++)
+	{
+		char buf[64];
+		if (fscanf(ref, "%63s", buf) != 1)
+			return false;
+		const double r = strtod(buf, nullptr);
+		if (!(std::fabs(r - bounds[i]) <= tol * (1 + std::fabs(r))))
+			ok = false;
+	}
+	return ok;
+}
+
+// Analyses a box with T bounds, and checks sampled inputs against the bounds of every layer.
+template <typename T>
+static int checkNet(const Net& net, bool singleNet, int samples, FILE* write, FILE* compare)
+{
+	const std::string name = net.name + (sizeof(T) == sizeof(float) ? " bounds f32" : " bounds f64");
+	std::vector<int> outputs, all;
+	NeuralNetwork* nn = build(net, singleNet, outputs, all);
+	if (!nn)
+		return report(name + " create", false);
+
+	std::mt19937 rng(7);
+	const float eps = 0.05f;
+	std::vector<T> down(net.inputSize), up(net.inputSize);
+	for (int i = 0; i < net.inputSize; i++)
+	{
+		const float c = float(uniform(rng));
+		down[i] = c - eps;
+		up[i] = c + eps;
+	}
+	setBox(nn, down.data(), up.data());
+	for (int layer : all)
+		relax(nn, layer, T());
+
+	// concrete bounds of every layer, plus the back-substituted bounds of the output
+	std::vector<std::vector<double>> bounds(net.layers.size() + 1);
+	for (size_t k = 0; k <= net.layers.size(); k++)
+	{
+		const int layer = k < net.layers.size() ? outputs[k] : outputs.back();
+		std::vector<T> dest(2 * getOutputSize(nn, layer));
+		eval(nn, dest.data(), layer, k < net.layers.size() ? 0 : 1);
+		bounds[k].assign(dest.begin(), dest.end());
+	}
+	clean(nn);
+
+	int failed = 0;
+	bool wellFormed = true;
+	for (const auto& b : bounds)
+		for (size_t i = 0; i < b.size(); i += 2)
+			if (!(b[i] <= b[i + 1]))
+				wellFormed = false;
+	failed += report(name + " well formed", wellFormed);
+
+	bool contained = true;
+	for (int s = 0; s < samples; s++)
+	{
+		// corners of the box are sampled as well as its interior
+		std::vector<Val> x(net.inputSize);
+		for (int i = 0; i < net.inputSize; i++)
+		{
+			const double u = uniform(rng);
+			const double t = s % 2 ? (u < 0.5 ? 0 : 1) : u;
+			float v = float(down[i] + t * (double(up[i]) - down[i]));
+			v = std::fmin(std::fmax(v, float(down[i])), float(up[i]));
+			x[i] = { v, 0 };
+		}
+		for (size_t k = 0; k <= net.layers.size(); k++)
+		{
+			if (k < net.layers.size())
+				x = forward(net.layers[k], x);
+			const auto& b = bounds[k];
+			for (size_t i = 0; i < x.size(); i++)
+				if (x[i].v + x[i].err < b[2 * i] || x[i].v - x[i].err > b[2 * i + 1])
+					contained = false;
+		}
+	}
+	failed += report(name + " contain samples", contained);
+
+	std::string key = name;
+	for (char& c : key)
+		if (c == ' ')
+			c = '_';
+	if (write)
+		for (size_t k = 0; k < bounds.size(); k++)
+		{
+			fprintf(write, "%s %d %d", key.c_str(), int(k), int(bounds[k].size()));
+			for (double v : bounds[k])
+				fprintf(write, " %a", v);
+			fprintf(write, "\n");
+		}
+	if (compare)
+	{
+		// both libraries use the same relaxations, but sum in different orders
+		const double tol = sizeof(T) == sizeof(float) ? 1e-4 : 1e-9;
+		bool same = true;
+		for (size_t k = 0; k < bounds.size(); k++)
+			same = compareBounds(compare, key, int(k), bounds[k], tol) && same;
+		failed += report(name + " same as reference", same);
+	}
+	return failed;
+}
+
+int main(int argc, char** argv)
+{
+	FILE* write = nullptr;
+	FILE* compare = nullptr;
+	if (argc == 3 && !strcmp(argv[1], "--write"))
+		write = fopen(argv[2], "w");
+	else if (argc == 3 && !strcmp(argv[1], "--compare"))
+		compare = fopen(argv[2], "r");
+	else if (argc != 1)
+	{
+		fprintf(stderr, "Usage: %s [--write file | --compare file]\n", argv[0]);
+		return 2;
+	}
+	if (argc == 3 && !write && !compare)
+	{
+		fprintf(stderr, "Cannot open %s\n", argv[2]);
+		return 2;
+	}
+
+	int failed = 0;
+	for (bool single : { true, false })
+		for (const Net& net : makeNets(single))
+		{
+			failed += checkNet<float>(net, single, 200, write, compare);
+			failed += checkNet<double>(net, single, 200, write, compare);
+		}
+	if (write)
+		fclose(write);
+	if (compare)
+		fclose(compare);
+	printf("%d FAILED\n", failed);
+	return failed ? 1 : 0;
+}
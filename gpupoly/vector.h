@@ -24,15 +24,22 @@
 
 
 #pragma once
+#ifdef GPUPOLY_CPU
+#include "cpu/runtime.h"
+#else
 #include "cuda_runtime.h"
+#endif
 #include "utils.h"
 #include "intv.h"
 #include "gpumem.h"
+#ifndef GPUPOLY_CPU
 #include <thrust/device_ptr.h>
 #include <thrust/copy.h>
+#endif
 #include <vector>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 /*! Vector of real or interval values stored in GPU memory
 */
@@ -93,6 +100,7 @@ public:
 		return n_;
 	}
 	void resize(size_t n, bool interval);
+#ifndef GPUPOLY_CPU
 	inline thrust::device_ptr<T> begin() const
 	{
 		return thrust::device_pointer_cast<T>(data_);
@@ -109,6 +117,7 @@ public:
 	{
 		return thrust::device_pointer_cast<const Intv<T>>(*this) + n_;
 	}
+#endif
 	inline const T* data() const 
 	{
 		return data_;
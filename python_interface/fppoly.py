@@ -29,6 +29,37 @@ from numpy.ctypeslib import ndpointer
 import ctypes
 
 _doublepp = ndpointer(dtype=np.uintp, ndim=1, flags='C')
+
+
+class FppolyDtype(CtypesEnum):
+    """ Enum compatible with fppoly_dtype_t from fppoly.h """
+
+    FPPOLY_FLOAT64 = 0
+    FPPOLY_FLOAT32 = 1
+
+
+def _weight_buffer(weights):
+    """
+    Views any object supporting the buffer protocol as a 2-D float32 or float64 array, only other
+    element types are converted. Returns the array, its FppolyDtype, its row and column strides in bytes
+    and whether the array is a view of memory the caller holds. A converted array is freed when the
+    calling wrapper returns, so the library must not borrow its rows.
+    """
+
+    array = np.asarray(weights)
+    # lists and other sequences are copied into a new array by asarray
+    is_view = array is weights or not array.flags.owndata
+    if array.dtype == np.float32:
+        dtype = FppolyDtype.FPPOLY_FLOAT32
+    elif array.dtype == np.float64:
+        dtype = FppolyDtype.FPPOLY_FLOAT64
+    else:
+        array = array.astype(np.float64)
+        dtype = FppolyDtype.FPPOLY_FLOAT64
+        is_view = False
+    if array.ndim != 2:
+        raise ValueError('the weights must be a matrix, got shape %s' % (array.shape,))
+    return array, dtype, array.strides[0], array.strides[1], is_view
 # ====================================================================== #
 # Basics
 # ====================================================================== #
@@ -57,6 +88,426 @@ def fppoly_manager_alloc():
 
     return man
 
+def fppoly_manager_set_num_threads(man, num_threads, set_affinity=False):
+    """
+    Resizes the thread pool used by the manager for parallel back-substitution.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    num_threads : c_size_t
+        Number of threads, 0 uses one thread per online CPU.
+    set_affinity : c_bool
+        Pin each worker thread to its own CPU.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_num_threads_c = fppoly_api.fppoly_manager_set_num_threads
+        fppoly_manager_set_num_threads_c.restype = None
+        fppoly_manager_set_num_threads_c.argtypes = [ElinaManagerPtr, c_size_t, c_bool]
+        fppoly_manager_set_num_threads_c(man, num_threads, set_affinity)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_num_threads" from "libfppoly.so"')
+
+class FppolyBacksubstitution(CtypesEnum):
+    """ Enum compatible with fppoly_backsubstitution_t from fppoly.h """
+
+    FPPOLY_BACKSUBSTITUTE_NEURON = 0
+    FPPOLY_BACKSUBSTITUTE_MATRIX = 1
+
+
+def fppoly_manager_set_backsubstitution(man, backsubstitution):
+    """
+    Selects how the manager back-substitutes the neurons of a layer.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    backsubstitution : FppolyBacksubstitution
+        FPPOLY_BACKSUBSTITUTE_NEURON for one expression at a time, FPPOLY_BACKSUBSTITUTE_MATRIX
+        for blocks of neurons as interval matrix products.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_backsubstitution_c = fppoly_api.fppoly_manager_set_backsubstitution
+        fppoly_manager_set_backsubstitution_c.restype = None
+        fppoly_manager_set_backsubstitution_c.argtypes = [ElinaManagerPtr, FppolyBacksubstitution]
+        fppoly_manager_set_backsubstitution_c(man, backsubstitution)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_backsubstitution" from "libfppoly.so"')
+
+def fppoly_manager_set_borrow_weights(man, borrow):
+    """
+    Lets fully connected layers point to the weight rows of the caller instead of copying them.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    borrow : c_bool
+        If True the weight arrays passed to handle_fully_connected_layer must stay alive and
+        unchanged until the abstract element is freed.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_borrow_weights_c = fppoly_api.fppoly_manager_set_borrow_weights
+        fppoly_manager_set_borrow_weights_c.restype = None
+        fppoly_manager_set_borrow_weights_c.argtypes = [ElinaManagerPtr, c_bool]
+        fppoly_manager_set_borrow_weights_c(man, borrow)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_borrow_weights" from "libfppoly.so"')
+
+class FppolySpatialSolver(CtypesEnum):
+    """ Enum compatible with fppoly_spatial_solver_t from fppoly.h """
+
+    FPPOLY_SPATIAL_NONE = 0
+    FPPOLY_SPATIAL_DUAL_ASCENT = 1
+    FPPOLY_SPATIAL_GUROBI = 2
+
+
+def fppoly_manager_set_spatial_solver(man, solver):
+    """
+    Selects how bounds over inputs with spatial constraints are computed, for the inputs created afterwards.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    solver : FppolySpatialSolver
+        FPPOLY_SPATIAL_NONE to ignore the spatial constraints, FPPOLY_SPATIAL_DUAL_ASCENT for the
+        in-tree solver, FPPOLY_SPATIAL_GUROBI for a persistent Gurobi model when libfppoly.so was
+        built with Gurobi. Without Gurobi the default is FPPOLY_SPATIAL_NONE.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_spatial_solver_c = fppoly_api.fppoly_manager_set_spatial_solver
+        fppoly_manager_set_spatial_solver_c.restype = None
+        fppoly_manager_set_spatial_solver_c.argtypes = [ElinaManagerPtr, FppolySpatialSolver]
+        fppoly_manager_set_spatial_solver_c(man, solver)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_spatial_solver" from "libfppoly.so"')
+
+def fppoly_manager_set_implicit_conv(man, implicit):
+    """
+    Keeps convolutional layers as their filters and back-substitutes through them by transposed convolution.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    implicit : c_bool
+        If True convolutional layers do not build one expression per output neuron; the
+        matrix back-substitution is then not used for networks with such layers.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_implicit_conv_c = fppoly_api.fppoly_manager_set_implicit_conv
+        fppoly_manager_set_implicit_conv_c.restype = None
+        fppoly_manager_set_implicit_conv_c.argtypes = [ElinaManagerPtr, c_bool]
+        fppoly_manager_set_implicit_conv_c(man, implicit)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_implicit_conv" from "libfppoly.so"')
+
+def fppoly_manager_set_single_precision(man, single):
+    """
+    Runs the matrix back-substitution in float with the rounding errors of float.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    single : c_bool
+        If True the rows of the matrix back-substitution are kept in float and the weights of
+        affine layers are rounded outward to float as they are applied; the bounds stay sound
+        but are slightly looser. The neuron-wise back-substitution is not affected.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_single_precision_c = fppoly_api.fppoly_manager_set_single_precision
+        fppoly_manager_set_single_precision_c.restype = None
+        fppoly_manager_set_single_precision_c.argtypes = [ElinaManagerPtr, c_bool]
+        fppoly_manager_set_single_precision_c(man, single)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_single_precision" from "libfppoly.so"')
+
+class FppolyLayerStats(Structure):
+    """
+    FppolyLayerStats ctype compatible with fppoly_layer_stats_t from fppoly.h
+
+    Fields
+    ------
+    layerno : c_size_t
+    dims : c_size_t
+    is_activation : c_bool
+    calls : c_size_t
+    wall_time : c_double
+    cpu_time : c_double
+    expr_size_before : c_size_t
+    expr_size_after : c_size_t
+    unstable_relus : c_size_t
+    expr_bytes : c_size_t
+    thread_utilisation : c_double
+
+    """
+
+    _fields_ = [('layerno', c_size_t), ('dims', c_size_t), ('is_activation', c_bool), ('calls', c_size_t),
+                ('wall_time', c_double), ('cpu_time', c_double), ('expr_size_before', c_size_t),
+                ('expr_size_after', c_size_t), ('unstable_relus', c_size_t), ('expr_bytes', c_size_t),
+                ('thread_utilisation', c_double)]
+
+
+def fppoly_manager_set_stats(man, enable):
+    """
+    Enables or disables the per-layer statistics of the manager.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    enable : c_bool
+        If True the wall and CPU time, expression sizes and bytes, unstable ReLUs and
+        thread utilisation of every layer are recorded.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_set_stats_c = fppoly_api.fppoly_manager_set_stats
+        fppoly_manager_set_stats_c.restype = None
+        fppoly_manager_set_stats_c.argtypes = [ElinaManagerPtr, c_bool]
+        fppoly_manager_set_stats_c(man, enable)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_set_stats" from "libfppoly.so"')
+
+def fppoly_manager_reset_stats(man):
+    """
+    Forgets the statistics recorded so far.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        fppoly_manager_reset_stats_c = fppoly_api.fppoly_manager_reset_stats
+        fppoly_manager_reset_stats_c.restype = None
+        fppoly_manager_reset_stats_c.argtypes = [ElinaManagerPtr]
+        fppoly_manager_reset_stats_c(man)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_reset_stats" from "libfppoly.so"')
+
+def fppoly_manager_get_stats(man):
+    """
+    Returns the statistics recorded for every layer.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+
+    Returns
+    -------
+    stats : list
+        One FppolyLayerStats per layer index, layers never seen have calls 0.
+
+    """
+
+    stats = None
+    try:
+        fppoly_manager_get_stats_c = fppoly_api.fppoly_manager_get_stats
+        fppoly_manager_get_stats_c.restype = c_size_t
+        fppoly_manager_get_stats_c.argtypes = [ElinaManagerPtr, POINTER(FppolyLayerStats), c_size_t]
+        size = fppoly_manager_get_stats_c(man, None, 0)
+        array = (FppolyLayerStats * size)()
+        size = min(size, fppoly_manager_get_stats_c(man, array, size))
+        stats = list(array[:size])
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_get_stats" from "libfppoly.so"')
+    return stats
+
+def fppoly_manager_stats_json(man):
+    """
+    Returns the statistics as a JSON document.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+
+    Returns
+    -------
+    json : str
+        The text written by fppoly_manager_dump_stats.
+
+    """
+
+    json = None
+    try:
+        fppoly_manager_stats_json_c = fppoly_api.fppoly_manager_stats_json
+        fppoly_manager_stats_json_c.restype = c_size_t
+        fppoly_manager_stats_json_c.argtypes = [ElinaManagerPtr, c_char_p, c_size_t]
+        size = fppoly_manager_stats_json_c(man, None, 0)
+        buf = create_string_buffer(size + 1)
+        while fppoly_manager_stats_json_c(man, buf, len(buf)) >= len(buf):
+            buf = create_string_buffer(2*len(buf))
+        json = buf.value.decode('utf-8')
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_stats_json" from "libfppoly.so"')
+    return json
+
+def fppoly_manager_dump_stats(man, path):
+    """
+    Writes the statistics as JSON to a file.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    path : str
+        File to write.
+
+    Returns
+    -------
+    res : c_bool
+        False if the file could not be written.
+
+    """
+
+    res = False
+    try:
+        fppoly_manager_dump_stats_c = fppoly_api.fppoly_manager_dump_stats
+        fppoly_manager_dump_stats_c.restype = c_bool
+        fppoly_manager_dump_stats_c.argtypes = [ElinaManagerPtr, c_char_p]
+        res = fppoly_manager_dump_stats_c(man, path.encode('utf-8'))
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_manager_dump_stats" from "libfppoly.so"')
+    return res
+
+def fppoly_snapshot_save(man, element, path):
+    """
+    Writes an analysed abstract element to a snapshot file.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    element : ElinaAbstract0Ptr
+        Pointer to the abstract element.
+    path : str
+        File to write.
+
+    Returns
+    -------
+    res : c_bool
+        False if the file could not be written.
+
+    """
+
+    res = False
+    try:
+        fppoly_snapshot_save_c = fppoly_api.fppoly_snapshot_save
+        fppoly_snapshot_save_c.restype = c_bool
+        fppoly_snapshot_save_c.argtypes = [ElinaManagerPtr, ElinaAbstract0Ptr, c_char_p]
+        res = fppoly_snapshot_save_c(man, element, path.encode('utf-8'))
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_snapshot_save" from "libfppoly.so"')
+    return res
+
+def fppoly_snapshot_load(man, path):
+    """
+    Restores an abstract element from a snapshot file. The file is mapped, so processes loading the same snapshot share its memory. The headers of all layers are built at load time, the coefficients are read from the file when first used.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    path : str
+        File written by fppoly_snapshot_save.
+
+    Returns
+    -------
+    res : ElinaAbstract0Ptr
+        Pointer to the restored abstract element, None if the file is not a snapshot.
+
+    """
+
+    res = None
+    try:
+        fppoly_snapshot_load_c = fppoly_api.fppoly_snapshot_load
+        fppoly_snapshot_load_c.restype = ElinaAbstract0Ptr
+        fppoly_snapshot_load_c.argtypes = [ElinaManagerPtr, c_char_p]
+        res = fppoly_snapshot_load_c(man, path.encode('utf-8'))
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "fppoly_snapshot_load" from "libfppoly.so"')
+    return res if res else None
+
 def fppoly_from_network_input(man, intdim, realdim, inf_array, sup_array):
     """
     Create an abstract element from perturbed input
@@ -300,6 +751,51 @@ def handle_fully_connected_layer(man, element,weights, bias,  size, num_pixels,
     return
     
     
+def handle_fully_connected_layer_array(man, element, weights, bias, predecessors, num_predecessors):
+    """
+    handle the FFN layer, with the weights passed without building an array of row pointers
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    element : ElinaAbstract0Ptr
+        Pointer to the ElinaAbstract0.
+    weights : numpy.ndarray
+        The weight matrix of shape (size, num_pixels), float32 or float64 with any strides. With
+        fppoly_manager_set_borrow_weights, the rows of a float64 array with contiguous columns are
+        referenced by the abstract element and the array must stay alive and unchanged until the
+        element is freed. Weights that have to be converted to an array, such as lists or integer
+        arrays, are always copied.
+    bias : numpy.ndarray
+        The bias vector
+    predecessors: POINTER(c_size_t)
+        the layers before the current layer
+    num_predecessors: c_size_t
+        the number of predecessors of the current layer
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        weights, dtype, row_stride, col_stride, is_view = _weight_buffer(weights)
+        bias = np.ascontiguousarray(bias, dtype=np.float64)
+        handle_fully_connected_layer_buffer_c = fppoly_api.handle_fully_connected_layer_buffer
+        handle_fully_connected_layer_buffer_c.restype = None
+        handle_fully_connected_layer_buffer_c.argtypes = [ElinaManagerPtr, ElinaAbstract0Ptr, c_void_p, FppolyDtype, c_ssize_t, c_ssize_t, c_bool, ndpointer(ctypes.c_double), c_size_t, c_size_t, POINTER(c_size_t), c_size_t]
+        handle_fully_connected_layer_buffer_c(man, element, weights.ctypes.data, dtype, row_stride, col_stride, is_view, bias, weights.shape[0], weights.shape[1], predecessors, num_predecessors)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "handle_fully_connected_layer_buffer" from "libfppoly.so"')
+        print(inst)
+
+    return
+
+
 def handle_right_multiply_with_matrix(man, element, weights, num_weight_rows, num_weight_cols, num_out_cols, predecessors, num_predecessors):
     """
     handle the FFN layer
@@ -966,6 +1462,81 @@ def label_deviation_lb(man, element, y, x):
         print(inst)
     return res
 
+def label_deviation_lb_until(man, element, y, x, threshold):
+    """
+    Lower bound of y-x that is only as tight as needed to compare it with threshold.
+    The back-substitution stops after the first layer that proves y-x>threshold and is
+    skipped when the output bounds already show y-x<=threshold.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    element : ElinaAbstract0Ptr
+        Pointer to the abstract element.
+    y : ElinaDim
+        The dimension y in the constraint y-x>threshold.
+    x : ElinaDim
+        The dimension x in the constraint y-x>threshold.
+    threshold : c_double
+        The bound to compare y-x with.
+
+    Returns
+    -------
+    res = double
+
+    """
+    res= None
+    try:
+        label_deviation_lb_until_c = fppoly_api.label_deviation_lb_until
+        label_deviation_lb_until_c.restype = c_double
+        label_deviation_lb_until_c.argtypes = [ElinaManagerPtr, ElinaAbstract0Ptr, ElinaDim, ElinaDim, c_double]
+        res = label_deviation_lb_until_c(man, element, y, x, threshold)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "label_deviation_lb_until" from "libfppoly.so"')
+        print(inst)
+    return res
+
+def is_greater_batch(man, element, y, xs, num_xs, lbs):
+    """
+    Check if y is strictly greater than every label in xs in the abstract element.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    element : ElinaAbstract0Ptr
+        Pointer to the abstract element.
+    y : ElinaDim
+        The dimension y in the constraints y-x>0.
+    xs : POINTER(ElinaDim)
+        The dimensions x to compare y with.
+    num_xs : c_size_t
+        Number of dimensions in xs.
+    lbs : POINTER(c_double)
+        None to stop at the first comparison that fails, otherwise an array of num_xs
+        doubles that receives the lower bound of y-x reached for every x.
+
+    Returns
+    -------
+    res = boolean
+
+    """
+    res= None
+    try:
+        is_greater_batch_c = fppoly_api.is_greater_batch
+        is_greater_batch_c.restype = c_bool
+        is_greater_batch_c.argtypes = [ElinaManagerPtr, ElinaAbstract0Ptr, ElinaDim, POINTER(ElinaDim), c_size_t, POINTER(c_double)]
+        res = is_greater_batch_c(man, element, y, xs, num_xs, lbs)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "is_greater_batch" from "libfppoly.so"')
+        print(inst)
+    return res
+
 def clear_neurons_status(man,element):
     """
         Clear and reset the neuron status
@@ -1798,3 +2369,295 @@ def update_activation_lower_bound_for_neuron(man, element,layerno, neuron_no, co
         print(inst)
         print('Problem with loading/calling "update_activation_lower_bound_for_neuron" from "fppoly.so"')
         print('Make sure you are passing ElinaManagerPtr, ElinaAbstract0Ptr, c_size_t, c_size_t, POINTER(c_double), POINTER(c_size_t), c_size_t to the function')
+
+
+def fppoly_network_alloc(num_pixels):
+    """
+    Create an empty compiled network, the layers are added with the fppoly_network_add_* functions.
+
+    Parameters
+    ----------
+    num_pixels : c_size_t
+        Number of inputs of the network.
+
+    Returns
+    -------
+    net : c_void_p
+        Pointer to the compiled network, to be released with fppoly_network_free.
+
+    """
+    net = None
+    try:
+        fppoly_network_alloc_c = fppoly_api.fppoly_network_alloc
+        fppoly_network_alloc_c.restype = c_void_p
+        fppoly_network_alloc_c.argtypes = [c_size_t]
+        net = fppoly_network_alloc_c(num_pixels)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_alloc" from "libfppoly.so"')
+        print(inst)
+    return net
+
+
+def fppoly_network_free(net):
+    """
+    Free a compiled network.
+
+    Parameters
+    ----------
+    net : c_void_p
+        Pointer to the compiled network.
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        fppoly_network_free_c = fppoly_api.fppoly_network_free
+        fppoly_network_free_c.restype = None
+        fppoly_network_free_c.argtypes = [c_void_p]
+        fppoly_network_free_c(net)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_free" from "libfppoly.so"')
+        print(inst)
+    return
+
+
+def fppoly_network_add_fully_connected(net, weights, bias, size, num_pixels, predecessors, num_predecessors):
+    """
+    Append a fully connected layer to a compiled network.
+
+    Parameters
+    ----------
+    net : c_void_p
+        Pointer to the compiled network.
+    weights : POINTER(POINTER(c_double))
+        The weight matrix.
+    bias : POINTER(c_double)
+        The bias vector.
+    size : c_size_t
+        Number of neurons of the layer.
+    num_pixels : c_size_t
+        Number of neurons of the predecessor.
+    predecessors : POINTER(c_size_t)
+        the layers before the current layer
+    num_predecessors : c_size_t
+        the number of predecessors of the current layer
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        fppoly_network_add_fully_connected_c = fppoly_api.fppoly_network_add_fully_connected
+        fppoly_network_add_fully_connected_c.restype = None
+        fppoly_network_add_fully_connected_c.argtypes = [c_void_p, _doublepp, ndpointer(ctypes.c_double), c_size_t, c_size_t, POINTER(c_size_t), c_size_t]
+        fppoly_network_add_fully_connected_c(net, weights, bias, size, num_pixels, predecessors, num_predecessors)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_add_fully_connected" from "libfppoly.so"')
+        print(inst)
+    return
+
+
+def fppoly_network_add_fully_connected_array(net, weights, bias, predecessors, num_predecessors):
+    """
+    Append a fully connected layer to a compiled network, the weights are read in place.
+
+    Parameters
+    ----------
+    net : c_void_p
+        Pointer to the compiled network.
+    weights : numpy.ndarray
+        The weight matrix of shape (size, num_pixels), float32 or float64 with any strides.
+    bias : numpy.ndarray
+        The bias vector.
+    predecessors : POINTER(c_size_t)
+        the layers before the current layer
+    num_predecessors : c_size_t
+        the number of predecessors of the current layer
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        weights, dtype, row_stride, col_stride, _ = _weight_buffer(weights)
+        bias = np.ascontiguousarray(bias, dtype=np.float64)
+        fppoly_network_add_fully_connected_buffer_c = fppoly_api.fppoly_network_add_fully_connected_buffer
+        fppoly_network_add_fully_connected_buffer_c.restype = None
+        fppoly_network_add_fully_connected_buffer_c.argtypes = [c_void_p, c_void_p, FppolyDtype, c_ssize_t, c_ssize_t, ndpointer(ctypes.c_double), c_size_t, c_size_t, POINTER(c_size_t), c_size_t]
+        fppoly_network_add_fully_connected_buffer_c(net, weights.ctypes.data, dtype, row_stride, col_stride, bias, weights.shape[0], weights.shape[1], predecessors, num_predecessors)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_add_fully_connected_buffer" from "libfppoly.so"')
+        print(inst)
+    return
+
+
+def fppoly_network_add_convolutional(net, filter_weights, filter_bias, input_size, filter_size, num_filters, strides, output_size, pad_top, pad_left, has_bias, predecessors, num_predecessors):
+    """
+    Append a convolutional layer to a compiled network, the arguments are those of handle_convolutional_layer.
+
+    Parameters
+    ----------
+    net : c_void_p
+        Pointer to the compiled network.
+    filter_weights : POINTER(double)
+        filter weights
+    filter_bias : POINTER(double)
+        filter biases
+    input_size : POINTER(c_size_t)
+        size of the input
+    filter_size : POINTER(c_size_t)
+        size of the filters
+    num_filters : c_size_t
+        number of filters
+    strides : POINTER(c_size_t)
+        size of the strides
+    output_size : POINTER(c_size_t)
+        size of the output
+    pad_top : c_size_t
+        padding at the top
+    pad_left : c_size_t
+        padding on the left
+    has_bias : c_bool
+        if the filter has bias
+    predecessors : POINTER(c_size_t)
+        the layers before the current layer
+    num_predecessors : c_size_t
+        the number of predecessors of the current layer
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        fppoly_network_add_convolutional_c = fppoly_api.fppoly_network_add_convolutional
+        fppoly_network_add_convolutional_c.restype = None
+        fppoly_network_add_convolutional_c.argtypes = [c_void_p, ndpointer(ctypes.c_double), ndpointer(ctypes.c_double), ndpointer(ctypes.c_size_t), POINTER(c_size_t), c_size_t, POINTER(c_size_t), POINTER(c_size_t), c_size_t, c_size_t, c_bool, POINTER(c_size_t), c_size_t]
+        fppoly_network_add_convolutional_c(net, filter_weights, filter_bias, input_size, filter_size, num_filters, strides, output_size, pad_top, pad_left, has_bias, predecessors, num_predecessors)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_add_convolutional" from "libfppoly.so"')
+        print(inst)
+    return
+
+
+def fppoly_network_add_relu(net, num_neurons, predecessors, num_predecessors, use_default_heuristic):
+    """
+    Append a ReLU layer to a compiled network.
+
+    Parameters
+    ----------
+    net : c_void_p
+        Pointer to the compiled network.
+    num_neurons : c_size_t
+        number of neurons
+    predecessors : POINTER(c_size_t)
+        the layers before the current layer
+    num_predecessors : c_size_t
+        the number of predecessors of the current layer
+    use_default_heuristic : c_bool
+        whether to use the area heuristic
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        fppoly_network_add_relu_c = fppoly_api.fppoly_network_add_relu
+        fppoly_network_add_relu_c.restype = None
+        fppoly_network_add_relu_c.argtypes = [c_void_p, c_size_t, POINTER(c_size_t), c_size_t, c_bool]
+        fppoly_network_add_relu_c(net, num_neurons, predecessors, num_predecessors, use_default_heuristic)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_add_relu" from "libfppoly.so"')
+        print(inst)
+    return
+
+
+def fppoly_network_analyze(man, net, inf_array, sup_array):
+    """
+    Run DeepPoly through a compiled network on an input box.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    net : c_void_p
+        Pointer to the compiled network.
+    inf_array : POINTER(double)
+        lower bounds of the inputs
+    sup_array : POINTER(double)
+        upper bounds of the inputs
+
+    Returns
+    -------
+    res : ElinaAbstract0Ptr
+        Pointer to the new abstract object.
+
+    """
+    res = None
+    try:
+        fppoly_network_analyze_c = fppoly_api.fppoly_network_analyze
+        fppoly_network_analyze_c.restype = ElinaAbstract0Ptr
+        fppoly_network_analyze_c.argtypes = [ElinaManagerPtr, c_void_p, ndpointer(ctypes.c_double), ndpointer(ctypes.c_double)]
+        res = fppoly_network_analyze_c(man, net, inf_array, sup_array)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_analyze" from "libfppoly.so"')
+        print(inst)
+    return res
+
+
+def fppoly_network_verify_batch(man, net, num_regions, inf, sup, labels, results):
+    """
+    Check for every input box that its label is greater than every other output, the boxes are analysed in parallel.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    net : c_void_p
+        Pointer to the compiled network.
+    num_regions : c_size_t
+        number of input boxes
+    inf : POINTER(POINTER(c_double))
+        lower bounds of the inputs of every box
+    sup : POINTER(POINTER(c_double))
+        upper bounds of the inputs of every box
+    labels : POINTER(ElinaDim)
+        the label of every box
+    results : POINTER(c_bool)
+        array of num_regions booleans that receives the outcome for every box
+
+    Returns
+    -------
+    None
+
+    """
+    try:
+        fppoly_network_verify_batch_c = fppoly_api.fppoly_network_verify_batch
+        fppoly_network_verify_batch_c.restype = None
+        fppoly_network_verify_batch_c.argtypes = [ElinaManagerPtr, c_void_p, c_size_t, _doublepp, _doublepp, POINTER(ElinaDim), POINTER(c_bool)]
+        fppoly_network_verify_batch_c(man, net, num_regions, inf, sup, labels, results)
+    except TimeoutError:
+        raise
+    except Exception as inst:
+        print('Problem with loading/calling "fppoly_network_verify_batch" from "libfppoly.so"')
+        print(inst)
+    return
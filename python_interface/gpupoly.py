@@ -29,13 +29,26 @@ import numpy as np
 
 ## Python friendly interface to the GPUPoly library.
 class Network:
+    # The CUDA library is used when it is available, unless the environment variable GPUPOLY_CPU is set; otherwise, the CPU library is loaded.
+    _useCPU = 'GPUPOLY_CPU' in os.environ
     if os.name == 'nt': # Running in Windows
-        os.add_dll_directory("${CUDAToolkit_BIN_DIR}")
-        _lib = ctypes.cdll.LoadLibrary("${GPUPoly_BINARY_DIR}/gpupoly.dll")
+        _useCPU = _useCPU or not os.path.exists("${GPUPoly_BINARY_DIR}/gpupoly.dll")
+        if not _useCPU:
+            os.add_dll_directory("${CUDAToolkit_BIN_DIR}")
+            _lib = ctypes.cdll.LoadLibrary("${GPUPoly_BINARY_DIR}/gpupoly.dll")
+        else:
+            _lib = ctypes.cdll.LoadLibrary("${GPUPoly_BINARY_DIR}/gpupoly_cpu.dll")
 
     else: # Not running in Windows
         # _lib=ctypes.cdll.LoadLibrary('${GPUPoly_BINARY_DIR}/dpGPUlib.so.0.13')
-        _lib = ctypes.cdll.LoadLibrary(os.path.join(os.path.dirname(os.path.abspath(__file__)),"../gpupoly/libgpupoly.so.0.13"))
+        _libDir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "../gpupoly")
+        try:
+            if _useCPU:
+                raise OSError
+            _lib = ctypes.cdll.LoadLibrary(os.path.join(_libDir, "libgpupoly.so.0.13"))
+        except OSError:
+            _useCPU = True
+            _lib = ctypes.cdll.LoadLibrary(os.path.join(_libDir, "libgpupoly_cpu.so.0.13"))
         #_lib = ctypes.cdll.LoadLibrary('libgpupoly.so')
 
     def _nullable_ndptr(*args, **kwargs):
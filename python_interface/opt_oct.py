@@ -49,3 +49,31 @@ def opt_oct_manager_alloc():
         print('Problem with loading/calling "opt_oct_manager_alloc" from "liboptoct.so"')
 
     return man
+
+
+def opt_oct_manager_set_num_threads(man, num_threads):
+    """
+    Sets the number of threads used by the strong closure.
+
+    Parameters
+    ----------
+    man : ElinaManagerPtr
+        Pointer to the ElinaManager.
+    num_threads : c_int
+        Number of threads, 0 uses one thread per online CPU.
+
+    Returns
+    -------
+    None
+
+    """
+
+    try:
+        opt_oct_manager_set_num_threads_c = opt_oct_api.opt_oct_manager_set_num_threads
+        opt_oct_manager_set_num_threads_c.restype = None
+        opt_oct_manager_set_num_threads_c.argtypes = [ElinaManagerPtr, c_int]
+        opt_oct_manager_set_num_threads_c(man, num_threads)
+    except TimeoutError:
+        raise
+    except:
+        print('Problem with loading/calling "opt_oct_manager_set_num_threads" from "liboptoct.so"')